@@ -3,6 +3,8 @@
 
 /* c++ library includes */
 #include <string>
+#include <istream>
+#include <ostream>
 
 /* local includes */
 #include "ByteArray.h"
@@ -13,6 +15,9 @@
 
 /**
  * @brief class to perform base64 encode/decode. Implements only static functions.
+ * The output is allocated once with its final size. On x86 processors with SSSE3 or AVX2,
+ * detected at run time, blocks of 12/24 bytes are encoded and decoded with vector instructions;
+ * otherwise, and for the remaining bytes, a table-driven scalar code is used.
  */
 
 class Base64
@@ -21,18 +26,36 @@ public:
 	/**
 	 * encode data (readable/unreadable) to base64 format
 	 * @data data to be encoded
-	 * @return encoded data 
+	 * @return encoded data
 	 */
 	static std::string encode(ByteArray &data);
 	/**
 	 * decode base64 format data to data (readable/unreadable)
+	 * Whitespace, such as the line breaks of PEM, is skipped. Decoding stops at the
+	 * first '=' or at the first character that is neither base64 nor whitespace.
 	 * @data data to be decoded
 	 * @return decoded data
 	 */
 	static ByteArray decode(std::string &data);
+	/**
+	 * encode a stream to base64 format, reading and writing it in blocks
+	 * @param in data to be encoded
+	 * @param out stream that receives the encoded data
+	 * @param lineLength if not 0, a '\n' is written after every lineLength characters and at
+	 * the end of the data, as in PEM (which uses 64)
+	 * @return false if a read or write error occurs
+	 */
+	static bool encode(std::istream *in, std::ostream *out, unsigned int lineLength = 0);
+	/**
+	 * decode a base64 stream, reading and writing it in blocks, with the rules of decode(std::string&)
+	 * @param in data to be decoded
+	 * @param out stream that receives the decoded data
+	 * @return false if a read or write error occurs
+	 */
+	static bool decode(std::istream *in, std::ostream *out);
 private:
 	/**
-	 * internal use. It Represents possible values to base64 format. 
+	 * internal use. It Represents possible values to base64 format.
 	 */
 	static const std::string base64Chars;
 };
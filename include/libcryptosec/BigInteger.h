@@ -144,6 +144,14 @@ public:
 	* */
 	void setDecValue(std::string dec) throw(BigIntegerException);
 	
+	/**
+	 * Define o valor inteiro, positivo, a partir de octetos em big-endian sem sinal.
+	 * @param data octetos do valor.
+	 * @param size quantidade de octetos.
+	 * @throw BigIntegerException no caso de um erro interno do OpenSSL.
+	 * */
+	void setUnsignedValue(const unsigned char *data, unsigned int size) throw(BigIntegerException);
+
 	/**
 	 * Define um valor inteiro randômico (positivo ou negativo).
 	 * @param numBits número de bits do BigInteger. Se nenhum parâmetro é passado, assume-se numBits = 64.
@@ -117,11 +117,20 @@ public:
 
     /**
      * Fazer ou-exclusivo entre dois ByteArray's.
+     * O resultado tem o tamanho do maior; o menor é combinado com o início do maior.
      * 
      * @param left Primeiro ByteArray da operação.
      * @param right Segundo ByteArray da operação.
      */
-    friend ByteArray& operator xor(const ByteArray& left, const ByteArray& right);
+    friend ByteArray operator xor(const ByteArray& left, const ByteArray& right);
+
+    /**
+     * Fazer ou-exclusivo com outro ByteArray sobre este, sem cópia intermediária.
+     * Se value for maior, este ByteArray cresce até o tamanho de value, como em operator xor.
+     * 
+     * @param value ByteArray combinado com este.
+     */
+    ByteArray& operator ^=(const ByteArray& value);
 
     /**
      * Copy bytes from desired memory location.
@@ -188,12 +197,49 @@ public:
      * Converts the content of this bytearray to hexadecimal value separated using the char informed as argument.
      */    
     virtual std::string toHex(char separator);
+
+    /**
+     * Converte texto hexadecimal, com dígitos maiúsculos ou minúsculos, no ByteArray correspondente.
+     * Inversa de toHex().
+     * 
+     * @param hex Texto com dois dígitos por byte.
+     * @throw invalid_argument Se o texto tiver tamanho ímpar ou caracteres não hexadecimais.
+     */
+    static ByteArray fromHex(const std::string& hex) throw (invalid_argument);
+
+    /**
+     * Converte texto hexadecimal com os bytes separados por um caractere. Inversa de toHex(char).
+     * 
+     * @param hex Texto no formato "0A:1B:2C".
+     * @param separator Caractere entre os bytes.
+     * @throw invalid_argument Se o texto não estiver no formato esperado.
+     */
+    static ByteArray fromHex(const std::string& hex, char separator) throw (invalid_argument);
+
+    /**
+     * Compara dois ByteArray's em tempo que depende apenas do tamanho, e não do conteúdo.
+     * Deve ser usado na verificação de MACs e tags; o operador == pode retornar na primeira diferença.
+     * 
+     * @param left Primeiro ByteArray da comparação.
+     * @param right Segundo ByteArray da comparação.
+     */
+    static bool constantTimeEquals(const ByteArray& left, const ByteArray& right);
     
     /**
      * Computes multiple xor of vector elements.
+     * The result has the size of the largest element and is computed in a single pass over the inputs.
      */
     static ByteArray xOr(vector<ByteArray> &array);
 
+    /**
+     * Computes data ^= value over length bytes, a machine word or vector register at a time.
+     * 
+     * @param data Bytes to be updated.
+     * @param value Bytes combined into data. May not partially overlap data.
+     * @param length Amount of bytes.
+     */
+    static void xorInto(unsigned char* data, const unsigned char* value, size_t length);
+
 private:
     unsigned char* m_data;
     unsigned int length;
@@ -22,7 +22,8 @@
 /**
  * @brief Implementa a representação da data.
  * É utilizada em certificados, LCRs.
- * Utiliza o formato epoch (time_t) para representar datas internamente. 
+ * Utiliza o formato epoch (time_t) para representar datas internamente, com a fração de segundo
+ * em nanossegundos das datas lidas de GeneralizedTime (ver getNanoseconds()).
   */
 class DateTime
 {
@@ -67,7 +68,7 @@ public:
 	
 	/**
 	 * Contrutor.
-	 * Cria um objeto DateTime com uma data específica.
+	 * Cria um objeto DateTime com uma data específica, incluindo a fração de segundo.
 	 * @param asn1Time data específica. 
 	 */	
 	DateTime(ASN1_TIME *asn1Time) throw(BigIntegerException);
@@ -105,6 +106,7 @@ public:
 	
 	/**
 	 * Obtem data em segundos.
+	 * Em plataformas com time_t de 32 bits, datas após 2038 não são representáveis; usar getSeconds().
 	 * @return data em segundos. 
 	 */
 	time_t getDateTime() const throw(BigIntegerException);
@@ -114,6 +116,14 @@ public:
 	 * @return data em segundos. 
 	 */
 	BigInteger const& getSeconds() const throw();
+
+	/**
+	 * Obtem a fração de segundo, lida de um GeneralizedTime por DateTime(ASN1_TIME*) ou
+	 * DateTime(std::string). É zerada por setDateTime() e não é incluída nas codificações
+	 * (getAsn1Time(), getISODate() etc.), que são truncadas em segundos.
+	 * @return fração de segundo em nanossegundos [0-999999999].
+	 */
+	long getNanoseconds() const throw();
 	
 	/**
 	 * Obtem data em formato ASN1.
@@ -354,6 +364,14 @@ public:
 	 * */
 	static BigInteger date2epoch(string aString) throw(BigIntegerException)
 	{
+		time_t epoch;
+		long nanoseconds;
+		
+		if(DateTime::time2epoch(reinterpret_cast<const unsigned char*>(aString.data()), aString.size(), aString.size() != 13, epoch, nanoseconds))
+		{
+			return BigInteger(static_cast<long>(epoch));
+		}
+		
 		int year;
 		int month; //[0-11]
 		int day; //[1-31]
@@ -423,27 +441,60 @@ public:
 	 * */	
 	static BigInteger date2epoch(int year, int month, int day, int hour, int min, int sec) throw(BigIntegerException)
 	{
-		BigInteger ret(0L);
+		//em BigInteger: os segundos não cabem em long de 32 bits após 2038
+		BigInteger ret(DateTime::getDaysSinceEpoch(year, month, day));
 		
-		for(int i = 1970; i < year; i++)
+		ret.mul(86400L);
+		ret.add((hour * 60L + min) * 60L + sec);
+			
+		return ret;
+	}
+	
+	/**
+	 * Transforma diretamente os bytes de um UTCTime ou GeneralizedTime para epoch, sem alocar memória
+	 * nem passar por streams. É o caminho utilizado por DateTime(ASN1_TIME*).
+	 * Formatos aceitos:
+	 * UTCTime: YYMMDDHHMM[SS](Z|+hhmm|-hhmm).
+	 * GeneralizedTime: YYYYMMDDHH[MM[SS]][(.|,)fff...][Z|+hhmm|-hhmm] (sem fuso, assume-se Zulu). A fração
+	 * se refere ao último campo presente: hora, minuto ou segundo.
+	 * @param data bytes da data (não precisam terminar em '\0').
+	 * @param length quantidade de bytes.
+	 * @param generalizedTime true se os bytes estão no formato GeneralizedTime, false para UTCTime.
+	 * @param epoch recebe os segundos desde 1970 (Zulu), já descontado o fuso.
+	 * @param nanoseconds recebe a fração de segundo em nanossegundos (0 se ausente).
+	 * @return true se a data foi decodificada, false se o formato é inválido ou se a data não é
+	 * representável em time_t (32 bits).
+	 * */
+	static bool time2epoch(const unsigned char *data, int length, bool generalizedTime, time_t& epoch, long& nanoseconds) throw();
+	
+	/**
+	 * Retorna a quantidade de dias desde 1 de Janeiro de 1970 (negativo para datas anteriores).
+	 * @param year ano.
+	 * @param month mês [0-11].
+	 * @param day dia [1-31].
+	 * @return número de dias.
+	 * obs: algoritmo days_from_civil de Howard Hinnant, sem laços por ano.
+	 * */
+	inline static long getDaysSinceEpoch(int year, int month, int day) throw()
+	{
+		long y = year;
+		long m = month + 1;
+		long era;
+		long yearOfEra;
+		long dayOfYear;
+		long dayOfEra;
+		
+		if(m <= 2)
 		{
-			ret.add(DateTime::getYearSize(i));
+			y--;
 		}
 		
-		for(int i = 0 ; i < month ; i ++)
-		{
-			ret.add(DateTime::getMonthSize(i, year));
-		}
+		era = (y >= 0 ? y : y - 399) / 400;
+		yearOfEra = y - era * 400;
+		dayOfYear = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + day - 1;
+		dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
 		
-		ret.add(day - 1);	
-		ret.mul(24);
-		ret.add(hour);
-		ret.mul(60);
-		ret.add(min);
-		ret.mul(60);
-		ret.add(sec);
-			
-		return ret;
+		return era * 146097 + dayOfEra - 719468;
 	}
 	
 	/***
@@ -570,6 +621,11 @@ protected:
 	 * Segundos desde  00:00:00 on January 1, 1970, Coordinated Universal Time (UTC).
 	 * */
 	BigInteger seconds;
+	
+	/*
+	 * Fração de segundo em nanossegundos [0-999999999].
+	 * */
+	long nanoseconds;
 };
 
 #endif /*DATETIME_H_*/
@@ -0,0 +1,179 @@
+#ifndef FILEDIGEST_H_
+#define FILEDIGEST_H_
+
+#include <openssl/evp.h>
+#include <string>
+#include <iostream>
+#include <vector>
+#include "ByteArray.h"
+#include "MessageDigest.h"
+#include "ThreadPool.h"
+#include <libcryptosec/exception/MessageDigestException.h>
+
+/**
+ * @ingroup Util
+ */
+
+/**
+ * @brief Calcula resumos criptográficos de arquivos e streams grandes.
+ *
+ * Modo FileDigest::STANDARD: resumo convencional do conteúdo, idêntico ao de MessageDigest.
+ * O conteúdo é lido em blocos grandes por uma thread auxiliar (leitura antecipada com dois buffers),
+ * de forma que a leitura do próximo bloco ocorre enquanto o bloco atual é resumido.
+ *
+ * Modo FileDigest::TREE: resumo em árvore (Merkle), que permite distribuir o cálculo entre as threads de um ThreadPool.
+ * O resultado depende do algoritmo e do tamanho de bloco, e é definido por:
+ * - o conteúdo é dividido em blocos de chunkSize bytes; o último pode ser menor.
+ *   Conteúdo vazio gera um único bloco vazio;
+ * - folha i: H(0x00 || bloco_i);
+ * - nó interno: H(0x01 || filho_esquerdo || filho_direito), combinando os nós de cada nível dois a dois, da esquerda para a direita.
+ *   Se o nível tem quantidade ímpar de nós, o último é promovido sem alteração ao nível seguinte;
+ * - o resumo é a raiz da árvore (com um único bloco, a própria folha).
+ * Arquivos são mapeados em memória (mmap) nesse modo, sem cópias dos blocos.
+ */
+class FileDigest
+{
+public:
+
+	/**
+	 * @enum FileDigest::Mode
+	 * Modos de cálculo do resumo.
+	 */
+	enum Mode
+	{
+		STANDARD,
+		TREE,
+	};
+
+	/**
+	 * Tamanho de bloco padrão (1 MiB).
+	 */
+	static const unsigned int DEFAULT_CHUNK_SIZE = 1048576;
+
+	/**
+	 * Construtor.
+	 * @param algorithm algoritmo de resumo.
+	 * @param mode modo de cálculo do resumo.
+	 * @param pool threads utilizadas no modo FileDigest::TREE. Se NULL, as folhas são calculadas na thread atual.
+	 * O ThreadPool não é liberado por FileDigest.
+	 * @param chunkSize tamanho dos blocos de leitura e, no modo FileDigest::TREE, das folhas da árvore.
+	 */
+	FileDigest(MessageDigest::Algorithm algorithm, FileDigest::Mode mode = FileDigest::STANDARD,
+			ThreadPool *pool = NULL, unsigned int chunkSize = FileDigest::DEFAULT_CHUNK_SIZE);
+
+	/**
+	 * Destrutor.
+	 */
+	virtual ~FileDigest();
+
+	/**
+	 * Calcula o resumo do conteúdo de um arquivo.
+	 * @param path caminho do arquivo.
+	 * @return resumo do arquivo.
+	 * @throw MessageDigestException caso o arquivo não possa ser lido ou ocorra erro no cálculo do resumo.
+	 */
+	ByteArray digestFile(std::string const &path) throw (MessageDigestException);
+
+	/**
+	 * Calcula o resumo do conteúdo restante de um stream, até o seu fim.
+	 * @param stream stream de entrada.
+	 * @return resumo do conteúdo.
+	 * @throw MessageDigestException caso ocorra erro de leitura ou no cálculo do resumo.
+	 */
+	ByteArray digestStream(std::istream &stream) throw (MessageDigestException);
+
+	/**
+	 * Retorna o algoritmo de resumo.
+	 * @return algoritmo de resumo.
+	 */
+	MessageDigest::Algorithm getAlgorithm() const;
+
+	/**
+	 * Retorna o modo de cálculo do resumo.
+	 * @return modo de cálculo.
+	 */
+	FileDigest::Mode getMode() const;
+
+	/**
+	 * Retorna o tamanho de bloco.
+	 * @return tamanho de bloco em bytes.
+	 */
+	unsigned int getChunkSize() const;
+
+	/**
+	 * @brief Origem dos dados a serem resumidos.
+	 */
+	class Source
+	{
+	public:
+		virtual ~Source() {}
+
+		/**
+		 * Lê até size bytes, preenchendo o buffer por completo exceto no fim dos dados.
+		 * @return bytes lidos, 0 no fim dos dados ou -1 em caso de erro.
+		 */
+		virtual long read(unsigned char *buffer, unsigned long size) = 0;
+	};
+
+protected:
+	FileDigest(const FileDigest &);
+	FileDigest& operator=(const FileDigest &);
+
+	/**
+	 * Calcula o resumo de uma origem com leitura antecipada, no modo configurado.
+	 */
+	ByteArray digestSource(FileDigest::Source &source) throw (MessageDigestException);
+
+	/**
+	 * Calcula o resumo em árvore de um conteúdo já em memória.
+	 */
+	ByteArray digestTree(const unsigned char *data, size_t size) throw (MessageDigestException);
+
+	/**
+	 * Calcula as folhas dos blocos de um buffer, acrescentando-as em leaves.
+	 */
+	void hashLeaves(const unsigned char *data, size_t size, std::vector<unsigned char> &leaves)
+			throw (MessageDigestException);
+
+	/**
+	 * Calcula a raiz da árvore a partir das folhas.
+	 */
+	ByteArray hashRoot(std::vector<unsigned char> &leaves) throw (MessageDigestException);
+
+	/**
+	 * Algoritmo de resumo.
+	 */
+	MessageDigest::Algorithm algorithm;
+
+	/**
+	 * Modo de cálculo.
+	 */
+	FileDigest::Mode mode;
+
+	/**
+	 * Threads utilizadas no modo FileDigest::TREE.
+	 */
+	ThreadPool *pool;
+
+	/**
+	 * Tamanho de bloco.
+	 */
+	unsigned int chunkSize;
+
+	/**
+	 * Estrutura OpenSSL do algoritmo.
+	 */
+	const EVP_MD *md;
+
+	/**
+	 * Algoritmo obtido uma única vez do provider, NULL se indisponível (ex.: algoritmos de engines).
+	 */
+	EVP_MD *fetched;
+
+	/**
+	 * Tamanho do resumo em bytes.
+	 */
+	unsigned int mdSize;
+};
+
+#endif /*FILEDIGEST_H_*/
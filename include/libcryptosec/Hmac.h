@@ -65,11 +65,27 @@ public:
 	 */
 	Hmac(ByteArray key, MessageDigest::Algorithm algorithm, Engine &engine) throw (HmacException);
 
+	/**
+	 * Construtor de cópia.
+	 * Duplica o contexto do hmac, incluindo o estado da chave já processada e o conteúdo
+	 * já atualizado, sem reprocessar a chave.
+	 * @param hmac objeto Hmac a ser copiado.
+	 * @throw HmacException caso ocorra erro ao copiar a estrutura do hmac do OpenSSL.
+	 */
+	Hmac(const Hmac &hmac) throw (HmacException);
+
 	/**
 	 * Destrutor.
 	 */
 	virtual ~Hmac();
 
+	/**
+	 * Operador de atribuição.
+	 * @param hmac objeto Hmac a ser copiado.
+	 * @throw HmacException caso ocorra erro ao copiar a estrutura do hmac do OpenSSL.
+	 */
+	Hmac& operator=(const Hmac &hmac) throw (HmacException);
+
 	/**
 	 * Inicializar a estrutura do hmac.
 	 * @param key chave secreta.
@@ -162,6 +178,33 @@ public:
 	 */
 	ByteArray doFinal() throw (HmacException, InvalidStateException);
 
+	/**
+	 * Gerar o hmac diretamente em um buffer do chamador, sem alocar memória.
+	 * Assim como doFinal(), mantém o estado da chave para uso com reset().
+	 * @param buffer destino do hmac.
+	 * @param size tamanho do buffer, que deve ser de pelo menos getSize() bytes.
+	 * @return quantidade de bytes escritos no buffer.
+	 * @throw HmacException caso o buffer seja pequeno demais ou ocorra erro ao finalizar o contexto do hmac do OpenSSL.
+	 * @throw InvalidStateException caso o objeto Hmac não tenha sido inicializado corretamente ou caso não tenha sido passado o conteúdo para calculo do hmac.
+	 */
+	unsigned int finalInto(unsigned char *buffer, unsigned int size) throw (HmacException, InvalidStateException);
+
+	/**
+	 * Reinicia o hmac para uma nova mensagem com a mesma chave e algoritmo.
+	 * Os blocos ipad/opad da chave calculados em init() são reaproveitados, portanto
+	 * a chave não é processada novamente. Pode ser chamado após doFinal() ou no meio de uma mensagem.
+	 * @throw HmacException caso ocorra erro ao reiniciar o contexto do hmac do OpenSSL.
+	 * @throw InvalidStateException caso o objeto Hmac nunca tenha sido inicializado com uma chave.
+	 */
+	void reset() throw (HmacException, InvalidStateException);
+
+	/**
+	 * Obtem o tamanho do hmac gerado pelo algoritmo selecionado.
+	 * @return tamanho do hmac em bytes.
+	 * @throw InvalidStateException caso o objeto Hmac nunca tenha sido inicializado com uma chave.
+	 */
+	unsigned int getSize() const throw (InvalidStateException);
+
 protected:
 	/**
 	 * @enum Hmac::State
@@ -169,14 +212,17 @@ protected:
 	 * @var NO_INIT estado inicial, enquanto a estrutura do Hmac ainda não foi inicializada.
 	 * @var INIT estado intermediário, após a estrutura do Hmac ser inicializada, porém o conteúdo para cálculo do Hmac ainda não foi passado.
 	 * @var UPDATE estado final, todas os requisitos cumpridos para se calcular o Hmac.
+	 * @var FINAL estado após o cálculo do Hmac. A chave continua carregada e o objeto pode ser reiniciado com reset().
 	 * @see Hmac::init(std::string key, Hmac::Algorithm algorithm).
 	 * @see Hmac::update(ByteArray &data).
 	 * @see Hmac::doFinal().
+	 * @see Hmac::reset().
 	 */
 	enum State {
 		NO_INIT,
 		INIT,
 		UPDATE,
+		FINAL,
 	};
 
 	/**
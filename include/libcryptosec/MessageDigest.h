@@ -5,6 +5,7 @@
 #include <string>
 #include "ByteArray.h"
 #include "Engine.h"
+#include "ThreadPool.h"
 #include <libcryptosec/exception/MessageDigestException.h>
 #include <libcryptosec/exception/InvalidStateException.h>
 #include <libcryptosec/certificate/ObjectIdentifier.h>
@@ -65,11 +66,28 @@ public:
 	 */
 	MessageDigest(MessageDigest::Algorithm algorithm, Engine &engine) throw (MessageDigestException);
 
+	/**
+	 * Construtor de cópia.
+	 * Duplica o contexto em andamento (EVP_MD_CTX_copy_ex), permitindo resumir um prefixo comum uma única vez
+	 * e ramificá-lo para várias mensagens.
+	 * @param md objeto MessageDigest a ser copiado.
+	 * @throw MessageDigestException caso ocorra erro ao copiar o contexto de resumo do OpenSSL.
+	 */
+	MessageDigest(const MessageDigest &md) throw (MessageDigestException);
+
 	/**
 	 * Destrutor.
 	 */
 	virtual ~MessageDigest();
 
+	/**
+	 * Operador de atribuição.
+	 * Duplica o contexto em andamento.
+	 * @param md objeto MessageDigest a ser copiado.
+	 * @throw MessageDigestException caso ocorra erro ao copiar o contexto de resumo do OpenSSL.
+	 */
+	MessageDigest& operator=(const MessageDigest &md) throw (MessageDigestException);
+
 	/**
 	 * Inicializa estruturas de resumos do OpenSSL.
 	 * @param algorithm algoritmo de resumo.
@@ -85,6 +103,34 @@ public:
 	 */
 	void init(MessageDigest::Algorithm algorithm, Engine &engine) throw (MessageDigestException);
 
+	/**
+	 * Inicializa estruturas de resumos do OpenSSL, opcionalmente permitindo exportar o estado intermediário.
+	 * No modo exportável o resumo é calculado pelas funções de baixo nível do OpenSSL (MD5_*, SHA1_*, SHA256_*, ...),
+	 * fora dos providers, e o estado pode ser obtido com getMidstate() a qualquer momento.
+	 * @param algorithm algoritmo de resumo. O modo exportável suporta MD5, SHA1, SHA224, SHA256, SHA384 e SHA512.
+	 * @param exportable true para o modo exportável, false equivale a init(MessageDigest::Algorithm).
+	 * @throw MessageDigestException caso o algoritmo não suporte o modo exportável ou ocorra erro ao inicializar a estrutura de resumos.
+	 */
+	void init(MessageDigest::Algorithm algorithm, bool exportable) throw (MessageDigestException);
+
+	/**
+	 * Exporta o estado intermediário (midstate) do resumo em formato portável, independente de plataforma:
+	 * versão (1 byte), algoritmo (1 byte), tamanho do conteúdo já resumido em bits (16 bytes, big-endian),
+	 * palavras do estado (big-endian) e bytes ainda não processados do bloco corrente.
+	 * @return estado intermediário serializado.
+	 * @throw InvalidStateException caso o objeto não tenha sido inicializado no modo exportável.
+	 * @see MessageDigest::init(MessageDigest::Algorithm, bool)
+	 */
+	ByteArray getMidstate() const throw (InvalidStateException);
+
+	/**
+	 * Restaura um estado intermediário exportado por getMidstate(), no modo exportável.
+	 * Após a restauração, o resumo pode ser atualizado e finalizado normalmente.
+	 * @param midstate estado intermediário serializado.
+	 * @throw MessageDigestException caso o estado seja inválido.
+	 */
+	void setMidstate(ByteArray &midstate) throw (MessageDigestException);
+
 	/**
 	 * Define o conteúdo de entrada função de resumo.
 	 * @param data conteúdo para resumo.
@@ -138,6 +184,43 @@ public:
 	MessageDigest::Algorithm getAlgorithm() throw (InvalidStateException);
 	
 	
+	/**
+	 * Calcula em lote os resumos de várias entradas independentes.
+	 * Um único contexto de resumo é reaproveitado para todas as entradas de cada thread, sem alocações por entrada.
+	 * Os resumos são escritos de forma contígua em output: o resumo da entrada i ocupa
+	 * os bytes [i * getDigestSize(algorithm), (i + 1) * getDigestSize(algorithm)).
+	 * @param algorithm algoritmo de resumo.
+	 * @param data ponteiros para as entradas.
+	 * @param sizes tamanhos das entradas.
+	 * @param count quantidade de entradas.
+	 * @param output buffer de saída, com pelo menos count * getDigestSize(algorithm) bytes.
+	 * @param pool threads utilizadas para dividir o lote. Se NULL, o lote é processado na thread atual.
+	 * @return tamanho de cada resumo em bytes.
+	 * @throw MessageDigestException caso ocorra erro ao calcular algum dos resumos.
+	 */
+	static unsigned int doFinal(MessageDigest::Algorithm algorithm, const unsigned char * const *data, const unsigned int *sizes,
+			unsigned int count, unsigned char *output, ThreadPool *pool = NULL) throw (MessageDigestException);
+
+	/**
+	 * Calcula em lote os resumos de várias entradas independentes.
+	 * @param algorithm algoritmo de resumo.
+	 * @param data entradas.
+	 * @param pool threads utilizadas para dividir o lote. Se NULL, o lote é processado na thread atual.
+	 * @return resumos concatenados, na mesma ordem das entradas.
+	 * @throw MessageDigestException caso ocorra erro ao calcular algum dos resumos.
+	 * @see MessageDigest::doFinal(MessageDigest::Algorithm, const unsigned char * const *, const unsigned int *, unsigned int, unsigned char *, ThreadPool *)
+	 */
+	static ByteArray doFinal(MessageDigest::Algorithm algorithm, std::vector<ByteArray> &data, ThreadPool *pool = NULL)
+			throw (MessageDigestException);
+
+	/**
+	 * Retorna o tamanho do resumo gerado por um algoritmo.
+	 * @param algorithm algoritmo de resumo.
+	 * @return tamanho do resumo em bytes.
+	 * @throw MessageDigestException caso o algoritmo não esteja disponível.
+	 */
+	static unsigned int getDigestSize(MessageDigest::Algorithm algorithm) throw (MessageDigestException);
+
 	/**
 	 * Retorna a estrutura do OpenSSL que representa o algoritmo de resumo desejado.
 	 * @return objeto EVP_MD referente ao algoritmo passado.
@@ -193,6 +276,17 @@ protected:
 	 * Estrutura OpenSSL que representa o algoritmo de resumo.
 	 */
 	EVP_MD_CTX* ctx;
+
+	/**
+	 * Contexto de baixo nível do OpenSSL (MD5_CTX, SHA_CTX, SHA256_CTX ou SHA512_CTX) utilizado no modo exportável.
+	 * NULL quando o resumo é calculado por ctx.
+	 */
+	void *lowLevelCtx;
+
+	/**
+	 * Libera o contexto de baixo nível, se houver.
+	 */
+	void freeLowLevelCtx();
 };
 
 #endif /*MESSAGEDIGEST_H_*/
@@ -49,15 +49,30 @@ public:
 protected:
 	/**
 	 * Popula os objetos internos da classe: privKey, cert e ca.
+	 * O conteúdo é decifrado apenas na primeira chamada com uma dada passphrase; chamadas
+	 * seguintes com a mesma passphrase reutilizam os objetos já obtidos, evitando repetir
+	 * a derivação de chave e a verificação do MAC.
 	 * @param password passphrase do pacote Pkcs12
 	 * */
 	void parse(string password) throw(Pkcs12Exception);
+
+	/**
+	 * @return hash SHA-256 da passphrase, usado para identificar o conteúdo em cache.
+	 * */
+	static ByteArray getPasswordDigest(string const& password);
+
+	/**
+	 * Libera os objetos internos obtidos pelo último parse.
+	 * */
+	void clear();
 	
 protected:
 	PrivateKey* privKey;
 	Certificate* cert;
 	vector<Certificate*> ca;
 	PKCS12* pkcs12;
+	bool parsed;
+	ByteArray passwordDigest;
 };
 
 #endif /*PKCS12_H_*/
@@ -2,8 +2,10 @@
 #define PKCS12BUILDER_H_
 
 #include "PrivateKey.h"
+#include "MessageDigest.h"
 #include <libcryptosec/certificate/Certificate.h>
 #include "Pkcs12.h"
+#include "ThreadPool.h"
 #include <libcryptosec/exception/Pkcs12Exception.h>
 
 class Pkcs12Builder
@@ -17,12 +19,129 @@ public:
 	void addAdditionalCert(Certificate* cert) throw();
 	void clearAdditionalCerts() throw();
 	Pkcs12* doFinal(string password = string("")) const throw(Pkcs12Exception);
+
+	/**
+	 * @brief Pacote a ser gerado por Pkcs12Builder::doFinal(std::vector<Pkcs12Builder::Entry> const&, Pkcs12Builder::Sink*, ...).
+	 **/
+	class Entry
+	{
+	public:
+		Entry(PrivateKey *key, Certificate *cert, string password, string friendlyName = string("")) :
+				key(key), cert(cert), password(password), friendlyName(friendlyName)
+		{
+		}
+
+		PrivateKey *key;
+		Certificate *cert;
+		string password;
+		string friendlyName;
+	};
+
+	/**
+	 * @brief Destino dos pacotes gerados em lote.
+	 * Os métodos são chamados pela thread que chamou doFinal(), na ordem dos pacotes.
+	 **/
+	class Sink
+	{
+	public:
+		virtual ~Sink() {}
+
+		/**
+		 * Recebe um pacote gerado.
+		 * @param index posição do pacote no vetor de entrada.
+		 * @param der pacote PKCS12 em codificação DER.
+		 **/
+		virtual void write(unsigned int index, ByteArray &der) = 0;
+
+		/**
+		 * Recebe a falha na geração de um pacote. A implementação padrão relança a exceção,
+		 * interrompendo o lote.
+		 * @param index posição do pacote no vetor de entrada.
+		 * @param exception motivo da falha.
+		 **/
+		virtual void fail(unsigned int index, Pkcs12Exception &exception)
+		{
+			throw exception;
+		}
+	};
+
+	/**
+	 * @enum Encryption
+	 **/
+	/**
+	 *  Algoritmos de cifragem baseada em senha para as bags de chave e de certificados.
+	 **/
+	enum Encryption
+	{
+		DEFAULT_ENCRYPTION, /*!< padrão do OpenSSL (PBES2 com AES-256-CBC).*/
+		NO_ENCRYPTION, /*!< sem cifragem. A chave é armazenada em uma keyBag em claro.*/
+		PBE_SHA1_3DES, /*!< PKCS#12 pbeWithSHAAnd3-KeyTripleDES-CBC, compatível com implementações antigas.*/
+		PBES2_AES_128_CBC, /*!< PBES2 com PBKDF2 e AES-128-CBC.*/
+		PBES2_AES_256_CBC, /*!< PBES2 com PBKDF2 e AES-256-CBC.*/
+	};
+
+	/**
+	 * Gera o pacote PKCS12 com parâmetros explícitos de derivação de chave e MAC.
+	 * O custo de importação e exportação é proporcional a iterations e macIterations.
+	 * @param password passphrase do pacote.
+	 * @param keyEncryption cifragem da bag da chave privada.
+	 * @param certEncryption cifragem da bag de certificados.
+	 * @param iterations iterações da derivação de chave de cifragem. Se 0, usa PKCS12_DEFAULT_ITER.
+	 * @param macAlgorithm algoritmo de hash do MAC de integridade.
+	 * @param macIterations iterações da derivação da chave do MAC. Se 0, usa o mesmo valor de iterations.
+	 * @throw Pkcs12Exception se a chave não corresponder ao certificado ou se ocorrer erro na geração.
+	 **/
+	Pkcs12* doFinal(string password, Pkcs12Builder::Encryption keyEncryption, Pkcs12Builder::Encryption certEncryption,
+			int iterations, MessageDigest::Algorithm macAlgorithm = MessageDigest::SHA256, int macIterations = 0)
+			const throw(Pkcs12Exception);
+
+	/**
+	 * Define o ThreadPool usado na geração de pacotes em lote.
+	 * @param pool ThreadPool a ser usado, ou NULL para gerar os pacotes sequencialmente.
+	 * O ThreadPool não passa a pertencer ao builder.
+	 **/
+	void setThreadPool(ThreadPool *pool);
+
+	/**
+	 * Gera um pacote PKCS12 para cada entrada, com os certificados adicionais do builder como cadeia
+	 * comum a todos. As bags da cadeia são codificadas uma única vez e compartilhadas entre os pacotes;
+	 * a derivação de chaves, a cifragem e o MAC de cada pacote são executados no ThreadPool definido
+	 * em setThreadPool().
+	 * Os pacotes são gerados em janelas de tamanho proporcional ao ThreadPool e entregues ao sink
+	 * ao fim de cada janela, de modo que a memória utilizada não cresce com a quantidade de entradas.
+	 * A chave, o certificado e o nome amigável definidos em setKeyAndCertificate() são ignorados.
+	 * @param entries chaves, certificados e passphrases dos pacotes.
+	 * @param sink destino dos pacotes gerados.
+	 * @param keyEncryption cifragem das bags de chave privada.
+	 * @param certEncryption cifragem das bags de certificados.
+	 * @param iterations iterações da derivação de chave de cifragem. Se 0, usa PKCS12_DEFAULT_ITER.
+	 * @param macAlgorithm algoritmo de hash do MAC de integridade.
+	 * @param macIterations iterações da derivação da chave do MAC. Se 0, usa o mesmo valor de iterations.
+	 * @throw Pkcs12Exception se não for possível codificar a cadeia comum, ou a exceção relançada
+	 * por Pkcs12Builder::Sink::fail().
+	 **/
+	void doFinal(std::vector<Pkcs12Builder::Entry> const& entries, Pkcs12Builder::Sink *sink,
+			Pkcs12Builder::Encryption keyEncryption = Pkcs12Builder::DEFAULT_ENCRYPTION,
+			Pkcs12Builder::Encryption certEncryption = Pkcs12Builder::DEFAULT_ENCRYPTION, int iterations = 0,
+			MessageDigest::Algorithm macAlgorithm = MessageDigest::SHA256, int macIterations = 0)
+			const throw(Pkcs12Exception);
+	
+protected:
+	/**
+	 * Gera o pacote PKCS12. Se md for NULL, o MAC é gerado por PKCS12_create() com seus parâmetros padrão.
+	 **/
+	Pkcs12* create(string password, int nidKey, int nidCert, int iterations, const EVP_MD *md, int macIterations)
+			const throw(Pkcs12Exception);
+
+	static int getEncryptionNid(Pkcs12Builder::Encryption encryption);
+
 	
 protected:
 	string friendlyName;
 	PrivateKey* key;
 	Certificate* keyCert;
 	vector<Certificate*> certs;
+	ThreadPool *pool;
 };
 
 #endif /*PKCS12BUILDER_H_*/
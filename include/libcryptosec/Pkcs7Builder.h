@@ -8,6 +8,7 @@
 #include <string>
 
 #include "ByteArray.h"
+#include "StreamBio.h"
 #include <libcryptosec/exception/EncodeException.h>
 #include <libcryptosec/exception/Pkcs7Exception.h>
 #include <libcryptosec/exception/InvalidStateException.h>
@@ -61,9 +62,25 @@ public:
 	 **/
 	void update(ByteArray &data) throw (InvalidStateException, Pkcs7Exception);
 	
+	/**
+	 * @enum Encoding
+	 **/
+	/**
+	 *  Codificações de saída para Pkcs7Builder::doFinal(std::istream*, std::ostream*, Pkcs7Builder::Encoding).
+	 **/
+	enum Encoding
+	{
+		PEM, /*!< BER em Base64 com cabeçalhos PEM.*/
+		BER, /*!< binário. Com conteúdo anexado, os campos que envolvem o conteúdo usam comprimento indefinido, permitindo escrita incremental.*/
+		DER, /*!< binário com comprimentos definidos. Disponível apenas para pacotes assinados sem conteúdo anexado.*/
+	};
+
 	/**
 	 * Gera um pacote PKCS7 a partir de de um stream de entrada e põe o resultado
 	 * no formato PEM em um stream de saída.
+	 * O pacote é codificado em DER dentro do PEM, como nas versões anteriores: com conteúdo anexado,
+	 * todo o conteúdo é mantido em memória até o final. Para escrita incremental, com BER de
+	 * comprimento indefinido, usar doFinal(in, out, Pkcs7Builder::PEM).
 	 * @param in stream de entrada cujo conteúdo será adicionado ao pacote PKCS7
 	 * @param out stream que vai receber o pacote PKCS7 no formato PEM
 	 * @throw InvalidStateException se o builder não estiver em um estado apropriado
@@ -77,8 +94,50 @@ public:
 	void doFinal(std::istream *in, std::ostream *out)
 			throw (InvalidStateException, Pkcs7Exception, EncodeException);
 
+	/**
+	 * Gera um pacote PKCS7 a partir de um stream de entrada, escrevendo o resultado
+	 * incrementalmente no stream de saída. O conteúdo nunca é mantido inteiro em memória:
+	 * com conteúdo anexado, o pacote é escrito à medida que a entrada é lida; sem conteúdo
+	 * anexado, a entrada é apenas resumida e o pacote é escrito ao final.
+	 * O builder deve estar no estado INIT, ou seja, update() não pode ter sido chamado.
+	 * @param in stream de entrada cujo conteúdo será adicionado ao pacote PKCS7
+	 * @param out stream que vai receber o pacote PKCS7
+	 * @param encoding codificação da saída
+	 * @param bufferSize tamanho dos buffers de leitura e escrita
+	 * @throw InvalidStateException se o builder não estiver no estado INIT.
+	 * @throw Pkcs7Exception caso ocorra algum erro no procedimento de empacotamento.
+	 * @throw EncodeException caso ocorra erro de leitura ou escrita nos streams, ou se DER
+	 * for solicitado para um pacote com conteúdo anexado.
+	 * @see Pkcs7Builder::Encoding
+	 **/
+	void doFinal(std::istream *in, std::ostream *out, Pkcs7Builder::Encoding encoding,
+			unsigned int bufferSize = StreamBio::DEFAULT_BUFFER_SIZE)
+			throw (InvalidStateException, Pkcs7Exception, EncodeException);
+
 protected:
 
+	/**
+	 * Prepara a estrutura PKCS7 para receber o conteúdo, retornando o BIO em que ele deve ser escrito.
+	 * A implementação padrão chama PKCS7_dataInit().
+	 * @return o BIO criado, ou NULL em caso de erro.
+	 **/
+	virtual BIO* dataInit();
+
+	/**
+	 * Finaliza a estrutura PKCS7 após todo o conteúdo ter sido escrito em p7bio.
+	 * A implementação padrão chama PKCS7_dataFinal().
+	 * @return 1 em caso de sucesso, 0 caso contrário.
+	 **/
+	virtual int dataFinal();
+
+	/**
+	 * Implementação de doFinal(std::istream*, std::ostream*) e de
+	 * doFinal(std::istream*, std::ostream*, Pkcs7Builder::Encoding, unsigned int).
+	 * @param streaming se falso, o pacote é sempre codificado em DER após a leitura de toda a entrada.
+	 **/
+	void encode(std::istream *in, std::ostream *out, Pkcs7Builder::Encoding encoding, unsigned int bufferSize,
+			bool streaming) throw (InvalidStateException, Pkcs7Exception, EncodeException);
+
 	/**
 	 * @enum State
 	 **/
@@ -8,6 +8,7 @@
 #include "PublicKey.h"
 #include "SymmetricKey.h"
 #include "SymmetricCipher.h"
+#include "StreamBio.h"
 
 #include <libcryptosec/exception/Pkcs7Exception.h>
 #include <libcryptosec/certificate/Certificate.h>
@@ -51,6 +52,27 @@ public:
 	 **/
 	void decrypt(Certificate &certificate, PrivateKey &privateKey, std::ostream *out)
 			throw (Pkcs7Exception);
+
+	/**
+	 * Decifra um pacote envelopado lido de um stream, colocando o resultado no stream de saída.
+	 * O pacote não é carregado em memória: apenas o cabeçalho e os destinatários são decodificados,
+	 * e o conteúdo cifrado é decifrado à medida que é lido. Aceita pacotes codificados em DER ou em
+	 * BER com comprimentos indefinidos, como os gerados por Pkcs7Builder::doFinal(std::istream*, std::ostream*, Pkcs7Builder::Encoding, unsigned int).
+	 * @param in stream com o pacote envelopado, em binário.
+	 * @param certificate o certificado contendo a chave ou uma das chaves que cifraram o pacote.
+	 * @param privateKey a chave privada correspondente ao certificado.
+	 * @param out o stream de saída onde será colocado o resultado da decifragem.
+	 * @throw Pkcs7Exception caso o pacote seja inválido ou não possa ser decifrado.
+	 **/
+	static void decrypt(std::istream *in, Certificate &certificate, PrivateKey &privateKey, std::ostream *out)
+			throw (Pkcs7Exception);
+
+protected:
+
+	/*
+	 * Copia o conteúdo decifrado de p7bio para out, verificando o padding ao final.
+	 */
+	static bool extract(BIO *p7bio, std::ostream *out);
 };
 
 #endif /*PKCS7ENVELOPEDDATA_H_*/
@@ -8,6 +8,7 @@
 #include "SymmetricCipher.h"
 #include "Pkcs7Builder.h"
 #include "Pkcs7EnvelopedData.h"
+#include "ThreadPool.h"
 
 #include <libcryptosec/exception/Pkcs7Exception.h>
 #include <libcryptosec/exception/InvalidStateException.h>
@@ -68,6 +69,17 @@ public:
 	 **/		
 	void addCipher(Certificate &certificate) throw (InvalidStateException, Pkcs7Exception);
 	
+	/**
+	 * Define o ThreadPool usado para cifrar a chave de conteúdo para os destinatários em paralelo.
+	 * O conteúdo é sempre cifrado uma única vez; com um ThreadPool definido, a cifragem da chave
+	 * de conteúdo com a chave pública de cada destinatário é distribuída entre as threads, o que
+	 * reduz o tempo de pacotes com muitos destinatários. Aplica-se a update() e às versões de
+	 * doFinal() que recebem os dados em memória.
+	 * @param pool ThreadPool a ser usado, ou NULL para cifrar sequencialmente dentro de PKCS7_dataInit().
+	 * O ThreadPool não passa a pertencer ao builder.
+	 **/
+	void setThreadPool(ThreadPool *pool);
+
 	/**
 	 * Especifica o uso das funções da superclasse Pkcs7Builder::doFinal(), recebendo um inputstream e
 	 * um outputstream como parâmetros. 
@@ -103,7 +115,19 @@ public:
 	 **/
 	Pkcs7EnvelopedData* doFinal(ByteArray &data)
 			throw (InvalidStateException, Pkcs7Exception);
-			
+
+protected:
+
+	/**
+	 * Cifra a chave de conteúdo para os destinatários em paralelo quando há um ThreadPool definido.
+	 * @see Pkcs7Builder::dataInit()
+	 **/
+	virtual BIO* dataInit();
+
+	/**
+	 * ThreadPool usado na cifragem da chave de conteúdo, ou NULL.
+	 **/
+	ThreadPool *pool;
 };
 
 #endif /*PKCS7ENVELOPEDDATABUILDER_H_*/
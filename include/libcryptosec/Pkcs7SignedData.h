@@ -6,7 +6,9 @@
 #include <libcryptosec/certificate/CertPathValidator.h>
 #include <libcryptosec/certificate/ValidationFlags.h>
 #include <libcryptosec/certificate/CertificateRevocationList.h>
+#include <libcryptosec/certificate/CertificateStore.h>
 #include "Pkcs7.h"
+#include "StreamBio.h"
 #include <libcryptosec/exception/Pkcs7Exception.h>
 
 /**
@@ -49,6 +51,15 @@ public:
 	 * @return a lista de certificados que assinaram o documento.
 	 **/
 	std::vector<Certificate *> getCertificates();
+
+	/**
+	 * Busca o certificado de cada signatário pelo emissor e número de série do SignerInfo,
+	 * primeiro em store, com custo constante, e depois entre os certificados anexados ao pacote.
+	 * @param store repositório de certificados.
+	 * @return um certificado por signatário, na ordem dos SignerInfo, ou NULL para os signatários
+	 * cujo certificado não foi encontrado. Os certificados retornados devem ser deletados.
+	 **/
+	std::vector<Certificate *> getSigners(const CertificateStore &store);
 	
 	
 	/**
@@ -75,6 +86,46 @@ public:
 	bool verify(bool checkSignerCert = false, vector<Certificate> trusted = vector<Certificate>(), CertPathValidatorResult **cpvr = NULL, vector<ValidationFlags>
 		flags = vector<ValidationFlags>());
 	
+	/**
+	 * Verifica a assinatura e/ou a integridade de um pacote PKCS7 cujo conteúdo não está
+	 * anexado. O conteúdo é resumido em uma única passagem, sem ser mantido em memória.
+	 * @param content stream com o conteúdo assinado, lido até o fim.
+	 * @param checkSignerCert true para verificar as assinaturas do pacote, false caso contrário
+	 * @param trusted certificados confiáveis
+	 * @param cpvr objeto resultado da verificação das assinaturas
+	 * @param flags opções de validação (ver CertPathValidator::ValidationFlags)
+	 * @return true se o pacote é íntegro e/ou suas assinaturas são válidas
+	 * @throw Pkcs7Exception caso a estrutura PKCS7 seja inválida ou o conteúdo não possa ser lido.
+	 **/
+	bool verifyDetached(std::istream *content, bool checkSignerCert = false, vector<Certificate> trusted = vector<Certificate>(),
+			CertPathValidatorResult **cpvr = NULL, vector<ValidationFlags> flags = vector<ValidationFlags>())
+			throw (Pkcs7Exception);
+
+	/**
+	 * Verifica a assinatura e/ou a integridade de um pacote PKCS7 cujo conteúdo não está
+	 * anexado, sendo o conteúdo uma região de memória, que não é copiada.
+	 * @param content início do conteúdo assinado.
+	 * @param size tamanho do conteúdo em bytes.
+	 * @see Pkcs7SignedData::verifyDetached(std::istream*, bool, vector<Certificate>, CertPathValidatorResult**, vector<ValidationFlags>)
+	 **/
+	bool verifyDetached(const unsigned char *content, size_t size, bool checkSignerCert = false,
+			vector<Certificate> trusted = vector<Certificate>(), CertPathValidatorResult **cpvr = NULL,
+			vector<ValidationFlags> flags = vector<ValidationFlags>())
+			throw (Pkcs7Exception);
+
+	/**
+	 * Verifica a assinatura e/ou a integridade de um pacote PKCS7 cujo conteúdo não está
+	 * anexado, sendo o conteúdo um arquivo. Arquivos regulares são mapeados em memória;
+	 * os demais são lidos sequencialmente.
+	 * @param path caminho do arquivo com o conteúdo assinado.
+	 * @throw Pkcs7Exception caso a estrutura PKCS7 seja inválida ou o arquivo não possa ser lido.
+	 * @see Pkcs7SignedData::verifyDetached(std::istream*, bool, vector<Certificate>, CertPathValidatorResult**, vector<ValidationFlags>)
+	 **/
+	bool verifyDetachedFile(std::string const &path, bool checkSignerCert = false,
+			vector<Certificate> trusted = vector<Certificate>(), CertPathValidatorResult **cpvr = NULL,
+			vector<ValidationFlags> flags = vector<ValidationFlags>())
+			throw (Pkcs7Exception);
+
 	/*
 	 * Função callback de tratamento de erro de validação de assinaturas
 	 * @param ok resultado da verificação
@@ -94,6 +145,12 @@ public:
 	bool verifyAndExtract(std::ostream *out) throw (Pkcs7Exception);
 	
 protected:
+	/*
+	 * Verifica o pacote sobre o conteúdo lido de content, ou sobre o conteúdo anexado se content for NULL.
+	 */
+	bool verifyContent(BIO *content, bool checkSignerCert, vector<Certificate> &trustedCerts,
+			CertPathValidatorResult **cpvr, vector<ValidationFlags> &vflags);
+
 	static CertPathValidatorResult cpvr; 
 };
 
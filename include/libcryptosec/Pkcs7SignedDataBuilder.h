@@ -5,6 +5,7 @@
 
 #include "Pkcs7SignedData.h"
 #include "MessageDigest.h"
+#include "ThreadPool.h"
 
 #include <libcryptosec/certificate/Certificate.h>
 
@@ -83,6 +84,17 @@ public:
 	*/
 	void addCrl(CertificateRevocationList &crl) throw (Pkcs7Exception, InvalidStateException);
 	
+	/**
+	 * Define o ThreadPool usado para gerar as assinaturas dos signatários em paralelo.
+	 * O conteúdo é resumido uma única vez por algoritmo de resumo distinto; em seguida cada
+	 * signatário assina o resumo correspondente em uma tarefa do ThreadPool.
+	 * A assinatura paralela é aplicada por doFinal() e pela versão em stream de doFinal() para
+	 * pacotes sem conteúdo anexado.
+	 * @param pool ThreadPool a ser usado, ou NULL para assinar sequencialmente dentro de PKCS7_dataFinal().
+	 * O ThreadPool não passa a pertencer ao builder.
+	 **/
+	void setThreadPool(ThreadPool *pool);
+
 	/**
 	 * Especifica o uso das funções da superclasse Pkcs7Builder::doFinal(), recebendo um inputstream e
 	 * um outputstream como parâmetros. 
@@ -120,6 +132,19 @@ public:
 			
 	Pkcs7SignedData* doFinal(ByteArray &data)
 			throw (InvalidStateException, Pkcs7Exception);
+
+protected:
+
+	/**
+	 * Gera as assinaturas em paralelo quando há um ThreadPool definido.
+	 * @see Pkcs7Builder::dataFinal()
+	 **/
+	virtual int dataFinal();
+
+	/**
+	 * ThreadPool usado na geração das assinaturas, ou NULL.
+	 **/
+	ThreadPool *pool;
 };
 
 #endif /*PKCS7SIGNEDDATABUILDER_H_*/
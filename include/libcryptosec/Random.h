@@ -14,11 +14,24 @@
  * Esta classe possui apenas métodos estáticos.
  * Antes de gerar dados randômicos deve-se semear o GNA com dados a partir de qualquer fonte.
  * Esta pode ser um arquivo, bytes randômicos ou dados fornecidos por um hardware (através de uma engine). 
+ *
+ * Cada thread possui seu próprio DRBG (CTR-DRBG com AES-256, semeado a partir do DRBG principal do OpenSSL)
+ * e um buffer de Random::BUFFER_SIZE bytes, de modo que pedidos pequenos, como nonces e IVs, não disputam
+ * o gerador global nem alocam memória. Bytes entregues são apagados do buffer. Após um fork(), o processo
+ * filho descarta o buffer e cria um novo DRBG. Com uma engine de números aleatórios configurada, ou com
+ * OpenSSL anterior a 3.0, os bytes vêm de RAND_bytes().
+ * O método RAND do OpenSSL é consultado apenas ao criar o estado da thread, em reseed() e após
+ * methodChanged(), pois RAND_get_rand_method() trava o lock global do gerador.
  */
 class Random
 {
 public:
 
+	/**
+	 * Tamanho, em bytes, do buffer de cada thread. Pedidos maiores são gerados diretamente no destino.
+	 */
+	static const unsigned int BUFFER_SIZE = 4096;
+
 	/**
 	 * Gera bytes randômicos.
 	 * @param nbytes quantidade de bytes a ser gerada.
@@ -27,6 +40,42 @@ public:
 	 */
 	static ByteArray bytes(int nbytes) throw (RandomException);
 	
+	/**
+	 * Preenche uma região de memória com bytes randômicos, usando o gerador da thread corrente.
+	 * @param data região a ser preenchida.
+	 * @param size tamanho da região em bytes.
+	 * @throw RandomException caso o gerador não possa ser criado ou semeado.
+	 */
+	static void fillInto(unsigned char *data, size_t size) throw (RandomException);
+
+	/**
+	 * Preenche todo o ByteArray com bytes randômicos, sem realocá-lo.
+	 * @param buffer ByteArray a ser preenchido.
+	 * @throw RandomException caso o gerador não possa ser criado ou semeado.
+	 */
+	static void fillInto(ByteArray &buffer) throw (RandomException);
+
+	/**
+	 * Define a política de renovação da semente dos geradores das threads.
+	 * @param bytes quantidade de bytes gerados por uma thread após a qual seu DRBG é ressemeado a partir
+	 * do DRBG principal. Se 0 (padrão), valem apenas os limites do próprio DRBG.
+	 */
+	static void setReseedInterval(unsigned long bytes);
+
+	/**
+	 * Ressemeia o gerador da thread corrente a partir do DRBG principal e descarta os bytes em buffer.
+	 * Também consulta novamente o método RAND do OpenSSL.
+	 * @throw RandomException caso o gerador não possa ser semeado.
+	 */
+	static void reseed() throw (RandomException);
+
+	/**
+	 * Faz com que todas as threads consultem novamente o método RAND do OpenSSL no próximo pedido,
+	 * descartando seus buffers. Engines::setEngineDefault() e DynamicEngine::load() já o chamam; deve ser
+	 * chamado após trocar o método por outros meios, como RAND_set_rand_method() ou ENGINE_set_default().
+	 */
+	static void methodChanged();
+
 	/**
 	 * Gera bytes pseudo-randômicos.
 	 * @param nbytes quantidade de bytes a ser gerada.
@@ -17,18 +17,29 @@
  */
 class SecretSharer {
 public:
+	/**
+	 * format of the parts
+	 */
+	enum Format
+	{
+		LEGACY, /*!< polynomials over the prime field 65521 (or xor when parts == threshold), read and written byte by byte */
+		GF256, /*!< polynomials over GF(2^8) with log/exp tables and block I/O; at most 255 parts */
+	};
+
 	/**
 	 * share a secret in parts and threshold parts is necessary to recover
 	 * @param data input of data, the secret
 	 * @param parts number of parts that the secret will be shared
 	 * @param threshold minimal number of parts to recover the secret
 	 * @param secrets vector of ostream that will be wrote the pieces of the parts
+	 * @param format format of the parts. The same format must be given to join
 	 * @throws InvalidNumberOfPartsException
 	 * @throws InvalidNumberOfThresholdException
 	 * @throws InvalidRandomDataSourceException
 	 * @throws SecretSharerInternalErrorException
 	 */
-	static void split(std::istream *data, int parts, int threshold, std::vector<std::ostream*> *secrets)
+	static void split(std::istream *data, int parts, int threshold, std::vector<std::ostream*> *secrets,
+			SecretSharer::Format format = SecretSharer::LEGACY)
 		throw (SecretSharerException, RandomException);
 	
 	/**
@@ -37,12 +48,14 @@ public:
 	 * @param parts number of parts that the secret was split
 	 * @param threshold value of threshold set on split
 	 * @param secret output stream that will be wrote the secret
+	 * @param format format used on split. With GF256 any threshold of the parts may be given, in any order
 	 * @throws InvalidNumberOfPartsException
 	 * @throws InvalidNumberOfThresholdException
 	 * @throws SecretSharerInternalErrorException
 	 */
 	
-	static void join(std::vector<std::istream* > *secrets, unsigned int parts, unsigned int threshold, std::ostream *secret)
+	static void join(std::vector<std::istream* > *secrets, unsigned int parts, unsigned int threshold, std::ostream *secret,
+			SecretSharer::Format format = SecretSharer::LEGACY)
 		throw (SecretSharerException);
 private:
 
@@ -78,5 +91,10 @@ private:
 	static void assemble_poly(std::vector<std::istream *>* secrets, unsigned int *seq, unsigned int threshold, std::ostream *secret)
 			throw (SecretSharerException);
 	static void assemble_xor(std::vector<std::istream *>* secrets, unsigned int parts, std::ostream *secret);
+
+	static void split_gf256(std::istream *data, int parts, int threshold, std::vector<std::ostream *>* secrets)
+			throw (RandomException, SecretSharerException);
+	static void assemble_gf256(std::vector<std::istream *>* secrets, unsigned int threshold, std::ostream *secret)
+			throw (SecretSharerException);
 };
 #endif /*SECRETSHARER_H_*/
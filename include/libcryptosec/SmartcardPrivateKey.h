@@ -0,0 +1,76 @@
+#ifndef SMARTCARDPRIVATEKEY_H_
+#define SMARTCARDPRIVATEKEY_H_
+
+#include <string>
+
+#include "PrivateKey.h"
+
+class SmartcardSlot;
+
+/**
+ * Representa uma chave privada armazenada em um smart card ou HSM PKCS#11.
+ * As operações com a chave são executadas pelo token, por meio da estrutura EVP_PKEY
+ * fornecida pela libp11, que mantém o handle do objeto PKCS#11 já resolvido. A chave pode
+ * ser usada em Signer, CertificateBuilder::sign() e Pkcs7SignedDataBuilder como qualquer
+ * outra PrivateKey, mas não pode ser exportada.
+ * Deve ser obtida por SmartcardSlot::getPrivateKey(), e o SmartcardSlot de origem deve
+ * permanecer válido enquanto a chave for usada, pois é ele que mantém a sessão autenticada.
+ * Enquanto a chave existir, o SmartcardSlot recusa, com SmartcardModuleException::SESSION_IN_USE,
+ * as operações que encerrariam essa sessão (login com outro PIN, logout() e refresh()).
+ * @see SmartcardSlot
+ * @ingroup SmartCard
+ **/
+
+class SmartcardPrivateKey : public PrivateKey
+{
+
+public:
+
+	/**
+	 * Construtor para uso interno, uma vez que as chaves são obtidas de smart cards.
+	 * @param key ponteiro para a estrutura EVP_PKEY da libp11, que passa a pertencer ao objeto.
+	 * @param id o identificador da chave no smart card.
+	 * @param serial o serial do token.
+	 * @param slot o SmartcardSlot que mantém a sessão da chave, notificado na destruição da chave.
+	 * @throw AsymmetricKeyException caso a estrutura EVP_PKEY não seja uma chave válida.
+	 **/
+	SmartcardPrivateKey(EVP_PKEY *key, std::string &id, std::string &serial, SmartcardSlot *slot = NULL)
+			throw (AsymmetricKeyException);
+
+	/**
+	 * Destrutor padrão. Libera a sessão do SmartcardSlot de origem.
+	 **/
+	virtual ~SmartcardPrivateKey();
+
+	/**
+	 * Retorna o identificador da chave.
+	 * @return o identificador da chave no smart card, em hexadecimal.
+	 **/
+	std::string getId();
+
+	/**
+	 * Retorna o serial do token que contém a chave.
+	 * @return o serial do token.
+	 **/
+	std::string getSerial();
+
+private:
+
+	/**
+	 * Identificador da chave no smart card.
+	 **/
+	std::string id;
+
+	/**
+	 * Serial do token.
+	 **/
+	std::string serial;
+
+	/**
+	 * SmartcardSlot de origem, ou NULL.
+	 **/
+	SmartcardSlot *slot;
+
+};
+
+#endif /*SMARTCARDPRIVATEKEY_H_*/
@@ -2,17 +2,32 @@
 #define SMARTCARDSLOT_H_
 
 #include <libp11.h>
+#include <pthread.h>
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "ByteArray.h"
 #include "SmartcardCertificate.h"
+#include "SmartcardPrivateKey.h"
 #include <libcryptosec/exception/SmartcardModuleException.h>
 
 /**
  * Representa um slot PKCS#11.
  * Esta classe implementa um slot (instância lógica de uma leitora), conforme definido
  * no padrão PKCS#11. 
+ * A sessão autenticada aberta por decrypt() ou getPrivateKey() é mantida e reutilizada pelas chamadas
+ * seguintes com o mesmo PIN, assim como os handles das chaves e certificados do token, que são
+ * enumerados uma única vez. A sessão permanece autenticada até logout() ou a destruição do objeto,
+ * ou até uma chamada com outro PIN.
+ * Um mesmo objeto pode ser usado por várias threads, mas a libp11 mantém uma única sessão por slot:
+ * as chamadas a decrypt() são serializadas, e o ganho está em evitar o login e a enumeração a cada
+ * operação, não em executá-las em paralelo.
+ * As chaves obtidas por getPrivateKey() dependem da sessão autenticada: enquanto existir alguma
+ * SmartcardPrivateKey obtida do objeto, as operações que encerrariam a sessão (decrypt() ou
+ * getPrivateKey() com outro PIN, logout() e refresh()) lançam SmartcardModuleException com o código
+ * SESSION_IN_USE, em vez de invalidar as chaves em uso.
  * @ingroup SmartCard
  **/
 
@@ -29,7 +44,7 @@ public:
 	SmartcardSlot(PKCS11_SLOT *slot);
 	
 	/**
-	 * Destrutor padrão, limpa a estrutura interna OpenSSL.
+	 * Destrutor padrão. Encerra a sessão autenticada, se houver.
 	 **/
 	virtual ~SmartcardSlot();
 	
@@ -47,6 +62,7 @@ public:
 	
 	/**
 	 * Retorna um vetor contendo todos os certificados relacionados ao slot.
+	 * Os certificados são lidos do token apenas na primeira chamada.
 	 * @return lista de certificados encontrados no slot.
 	 * @throw SmartcardModuleException caso tenha ocorrido um erro na carga dos certificados.
 	 */
@@ -55,6 +71,7 @@ public:
 	
 	/**
 	 * Usa a chave privada contida no slot para realizar a decifragem de dados.
+	 * O login é feito apenas se não houver sessão autenticada com o mesmo PIN.
 	 * @param keyId o id da chave a ser utilizada.
 	 * @param pin o PIN para permitir execução da operação.
 	 * @param data referência para os dados a serem decifrados.
@@ -63,18 +80,149 @@ public:
 	 * 	@li @c ENUMERATING_PRIVATE_KEYS quando a chave privada não for encontrada;
 	 * 	@li @c ID_NOT_FOUND quando o id da chave informado for inválido;
 	 * 	@li @c DECRYPTING_DATA quando tiver ocorrido um erro na decifragem;
-	 * 	@li @c BLOCKED_PIN quando o PIN da chave estiver no estado bloqueado.
+	 * 	@li @c BLOCKED_PIN quando o PIN da chave estiver no estado bloqueado;
+	 * 	@li @c SESSION_IN_USE quando o PIN for outro e houver chaves obtidas por getPrivateKey() em uso.
 	 */
 	ByteArray decrypt(std::string &keyId, std::string &pin, ByteArray &data)
 			throw (SmartcardModuleException);
 
+	/**
+	 * Retorna a chave privada do slot para uso em assinaturas e demais operações executadas pelo token.
+	 * A chave é resolvida uma única vez por sessão; chamadas seguintes com o mesmo id retornam
+	 * referências para a mesma estrutura.
+	 * @param keyId o id da chave a ser utilizada.
+	 * @param pin o PIN para permitir execução das operações.
+	 * @return a chave privada, que deve ser liberada pelo chamador antes do SmartcardSlot.
+	 * @throw SmartcardModuleException com os seguintes códigos de erro:
+	 * 	@li @c INVALID_PIN quando o PIN informado for inválido;
+	 * 	@li @c ENUMERATING_PRIVATE_KEYS quando a chave privada não puder ser carregada;
+	 * 	@li @c ID_NOT_FOUND quando o id da chave informado for inválido;
+	 * 	@li @c BLOCKED_PIN quando o PIN da chave estiver no estado bloqueado;
+	 * 	@li @c SESSION_IN_USE quando o PIN for outro e houver chaves obtidas anteriormente em uso.
+	 */
+	SmartcardPrivateKey* getPrivateKey(std::string &keyId, std::string &pin)
+			throw (SmartcardModuleException);
+
+	/**
+	 * Encerra a sessão autenticada mantida pelo slot, se houver, e descarta os handles
+	 * das chaves em cache. Não deve ser chamado enquanto outras threads executam operações no slot.
+	 * @throw SmartcardModuleException com o código SESSION_IN_USE quando houver chaves obtidas por
+	 * getPrivateKey() em uso.
+	 */
+	void logout() throw (SmartcardModuleException);
+
+	/**
+	 * Descarta os handles de chaves e certificados em cache, forçando uma nova enumeração
+	 * do token na próxima operação. Deve ser chamado quando o conteúdo do token for alterado,
+	 * e não enquanto outras threads executam operações no slot.
+	 * @throw SmartcardModuleException com o código SESSION_IN_USE quando houver chaves obtidas por
+	 * getPrivateKey() em uso.
+	 */
+	void refresh() throw (SmartcardModuleException);
+
 private:
 
+	SmartcardSlot(const SmartcardSlot &);
+	SmartcardSlot& operator=(const SmartcardSlot &);
+
+	friend class SmartcardPrivateKey;
+
+	/**
+	 * Garante uma sessão autenticada com o PIN informado. Deve ser chamado com mutex travado.
+	 * @throw SmartcardModuleException com os códigos INVALID_PIN, BLOCKED_PIN, SESSION_IN_USE ou UNKNOWN.
+	 */
+	void login(std::string &pin) throw (SmartcardModuleException);
+
+	/**
+	 * Retorna o handle da chave privada, enumerando as chaves do token se necessário.
+	 * Deve ser chamado com mutex travado.
+	 * @throw SmartcardModuleException com os códigos ENUMERATING_PRIVATE_KEYS ou ID_NOT_FOUND.
+	 */
+	PKCS11_KEY* getKey(std::string &keyId) throw (SmartcardModuleException);
+
+	/**
+	 * Descarta as chaves resolvidas por getPrivateKey(). Deve ser chamado com mutex travado.
+	 */
+	void clearPrivateKeys();
+
+	/**
+	 * Descarta todos os handles em cache (chaves, chaves privadas e certificados), que a libp11 libera
+	 * no login e no logout. Deve ser chamado com mutex travado.
+	 */
+	void clearHandles();
+
+	/**
+	 * Encerra a sessão autenticada e descarta os handles em cache. Deve ser chamado com mutex travado.
+	 */
+	void close();
+
+	/**
+	 * Chamado na destruição de uma SmartcardPrivateKey obtida por getPrivateKey().
+	 */
+	void releasePrivateKey();
+
+	/**
+	 * @return o id em hexadecimal maiúsculo, formato usado em SmartcardCertificate.
+	 */
+	static std::string encodeId(const unsigned char *id, size_t size);
+
+	/**
+	 * Deve ser chamado com mutex travado.
+	 * @return HMAC-SHA256 do PIN sob pinKey, mantido em lugar do PIN da sessão autenticada.
+	 * @throw SmartcardModuleException com o código UNKNOWN caso não seja possível gerar pinKey.
+	 */
+	ByteArray getPinDigest(std::string &pin) throw (SmartcardModuleException);
+
 	/**
 	 * Ponteiro para a estrutura OpenSSL que representa um slot.
 	 **/
 	PKCS11_SLOT *slot;
 
+	/**
+	 * Protege o estado da sessão e os handles em cache.
+	 **/
+	pthread_mutex_t mutex;
+
+	/**
+	 * Indica se há sessão autenticada aberta por este objeto.
+	 **/
+	bool loggedIn;
+
+	/**
+	 * HMAC do PIN usado na sessão autenticada.
+	 **/
+	ByteArray pinDigest;
+
+	/**
+	 * Chave aleatória do HMAC do PIN, gerada no primeiro login e própria de cada objeto.
+	 **/
+	ByteArray pinKey;
+
+	/**
+	 * Handles das chaves do token, indexados pelo id. Pertencem à libp11.
+	 **/
+	std::map<std::string, PKCS11_KEY *> keys;
+
+	/**
+	 * Chaves resolvidas por getPrivateKey(), indexadas pelo id.
+	 **/
+	std::map<std::string, EVP_PKEY *> privateKeys;
+
+	/**
+	 * Quantidade de SmartcardPrivateKey obtidas por getPrivateKey() e ainda não destruídas.
+	 **/
+	unsigned int privateKeysInUse;
+
+	/**
+	 * Handles dos certificados do token. Pertencem à libp11.
+	 **/
+	std::vector<PKCS11_CERT *> certificates;
+
+	/**
+	 * Indica se os certificados já foram enumerados.
+	 **/
+	bool certificatesLoaded;
+
 };
 
 #endif /*SMARTCARDSLOT_H_*/
@@ -0,0 +1,104 @@
+#ifndef STREAMBIO_H_
+#define STREAMBIO_H_
+
+#include <openssl/bio.h>
+#include <pthread.h>
+
+#include <istream>
+#include <ostream>
+
+/**
+ * @ingroup Util
+ */
+
+/**
+ * @brief Adapta std::istream e std::ostream para BIOs do OpenSSL.
+ * Permite que rotinas do OpenSSL leiam e escrevam diretamente nos streams, sem copiar
+ * o conteúdo inteiro para um BIO de memória. Os BIOs criados não assumem a posse dos streams,
+ * que devem permanecer válidos até que o BIO seja liberado com BIO_free_all().
+ */
+class StreamBio
+{
+public:
+
+	/**
+	 * Tamanho padrão, em bytes, dos buffers de leitura e escrita.
+	 */
+	static const unsigned int DEFAULT_BUFFER_SIZE = 65536;
+
+	/**
+	 * @brief Origem genérica de dados para StreamBio::newInput(StreamBio::Source*, unsigned int).
+	 */
+	class Source
+	{
+	public:
+		virtual ~Source() {}
+
+		/**
+		 * Lê até size bytes.
+		 * @return quantidade de bytes lidos, 0 no fim dos dados ou -1 em caso de erro.
+		 */
+		virtual int read(char *data, int size) = 0;
+	};
+
+	/**
+	 * Cria um BIO de leitura sobre um std::istream.
+	 * O BIO lê até o fim do stream; diferentemente de std::istream::readsome(), não retorna
+	 * fim de arquivo enquanto o stream ainda puder fornecer dados.
+	 * @param in stream de origem.
+	 * @param bufferSize tamanho do buffer de leitura. Se 0, o BIO não utiliza buffer.
+	 * @return BIO que deve ser liberado com BIO_free_all(), ou NULL em caso de erro.
+	 */
+	static BIO* newInput(std::istream *in, unsigned int bufferSize = StreamBio::DEFAULT_BUFFER_SIZE);
+
+	/**
+	 * Cria um BIO de leitura sobre uma região de memória, sem copiá-la.
+	 * Diferentemente de BIO_new_mem_buf(), aceita regiões maiores que 2 GB.
+	 * @param data início da região, que deve permanecer válida até que o BIO seja liberado.
+	 * @param size tamanho da região em bytes.
+	 * @return BIO que deve ser liberado com BIO_free_all(), ou NULL em caso de erro.
+	 */
+	static BIO* newInput(const unsigned char *data, size_t size);
+
+	/**
+	 * Cria um BIO de leitura sobre uma StreamBio::Source.
+	 * @param source origem dos dados, que não passa a pertencer ao BIO.
+	 * @param bufferSize tamanho do buffer de leitura. Se 0, o BIO não utiliza buffer.
+	 * @return BIO que deve ser liberado com BIO_free_all(), ou NULL em caso de erro.
+	 */
+	static BIO* newInput(StreamBio::Source *source, unsigned int bufferSize = StreamBio::DEFAULT_BUFFER_SIZE);
+
+	/**
+	 * Cria um BIO de escrita sobre um std::ostream.
+	 * Os dados são repassados ao stream à medida que o buffer enche e em BIO_flush().
+	 * @param out stream de destino.
+	 * @param bufferSize tamanho do buffer de escrita. Se 0, o BIO não utiliza buffer.
+	 * @return BIO que deve ser liberado com BIO_free_all(), ou NULL em caso de erro.
+	 */
+	static BIO* newOutput(std::ostream *out, unsigned int bufferSize = StreamBio::DEFAULT_BUFFER_SIZE);
+
+	/**
+	 * Copia todo o conteúdo de um BIO para outro, reutilizando um único buffer.
+	 * @param in BIO de origem.
+	 * @param out BIO de destino.
+	 * @param bufferSize tamanho do buffer de cópia.
+	 * @return true em caso de sucesso, false se ocorrer erro de leitura ou escrita.
+	 */
+	static bool copy(BIO *in, BIO *out, unsigned int bufferSize = StreamBio::DEFAULT_BUFFER_SIZE);
+
+private:
+	static BIO_METHOD* getInputMethod();
+	static BIO_METHOD* getOutputMethod();
+	static BIO_METHOD* getMemoryMethod();
+	static BIO_METHOD* getSourceMethod();
+	static void createMethods();
+	static BIO* push(BIO *sink, unsigned int bufferSize);
+
+	static pthread_once_t methodsOnce;
+	static BIO_METHOD *inputMethod;
+	static BIO_METHOD *outputMethod;
+	static BIO_METHOD *memoryMethod;
+	static BIO_METHOD *sourceMethod;
+};
+
+#endif /*STREAMBIO_H_*/
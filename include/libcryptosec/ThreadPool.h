@@ -0,0 +1,156 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <pthread.h>
+#include <vector>
+
+/**
+ * @ingroup Util
+ */
+
+/**
+ * @brief Conjunto fixo de threads para execução paralela de tarefas independentes.
+ * As threads são criadas no construtor e reaproveitadas a cada chamada de execute().
+ * A thread que chama execute() também executa tarefas, portanto um ThreadPool de tamanho 1
+ * executa tudo sequencialmente, sem criar threads.
+ * Um mesmo ThreadPool pode ser compartilhado; chamadas concorrentes a execute() são serializadas.
+ * Uma tarefa pode chamar execute() em qualquer ThreadPool, inclusive no que a executa ou em um que
+ * aguarda por ela: se o ThreadPool chamado já executa um lote, as tarefas aninhadas são executadas
+ * sequencialmente pela própria thread da tarefa; caso contrário, são distribuídas normalmente.
+ */
+class ThreadPool
+{
+public:
+
+	/**
+	 * @brief Tarefa a ser executada pelo ThreadPool.
+	 * Implementações devem sobrescrever run(). Exceções lançadas por run() são capturadas
+	 * pelo ThreadPool e a tarefa é marcada como falha (ver hasFailed()).
+	 */
+	class Task
+	{
+	public:
+		Task() : failed(false) {}
+		virtual ~Task() {}
+
+		/**
+		 * Executa a tarefa.
+		 */
+		virtual void run() = 0;
+
+		/**
+		 * Verifica se run() lançou exceção na última execução.
+		 * @return true se a tarefa falhou, false caso contrário.
+		 */
+		bool hasFailed() const
+		{
+			return this->failed;
+		}
+
+	private:
+		friend class ThreadPool;
+		bool failed;
+	};
+
+	/**
+	 * Construtor.
+	 * @param threads quantidade total de threads, incluindo a que chama execute().
+	 * Se 0, utiliza a quantidade de processadores disponíveis.
+	 * Caso o sistema não permita criar todas as threads, o ThreadPool opera com as que conseguiu criar.
+	 */
+	ThreadPool(unsigned int threads = 0);
+
+	/**
+	 * Destrutor.
+	 * Encerra e aguarda todas as threads.
+	 */
+	virtual ~ThreadPool();
+
+	/**
+	 * Executa todas as tarefas e retorna somente quando todas terminarem.
+	 * A ordem de execução não é definida. Quando chamado por uma tarefa de qualquer ThreadPool enquanto
+	 * este ThreadPool executa outro lote, executa as tarefas na thread corrente, em ordem, em vez de
+	 * aguardar o lote atual, que pode depender da tarefa chamadora.
+	 * @param tasks tarefas a serem executadas.
+	 */
+	void execute(std::vector<ThreadPool::Task*> &tasks);
+
+	/**
+	 * Obtem a quantidade de threads que executam tarefas, incluindo a que chama execute().
+	 * @return quantidade de threads.
+	 */
+	unsigned int getSize() const;
+
+	/**
+	 * Obtem a quantidade de processadores disponíveis no sistema.
+	 * @return quantidade de processadores, no mínimo 1.
+	 */
+	static unsigned int getProcessors();
+
+protected:
+	ThreadPool(const ThreadPool &);
+	ThreadPool& operator=(const ThreadPool &);
+
+	/**
+	 * Laço principal das threads do ThreadPool.
+	 */
+	static void* worker(void *pool);
+
+	/**
+	 * Retira e executa tarefas do lote atual até esgotá-lo.
+	 * Deve ser chamado com mutex travado; retorna com mutex travado.
+	 */
+	void runTasks();
+
+	/**
+	 * Executa uma tarefa, marcando-a como falha caso lance exceção.
+	 */
+	static void run(ThreadPool::Task *task);
+
+	/**
+	 * Threads criadas pelo ThreadPool.
+	 */
+	std::vector<pthread_t> threads;
+
+	/**
+	 * Protege o estado do lote atual.
+	 */
+	pthread_mutex_t mutex;
+
+	/**
+	 * Serializa chamadas concorrentes a execute().
+	 */
+	pthread_mutex_t executeMutex;
+
+	/**
+	 * Sinaliza às threads que há um novo lote ou que devem terminar.
+	 */
+	pthread_cond_t workCond;
+
+	/**
+	 * Sinaliza a execute() que todas as tarefas do lote terminaram.
+	 */
+	pthread_cond_t doneCond;
+
+	/**
+	 * Lote atual, NULL quando não há lote em execução.
+	 */
+	std::vector<ThreadPool::Task*> *tasks;
+
+	/**
+	 * Índice da próxima tarefa do lote a ser executada.
+	 */
+	unsigned int next;
+
+	/**
+	 * Quantidade de tarefas do lote ainda não concluídas.
+	 */
+	unsigned int pending;
+
+	/**
+	 * Indica às threads que devem terminar.
+	 */
+	bool stop;
+};
+
+#endif /*THREADPOOL_H_*/
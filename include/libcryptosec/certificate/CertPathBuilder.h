@@ -0,0 +1,126 @@
+#ifndef CERTPATHBUILDER_H_
+#define CERTPATHBUILDER_H_
+
+#include <pthread.h>
+#include <time.h>
+#include <map>
+#include <vector>
+
+#include "Certificate.h"
+#include "CertificateRevocationList.h"
+#include "CertificateStore.h"
+#include "CertPathValidator.h"
+#include "ValidationFlags.h"
+#include <libcryptosec/DateTime.h>
+
+/**
+ * @ingroup Util
+ */
+
+/**
+ * @brief Constrói caminhos de certificação a partir de um repositório de certificados
+ * intermediários, que pode conter certificados cruzados, até um repositório de certificados
+ * confiáveis.
+ * Os emissores candidatos de cada certificado são obtidos pelos índices de CertificateStore (ver
+ * CertificateStore::getIssuers()). São descartados os candidatos fora da validade, que não são de
+ * AC (extensões BasicConstraints e KeyUsage), cujo pathLenConstraint seria excedido, que já estão no
+ * caminho ou que não assinaram o certificado. Restrições de nomes e de políticas são deixadas para o
+ * CertPathValidator.
+ * As verificações de assinatura entre certificados dos repositórios e os caminhos encontrados a partir
+ * de cada intermediário são guardados e reaproveitados nas construções seguintes (os caminhos, apenas
+ * nas construções de um único caminho, como a primeira feita por verify()), de modo que um mesmo
+ * CertPathBuilder deve ser mantido entre requisições; pode ser usado por várias threads.
+ * Os repositórios devem existir enquanto o CertPathBuilder existir.
+ */
+class CertPathBuilder
+{
+public:
+	/**
+	 * Quantidade máxima de verificações de assinatura e de caminhos guardados; ao ser atingida, a
+	 * memória correspondente é esvaziada.
+	 */
+	static const unsigned int MAX_CACHED = 1 << 18;
+
+	/**
+	 * Construtor.
+	 * @param trusted certificados confiáveis, onde os caminhos terminam.
+	 * @param intermediates certificados intermediários.
+	 * @param maxPathLength quantidade máxima de certificados intermediários em um caminho.
+	 */
+	CertPathBuilder(const CertificateStore& trusted, const CertificateStore& intermediates, unsigned int maxPathLength = 8);
+	virtual ~CertPathBuilder();
+
+	/**
+	 * Busca caminhos de certificação para target.
+	 * @param target certificado para o qual se busca o caminho.
+	 * @param when momento do tempo para se considerar a validade dos certificados.
+	 * @param maxPaths quantidade máxima de caminhos retornados.
+	 * @return caminhos encontrados, dos mais curtos para os mais longos. Cada caminho contém os
+	 * certificados intermediários, a partir do emissor de target, e por último o certificado confiável;
+	 * é vazio se o próprio target é confiável. Os certificados pertencem aos repositórios.
+	 */
+	std::vector<std::vector<Certificate *> > build(const Certificate& target, DateTime when = DateTime(time(NULL)),
+			unsigned int maxPaths = 1);
+
+	/**
+	 * Busca até maxPaths caminhos de certificação para target e os valida com o CertPathValidator,
+	 * até que um deles seja válido. O caminho mais curto é construído e validado primeiro, como em
+	 * build() com um único caminho, reaproveitando os caminhos guardados; os demais só são construídos
+	 * se ele não for válido.
+	 * @param target certificado a ser validado.
+	 * @param path recebe o caminho válido, no formato de build().
+	 * @param when momento do tempo para se considerar a validade dos certificados.
+	 * @param crls LCRs, ver CertPathValidator::setCrls().
+	 * @param flags opções de validação.
+	 * @param maxPaths quantidade máxima de caminhos validados.
+	 * @return true se algum caminho é válido.
+	 */
+	bool verify(Certificate& target, std::vector<Certificate *>& path, DateTime when = DateTime(time(NULL)),
+			std::vector<CertificateRevocationList> crls = std::vector<CertificateRevocationList>(),
+			std::vector<ValidationFlags> flags = std::vector<ValidationFlags>(), unsigned int maxPaths = 4);
+
+protected:
+	/*
+	 * Estado de uma construção: o caminho corrente e os certificados que não levaram a um caminho,
+	 * com a quantidade de intermediários abaixo deles e quantos ainda cabiam acima.
+	 */
+	struct Search
+	{
+		time_t when;
+		unsigned int maxPaths;
+		std::vector<Certificate *> path;
+		std::vector<std::vector<Certificate *> > paths;
+		std::map<Certificate *, std::vector<std::pair<unsigned int, unsigned int> > > deadEnds;
+	};
+
+	bool validate(Certificate& target, std::vector<Certificate *>& path, DateTime& when,
+			std::vector<CertificateRevocationList>& crls, std::vector<ValidationFlags>& flags);
+	bool search(Search &search, const Certificate &current, Certificate *stored, unsigned int below,
+			unsigned int remaining);
+	bool isAcceptable(Search &search, Certificate *issuer, unsigned int below) const;
+	bool isSignedBy(const Certificate &current, Certificate *stored, Certificate *issuer);
+	bool isDeadEnd(Search &search, Certificate *certificate, unsigned int below, unsigned int remaining) const;
+	bool isInPath(Search &search, Certificate *certificate) const;
+	bool useCachedPath(Search &search, Certificate *certificate, unsigned int below, unsigned int remaining);
+	void addPath(Search &search, Certificate *anchor);
+
+	static bool isSelfIssued(Certificate *certificate);
+
+	const CertificateStore &trusted;
+	const CertificateStore &intermediates;
+	unsigned int maxPathLength;
+
+	/*
+	 * Resultado da verificação da assinatura de um certificado intermediário por outro, e caminho
+	 * até um certificado confiável a partir de cada intermediário, protegidos por mutex.
+	 */
+	std::map<std::pair<Certificate *, Certificate *>, bool> signatures;
+	std::map<Certificate *, std::vector<Certificate *> > cachedPaths;
+	pthread_mutex_t mutex;
+
+private:
+	CertPathBuilder(const CertPathBuilder& builder);
+	CertPathBuilder& operator =(const CertPathBuilder& builder);
+};
+
+#endif /*CERTPATHBUILDER_H_*/
@@ -6,12 +6,14 @@
 
 #include <vector>
 #include <string>
+#include <ostream>
 
 #include <libcryptosec/ByteArray.h>
 #include <libcryptosec/DateTime.h>
 #include <libcryptosec/MessageDigest.h>
 #include <libcryptosec/PrivateKey.h>
 #include <libcryptosec/PublicKey.h>
+#include <libcryptosec/ThreadPool.h>
 
 #include "Certificate.h"
 #include "CertificateRequest.h"
@@ -34,6 +36,114 @@
 class CertificateBuilder
 {
 public:
+	/**
+	 * @brief Campos próprios de um certificado emitido em lote por
+	 * CertificateBuilder::sign(std::vector<CertificateBuilder::Entry> const&, CertificateBuilder::Sink*, ...).
+	 * Os demais campos são os do builder.
+	 **/
+	class Entry
+	{
+	public:
+		/**
+		 * @param publicKeyInfo SubjectPublicKeyInfo do titular em DER, como obtido de uma requisição de
+		 * certificado ou de PublicKey::getDerEncoded(); é incluído no certificado sem decodificar a chave.
+		 **/
+		Entry(BigInteger serialNumber, RDNSequence subject, ByteArray publicKeyInfo) :
+				serialNumber(serialNumber), subject(subject), publicKey(NULL), publicKeyInfo(publicKeyInfo),
+				hasValidity(false)
+		{
+		}
+
+		/**
+		 * @param publicKey chave do titular, codificada pela thread que assina o certificado. Não é
+		 * copiada e deve existir até o fim da emissão.
+		 **/
+		Entry(BigInteger serialNumber, RDNSequence subject, PublicKey *publicKey) :
+				serialNumber(serialNumber), subject(subject), publicKey(publicKey), hasValidity(false)
+		{
+		}
+
+		/**
+		 * Define a validade do certificado, no lugar da validade do builder.
+		 **/
+		void setValidity(DateTime notBefore, DateTime notAfter)
+		{
+			this->notBefore = notBefore;
+			this->notAfter = notAfter;
+			this->hasValidity = true;
+		}
+
+		BigInteger serialNumber;
+		RDNSequence subject;
+		PublicKey *publicKey;
+		ByteArray publicKeyInfo;
+		bool hasValidity;
+		DateTime notBefore;
+		DateTime notAfter;
+	};
+
+	/**
+	 * @brief Destino dos certificados emitidos em lote.
+	 * Os métodos são chamados pela thread que chamou sign(), na ordem das entradas.
+	 **/
+	class Sink
+	{
+	public:
+		virtual ~Sink() {}
+
+		/**
+		 * Recebe um certificado emitido.
+		 * @param index posição da entrada no vetor de entrada.
+		 * @param der certificado em codificação DER.
+		 **/
+		virtual void write(unsigned int index, ByteArray &der) = 0;
+
+		/**
+		 * Recebe a falha na emissão de um certificado, como uma chave pública inválida. A
+		 * implementação padrão relança a exceção, interrompendo o lote.
+		 * @param index posição da entrada no vetor de entrada.
+		 * @param exception motivo da falha.
+		 **/
+		virtual void fail(unsigned int index, CertificationException &exception)
+		{
+			throw exception;
+		}
+	};
+
+	/**
+	 * @brief Escreve os certificados emitidos em lote em um stream, concatenados em DER ou em PEM.
+	 **/
+	class StreamSink : public Sink
+	{
+	public:
+		/**
+		 * @param out stream de saída. Não passa a pertencer ao StreamSink.
+		 * @param pem true para escrever em PEM, false para DER.
+		 **/
+		StreamSink(std::ostream *out, bool pem = true);
+		virtual ~StreamSink() {}
+
+		/**
+		 * @throw EncodeException se ocorrer erro de escrita no stream.
+		 **/
+		virtual void write(unsigned int index, ByteArray &der) throw (EncodeException);
+
+	protected:
+		std::ostream *out;
+		bool pem;
+	};
+
+	/**
+	 * @brief Resultado de uma emissão em lote.
+	 **/
+	struct Statistics
+	{
+		unsigned int issued; /*!< certificados entregues a Sink::write().*/
+		unsigned int failed; /*!< entradas entregues a Sink::fail().*/
+		double seconds; /*!< duração da emissão.*/
+		double certificatesPerSecond; /*!< certificados emitidos por segundo.*/
+	};
+
 	CertificateBuilder();
 	CertificateBuilder(std::string pemEncoded)
 			throw (EncodeException);
@@ -124,6 +234,34 @@ public:
 	std::vector<Extension *> getUnknownExtensions();
 	Certificate* sign(PrivateKey &privateKey, MessageDigest::Algorithm messageDigestAlgorithm)
 			throw (CertificationException, AsymmetricKeyException);
+
+	/**
+	 * Define o ThreadPool usado na emissão em lote.
+	 * @param pool ThreadPool a ser usado, ou NULL para emitir os certificados sequencialmente.
+	 * O ThreadPool não passa a pertencer ao builder.
+	 **/
+	void setThreadPool(ThreadPool *pool);
+
+	/**
+	 * Emite um certificado para cada entrada, usando o builder como modelo: versão, emissor, validade
+	 * e extensões são copiados uma única vez do builder, que não é alterado, e cada cópia recebe o
+	 * número de série, o titular, a chave pública e, se definida, a validade da entrada. Se o modelo
+	 * contém a extensão SubjectKeyIdentifier, ela é recalculada para cada certificado a partir da
+	 * chave pública (SHA-1, RFC 5280 4.2.1.2).
+	 * Os certificados são assinados no ThreadPool definido em setThreadPool(), em janelas de tamanho
+	 * proporcional ao ThreadPool, e entregues ao sink ao fim de cada janela.
+	 * @param entries campos de cada certificado.
+	 * @param sink destino dos certificados emitidos.
+	 * @param privateKey chave privada do emissor.
+	 * @param messageDigestAlgorithm algoritmo de resumo da assinatura.
+	 * @return quantidade de certificados emitidos e vazão da emissão.
+	 * @throw CertificationException se o modelo estiver incompleto, ou a exceção relançada por
+	 * CertificateBuilder::Sink::fail().
+	 * @throw EncodeException se lançada pelo sink.
+	 **/
+	CertificateBuilder::Statistics sign(std::vector<CertificateBuilder::Entry> const& entries,
+			CertificateBuilder::Sink *sink, PrivateKey &privateKey, MessageDigest::Algorithm messageDigestAlgorithm)
+			const throw (CertificationException, EncodeException);
 	X509* getX509() const;
 	CertificateBuilder& operator =(const CertificateBuilder& value);
 	bool isIncludeEcdsaParameters() const;
@@ -131,8 +269,15 @@ public:
 	void includeEcdsaParameters();
 
 protected:
+	/**
+	 * Algoritmo de resumo usado na assinatura: chaves EdDSA não usam resumo.
+	 **/
+	static MessageDigest::Algorithm getSignatureAlgorithm(PrivateKey &privateKey,
+			MessageDigest::Algorithm messageDigestAlgorithm);
+
 	X509 *cert;
 	bool includeECDSAParameters;
+	ThreadPool *pool;
 
 private:
 	int getCodification(RDNSequence& name);
@@ -0,0 +1,169 @@
+#ifndef CERTIFICATESTORE_H_
+#define CERTIFICATESTORE_H_
+
+#include <openssl/x509.h>
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include <libcryptosec/BigInteger.h>
+#include <libcryptosec/ByteArray.h>
+
+#include "Certificate.h"
+#include "RDNSequence.h"
+
+#include <libcryptosec/exception/CertificationException.h>
+
+/**
+ * @ingroup Util
+ */
+
+/**
+ * @brief Repositório de certificados em memória, indexado por nome do titular, identificador de
+ * chave do titular (SKI), emissor e número de série e impressão digital SHA-256.
+ * Cada índice é uma tabela hash, de modo que as consultas têm custo constante independente da
+ * quantidade de certificados armazenados.
+ * O repositório só cresce: os certificados adicionados permanecem válidos até sua destruição.
+ * As consultas não usam travas e podem ser feitas por várias threads concorrentemente com as
+ * inserções; as inserções são serializadas entre si. Em add(std::vector<Certificate>&) as chaves
+ * são calculadas fora da seção crítica.
+ * Os certificados ficam visíveis às consultas um a um, e cada certificado é publicado em um índice
+ * de cada vez: uma consulta concorrente a uma inserção pode ver apenas parte do lote, ou encontrar
+ * um certificado por um índice e ainda não pelos demais. Terminado add(), todos os certificados
+ * adicionados estão em todos os índices.
+ */
+class CertificateStore
+{
+public:
+	CertificateStore();
+	virtual ~CertificateStore();
+
+	/**
+	 * Adiciona o certificado. A estrutura X509 não é copiada, mas compartilhada por contagem de
+	 * referências, e não deve ser alterada depois de adicionada.
+	 * @param certificate certificado a ser adicionado.
+	 * @return false se um certificado com a mesma impressão digital já estava no repositório.
+	 * @throw CertificationException caso o certificado não possa ser codificado.
+	 */
+	bool add(const Certificate& certificate) throw (CertificationException);
+
+	/**
+	 * Adiciona um lote de certificados, como em add(const Certificate&).
+	 * @param certificates certificados a serem adicionados.
+	 * @return quantidade de certificados adicionados, descontados os repetidos.
+	 * @throw CertificationException caso algum certificado não possa ser codificado; nesse caso
+	 * nenhum certificado do lote é adicionado.
+	 */
+	unsigned int add(const std::vector<Certificate>& certificates) throw (CertificationException);
+	unsigned int add(const std::vector<Certificate *>& certificates) throw (CertificationException);
+
+	/**
+	 * Busca os certificados cujo titular é igual a subject, segundo RDNSequence::operator ==.
+	 * @return certificados encontrados, pertencentes ao repositório (não devem ser deletados).
+	 */
+	std::vector<Certificate *> getBySubject(const RDNSequence& subject) const;
+
+	/**
+	 * Busca os certificados com a extensão SubjectKeyIdentifier igual a keyIdentifier.
+	 * @return certificados encontrados, pertencentes ao repositório (não devem ser deletados).
+	 */
+	std::vector<Certificate *> getBySubjectKeyIdentifier(const ByteArray& keyIdentifier) const;
+
+	/**
+	 * Busca o certificado emitido por issuer com o número de série serialNumber.
+	 * @return certificado encontrado, pertencente ao repositório, ou NULL.
+	 */
+	Certificate* getByIssuerAndSerialNumber(const RDNSequence& issuer, const BigInteger& serialNumber) const;
+
+	/**
+	 * Busca o certificado pela impressão digital SHA-256 (ver Certificate::getFingerPrint()).
+	 * @return certificado encontrado, pertencente ao repositório, ou NULL.
+	 */
+	Certificate* getByFingerPrint(const ByteArray& fingerPrint) const;
+
+	/**
+	 * Busca os possíveis emissores de certificate: os certificados cujo SKI é igual ao
+	 * identificador de chave da extensão AuthorityKeyIdentifier de certificate e cujo titular é
+	 * igual ao emissor de certificate. Se certificate não tiver o identificador de chave do
+	 * emissor, a busca é feita apenas pelo nome. As assinaturas não são verificadas.
+	 * @return certificados encontrados, pertencentes ao repositório (não devem ser deletados).
+	 */
+	std::vector<Certificate *> getIssuers(const Certificate& certificate) const;
+
+	/**
+	 * Verifica se um certificado com a mesma impressão digital está no repositório.
+	 */
+	bool contains(const Certificate& certificate) const;
+
+	/**
+	 * @return todos os certificados, na ordem em que foram adicionados.
+	 */
+	std::vector<Certificate *> getCertificates() const;
+
+	/**
+	 * @return quantidade de certificados no repositório.
+	 */
+	unsigned int size() const;
+
+private:
+	enum Index
+	{
+		SUBJECT = 0,
+		SUBJECT_KEY_IDENTIFIER = 1,
+		ISSUER_AND_SERIAL_NUMBER = 2,
+		FINGERPRINT = 3,
+	};
+	static const int INDEXES = 4;
+
+	struct Node
+	{
+		size_t hash;
+		std::string key;
+		Certificate *certificate;
+		Node *next;
+	};
+
+	/*
+	 * Tabela de um índice. Ao crescer, uma nova tabela é publicada e a anterior é mantida em
+	 * retired até a destruição do repositório, pois pode estar sendo percorrida por uma consulta.
+	 */
+	struct Table
+	{
+		size_t mask;
+		size_t count;
+		Node **buckets;
+		Table *retired;
+	};
+
+	/*
+	 * Certificado a ser inserido com as chaves de cada índice; uma chave vazia não é indexada.
+	 */
+	struct Entry
+	{
+		Entry() : certificate(NULL) {}
+		Certificate *certificate;
+		std::string keys[INDEXES];
+	};
+
+	CertificateStore(const CertificateStore& store);
+	CertificateStore& operator =(const CertificateStore& store);
+
+	static void newEntry(const Certificate& certificate, Entry &entry) throw (CertificationException);
+	static void deleteEntries(std::vector<Entry>& entries);
+	static std::string getIssuerAndSerialNumberKey(const std::string& issuer, ASN1_INTEGER *serialNumber);
+	static size_t getHash(const std::string& key);
+	static Table* newTable(size_t buckets);
+
+	unsigned int insert(std::vector<Entry>& entries);
+	void link(Index index, const std::string& key, Certificate *certificate);
+	std::vector<Certificate *> find(Index index, const std::string& key) const;
+	Certificate* findFirst(Index index, const std::string& key) const;
+
+	Table *tables[INDEXES];
+	std::vector<Certificate *> certificates;
+	unsigned int count;
+	mutable pthread_mutex_t mutex;
+};
+
+#endif /*CERTIFICATESTORE_H_*/
@@ -8,10 +8,18 @@
 
 #include <libcryptosec/exception/CertificationException.h>
 
+/**
+ * @brief Identificador de objeto (OID).
+ * Instâncias obtidas de ObjectIdentifierFactory compartilham o ASN1_OBJECT registrado na fábrica,
+ * que é imutável: cópias e atribuições copiam apenas o ponteiro.
+ */
 class ObjectIdentifier
 {
 public:
 	ObjectIdentifier();
+	/**
+	 * @param asn1Object objeto que passa a pertencer ao ObjectIdentifier.
+	 */
 	ObjectIdentifier(ASN1_OBJECT *asn1Object);
 	ObjectIdentifier(const ObjectIdentifier& objectIdentifier);
 	virtual ~ObjectIdentifier();
@@ -23,8 +31,22 @@ public:
 	std::string getName();
 	ASN1_OBJECT* getObjectIdentifier() const;
 	ObjectIdentifier& operator =(const ObjectIdentifier& value);
+	/**
+	 * Compara os ponteiros e, se diferentes, a codificação dos OIDs.
+	 */
+	bool operator ==(const ObjectIdentifier& value) const;
+	bool operator !=(const ObjectIdentifier& value) const;
 protected:
 	ASN1_OBJECT *asn1Object;
+	/**
+	 * true se asn1Object pertence a ObjectIdentifierFactory e não deve ser liberado.
+	 */
+	bool shared;
+
+private:
+	ObjectIdentifier(ASN1_OBJECT *asn1Object, bool shared);
+
+	friend class ObjectIdentifierFactory;
 };
 
 #endif /*OBJECTIDENTIFIER_H_*/
@@ -2,20 +2,51 @@
 #define OBJECTIDENTIFIERFACTORY_H_
 
 #include <openssl/objects.h>
+#include <pthread.h>
+
+#include <map>
+#include <string>
 
 #include "ObjectIdentifier.h"
 
 #include <libcryptosec/exception/CertificationException.h>
 
+/**
+ * @brief Cria ObjectIdentifiers a partir da notação com pontos, de NIDs e de ASN1_OBJECTs.
+ * Cada OID é convertido uma única vez: os ASN1_OBJECT resultantes ficam registrados na fábrica até o
+ * fim do processo e são compartilhados, sem cópia, por todos os ObjectIdentifiers que os utilizam.
+ */
 class ObjectIdentifierFactory
 {
 public:
+	/**
+	 * Máximo de OIDs em notação com pontos registrados. Além deste limite, cada chamada converte o OID
+	 * novamente e retorna um ObjectIdentifier com cópia própria.
+	 */
+	static const unsigned int MAX_REGISTERED = 4096;
+
 	static ObjectIdentifier getObjectIdentifier(std::string oid)
 			throw (CertificationException);
 	static ObjectIdentifier getObjectIdentifier(int nid)
 		throw (CertificationException);
+	/**
+	 * Obtém o ObjectIdentifier de um objeto lido de uma estrutura do OpenSSL.
+	 * OIDs conhecidos pelo OpenSSL são compartilhados; os demais são copiados.
+	 * @param asn1Object objeto, que continua pertencendo ao chamador. Se NULL, retorna um ObjectIdentifier vazio.
+	 */
+	static ObjectIdentifier getObjectIdentifier(const ASN1_OBJECT *asn1Object)
+		throw (CertificationException);
 	static ObjectIdentifier createObjectIdentifier(std::string oid, std::string name)
 			throw (CertificationException);
+
+private:
+	/**
+	 * Objeto registrado para oid, ou NULL se o registro estiver cheio.
+	 */
+	static ASN1_OBJECT* getRegistered(std::string const& oid);
+
+	static pthread_mutex_t mutex;
+	static std::map<std::string, ASN1_OBJECT*> *registered;
 };
 
 #endif /*OBJECTIDENTIFIERFACTORY_H_*/
@@ -7,6 +7,9 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#if __cplusplus >= 201103L
+#include <functional>
+#endif
 
 #include <libcryptosec/ByteArray.h>
 #include "ObjectIdentifier.h"
@@ -51,11 +54,54 @@ public:
 	std::vector<std::pair<ObjectIdentifier, std::string> > getEntries() const;
 	X509_NAME* getX509Name();
 	RDNSequence& operator =(const RDNSequence& value);
+
+	/**
+	 * Forma canônica do nome, calculada à medida que as entradas são adicionadas: para cada RDN, a
+	 * quantidade de entradas e, em ordem, a codificação de cada entrada: o OID em DER e o valor em UTF-8
+	 * sem espaços nas pontas, com sequências de espaços reduzidas a um e letras ASCII em minúsculas,
+	 * segundo as regras de comparação de nomes da RFC 5280. Cada entrada adicionada por addEntry() forma
+	 * um RDN; nos nomes lidos de um X509_NAME, as entradas de um RDN com vários valores (CN=a+O=b)
+	 * permanecem juntas.
+	 */
+	const std::string& getCanonical() const;
+
+	/**
+	 * Hash da forma canônica, derivado de SHA-256 com uma chave aleatória do processo e calculado na
+	 * primeira chamada após a última alteração do nome.
+	 * Nomes iguais segundo operator == têm o mesmo hash.
+	 */
+	size_t getHash() const;
+
+	/**
+	 * Compara as formas canônicas: a ordem dos RDNs é significativa, a ordem das entradas de um mesmo
+	 * RDN, maiúsculas e espaços não.
+	 */
+	bool operator ==(const RDNSequence& value) const;
+	bool operator !=(const RDNSequence& value) const;
+
+	/**
+	 * Função de hash para std::unordered_map<RDNSequence, T, RDNSequence::Hash> e contêineres similares.
+	 */
+	struct Hash
+	{
+		size_t operator()(const RDNSequence& value) const
+		{
+			return value.getHash();
+		}
+	};
 protected:
 //	std::map<EntryType, std::vector<std::string> > entries;
 //	std::vector<std::pair<std::string, std::string> > unknownEntries;
 	
 	std::vector<std::pair<ObjectIdentifier, std::string> > newEntries;
+	std::string canonical;
+	mutable size_t hash;
+	mutable bool hashed;
+
+	void addNameEntry(X509_NAME_ENTRY *nameEntry, std::vector<std::string> &values, int &set);
+	void addCanonical(std::vector<std::string> &values);
+
+	static std::string getCanonical(const ObjectIdentifier& oid, const std::string& value);
 
 	static RDNSequence::EntryType id2Type(int id);
 	static int type2Id(RDNSequence::EntryType type);
@@ -64,4 +110,18 @@ protected:
 //	std::string getNameId(RDNSequence::EntryType type);
 };
 
+#if __cplusplus >= 201103L
+namespace std
+{
+	template<>
+	struct hash<RDNSequence>
+	{
+		size_t operator()(const RDNSequence& value) const
+		{
+			return value.getHash();
+		}
+	};
+}
+#endif
+
 #endif /*RDNSEQUENCE_H_*/
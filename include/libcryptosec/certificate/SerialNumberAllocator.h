@@ -0,0 +1,121 @@
+#ifndef SERIALNUMBERALLOCATOR_H_
+#define SERIALNUMBERALLOCATOR_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include <libcryptosec/BigInteger.h>
+#include <libcryptosec/ByteArray.h>
+
+#include <libcryptosec/exception/BigIntegerException.h>
+#include <libcryptosec/exception/CertificationException.h>
+#include <libcryptosec/exception/RandomException.h>
+
+/**
+ * @ingroup Util
+ */
+
+/**
+ * @brief Gera números de série de certificados únicos sem consulta a um banco de dados.
+ * Cada número de série tem SIZE (20) octetos, o máximo permitido pela RFC 5280 4.1.2.2, e é sempre
+ * positivo e do mesmo tamanho:
+ * - 4 octetos com o shard, identificador da instância que emite, com o bit 0x40000000 ligado;
+ * - 8 octetos com um contador, iniciado no instante da criação do SerialNumberAllocator (em
+ * microssegundos, multiplicado por 4096) e incrementado a cada número de série;
+ * - 8 octetos aleatórios (Random::fillInto()), os 64 bits de entropia exigidos pelos Baseline
+ * Requirements do CA/Browser Forum.
+ * Shard e contador garantem a unicidade entre threads, que compartilham o mesmo SerialNumberAllocator
+ * sem travas, e entre processos, desde que cada processo em execução use um shard diferente. Um
+ * processo reiniciado com o mesmo shard não repete números de série enquanto tiver emitido, em
+ * média, menos de 4096 por microssegundo e o relógio não retroceder. Pelo mesmo motivo, após um
+ * fork() o processo filho reinicia o contador dos SerialNumberAllocators herdados com o instante
+ * corrente, e pode continuar a usá-los com o mesmo shard que o pai.
+ * A parte aleatória vem do gerador da thread (ver Random), sem travas globais a cada número de série.
+ */
+class SerialNumberAllocator
+{
+public:
+	/**
+	 * Tamanho em octetos dos números de série.
+	 */
+	static const unsigned int SIZE = 20;
+
+	/**
+	 * Maior shard aceito.
+	 */
+	static const unsigned int MAX_SHARD = (1u << 30) - 1;
+
+	/**
+	 * Construtor com shard aleatório: a unicidade entre processos passa a ser probabilística.
+	 * @throw RandomException caso não seja possível gerar o shard.
+	 */
+	SerialNumberAllocator() throw (RandomException);
+
+	/**
+	 * Construtor.
+	 * @param shard identificador da instância, que não deve ser usado por outro processo em execução.
+	 * @throw CertificationException caso shard seja maior que MAX_SHARD.
+	 */
+	SerialNumberAllocator(unsigned int shard) throw (CertificationException);
+	virtual ~SerialNumberAllocator();
+
+	/**
+	 * Gera um número de série.
+	 * @param serial recebe os SIZE octetos do número de série, big-endian.
+	 * @throw RandomException caso não seja possível gerar a parte aleatória.
+	 */
+	void next(unsigned char *serial) throw (RandomException);
+
+	/**
+	 * Gera count números de série consecutivos, reservando o contador e gerando a parte aleatória
+	 * uma única vez para todo o lote.
+	 * @param serials recebe count * SIZE octetos.
+	 * @param count quantidade de números de série.
+	 * @throw RandomException caso não seja possível gerar a parte aleatória.
+	 */
+	void next(unsigned char *serials, unsigned int count) throw (RandomException);
+
+	/**
+	 * Gera um número de série, para CertificateBuilder::setSerialNumber(BigInteger).
+	 * @throw RandomException caso não seja possível gerar a parte aleatória.
+	 */
+	BigInteger next() throw (RandomException, BigIntegerException);
+
+	/**
+	 * Gera count números de série, como em next(unsigned char *, unsigned int).
+	 * @throw RandomException caso não seja possível gerar a parte aleatória.
+	 */
+	std::vector<BigInteger> next(unsigned int count) throw (RandomException, BigIntegerException);
+
+	unsigned int getShard() const;
+
+	/**
+	 * Obtém o shard de um número de série gerado por um SerialNumberAllocator.
+	 * @param serial número de série.
+	 * @param shard recebe o shard.
+	 * @return false se serial não tem o formato gerado pelo SerialNumberAllocator.
+	 */
+	static bool getShard(const BigInteger &serial, unsigned int &shard);
+
+	/**
+	 * Reinicia os contadores no processo filho de um fork(); registrado com pthread_atfork().
+	 */
+	static void forkChild();
+
+protected:
+	void init(unsigned int shard);
+	void fill(unsigned char *serial, uint64_t counter) const;
+
+	unsigned int shard;
+
+	/*
+	 * Próximo valor do contador, incrementado atomicamente.
+	 */
+	uint64_t counter;
+
+private:
+	SerialNumberAllocator(const SerialNumberAllocator& allocator);
+	SerialNumberAllocator& operator =(const SerialNumberAllocator& allocator);
+};
+
+#endif /*SERIALNUMBERALLOCATOR_H_*/
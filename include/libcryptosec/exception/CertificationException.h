@@ -29,6 +29,12 @@ public:
     {
     	this->where = where;
     	this->errorCode = errorCode;
+    }
+    CertificationException(CertificationException::ErrorCode errorCode, std::string where, std::string details)
+    {
+    	this->where = where;
+    	this->errorCode = errorCode;
+    	this->details = details;
     }
 	virtual ~CertificationException() throw () {}
 	virtual std::string getMessage() const
@@ -46,6 +52,10 @@ public:
     	{
     		ret = "CertificationException: " + CertificationException::errorCode2Message(this->errorCode) + ". Called by: " + this->where + ".";
     	}
+    	if (this->details != "")
+    	{
+    		ret += " More details: " + this->details + ".";
+    	}
     	return ret;
     }
     virtual CertificationException::ErrorCode getErrorCode()
@@ -13,6 +13,8 @@ public:
 		CTX_UPDATE,
 		CTX_FINISH,
 		INVALID_ALGORITHM,
+		READING_CONTENT,
+		INVALID_MIDSTATE,
 	};
     MessageDigestException(std::string where)
     {
@@ -66,6 +68,12 @@ public:
     		case MessageDigestException::CTX_FINISH:
     			ret = "Finishing message digest context";
     			break;
+    		case MessageDigestException::READING_CONTENT:
+    			ret = "Reading content to digest";
+    			break;
+    		case MessageDigestException::INVALID_MIDSTATE:
+    			ret = "Invalid message digest midstate";
+    			break;
 //    		case ErrorCode:::
 //    			ret = "";
 //    			break;
@@ -17,6 +17,7 @@ public:
 		INVALID_CERTIFICATE,
 		ADDING_SIGNER,
 		ADDING_CERTIFICATE,
+		READING_CONTENT,
 	};
     Pkcs7Exception(std::string where)
     {
@@ -99,6 +100,9 @@ public:
     		case Pkcs7Exception::ADDING_CERTIFICATE:
     			ret = "Adding certificate";
     			break;
+    		case Pkcs7Exception::READING_CONTENT:
+    			ret = "Reading content";
+    			break;
 //    		case Pkcs7Exception:::
 //    			ret = "";
 //    			break;
@@ -18,6 +18,7 @@ public:
 		INVALID_PKCS11_MODULE = 8,
 		BLOCKED_PIN = 0x000000A4,
 		ID_NOT_FOUND = 9,
+		SESSION_IN_USE = 10,
 	};
 	SmartcardModuleException(std::string where)
     {
@@ -105,6 +106,9 @@ public:
     		case SmartcardModuleException::ID_NOT_FOUND:
     			ret = "ID not found";
     			break;
+    		case SmartcardModuleException::SESSION_IN_USE:
+    			ret = "Session in use by private keys";
+    			break;
 //    		case SmartcardModuleException:::
 //    			ret = "";
 //    			break;
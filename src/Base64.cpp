@@ -1,109 +1,407 @@
 #include <libcryptosec/Base64.h>
 
-const std::string Base64::base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+#include <algorithm>
+#include <vector>
 
-std::string Base64::encode(ByteArray &data)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_SIMD
+#include <immintrin.h>
+#endif
+
+/* base64 digit of each 6-bit value */
+static const char encodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+const std::string Base64::base64Chars = encodeTable;
+
+/* decodeTable values for characters that are not base64 digits */
+#define BASE64_SPACE 0xfe
+#define BASE64_INVALID 0xff
+
+/* bytes read per block by the stream encoder (a multiple of 3) */
+#define BASE64_ENCODE_BLOCK 49152
+/* characters read per block by the stream decoder */
+#define BASE64_DECODE_BLOCK 65536
+/* decode output slack: vector blocks store 4 bytes past the ones they produce */
+#define BASE64_DECODE_SLACK 32
+
+/* 6-bit value of each character */
+static const unsigned char decodeTable[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+	0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+/* decoder state carried across blocks */
+struct DecodeState
 {
-	std::string ret;
-	int i = 0;
-	int j = 0;
-	int in_len;
-	unsigned char *bytes_to_encode;
-	unsigned char char_array_3[3];
-	unsigned char char_array_4[4];
-	
-	in_len = data.size();
-	bytes_to_encode = data.getDataPointer();
-	
-	while (in_len--)
+	unsigned int bits;
+	unsigned int count;
+	bool done;
+};
+
+/******************* scalar *********************/
+
+/* n must be a multiple of 3 */
+static void encodeScalar(const unsigned char *in, size_t n, char *out)
+{
+	unsigned int bits;
+	size_t i;
+	for (i = 0; i < n; i += 3)
 	{
-		char_array_3[i++] = *(bytes_to_encode++);
-		if (i == 3)
-		{
-			char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-			char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-			char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-			char_array_4[3] = char_array_3[2] & 0x3f;
-	
-			for(i = 0; (i <4) ; i++)
-				ret += base64Chars[char_array_4[i]];
-			i = 0;
-		}
+		bits = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+		*out++ = encodeTable[bits >> 18];
+		*out++ = encodeTable[(bits >> 12) & 0x3f];
+		*out++ = encodeTable[(bits >> 6) & 0x3f];
+		*out++ = encodeTable[bits & 0x3f];
 	}
-	
-	if (i)
+}
+
+/* last 1 or 2 bytes, padded with '=' */
+static void encodeTail(const unsigned char *in, size_t n, char *out)
+{
+	unsigned int bits;
+	if (n == 0)
 	{
-		for(j = i; j < 3; j++)
-			char_array_3[j] = '\0';
-	
-		char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-		char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-		char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-		char_array_4[3] = char_array_3[2] & 0x3f;
-	
-		for (j = 0; (j < i + 1); j++)
-			ret += base64Chars[char_array_4[j]];
-	
-		while((i++ < 3))
-			ret += '=';
+		return;
 	}
-	return ret;
+	bits = (in[0] << 16) | (n == 2 ? in[1] << 8 : 0);
+	out[0] = encodeTable[bits >> 18];
+	out[1] = encodeTable[(bits >> 12) & 0x3f];
+	out[2] = n == 2 ? encodeTable[(bits >> 6) & 0x3f] : '=';
+	out[3] = '=';
 }
 
-ByteArray Base64::decode(std::string &data)
+/******************* SSSE3 and AVX2 *********************/
+
+#ifdef BASE64_SIMD
+
+/* 6-bit indices to characters: the offset added depends on the range of each index */
+__attribute__((target("ssse3")))
+static inline __m128i encodeLookup(__m128i indices)
+{
+	const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	__m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+	range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+	return _mm_add_epi8(indices, _mm_shuffle_epi8(shift, range));
+}
+
+/* 12 bytes to 16 6-bit indices */
+__attribute__((target("ssse3")))
+static inline __m128i encodeSplit(__m128i in)
+{
+	const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	__m128i t0, t1;
+	in = _mm_shuffle_epi8(in, shuffle);
+	t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+	t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+	return _mm_or_si128(t0, t1);
+}
+
+/* encodes 12-byte blocks while 16 bytes are readable; returns the bytes consumed */
+__attribute__((target("ssse3")))
+static size_t encodeSsse3(const unsigned char *in, size_t n, char *out)
 {
-	int in_len = data.size();
-	int i = 0;
-	int j = 0;
-	int counter = 0;
-	int in_ = 0;
-	unsigned char char_array_4[4], char_array_3[3];
-	ByteArray ret, *temp;
-
-	temp = new ByteArray(in_len);
-
-	while (in_len-- && ( data[in_] != '=') 
-  		&& (isalnum(data[in_]) || (data[in_] == '+') || (data[in_] == '/')))
-  	{
-    
-    	char_array_4[i++] = data[in_]; in_++;
-		if (i == 4)
+	size_t done = 0;
+	while (n - done >= 16)
+	{
+		__m128i v = encodeSplit(_mm_loadu_si128((const __m128i *)(in + done)));
+		_mm_storeu_si128((__m128i *)(out + done / 3 * 4), encodeLookup(v));
+		done += 12;
+	}
+	return done;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i encodeLookup(__m256i indices)
+{
+	const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	__m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+	range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+	return _mm256_add_epi8(indices, _mm256_shuffle_epi8(shift, range));
+}
+
+/* encodes 24-byte blocks, 12 per lane, while 28 bytes are readable */
+__attribute__((target("avx2")))
+static size_t encodeAvx2(const unsigned char *in, size_t n, char *out)
+{
+	const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+			10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	size_t done = 0;
+	__m256i v, t0, t1;
+	while (n - done >= 28)
+	{
+		v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + done))),
+				_mm_loadu_si128((const __m128i *)(in + done + 12)), 1);
+		v = _mm256_shuffle_epi8(v, shuffle);
+		t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+		t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+		_mm256_storeu_si256((__m256i *)(out + done / 3 * 4), encodeLookup(_mm256_or_si256(t0, t1)));
+		done += 24;
+	}
+	return done;
+}
+
+/*
+ * decodes 16-character blocks to 12 bytes while they hold only base64 digits;
+ * returns the characters consumed. Stores up to 4 bytes past the ones produced.
+ */
+__attribute__((target("ssse3")))
+static size_t decodeSsse3(const char *in, size_t n, unsigned char *out)
+{
+	const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	size_t done = 0;
+	__m128i v, hi, lo, roll;
+	while (n - done >= 16)
+	{
+		v = _mm_loadu_si128((const __m128i *)(in + done));
+		hi = _mm_and_si128(_mm_srli_epi32(v, 4), _mm_set1_epi8(0x0f));
+		lo = _mm_and_si128(v, _mm_set1_epi8(0x0f));
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(_mm_shuffle_epi8(lutLo, lo), _mm_shuffle_epi8(lutHi, hi)),
+				_mm_setzero_si128())))
+		{
+			break;
+		}
+		roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), hi));
+		v = _mm_add_epi8(v, roll);
+		v = _mm_madd_epi16(_mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i *)(out + done / 4 * 3), _mm_shuffle_epi8(v, pack));
+		done += 16;
+	}
+	return done;
+}
+
+/* decodes 32-character blocks to 24 bytes, 12 per lane */
+__attribute__((target("avx2")))
+static size_t decodeAvx2(const char *in, size_t n, unsigned char *out)
+{
+	const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+			0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+	const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	size_t done = 0;
+	__m256i v, hi, lo, roll;
+	while (n - done >= 32)
+	{
+		v = _mm256_loadu_si256((const __m256i *)(in + done));
+		hi = _mm256_and_si256(_mm256_srli_epi32(v, 4), _mm256_set1_epi8(0x0f));
+		lo = _mm256_and_si256(v, _mm256_set1_epi8(0x0f));
+		if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(_mm256_shuffle_epi8(lutLo, lo),
+				_mm256_shuffle_epi8(lutHi, hi)), _mm256_setzero_si256())))
 		{
-			for (i = 0; i <4; i++)
-				char_array_4[i] = base64Chars.find(char_array_4[i]);
+			break;
+		}
+		roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')), hi));
+		v = _mm256_add_epi8(v, roll);
+		v = _mm256_madd_epi16(_mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+		v = _mm256_shuffle_epi8(v, pack);
+		_mm_storeu_si128((__m128i *)(out + done / 4 * 3), _mm256_castsi256_si128(v));
+		_mm_storeu_si128((__m128i *)(out + done / 4 * 3 + 12), _mm256_extracti128_si256(v, 1));
+		done += 32;
+	}
+	return done;
+}
 
-			char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-			char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-			char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+#endif /* BASE64_SIMD */
 
-			for (i = 0; (i < 3); i++)
+/******************* dispatch *********************/
+
+/* n must be a multiple of 3 */
+static void encodeGroups(const unsigned char *in, size_t n, char *out)
+{
+	size_t done = 0;
+#ifdef BASE64_SIMD
+	if (__builtin_cpu_supports("avx2"))
+	{
+		done = encodeAvx2(in, n, out);
+	}
+	if (__builtin_cpu_supports("ssse3"))
+	{
+		done += encodeSsse3(in + done, n - done, out + done / 3 * 4);
+	}
+#endif
+	encodeScalar(in + done, n - done, out + done / 3 * 4);
+}
+
+/* out must hold n / 4 * 3 + BASE64_DECODE_SLACK bytes; returns the bytes written */
+static size_t decodeChunk(const char *in, size_t n, unsigned char *out, DecodeState *state)
+{
+	size_t i = 0, o = 0;
+	unsigned char v;
+#ifdef BASE64_SIMD
+	size_t retry = 0, used;
+	bool avx2 = __builtin_cpu_supports("avx2"), ssse3 = __builtin_cpu_supports("ssse3");
+#endif
+	while (i < n && !state->done)
+	{
+#ifdef BASE64_SIMD
+		/* vector blocks need an aligned quantum; a block holding whitespace or the end of the
+		   data is stepped over by the scalar code, retrying as soon as the quantum realigns */
+		if (state->count == 0 && i >= retry && n - i >= 16)
+		{
+			used = avx2 ? decodeAvx2(in + i, n - i, out + o) : 0;
+			used += ssse3 ? decodeSsse3(in + i + used, n - i - used, out + o + used / 4 * 3) : 0;
+			i += used;
+			o += used / 4 * 3;
+			retry = i + 1;
+			if (i == n)
 			{
-				(temp->getDataPointer())[counter] = char_array_3[i];
-				counter++;
+				break;
 			}
-			i = 0;
+		}
+#endif
+		v = decodeTable[(unsigned char)in[i++]];
+		if (v < 64)
+		{
+			state->bits = (state->bits << 6) | v;
+			if (++state->count == 4)
+			{
+				out[o++] = (unsigned char)(state->bits >> 16);
+				out[o++] = (unsigned char)(state->bits >> 8);
+				out[o++] = (unsigned char)state->bits;
+				state->bits = 0;
+				state->count = 0;
+			}
+		}
+		else if (v != BASE64_SPACE)
+		{
+			state->done = true;
 		}
 	}
+	return o;
+}
 
-	if (i)
+/* incomplete quantum at the end of the data: c characters give c - 1 bytes */
+static size_t decodeFinish(unsigned char *out, DecodeState *state)
+{
+	size_t o = 0;
+	unsigned int bits = state->bits << (6 * (4 - state->count));
+	if (state->count >= 2)
 	{
-		for (j = i; j <4; j++)
-			char_array_4[j] = 0;
+		out[o++] = (unsigned char)(bits >> 16);
+	}
+	if (state->count >= 3)
+	{
+		out[o++] = (unsigned char)(bits >> 8);
+	}
+	state->bits = 0;
+	state->count = 0;
+	return o;
+}
 
-		for (j = 0; j <4; j++)
-			char_array_4[j] = base64Chars.find(char_array_4[j]);
+std::string Base64::encode(ByteArray &data)
+{
+	size_t size = data.size();
+	size_t full = size - size % 3;
+	std::string ret;
+	if (size == 0)
+	{
+		return ret;
+	}
+	ret.resize((size + 2) / 3 * 4);
+	encodeGroups(data.getDataPointer(), full, &ret[0]);
+	encodeTail(data.getDataPointer() + full, size - full, &ret[full / 3 * 4]);
+	return ret;
+}
 
-		char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-		char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-		char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+ByteArray Base64::decode(std::string &data)
+{
+	std::vector<unsigned char> buffer(data.size() / 4 * 3 + BASE64_DECODE_SLACK);
+	DecodeState state = {0, 0, false};
+	size_t size;
+	size = decodeChunk(data.data(), data.size(), &buffer[0], &state);
+	size += decodeFinish(&buffer[size], &state);
+	return ByteArray(&buffer[0], (unsigned int)size);
+}
 
-		for (j = 0; (j < i - 1); j++)
+bool Base64::encode(std::istream *in, std::ostream *out, unsigned int lineLength)
+{
+	std::vector<unsigned char> block(BASE64_ENCODE_BLOCK);
+	std::vector<char> encoded(BASE64_ENCODE_BLOCK / 3 * 4);
+	size_t n, size, line, column = 0, done;
+	do
+	{
+		in->read((char *)&block[0], BASE64_ENCODE_BLOCK);
+		n = (size_t)in->gcount();
+		if (in->bad())
+		{
+			return false;
+		}
+		/* only the last block may be incomplete */
+		encodeGroups(&block[0], n - n % 3, &encoded[0]);
+		encodeTail(&block[n - n % 3], n % 3, &encoded[(n - n % 3) / 3 * 4]);
+		size = (n + 2) / 3 * 4;
+		if (lineLength == 0)
 		{
-			(temp->getDataPointer())[counter] = char_array_3[j];
-			counter++;
+			out->write(&encoded[0], size);
+			continue;
 		}
+		for (done = 0; done < size; done += line)
+		{
+			line = std::min(size - done, (size_t)lineLength - column);
+			out->write(&encoded[done], line);
+			column += line;
+			if (column == lineLength)
+			{
+				out->put('\n');
+				column = 0;
+			}
+		}
+	} while (n == BASE64_ENCODE_BLOCK && out->good());
+	if (column > 0)
+	{
+		out->put('\n');
 	}
-	ret = ByteArray(temp->getDataPointer(), counter);
-	delete temp;
-	return ret;
+	return out->good();
+}
+
+bool Base64::decode(std::istream *in, std::ostream *out)
+{
+	std::vector<char> block(BASE64_DECODE_BLOCK);
+	std::vector<unsigned char> decoded(BASE64_DECODE_BLOCK / 4 * 3 + BASE64_DECODE_SLACK);
+	DecodeState state = {0, 0, false};
+	size_t n, size;
+	do
+	{
+		in->read(&block[0], BASE64_DECODE_BLOCK);
+		n = (size_t)in->gcount();
+		if (in->bad())
+		{
+			return false;
+		}
+		size = decodeChunk(&block[0], n, &decoded[0], &state);
+		out->write((char *)&decoded[0], size);
+	} while (n == BASE64_DECODE_BLOCK && !state.done && out->good());
+	size = decodeFinish(&decoded[0], &state);
+	out->write((char *)&decoded[0], size);
+	return out->good();
 }
@@ -279,6 +279,14 @@ void BigInteger::setDecValue(std::string dec) throw(BigIntegerException)
 	}
 }
 
+void BigInteger::setUnsignedValue(const unsigned char *data, unsigned int size) throw(BigIntegerException)
+{
+	if(!(BN_bin2bn(data, size, this->bigInt)))
+	{
+		throw BigIntegerException(BigIntegerException::INTERNAL_ERROR, "BigInteger::setUnsignedValue");
+	}
+}
+
 BigInteger& BigInteger::add(BigInteger const& a) throw(BigIntegerException)
 {
 	if(!(BN_add(this->bigInt, this->bigInt, a.getBIGNUM())))
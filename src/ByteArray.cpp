@@ -1,6 +1,42 @@
 #include "stdlib.h"
 #include <libcryptosec/ByteArray.h>
 
+#include <openssl/crypto.h>
+
+#include <algorithm>
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BYTEARRAY_SIMD
+#include <immintrin.h>
+#endif
+
+/* bytes de cada entrada combinados por vez em ByteArray::xOr, para manter o resultado em cache */
+#define XOR_CHUNK_SIZE 4096
+
+/* dígito hexadecimal de cada nibble */
+static const char hexDigits[] = "0123456789ABCDEF";
+
+/* valor de cada dígito hexadecimal; 0xff para os demais caracteres */
+static const unsigned char hexValues[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
 ByteArray::ByteArray()
 {
     this->m_data = NULL;
@@ -188,41 +224,73 @@ std::string ByteArray::toString()
 
 std::string ByteArray::toHex()
 {
-	//sets the hexadecimal lenght for twice the lenght of the bytearray
-	//because each byte contains 2 hexadecimals characters	
-	//go trought the bytearray m_data, coping each byte to two hex in the hex_data
-	std::string data;	
-    char *hex_data = new char[this->length*2 +1];
-    
-    int j = 0;
-    for(unsigned int i = 0; i < this->length; i++)
-    {    	
-		sprintf(&hex_data[j], "%02X", this->m_data[i]);
-		j+=2;		
-    }
-    hex_data[j] = '\0';
-	data = hex_data;
-	delete[] hex_data;
-    return data;
+	//each byte becomes two hexadecimal characters, written into the pre-sized string
+	std::string data(this->length * 2, '\0');
+	for (unsigned int i = 0; i < this->length; i++)
+	{
+		data[2 * i] = hexDigits[this->m_data[i] >> 4];
+		data[2 * i + 1] = hexDigits[this->m_data[i] & 0x0f];
+	}
+	return data;
 }
 
 std::string ByteArray::toHex(char separator)
 {
-	//sets the hexadecimal lenght for twice the lenght of the bytearray
-	//because each byte contains 2 hexadecimals characters	
-	//go trought the bytearray m_data, coping each byte to two hex in the hex_data
-	std::stringstream data;	
-    char* hex_data = new char[2];
-    
-    for(unsigned int i = 0; i < this->length; i++)
-    {    	
-		sprintf(&hex_data[0], "%02X", this->m_data[i]);
-		data << hex_data;
-		if(i < this->length-1)
-			data << separator;
-    }
-	delete[] hex_data; 
-    return data.str();
+	//two hexadecimal characters per byte and a separator between bytes
+	std::string data(this->length > 0 ? this->length * 3 - 1 : 0, separator);
+	for (unsigned int i = 0; i < this->length; i++)
+	{
+		data[3 * i] = hexDigits[this->m_data[i] >> 4];
+		data[3 * i + 1] = hexDigits[this->m_data[i] & 0x0f];
+	}
+	return data;
+}
+
+/*
+ * decodifica pares de dígitos espaçados de stride caracteres; se stride for 3, o caractere
+ * após cada par, exceto o último, deve ser o separador
+ */
+static ByteArray decodeHex(const std::string& hex, unsigned int stride, char separator) throw (invalid_argument)
+{
+	unsigned int size = (hex.size() + stride - 2) / stride;
+	ByteArray ret(size);
+	unsigned char *data = ret.getDataPointer();
+	const unsigned char *in = (const unsigned char *)hex.data();
+	unsigned char high, low;
+	if (hex.size() != (size > 0 ? size * stride - (stride - 2) : 0))
+	{
+		throw invalid_argument("ByteArray::fromHex: invalid length");
+	}
+	for (unsigned int i = 0; i < size; i++, in += stride)
+	{
+		high = hexValues[in[0]];
+		low = hexValues[in[1]];
+		if ((high | low) == 0xff || (stride == 3 && i + 1 < size && (char)in[2] != separator))
+		{
+			throw invalid_argument("ByteArray::fromHex: invalid character");
+		}
+		data[i] = (high << 4) | low;
+	}
+	return ret;
+}
+
+ByteArray ByteArray::fromHex(const std::string& hex) throw (invalid_argument)
+{
+	return decodeHex(hex, 2, '\0');
+}
+
+ByteArray ByteArray::fromHex(const std::string& hex, char separator) throw (invalid_argument)
+{
+	return decodeHex(hex, 3, separator);
+}
+
+bool ByteArray::constantTimeEquals(const ByteArray& left, const ByteArray& right)
+{
+	if (left.length != right.length)
+	{
+		return false;
+	}
+	return CRYPTO_memcmp(left.m_data, right.m_data, left.length) == 0;
 }
 
 void ByteArray::copyFrom(int offset, int length, ByteArray& data, int offset2) 
@@ -239,32 +307,100 @@ std::istringstream* ByteArray::toStream()
 	return stream;
 }
 
-ByteArray& operator xor(const ByteArray& left, const ByteArray& right)
+#ifdef BYTEARRAY_SIMD
+/* combina blocos de 32 bytes; retorna os bytes processados */
+__attribute__((target("avx2")))
+static size_t xorAvx2(unsigned char* data, const unsigned char* value, size_t length)
 {
-    const ByteArray* biggest;
-    const ByteArray* smallest;
-    if (left.size() > right.size()) {
-        biggest = &left;
-        smallest = &right;
-    } else {
-        biggest = &right;
-        smallest = &left;
+    size_t i;
+    __m256i v;
+    for (i = 0; i + 32 <= length; i += 32) {
+        v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (data + i)),
+                _mm256_loadu_si256((const __m256i *) (value + i)));
+        _mm256_storeu_si256((__m256i *) (data + i), v);
     }
-    
-    ByteArray* xored = new ByteArray(*biggest);
-    for (unsigned int i = 0; i < smallest->size(); i++) {
-        (*xored)[i] = (*xored)[i] xor smallest->at(i);
+    return i;
+}
+
+/* combina blocos de 16 bytes */
+__attribute__((target("sse2")))
+static size_t xorSse2(unsigned char* data, const unsigned char* value, size_t length)
+{
+    size_t i;
+    __m128i v;
+    for (i = 0; i + 16 <= length; i += 16) {
+        v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (data + i)),
+                _mm_loadu_si128((const __m128i *) (value + i)));
+        _mm_storeu_si128((__m128i *) (data + i), v);
+    }
+    return i;
+}
+#endif
+
+void ByteArray::xorInto(unsigned char* data, const unsigned char* value, size_t length)
+{
+    size_t i = 0;
+    uint64_t a, b;
+#ifdef BYTEARRAY_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        i = xorAvx2(data, value, length);
+    } else if (__builtin_cpu_supports("sse2")) {
+        i = xorSse2(data, value, length);
+    }
+#endif
+    //memcpy keeps the word accesses valid for unaligned buffers
+    for (; i + 8 <= length; i += 8) {
+        memcpy(&a, data + i, 8);
+        memcpy(&b, value + i, 8);
+        a ^= b;
+        memcpy(data + i, &a, 8);
+    }
+    for (; i < length; i++) {
+        data[i] ^= value[i];
     }
-    return *xored;
+}
+
+ByteArray& ByteArray::operator ^=(const ByteArray& value)
+{
+    unsigned char *data;
+    if (value.length > this->length) {
+        data = new unsigned char[value.length + 1];
+        memcpy(data, this->m_data, this->length);
+        memset(data + this->length, 0, value.length - this->length + 1);
+        delete[] this->m_data;
+        this->m_data = data;
+        this->length = value.length;
+    }
+    ByteArray::xorInto(this->m_data, value.m_data, value.length);
+    return *this;
+}
+
+ByteArray operator xor(const ByteArray& left, const ByteArray& right)
+{
+    if (left.size() >= right.size()) {
+        ByteArray xored(left);
+        return xored ^= right;
+    }
+    ByteArray xored(right);
+    return xored ^= left;
 }
 
 ByteArray ByteArray::xOr(vector<ByteArray> &array) {
-    ByteArray ba(array.at(0));
-    ByteArray temp;
-    
-    for (unsigned int i = 1; i < array.size(); i++) {
-        temp = (ba xor array.at(i));
-        ba = temp;
+    unsigned int size = 0, length;
+    unsigned int i, offset;
+    for (i = 0; i < array.size(); i++) {
+        size = std::max(size, array.at(i).size());
+    }
+    ByteArray ba(size);
+    memcpy(ba.m_data, array.at(0).m_data, array.at(0).size());
+    //each chunk of the result is combined with every input before moving to the next one
+    for (offset = 0; offset < size; offset += XOR_CHUNK_SIZE) {
+        for (i = 1; i < array.size(); i++) {
+            if (array[i].size() > offset) {
+                length = std::min((unsigned int) XOR_CHUNK_SIZE, array[i].size() - offset);
+                ByteArray::xorInto(ba.m_data + offset, array[i].m_data + offset, length);
+            }
+        }
     }
     return ba;
 }
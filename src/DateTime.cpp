@@ -108,13 +108,35 @@ DateTime::DateTime(ASN1_TIME *asn1Time) throw(BigIntegerException)
 		}
 	}*/
 	
-	string str(reinterpret_cast<char*>(asn1Time->data), asn1Time->length);
-	this->setDateTime(this->date2epoch(str));
+	time_t epoch;
+	long nanoseconds;
+	
+	if(DateTime::time2epoch(asn1Time->data, asn1Time->length, asn1Time->type == V_ASN1_GENERALIZEDTIME, epoch, nanoseconds))
+	{
+		this->setDateTime(epoch);
+		this->nanoseconds = nanoseconds;
+	}
+	else
+	{
+		string str(reinterpret_cast<char*>(asn1Time->data), asn1Time->length);
+		this->setDateTime(this->date2epoch(str));
+	}
 }
 
 DateTime::DateTime(std::string s) throw(BigIntegerException)
 {
-	this->setDateTime(DateTime::date2epoch(s));
+	time_t epoch;
+	long nanoseconds;
+	
+	if(DateTime::time2epoch(reinterpret_cast<const unsigned char*>(s.data()), s.size(), s.size() != 13, epoch, nanoseconds))
+	{
+		this->setDateTime(epoch);
+		this->nanoseconds = nanoseconds;
+	}
+	else
+	{
+		this->setDateTime(DateTime::date2epoch(s));
+	}
 }
 
 DateTime::~DateTime()
@@ -124,11 +146,13 @@ DateTime::~DateTime()
 void DateTime::setDateTime(time_t dateTime) throw(BigIntegerException)
 {
 	this->seconds = dateTime;
+	this->nanoseconds = 0;
 }
 
 void DateTime::setDateTime(BigInteger const& b) throw(BigIntegerException)
 {
 	this->seconds = b;
+	this->nanoseconds = 0;
 }
 
 time_t DateTime::getDateTime() const throw(BigIntegerException)
@@ -335,6 +359,7 @@ std::string DateTime::getISODate() const throw(BigIntegerException)
 DateTime& DateTime::operator =(const DateTime& aDate) throw(BigIntegerException)
 {
 	this->setDateTime(aDate.getSeconds());
+	this->nanoseconds = aDate.getNanoseconds();
 	return(*this);	
 }
 
@@ -343,6 +368,11 @@ BigInteger const& DateTime::getSeconds() const throw()
 	return this->seconds;
 }
 
+long DateTime::getNanoseconds() const throw()
+{
+	return this->nanoseconds;
+}
+
 void DateTime::addSeconds(long b) throw(BigIntegerException)
 {
 	this->seconds.add(b);
@@ -482,19 +512,193 @@ void DateTime::addYears(long b) throw(BigIntegerException)
 	return ret;
 }*/
 
+/*
+ * Le exatamente count digitos decimais a partir de data[pos].
+ * Retorna -1 se algum dos bytes nao for digito ou se faltarem bytes.
+ */
+static int readDigits(const unsigned char *data, int length, int pos, int count)
+{
+	int ret = 0;
+	
+	if(pos + count > length)
+	{
+		return -1;
+	}
+	
+	for(int i = pos; i < pos + count; i++)
+	{
+		if(data[i] < '0' || data[i] > '9')
+		{
+			return -1;
+		}
+		ret = ret * 10 + (data[i] - '0');
+	}
+	
+	return ret;
+}
+
+bool DateTime::time2epoch(const unsigned char *data, int length, bool generalizedTime, time_t& epoch, long& nanoseconds) throw()
+{
+	int year;
+	int month; //[1-12]
+	int day; //[1-31]
+	int hour; //[0-23]
+	int min = 0; //[0-59]
+	int sec = 0; //[0-60] (leap second)
+	int offset = 0; //deslocamento do fuso em minutos
+	int unit = 3600; //segundos do ultimo campo presente, ao qual a fracao se refere
+	long long fraction = 0;
+	long long value;
+	int pos;
+	
+	if(data == NULL || length <= 0)
+	{
+		return false;
+	}
+	
+	//year
+	if(generalizedTime)
+	{
+		year = readDigits(data, length, 0, 4);
+		pos = 4;
+	}
+	else
+	{
+		year = readDigits(data, length, 0, 2);
+		if(year >= 0)
+		{
+			year+= (year >= 50) ? 1900 : 2000;
+		}
+		pos = 2;
+	}
+	
+	month = readDigits(data, length, pos, 2);
+	day = readDigits(data, length, pos + 2, 2);
+	hour = readDigits(data, length, pos + 4, 2);
+	pos+= 6;
+	
+	if(year < 0 || month < 1 || month > 12 || day < 1 || hour < 0 || hour > 23
+			|| day > DateTime::getMonthSize(month - 1, year))
+	{
+		return false;
+	}
+	
+	//UTCTime exige minutos; GeneralizedTime permite omiti-los
+	if(pos < length && data[pos] >= '0' && data[pos] <= '9')
+	{
+		min = readDigits(data, length, pos, 2);
+		pos+= 2;
+		unit = 60;
+		
+		//segundos sao opcionais em ambos os formatos
+		if(min >= 0 && pos < length && data[pos] >= '0' && data[pos] <= '9')
+		{
+			sec = readDigits(data, length, pos, 2);
+			pos+= 2;
+			unit = 1;
+		}
+	}
+	else if(!generalizedTime)
+	{
+		return false;
+	}
+	
+	if(min < 0 || min > 59 || sec < 0 || sec > 60)
+	{
+		return false;
+	}
+	
+	//fracao da hora, do minuto ou do segundo (somente GeneralizedTime), truncada em nanossegundos do campo
+	if(generalizedTime && pos < length && (data[pos] == '.' || data[pos] == ','))
+	{
+		int digits = 0;
+		
+		pos++;
+		while(pos < length && data[pos] >= '0' && data[pos] <= '9')
+		{
+			if(digits < 9)
+			{
+				fraction = fraction * 10 + (data[pos] - '0');
+				digits++;
+			}
+			pos++;
+		}
+		
+		if(digits == 0)
+		{
+			return false;
+		}
+		
+		for(; digits < 9; digits++)
+		{
+			fraction*= 10;
+		}
+		fraction*= unit;
+	}
+	
+	//fuso horario
+	if(pos < length)
+	{
+		if(data[pos] == 'Z')
+		{
+			pos++;
+		}
+		else if(data[pos] == '+' || data[pos] == '-')
+		{
+			int offHour = readDigits(data, length, pos + 1, 2);
+			int offMin = readDigits(data, length, pos + 3, 2);
+			
+			if(offHour < 0 || offHour > 23 || offMin < 0 || offMin > 59)
+			{
+				return false;
+			}
+			
+			offset = offHour * 60 + offMin;
+			if(data[pos] == '-')
+			{
+				offset = -offset;
+			}
+			pos+= 5;
+		}
+	}
+	else if(!generalizedTime)
+	{
+		return false;
+	}
+	
+	if(pos != length)
+	{
+		return false;
+	}
+	
+	value = DateTime::getDaysSinceEpoch(year, month - 1, day);
+	value = ((value * 24 + hour) * 60 + min - offset) * 60 + sec + fraction / 1000000000;
+	
+	//time_t de 32 bits nao representa datas apos 2038
+	epoch = static_cast<time_t>(value);
+	if(static_cast<long long>(epoch) != value)
+	{
+		return false;
+	}
+	nanoseconds = static_cast<long>(fraction % 1000000000);
+	
+	return true;
+}
+
 bool DateTime::operator==(const DateTime& other) const throw()
 {
-	return (this->getSeconds() == other.getSeconds());
+	return (this->getSeconds() == other.getSeconds() && this->nanoseconds == other.nanoseconds);
 }
 
 bool DateTime::operator==(time_t other) const throw(BigIntegerException)
 {
-	return (this->getSeconds() == other);
+	return (this->getSeconds() == other && this->nanoseconds == 0);
 }
 
 bool DateTime::operator<(const DateTime& other) const throw()
 {
-	return (this->getSeconds() < other.getSeconds());
+	return (this->getSeconds() < other.getSeconds()
+			|| (this->getSeconds() == other.getSeconds() && this->nanoseconds < other.nanoseconds));
 }
 
 bool DateTime::operator<(time_t other) const throw(BigIntegerException)
@@ -504,10 +708,11 @@ bool DateTime::operator<(time_t other) const throw(BigIntegerException)
 
 bool DateTime::operator>(const DateTime& other) const throw()
 {
-	return (this->getSeconds() > other.getSeconds());
+	return (this->getSeconds() > other.getSeconds()
+			|| (this->getSeconds() == other.getSeconds() && this->nanoseconds > other.nanoseconds));
 }
 
 bool DateTime::operator>(time_t other) const throw(BigIntegerException)
 {
-	return (this->getSeconds() > other);
+	return (this->getSeconds() > other || (this->getSeconds() == other && this->nanoseconds > 0));
 }
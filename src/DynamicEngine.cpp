@@ -1,4 +1,5 @@
 #include <libcryptosec/DynamicEngine.h>
+#include <libcryptosec/Random.h>
 
 DynamicEngine::DynamicEngine(std::string &enginePath)
 throw (EngineException) : Engine(NULL)
@@ -109,6 +110,7 @@ bool DynamicEngine::load() throw (EngineException)
 	int rc = ENGINE_init(this->engine);
 	rc &= ENGINE_set_default(this->engine, ENGINE_METHOD_ALL);
 	OpenSSL_add_all_algorithms();
+	Random::methodChanged();
 	return rc;
 }
 
@@ -116,5 +118,6 @@ bool DynamicEngine::release() throw (EngineException)
 {
 	int rc = ENGINE_finish(this->engine);
 	rc &= ENGINE_free(this->engine);
+	Random::methodChanged();
 	return rc;
 }
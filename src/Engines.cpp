@@ -1,4 +1,5 @@
 #include <libcryptosec/Engines.h>
+#include <libcryptosec/Random.h>
 
 std::vector<std::string> Engines::getEnginesList() throw (EngineException)
 {
@@ -35,6 +36,10 @@ void Engines::setEngineDefault(Engine &engine, Engine::Algorithm algorithm)
 	{
 		throw EngineException(EngineException::INTERNAL_ERROR, "Engines::setEngineDefault");
 	}
+	if (flag & ENGINE_METHOD_RAND)
+	{
+		Random::methodChanged();
+	}
 }
 
 Engine* Engines::getEngineDefault(Engine::Algorithm algorithm)
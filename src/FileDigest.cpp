@@ -0,0 +1,606 @@
+#include <libcryptosec/FileDigest.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//prefixos de separacao de dominio entre folhas e nos internos da arvore
+static const unsigned char LEAF_PREFIX = 0x00;
+static const unsigned char NODE_PREFIX = 0x01;
+
+/*
+ * Origem de dados lida de um descritor de arquivo.
+ */
+class FdSource : public FileDigest::Source
+{
+public:
+	FdSource(int fd) : fd(fd) {}
+
+	virtual long read(unsigned char *buffer, unsigned long size)
+	{
+		unsigned long total = 0;
+		ssize_t rc;
+
+		while (total < size)
+		{
+			rc = ::read(this->fd, buffer + total, size - total);
+			if (rc < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (rc < 0)
+			{
+				return -1;
+			}
+			if (rc == 0)
+			{
+				break;
+			}
+			total+= rc;
+		}
+		return total;
+	}
+
+	int fd;
+};
+
+/*
+ * Origem de dados lida de um std::istream.
+ */
+class StreamSource : public FileDigest::Source
+{
+public:
+	StreamSource(std::istream &stream) : stream(stream) {}
+
+	virtual long read(unsigned char *buffer, unsigned long size)
+	{
+		if (this->stream.bad())
+		{
+			return -1;
+		}
+		this->stream.read(reinterpret_cast<char*>(buffer), size);
+		if (this->stream.bad())
+		{
+			return -1;
+		}
+		return this->stream.gcount();
+	}
+
+	std::istream &stream;
+};
+
+/*
+ * Consumidor dos blocos lidos antecipadamente.
+ */
+class BlockConsumer
+{
+public:
+	virtual ~BlockConsumer() {}
+	virtual void consume(const unsigned char *data, size_t size) = 0;
+};
+
+/*
+ * Leitura antecipada com dois buffers: uma thread auxiliar le o proximo bloco
+ * enquanto a thread atual entrega o bloco corrente ao consumidor.
+ */
+class ReadAhead
+{
+public:
+	ReadAhead(FileDigest::Source &source, size_t size) : source(source), size(size), stop(false)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			this->buffers[i] = new unsigned char[size];
+			this->lengths[i] = 0;
+			this->full[i] = false;
+		}
+		pthread_mutex_init(&this->mutex, NULL);
+		pthread_cond_init(&this->cond, NULL);
+	}
+
+	virtual ~ReadAhead()
+	{
+		pthread_cond_destroy(&this->cond);
+		pthread_mutex_destroy(&this->mutex);
+		for (int i = 0; i < 2; i++)
+		{
+			delete[] this->buffers[i];
+		}
+	}
+
+	/*
+	 * Entrega todos os blocos ao consumidor. Retorna false em caso de erro de leitura.
+	 * Excecoes do consumidor sao propagadas apos o termino da thread de leitura.
+	 */
+	bool run(BlockConsumer &consumer)
+	{
+		pthread_t reader;
+		bool threaded;
+		bool ok = true;
+		long length;
+		int current = 0;
+
+		threaded = (pthread_create(&reader, NULL, ReadAhead::reader, this) == 0);
+		if (!threaded)
+		{
+			//sem thread auxiliar, le e consome alternadamente
+			while ((length = this->source.read(this->buffers[0], this->size)) > 0)
+			{
+				consumer.consume(this->buffers[0], length);
+			}
+			return length == 0;
+		}
+
+		try
+		{
+			while (true)
+			{
+				pthread_mutex_lock(&this->mutex);
+				while (!this->full[current])
+				{
+					pthread_cond_wait(&this->cond, &this->mutex);
+				}
+				length = this->lengths[current];
+				pthread_mutex_unlock(&this->mutex);
+
+				if (length <= 0)
+				{
+					ok = (length == 0);
+					break;
+				}
+
+				consumer.consume(this->buffers[current], length);
+
+				pthread_mutex_lock(&this->mutex);
+				this->full[current] = false;
+				pthread_cond_broadcast(&this->cond);
+				pthread_mutex_unlock(&this->mutex);
+				current^= 1;
+			}
+		}
+		catch (...)
+		{
+			this->finish(reader);
+			throw;
+		}
+
+		this->finish(reader);
+		return ok;
+	}
+
+protected:
+	void finish(pthread_t reader)
+	{
+		pthread_mutex_lock(&this->mutex);
+		this->stop = true;
+		pthread_cond_broadcast(&this->cond);
+		pthread_mutex_unlock(&this->mutex);
+		pthread_join(reader, NULL);
+	}
+
+	static void* reader(void *arg)
+	{
+		ReadAhead *self = static_cast<ReadAhead*>(arg);
+		long length;
+		int current = 0;
+
+		do
+		{
+			pthread_mutex_lock(&self->mutex);
+			while (self->full[current] && !self->stop)
+			{
+				pthread_cond_wait(&self->cond, &self->mutex);
+			}
+			if (self->stop)
+			{
+				pthread_mutex_unlock(&self->mutex);
+				break;
+			}
+			pthread_mutex_unlock(&self->mutex);
+
+			length = self->source.read(self->buffers[current], self->size);
+
+			pthread_mutex_lock(&self->mutex);
+			self->lengths[current] = length;
+			self->full[current] = true;
+			pthread_cond_broadcast(&self->cond);
+			pthread_mutex_unlock(&self->mutex);
+			current^= 1;
+		} while (length > 0);
+
+		return NULL;
+	}
+
+	FileDigest::Source &source;
+	size_t size;
+	unsigned char *buffers[2];
+	long lengths[2];
+	bool full[2];
+	bool stop;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+/*
+ * Resumo convencional: atualiza um unico contexto com cada bloco.
+ */
+class StandardConsumer : public BlockConsumer
+{
+public:
+	StandardConsumer(EVP_MD_CTX *ctx) : ctx(ctx) {}
+
+	virtual void consume(const unsigned char *data, size_t size)
+	{
+		if (!EVP_DigestUpdate(this->ctx, data, size))
+		{
+			throw MessageDigestException(MessageDigestException::CTX_UPDATE, "FileDigest::digestSource");
+		}
+	}
+
+	EVP_MD_CTX *ctx;
+};
+
+/*
+ * Resumo em arvore: calcula as folhas dos blocos lidos.
+ */
+class TreeConsumer : public BlockConsumer
+{
+public:
+	typedef void (FileDigest::*HashLeaves)(const unsigned char*, size_t, std::vector<unsigned char>&);
+
+	TreeConsumer(FileDigest *digest, HashLeaves hashLeaves, std::vector<unsigned char> &leaves) :
+			digest(digest), hashLeaves(hashLeaves), leaves(leaves)
+	{
+	}
+
+	virtual void consume(const unsigned char *data, size_t size)
+	{
+		(this->digest->*this->hashLeaves)(data, size, this->leaves);
+	}
+
+	FileDigest *digest;
+	HashLeaves hashLeaves;
+	std::vector<unsigned char> &leaves;
+};
+
+/*
+ * Calcula as folhas dos blocos [begin, end) de um buffer.
+ */
+class LeafTask : public ThreadPool::Task
+{
+public:
+	LeafTask(const EVP_MD *md, const unsigned char *data, size_t size, unsigned int chunkSize,
+			size_t begin, size_t end, unsigned char *output, unsigned int mdSize) :
+			md(md), data(data), size(size), chunkSize(chunkSize), begin(begin), end(end), output(output), mdSize(mdSize), ok(false)
+	{
+	}
+
+	virtual void run()
+	{
+		EVP_MD_CTX *ctx;
+		size_t offset;
+		size_t length;
+		unsigned int ndigest;
+
+		if (!(ctx = EVP_MD_CTX_new()))
+		{
+			return;
+		}
+
+		this->ok = true;
+		for (size_t i = this->begin; i < this->end && this->ok; i++)
+		{
+			offset = i * this->chunkSize;
+			length = std::min<size_t>(this->chunkSize, this->size - offset);
+			this->ok = EVP_DigestInit_ex(ctx, this->md, NULL)
+					&& EVP_DigestUpdate(ctx, &LEAF_PREFIX, 1)
+					&& EVP_DigestUpdate(ctx, this->data + offset, length)
+					&& EVP_DigestFinal_ex(ctx, this->output + i * this->mdSize, &ndigest);
+		}
+
+		EVP_MD_CTX_free(ctx);
+	}
+
+	const EVP_MD *md;
+	const unsigned char *data;
+	size_t size;
+	unsigned int chunkSize;
+	size_t begin;
+	size_t end;
+	unsigned char *output;
+	unsigned int mdSize;
+	bool ok;
+};
+
+FileDigest::FileDigest(MessageDigest::Algorithm algorithm, FileDigest::Mode mode, ThreadPool *pool, unsigned int chunkSize)
+{
+	this->algorithm = algorithm;
+	this->mode = mode;
+	this->pool = pool;
+	this->chunkSize = (chunkSize > 0) ? chunkSize : FileDigest::DEFAULT_CHUNK_SIZE;
+	this->md = MessageDigest::getMessageDigest(algorithm);
+	this->fetched = NULL;
+	this->mdSize = 0;
+	if (this->md)
+	{
+		this->fetched = EVP_MD_fetch(NULL, EVP_MD_get0_name(this->md), NULL);
+		if (this->fetched)
+		{
+			this->md = this->fetched;
+		}
+		this->mdSize = EVP_MD_size(this->md);
+	}
+}
+
+FileDigest::~FileDigest()
+{
+	EVP_MD_free(this->fetched);
+}
+
+ByteArray FileDigest::digestFile(std::string const &path) throw (MessageDigestException)
+{
+	struct stat info;
+	void *mapped;
+	int fd;
+
+	if (!this->md)
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_ALGORITHM, "FileDigest::digestFile");
+	}
+
+	fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw MessageDigestException(MessageDigestException::READING_CONTENT, "FileDigest::digestFile");
+	}
+
+	if (this->mode == FileDigest::TREE && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED)
+		{
+			close(fd);
+			try
+			{
+				ByteArray ret = this->digestTree(static_cast<const unsigned char*>(mapped), info.st_size);
+				munmap(mapped, info.st_size);
+				return ret;
+			}
+			catch (...)
+			{
+				munmap(mapped, info.st_size);
+				throw;
+			}
+		}
+	}
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	FdSource source(fd);
+	try
+	{
+		ByteArray ret = this->digestSource(source);
+		close(fd);
+		return ret;
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+}
+
+ByteArray FileDigest::digestStream(std::istream &stream) throw (MessageDigestException)
+{
+	StreamSource source(stream);
+
+	if (!this->md)
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_ALGORITHM, "FileDigest::digestStream");
+	}
+
+	return this->digestSource(source);
+}
+
+MessageDigest::Algorithm FileDigest::getAlgorithm() const
+{
+	return this->algorithm;
+}
+
+FileDigest::Mode FileDigest::getMode() const
+{
+	return this->mode;
+}
+
+unsigned int FileDigest::getChunkSize() const
+{
+	return this->chunkSize;
+}
+
+ByteArray FileDigest::digestSource(FileDigest::Source &source) throw (MessageDigestException)
+{
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int ndigest;
+	size_t bufferSize;
+	bool ok;
+
+	if (this->mode == FileDigest::STANDARD)
+	{
+		EVP_MD_CTX *ctx;
+
+		if (!(ctx = EVP_MD_CTX_new()) || !EVP_DigestInit_ex(ctx, this->md, NULL))
+		{
+			EVP_MD_CTX_free(ctx);
+			throw MessageDigestException(MessageDigestException::CTX_INIT, "FileDigest::digestSource");
+		}
+
+		StandardConsumer consumer(ctx);
+		ReadAhead readAhead(source, this->chunkSize);
+		try
+		{
+			ok = readAhead.run(consumer);
+		}
+		catch (...)
+		{
+			EVP_MD_CTX_free(ctx);
+			throw;
+		}
+
+		if (!ok)
+		{
+			EVP_MD_CTX_free(ctx);
+			throw MessageDigestException(MessageDigestException::READING_CONTENT, "FileDigest::digestSource");
+		}
+
+		ok = EVP_DigestFinal_ex(ctx, digest, &ndigest);
+		EVP_MD_CTX_free(ctx);
+		if (!ok)
+		{
+			throw MessageDigestException(MessageDigestException::CTX_FINISH, "FileDigest::digestSource");
+		}
+
+		return ByteArray(digest, ndigest);
+	}
+
+	//le varios blocos por vez, para que todas as threads tenham folhas a calcular
+	std::vector<unsigned char> leaves;
+	bufferSize = this->chunkSize;
+	if (this->pool)
+	{
+		bufferSize*= this->pool->getSize();
+	}
+
+	TreeConsumer consumer(this, &FileDigest::hashLeaves, leaves);
+	ReadAhead readAhead(source, bufferSize);
+	if (!readAhead.run(consumer))
+	{
+		throw MessageDigestException(MessageDigestException::READING_CONTENT, "FileDigest::digestSource");
+	}
+
+	if (leaves.empty())
+	{
+		this->hashLeaves(NULL, 0, leaves);
+	}
+
+	return this->hashRoot(leaves);
+}
+
+ByteArray FileDigest::digestTree(const unsigned char *data, size_t size) throw (MessageDigestException)
+{
+	std::vector<unsigned char> leaves;
+
+	this->hashLeaves(data, size, leaves);
+
+	return this->hashRoot(leaves);
+}
+
+void FileDigest::hashLeaves(const unsigned char *data, size_t size, std::vector<unsigned char> &leaves)
+		throw (MessageDigestException)
+{
+	std::vector<LeafTask> batch;
+	std::vector<ThreadPool::Task*> tasks;
+	size_t count;
+	size_t perTask;
+	size_t ntasks;
+	size_t offset;
+	bool ok = true;
+
+	//conteudo vazio gera um unico bloco vazio
+	count = (size + this->chunkSize - 1) / this->chunkSize;
+	if (count == 0)
+	{
+		count = 1;
+	}
+
+	offset = leaves.size();
+	leaves.resize(offset + count * this->mdSize);
+
+	ntasks = 1;
+	if (this->pool)
+	{
+		ntasks = std::min<size_t>(count, this->pool->getSize() * 4);
+	}
+	perTask = (count + ntasks - 1) / ntasks;
+
+	batch.reserve(ntasks);
+	for (size_t begin = 0; begin < count; begin+= perTask)
+	{
+		batch.push_back(LeafTask(this->md, data, size, this->chunkSize, begin, std::min(begin + perTask, count),
+				&leaves[offset], this->mdSize));
+	}
+
+	if (batch.size() == 1)
+	{
+		batch[0].run();
+	}
+	else
+	{
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			tasks.push_back(&batch[i]);
+		}
+		this->pool->execute(tasks);
+	}
+
+	for (size_t i = 0; i < batch.size(); i++)
+	{
+		ok = ok && batch[i].ok;
+	}
+	if (!ok)
+	{
+		throw MessageDigestException(MessageDigestException::CTX_FINISH, "FileDigest::hashLeaves");
+	}
+}
+
+ByteArray FileDigest::hashRoot(std::vector<unsigned char> &leaves) throw (MessageDigestException)
+{
+	EVP_MD_CTX *ctx;
+	unsigned char *level;
+	unsigned int ndigest;
+	size_t count = leaves.size() / this->mdSize;
+	size_t next;
+	bool ok = true;
+
+	//algoritmos sem tamanho fixo de resumo (ex.: identidade) nao formam arvore
+	if (this->mdSize == 0 || leaves.empty())
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_ALGORITHM, "FileDigest::hashRoot");
+	}
+
+	if (!(ctx = EVP_MD_CTX_new()))
+	{
+		throw MessageDigestException(MessageDigestException::CTX_INIT, "FileDigest::hashRoot");
+	}
+
+	//cada nivel e calculado no proprio buffer das folhas, sobrescrevendo o nivel anterior
+	level = &leaves[0];
+	while (count > 1 && ok)
+	{
+		next = 0;
+		for (size_t i = 0; i + 1 < count && ok; i+= 2)
+		{
+			ok = EVP_DigestInit_ex(ctx, this->md, NULL)
+					&& EVP_DigestUpdate(ctx, &NODE_PREFIX, 1)
+					&& EVP_DigestUpdate(ctx, level + i * this->mdSize, 2 * this->mdSize)
+					&& EVP_DigestFinal_ex(ctx, level + next * this->mdSize, &ndigest);
+			next++;
+		}
+		if (count % 2)
+		{
+			memmove(level + next * this->mdSize, level + (count - 1) * this->mdSize, this->mdSize);
+			next++;
+		}
+		count = next;
+	}
+
+	EVP_MD_CTX_free(ctx);
+	if (!ok)
+	{
+		throw MessageDigestException(MessageDigestException::CTX_FINISH, "FileDigest::hashRoot");
+	}
+
+	return ByteArray(level, this->mdSize);
+}
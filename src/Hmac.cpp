@@ -29,10 +29,37 @@ Hmac::Hmac(ByteArray key, MessageDigest::Algorithm algorithm, Engine &engine) th
 	this->init( key, algorithm, engine );
 }
 
+Hmac::Hmac(const Hmac &hmac) throw (HmacException) {
+	this->state = Hmac::NO_INIT;
+	this->ctx = HMAC_CTX_new();
+	*this = hmac;
+}
+
 Hmac::~Hmac() {
 	HMAC_CTX_free(this->ctx);
 }
 
+Hmac& Hmac::operator=(const Hmac &hmac) throw (HmacException) {
+	if (this == &hmac)
+	{
+		return *this;
+	}
+
+	this->algorithm = hmac.algorithm;
+	if (hmac.state == Hmac::NO_INIT)
+	{
+		HMAC_CTX_reset( this->ctx );
+	}
+	else if (!HMAC_CTX_copy( this->ctx, hmac.ctx ))
+	{
+		this->state = Hmac::NO_INIT;
+		throw HmacException(HmacException::CTX_INIT, "Hmac::operator=");
+	}
+	this->state = hmac.state;
+
+	return *this;
+}
+
 void Hmac::init(ByteArray &key, MessageDigest::Algorithm algorithm) throw (HmacException) {
 	if (this->state != Hmac::NO_INIT)
 	{
@@ -80,7 +107,7 @@ void Hmac::init(std::string key, MessageDigest::Algorithm algorithm, Engine &eng
 }
 
 void Hmac::update(ByteArray &data) throw (HmacException, InvalidStateException) {
-	if (this->state == Hmac::NO_INIT)
+	if (this->state == Hmac::NO_INIT || this->state == Hmac::FINAL)
 	{
 		throw InvalidStateException("Hmac::update");
 	}
@@ -120,24 +147,65 @@ ByteArray Hmac::doFinal(std::string data) throw (HmacException, InvalidStateExce
 }
 
 ByteArray Hmac::doFinal() throw (HmacException, InvalidStateException) {
-	if (this->state == Hmac::NO_INIT || this->state == Hmac::INIT)
+	if (this->state != Hmac::UPDATE)
 	{
 		throw InvalidStateException("Hmac::doFinal");
 	}
 
+	unsigned char md[EVP_MAX_MD_SIZE];
 	unsigned int size;
-	unsigned char *md = new unsigned char[EVP_MAX_MD_SIZE + 1];
-	int rc = HMAC_Final( this->ctx, md, &size );
-	HMAC_CTX_reset( this->ctx ); //martin: HMAC_CTX_cleanup -> HMAC_CTX_free, see openssl1.1.0c/CHANGES:647
-	this->state = Hmac::NO_INIT;
+
+	size = this->finalInto( md, sizeof(md) );
+
+	return ByteArray( md, size );
+}
+
+unsigned int Hmac::finalInto(unsigned char *buffer, unsigned int size) throw (HmacException, InvalidStateException) {
+	if (this->state != Hmac::UPDATE)
+	{
+		throw InvalidStateException("Hmac::finalInto");
+	}
+
+	if (size < HMAC_size( this->ctx ))
+	{
+		throw HmacException(HmacException::CTX_FINISH, "Hmac::finalInto");
+	}
+
+	unsigned int len;
+	int rc = HMAC_Final( this->ctx, buffer, &len );
+	if (!rc)
+	{
+		HMAC_CTX_reset( this->ctx );
+		this->state = Hmac::NO_INIT;
+		throw HmacException(HmacException::CTX_FINISH, "Hmac::finalInto");
+	}
+	this->state = Hmac::FINAL;
+
+	return len;
+}
+
+void Hmac::reset() throw (HmacException, InvalidStateException) {
+	if (this->state == Hmac::NO_INIT)
+	{
+		throw InvalidStateException("Hmac::reset");
+	}
+
+	//chave e algoritmo nulos: o OpenSSL restaura o contexto interno (ipad) ja calculado
+	int rc = HMAC_Init_ex( this->ctx, NULL, 0, NULL, NULL );
 	if (!rc)
 	{
-		delete( md );
-		throw HmacException(HmacException::CTX_FINISH, "Hmac::doFinal");
+		this->state = Hmac::NO_INIT;
+		throw HmacException(HmacException::CTX_INIT, "Hmac::reset");
 	}
 
-	ByteArray content;
-	content.setDataPointer( md, size );
+	this->state = Hmac::INIT;
+}
+
+unsigned int Hmac::getSize() const throw (InvalidStateException) {
+	if (this->state == Hmac::NO_INIT)
+	{
+		throw InvalidStateException("Hmac::getSize");
+	}
 
-	return content;
+	return EVP_MD_size( MessageDigest::getMessageDigest( this->algorithm ) );
 }
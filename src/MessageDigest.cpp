@@ -1,7 +1,26 @@
 #include <libcryptosec/MessageDigest.h>
 
+#include <openssl/md5.h>
+#include <openssl/sha.h>
+#include <algorithm>
+
+/*
+ * Contextos de baixo nivel utilizados no modo exportavel.
+ */
+union LowLevelCtx
+{
+	MD5_CTX md5;
+	SHA_CTX sha1;
+	SHA256_CTX sha256;
+	SHA512_CTX sha512;
+};
+
+//versao do formato serializado do estado intermediario
+static const unsigned char MIDSTATE_VERSION = 1;
+
 MessageDigest::MessageDigest()
 {
+	this->lowLevelCtx = NULL;
 	this->ctx = EVP_MD_CTX_new();
 	this->state = MessageDigest::NO_INIT;
 }
@@ -13,6 +32,7 @@ MessageDigest::MessageDigest(MessageDigest::Algorithm algorithm)
 	const EVP_MD *md;
 	this->state = MessageDigest::INIT;
 	this->algorithm = algorithm;
+	this->lowLevelCtx = NULL;
 	this->ctx = EVP_MD_CTX_new();
 	md = MessageDigest::getMessageDigest(this->algorithm);
 	EVP_MD_CTX_init(this->ctx);
@@ -30,6 +50,7 @@ MessageDigest::MessageDigest(MessageDigest::Algorithm algorithm, Engine &engine)
 	const EVP_MD *md;
 	this->state = MessageDigest::INIT;
 	this->algorithm = algorithm;
+	this->lowLevelCtx = NULL;
 	this->ctx = EVP_MD_CTX_new();
 	md = MessageDigest::getMessageDigest(this->algorithm);
 	EVP_MD_CTX_init(this->ctx);
@@ -40,11 +61,55 @@ MessageDigest::MessageDigest(MessageDigest::Algorithm algorithm, Engine &engine)
 	}
 }
 
+MessageDigest::MessageDigest(const MessageDigest &md) throw (MessageDigestException)
+{
+	this->state = MessageDigest::NO_INIT;
+	this->lowLevelCtx = NULL;
+	this->ctx = EVP_MD_CTX_new();
+	*this = md;
+}
+
 MessageDigest::~MessageDigest()
 {
+	this->freeLowLevelCtx();
 	EVP_MD_CTX_free(this->ctx);
 }
 
+MessageDigest& MessageDigest::operator=(const MessageDigest &md) throw (MessageDigestException)
+{
+	if (this == &md)
+	{
+		return *this;
+	}
+
+	this->freeLowLevelCtx();
+	EVP_MD_CTX_reset(this->ctx);
+	this->algorithm = md.algorithm;
+	this->state = MessageDigest::NO_INIT;
+
+	if (md.lowLevelCtx)
+	{
+		this->lowLevelCtx = new LowLevelCtx(*static_cast<LowLevelCtx*>(md.lowLevelCtx));
+	}
+	else if (md.state != MessageDigest::NO_INIT && !EVP_MD_CTX_copy_ex(this->ctx, md.ctx))
+	{
+		throw MessageDigestException(MessageDigestException::CTX_INIT, "MessageDigest::operator=");
+	}
+	this->state = md.state;
+
+	return *this;
+}
+
+void MessageDigest::freeLowLevelCtx()
+{
+	if (this->lowLevelCtx)
+	{
+		OPENSSL_cleanse(this->lowLevelCtx, sizeof(LowLevelCtx));
+		delete static_cast<LowLevelCtx*>(this->lowLevelCtx);
+		this->lowLevelCtx = NULL;
+	}
+}
+
 void MessageDigest::init(MessageDigest::Algorithm algorithm)
 		throw (MessageDigestException)
 {
@@ -53,6 +118,7 @@ void MessageDigest::init(MessageDigest::Algorithm algorithm)
 	if (this->state != MessageDigest::NO_INIT){
 		EVP_MD_CTX_reset(this->ctx); //martin: EVP_MD_CTX_cleanup -> EVP_MD_CTX_reset see openssl1.1.c/CHANGES:647
 	}
+	this->freeLowLevelCtx();
 	this->algorithm = algorithm;
 	md = MessageDigest::getMessageDigest(this->algorithm);
 	rc = EVP_DigestInit(this->ctx, md);
@@ -71,6 +137,7 @@ void MessageDigest::init(MessageDigest::Algorithm algorithm, Engine &engine)
 	if (this->state != MessageDigest::NO_INIT){
 		EVP_MD_CTX_reset(this->ctx); //martin: EVP_MD_CTX_cleanup -> EVP_MD_CTX_reset see openssl1.1.c/CHANGES:647
 	}
+	this->freeLowLevelCtx();
 	this->algorithm = algorithm;
 	md = MessageDigest::getMessageDigest(this->algorithm);
 	EVP_MD_CTX_init(this->ctx);
@@ -82,6 +149,280 @@ void MessageDigest::init(MessageDigest::Algorithm algorithm, Engine &engine)
 	this->state = MessageDigest::INIT;
 }
 
+void MessageDigest::init(MessageDigest::Algorithm algorithm, bool exportable) throw (MessageDigestException)
+{
+	LowLevelCtx *lowLevel;
+	int rc = 0;
+
+	if (!exportable)
+	{
+		this->init(algorithm);
+		return;
+	}
+
+	lowLevel = new LowLevelCtx();
+	switch (algorithm)
+	{
+		case MessageDigest::MD5:
+			rc = MD5_Init(&lowLevel->md5);
+			break;
+		case MessageDigest::SHA1:
+			rc = SHA1_Init(&lowLevel->sha1);
+			break;
+		case MessageDigest::SHA224:
+			rc = SHA224_Init(&lowLevel->sha256);
+			break;
+		case MessageDigest::SHA256:
+			rc = SHA256_Init(&lowLevel->sha256);
+			break;
+		case MessageDigest::SHA384:
+			rc = SHA384_Init(&lowLevel->sha512);
+			break;
+		case MessageDigest::SHA512:
+			rc = SHA512_Init(&lowLevel->sha512);
+			break;
+		default:
+			delete lowLevel;
+			throw MessageDigestException(MessageDigestException::INVALID_ALGORITHM, "MessageDigest::init");
+	}
+	if (!rc)
+	{
+		delete lowLevel;
+		throw MessageDigestException(MessageDigestException::CTX_INIT, "MessageDigest::init");
+	}
+
+	if (this->state != MessageDigest::NO_INIT)
+	{
+		EVP_MD_CTX_reset(this->ctx);
+	}
+	this->freeLowLevelCtx();
+	this->lowLevelCtx = lowLevel;
+	this->algorithm = algorithm;
+	this->state = MessageDigest::INIT;
+}
+
+/*
+ * Escreve value em big-endian com size bytes.
+ */
+static void putBigEndian(std::vector<unsigned char> &out, unsigned long long value, unsigned int size)
+{
+	for (int i = size - 1; i >= 0; i--)
+	{
+		out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+}
+
+/*
+ * Le size bytes em big-endian a partir de in.
+ */
+static unsigned long long getBigEndian(const unsigned char *in, unsigned int size)
+{
+	unsigned long long ret = 0;
+
+	for (unsigned int i = 0; i < size; i++)
+	{
+		ret = (ret << 8) | in[i];
+	}
+	return ret;
+}
+
+/*
+ * Parametros do estado de cada algoritmo no modo exportavel.
+ */
+static bool getMidstateLayout(MessageDigest::Algorithm algorithm, unsigned int &nwords, unsigned int &wordSize, unsigned int &blockSize)
+{
+	switch (algorithm)
+	{
+		case MessageDigest::MD5:
+			nwords = 4;
+			wordSize = 4;
+			blockSize = MD5_CBLOCK;
+			return true;
+		case MessageDigest::SHA1:
+			nwords = 5;
+			wordSize = 4;
+			blockSize = SHA_CBLOCK;
+			return true;
+		case MessageDigest::SHA224: case MessageDigest::SHA256:
+			nwords = 8;
+			wordSize = 4;
+			blockSize = SHA256_CBLOCK;
+			return true;
+		case MessageDigest::SHA384: case MessageDigest::SHA512:
+			nwords = 8;
+			wordSize = 8;
+			blockSize = SHA512_CBLOCK;
+			return true;
+		default:
+			return false;
+	}
+}
+
+ByteArray MessageDigest::getMidstate() const throw (InvalidStateException)
+{
+	LowLevelCtx *lowLevel = static_cast<LowLevelCtx*>(this->lowLevelCtx);
+	std::vector<unsigned char> out;
+	unsigned long long words[8];
+	unsigned long long bitsHigh = 0;
+	unsigned long long bitsLow;
+	const unsigned char *buffered;
+	unsigned int num;
+	unsigned int nwords;
+	unsigned int wordSize;
+	unsigned int blockSize;
+
+	if (this->state == MessageDigest::NO_INIT || !lowLevel)
+	{
+		throw InvalidStateException("MessageDigest::getMidstate");
+	}
+
+	getMidstateLayout(this->algorithm, nwords, wordSize, blockSize);
+	switch (this->algorithm)
+	{
+		case MessageDigest::MD5:
+			words[0] = lowLevel->md5.A;
+			words[1] = lowLevel->md5.B;
+			words[2] = lowLevel->md5.C;
+			words[3] = lowLevel->md5.D;
+			bitsLow = ((unsigned long long) lowLevel->md5.Nh << 32) | lowLevel->md5.Nl;
+			buffered = reinterpret_cast<const unsigned char*>(lowLevel->md5.data);
+			num = lowLevel->md5.num;
+			break;
+		case MessageDigest::SHA1:
+			words[0] = lowLevel->sha1.h0;
+			words[1] = lowLevel->sha1.h1;
+			words[2] = lowLevel->sha1.h2;
+			words[3] = lowLevel->sha1.h3;
+			words[4] = lowLevel->sha1.h4;
+			bitsLow = ((unsigned long long) lowLevel->sha1.Nh << 32) | lowLevel->sha1.Nl;
+			buffered = reinterpret_cast<const unsigned char*>(lowLevel->sha1.data);
+			num = lowLevel->sha1.num;
+			break;
+		case MessageDigest::SHA224: case MessageDigest::SHA256:
+			for (unsigned int i = 0; i < nwords; i++)
+			{
+				words[i] = lowLevel->sha256.h[i];
+			}
+			bitsLow = ((unsigned long long) lowLevel->sha256.Nh << 32) | lowLevel->sha256.Nl;
+			buffered = reinterpret_cast<const unsigned char*>(lowLevel->sha256.data);
+			num = lowLevel->sha256.num;
+			break;
+		default:
+			for (unsigned int i = 0; i < nwords; i++)
+			{
+				words[i] = lowLevel->sha512.h[i];
+			}
+			bitsHigh = lowLevel->sha512.Nh;
+			bitsLow = lowLevel->sha512.Nl;
+			buffered = lowLevel->sha512.u.p;
+			num = lowLevel->sha512.num;
+			break;
+	}
+
+	out.push_back(MIDSTATE_VERSION);
+	out.push_back(static_cast<unsigned char>(this->algorithm));
+	putBigEndian(out, bitsHigh, 8);
+	putBigEndian(out, bitsLow, 8);
+	for (unsigned int i = 0; i < nwords; i++)
+	{
+		putBigEndian(out, words[i], wordSize);
+	}
+	out.insert(out.end(), buffered, buffered + num);
+
+	return ByteArray(&out[0], out.size());
+}
+
+void MessageDigest::setMidstate(ByteArray &midstate) throw (MessageDigestException)
+{
+	const unsigned char *in = midstate.getDataPointer();
+	MessageDigest::Algorithm algorithm;
+	LowLevelCtx *lowLevel;
+	unsigned long long words[8];
+	unsigned long long bitsHigh;
+	unsigned long long bitsLow;
+	unsigned int num;
+	unsigned int nwords;
+	unsigned int wordSize;
+	unsigned int blockSize;
+	unsigned int offset;
+
+	if (midstate.size() < 18 || in[0] != MIDSTATE_VERSION)
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_MIDSTATE, "MessageDigest::setMidstate");
+	}
+	algorithm = static_cast<MessageDigest::Algorithm>(in[1]);
+	if (!getMidstateLayout(algorithm, nwords, wordSize, blockSize))
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_MIDSTATE, "MessageDigest::setMidstate");
+	}
+
+	bitsHigh = getBigEndian(in + 2, 8);
+	bitsLow = getBigEndian(in + 10, 8);
+	num = (bitsLow / 8) % blockSize;
+	offset = 18 + nwords * wordSize;
+	if ((bitsLow % 8) != 0 || midstate.size() != offset + num || (wordSize == 4 && bitsHigh != 0))
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_MIDSTATE, "MessageDigest::setMidstate");
+	}
+	for (unsigned int i = 0; i < nwords; i++)
+	{
+		words[i] = getBigEndian(in + 18 + i * wordSize, wordSize);
+	}
+
+	//init define os campos que nao fazem parte do estado (ex.: md_len)
+	this->init(algorithm, true);
+	lowLevel = static_cast<LowLevelCtx*>(this->lowLevelCtx);
+	switch (algorithm)
+	{
+		case MessageDigest::MD5:
+			lowLevel->md5.A = words[0];
+			lowLevel->md5.B = words[1];
+			lowLevel->md5.C = words[2];
+			lowLevel->md5.D = words[3];
+			lowLevel->md5.Nl = bitsLow & 0xffffffffUL;
+			lowLevel->md5.Nh = bitsLow >> 32;
+			memcpy(lowLevel->md5.data, in + offset, num);
+			lowLevel->md5.num = num;
+			break;
+		case MessageDigest::SHA1:
+			lowLevel->sha1.h0 = words[0];
+			lowLevel->sha1.h1 = words[1];
+			lowLevel->sha1.h2 = words[2];
+			lowLevel->sha1.h3 = words[3];
+			lowLevel->sha1.h4 = words[4];
+			lowLevel->sha1.Nl = bitsLow & 0xffffffffUL;
+			lowLevel->sha1.Nh = bitsLow >> 32;
+			memcpy(lowLevel->sha1.data, in + offset, num);
+			lowLevel->sha1.num = num;
+			break;
+		case MessageDigest::SHA224: case MessageDigest::SHA256:
+			for (unsigned int i = 0; i < nwords; i++)
+			{
+				lowLevel->sha256.h[i] = words[i];
+			}
+			lowLevel->sha256.Nl = bitsLow & 0xffffffffUL;
+			lowLevel->sha256.Nh = bitsLow >> 32;
+			memcpy(lowLevel->sha256.data, in + offset, num);
+			lowLevel->sha256.num = num;
+			break;
+		default:
+			for (unsigned int i = 0; i < nwords; i++)
+			{
+				lowLevel->sha512.h[i] = words[i];
+			}
+			lowLevel->sha512.Nl = bitsLow;
+			lowLevel->sha512.Nh = bitsHigh;
+			memcpy(lowLevel->sha512.u.p, in + offset, num);
+			lowLevel->sha512.num = num;
+			break;
+	}
+
+	if (bitsHigh || bitsLow)
+	{
+		this->state = MessageDigest::UPDATE;
+	}
+}
+
 void MessageDigest::update(ByteArray &data) throw (MessageDigestException, InvalidStateException)
 {
 	int rc;
@@ -89,7 +430,35 @@ void MessageDigest::update(ByteArray &data) throw (MessageDigestException, Inval
 	{
 		throw InvalidStateException("MessageDigest::update");
 	}
-	rc = EVP_DigestUpdate(this->ctx, data.getDataPointer(), data.size());
+	if (this->lowLevelCtx)
+	{
+		LowLevelCtx *lowLevel = static_cast<LowLevelCtx*>(this->lowLevelCtx);
+		switch (this->algorithm)
+		{
+			case MessageDigest::MD5:
+				rc = MD5_Update(&lowLevel->md5, data.getDataPointer(), data.size());
+				break;
+			case MessageDigest::SHA1:
+				rc = SHA1_Update(&lowLevel->sha1, data.getDataPointer(), data.size());
+				break;
+			case MessageDigest::SHA224:
+				rc = SHA224_Update(&lowLevel->sha256, data.getDataPointer(), data.size());
+				break;
+			case MessageDigest::SHA256:
+				rc = SHA256_Update(&lowLevel->sha256, data.getDataPointer(), data.size());
+				break;
+			case MessageDigest::SHA384:
+				rc = SHA384_Update(&lowLevel->sha512, data.getDataPointer(), data.size());
+				break;
+			default:
+				rc = SHA512_Update(&lowLevel->sha512, data.getDataPointer(), data.size());
+				break;
+		}
+	}
+	else
+	{
+		rc = EVP_DigestUpdate(this->ctx, data.getDataPointer(), data.size());
+	}
 	if (!rc)
 	{
 		throw MessageDigestException(MessageDigestException::CTX_UPDATE, "MessageDigest::update");
@@ -113,7 +482,37 @@ ByteArray MessageDigest::doFinal() throw (MessageDigestException, InvalidStateEx
 		throw InvalidStateException("MessageDigest::doFinal");
 	}
 	digest = (unsigned char *)calloc(EVP_MAX_MD_SIZE + 1, sizeof(unsigned char));
-	rc = EVP_DigestFinal_ex(this->ctx, digest, &ndigest);
+	if (this->lowLevelCtx)
+	{
+		LowLevelCtx *lowLevel = static_cast<LowLevelCtx*>(this->lowLevelCtx);
+		switch (this->algorithm)
+		{
+			case MessageDigest::MD5:
+				rc = MD5_Final(digest, &lowLevel->md5);
+				break;
+			case MessageDigest::SHA1:
+				rc = SHA1_Final(digest, &lowLevel->sha1);
+				break;
+			case MessageDigest::SHA224:
+				rc = SHA224_Final(digest, &lowLevel->sha256);
+				break;
+			case MessageDigest::SHA256:
+				rc = SHA256_Final(digest, &lowLevel->sha256);
+				break;
+			case MessageDigest::SHA384:
+				rc = SHA384_Final(digest, &lowLevel->sha512);
+				break;
+			default:
+				rc = SHA512_Final(digest, &lowLevel->sha512);
+				break;
+		}
+		ndigest = MessageDigest::getDigestSize(this->algorithm);
+		this->freeLowLevelCtx();
+	}
+	else
+	{
+		rc = EVP_DigestFinal_ex(this->ctx, digest, &ndigest);
+	}
 	EVP_MD_CTX_reset(this->ctx); //martin: EVP_MD_CTX_cleanup -> EVP_MD_CTX_reset see openssl1.1.c/CHANGES:647
 	this->state = MessageDigest::NO_INIT;
 	if (!rc)
@@ -138,6 +537,161 @@ ByteArray MessageDigest::doFinal(std::string &data) throw (MessageDigestExceptio
 	return this->doFinal();
 }
 
+/*
+ * Calcula os resumos das entradas [begin, end) reaproveitando um unico contexto.
+ */
+static bool digestRange(const EVP_MD *md, const unsigned char * const *data, const unsigned int *sizes,
+		unsigned int begin, unsigned int end, unsigned char *output, unsigned int mdSize)
+{
+	EVP_MD_CTX *ctx;
+	unsigned int ndigest;
+	bool ret = true;
+
+	ctx = EVP_MD_CTX_new();
+	if (!ctx)
+	{
+		return false;
+	}
+
+	for (unsigned int i = begin; i < end && ret; i++)
+	{
+		ret = EVP_DigestInit_ex(ctx, md, NULL)
+				&& EVP_DigestUpdate(ctx, data[i], sizes[i])
+				&& EVP_DigestFinal_ex(ctx, output + (size_t) i * mdSize, &ndigest);
+	}
+
+	EVP_MD_CTX_free(ctx);
+	return ret;
+}
+
+/*
+ * Fatia de um lote de resumos executada por uma thread do ThreadPool.
+ */
+class DigestBatchTask : public ThreadPool::Task
+{
+public:
+	DigestBatchTask(const EVP_MD *md, const unsigned char * const *data, const unsigned int *sizes,
+			unsigned int begin, unsigned int end, unsigned char *output, unsigned int mdSize) :
+			md(md), data(data), sizes(sizes), begin(begin), end(end), output(output), mdSize(mdSize), ok(false)
+	{
+	}
+
+	virtual void run()
+	{
+		this->ok = digestRange(this->md, this->data, this->sizes, this->begin, this->end, this->output, this->mdSize);
+	}
+
+	const EVP_MD *md;
+	const unsigned char * const *data;
+	const unsigned int *sizes;
+	unsigned int begin;
+	unsigned int end;
+	unsigned char *output;
+	unsigned int mdSize;
+	bool ok;
+};
+
+unsigned int MessageDigest::doFinal(MessageDigest::Algorithm algorithm, const unsigned char * const *data, const unsigned int *sizes,
+		unsigned int count, unsigned char *output, ThreadPool *pool) throw (MessageDigestException)
+{
+	//quantidade minima de entradas por tarefa, para que a divisao compense
+	const unsigned int minPerTask = 64;
+	const EVP_MD *md;
+	EVP_MD *fetched;
+	unsigned int mdSize;
+	unsigned int ntasks;
+	unsigned int perTask;
+	bool ok = true;
+
+	mdSize = MessageDigest::getDigestSize(algorithm);
+
+	//busca explicita do algoritmo, evitando a busca implicita no provider a cada EVP_DigestInit_ex
+	md = MessageDigest::getMessageDigest(algorithm);
+	fetched = EVP_MD_fetch(NULL, EVP_MD_get0_name(md), NULL);
+	if (fetched)
+	{
+		md = fetched;
+	}
+
+	ntasks = (count + minPerTask - 1) / minPerTask;
+	if (pool == NULL || pool->getSize() == 1 || ntasks <= 1)
+	{
+		ok = digestRange(md, data, sizes, 0, count, output, mdSize);
+	}
+	else
+	{
+		std::vector<DigestBatchTask> batch;
+		std::vector<ThreadPool::Task*> tasks;
+
+		if (ntasks > pool->getSize() * 4)
+		{
+			ntasks = pool->getSize() * 4;
+		}
+		perTask = (count + ntasks - 1) / ntasks;
+
+		batch.reserve(ntasks);
+		for (unsigned int begin = 0; begin < count; begin+= perTask)
+		{
+			batch.push_back(DigestBatchTask(md, data, sizes, begin, std::min(begin + perTask, count), output, mdSize));
+		}
+		for (unsigned int i = 0; i < batch.size(); i++)
+		{
+			tasks.push_back(&batch[i]);
+		}
+
+		pool->execute(tasks);
+
+		for (unsigned int i = 0; i < batch.size(); i++)
+		{
+			ok = ok && batch[i].ok;
+		}
+	}
+
+	EVP_MD_free(fetched);
+	if (!ok)
+	{
+		throw MessageDigestException(MessageDigestException::CTX_FINISH, "MessageDigest::doFinal");
+	}
+
+	return mdSize;
+}
+
+ByteArray MessageDigest::doFinal(MessageDigest::Algorithm algorithm, std::vector<ByteArray> &data, ThreadPool *pool)
+		throw (MessageDigestException)
+{
+	std::vector<const unsigned char*> pointers(data.size());
+	std::vector<unsigned int> sizes(data.size());
+	unsigned int mdSize;
+
+	for (unsigned int i = 0; i < data.size(); i++)
+	{
+		pointers[i] = data[i].getDataPointer();
+		sizes[i] = data[i].size();
+	}
+
+	mdSize = MessageDigest::getDigestSize(algorithm);
+	ByteArray ret(static_cast<unsigned int>(data.size() * mdSize));
+	if (!data.empty())
+	{
+		MessageDigest::doFinal(algorithm, &pointers[0], &sizes[0], data.size(), ret.getDataPointer(), pool);
+	}
+
+	return ret;
+}
+
+unsigned int MessageDigest::getDigestSize(MessageDigest::Algorithm algorithm) throw (MessageDigestException)
+{
+	const EVP_MD *md;
+
+	md = MessageDigest::getMessageDigest(algorithm);
+	if (!md)
+	{
+		throw MessageDigestException(MessageDigestException::INVALID_ALGORITHM, "MessageDigest::getDigestSize");
+	}
+
+	return EVP_MD_size(md);
+}
+
 MessageDigest::Algorithm MessageDigest::getAlgorithm() throw (InvalidStateException)
 {
 	if (this->state == MessageDigest::NO_INIT)
@@ -6,26 +6,35 @@ Pkcs12::Pkcs12(PKCS12* p12)
 	this->privKey = NULL;
 	this->cert = NULL;
 	this->pkcs12 = p12;
+	this->parsed = false;
 }
 
 Pkcs12::~Pkcs12()
+{
+	this->clear();
+	PKCS12_free(this->pkcs12);
+}
+
+void Pkcs12::clear()
 {
 	if(this->privKey != NULL)
 	{
 		delete this->privKey;
+		this->privKey = NULL;
 	}
 	
 	if(this->cert != NULL)
 	{
 		delete this->cert;
+		this->cert = NULL;
 	}
 	
 	for(unsigned int i = 0 ; i < this->ca.size() ; i++)
 	{
 		delete ca.at(i);
 	}
-	
-	PKCS12_free(this->pkcs12);
+	this->ca.clear();
+	this->parsed = false;
 }
 
 ByteArray Pkcs12::getDerEncoded() const throw(EncodeException)
@@ -61,10 +70,7 @@ PrivateKey* Pkcs12::getPrivKey(string password) throw(Pkcs12Exception)
 {
 	PrivateKey* ret = NULL;
 	
-	if(this->privKey == NULL)
-	{
-		this->parse(password);
-	}
+	this->parse(password);
 	
 	switch (this->privKey->getAlgorithm())
 	{
@@ -96,10 +102,7 @@ PrivateKey* Pkcs12::getPrivKey(string password) throw(Pkcs12Exception)
 
 Certificate* Pkcs12::getCertificate(string password) throw(Pkcs12Exception)
 {
-	if(this->privKey == NULL)
-	{
-		this->parse(password);
-	}
+	this->parse(password);
 	
 	return new Certificate(X509_dup(this->cert->getX509()));
 }
@@ -108,10 +111,7 @@ vector<Certificate*> Pkcs12::getAdditionalCertificates(string password) throw(Pk
 {
 	vector<Certificate*> ret;
 	
-	if(this->privKey == NULL)
-	{
-		this->parse(password);
-	}
+	this->parse(password);
 		
 	for(unsigned int i = 0 ; i < this->ca.size() ; i++)
 	{
@@ -128,6 +128,12 @@ void Pkcs12::parse(string password) throw(Pkcs12Exception)
 	STACK_OF(X509)* ca = NULL;
 	unsigned long opensslError = 0;
 	X509* tmp = NULL;
+	ByteArray digest = Pkcs12::getPasswordDigest(password);
+	
+	if(this->parsed && ByteArray::constantTimeEquals(digest, this->passwordDigest))
+	{
+		return;
+	}
 	
 	//Limpa fila de erros e carrega tabelas
 	ERR_clear_error();	
@@ -148,8 +154,11 @@ void Pkcs12::parse(string password) throw(Pkcs12Exception)
 				throw Pkcs12Exception(Pkcs12Exception::MAC_VERIFY_FAILURE, "Pkcs12::parse");
 				break;
 		}
+		throw Pkcs12Exception(Pkcs12Exception::UNKNOWN, "Pkcs12::parse");
 	}
 	
+	//substitui o conteudo obtido com outra passphrase, se houver
+	this->clear();
 	this->privKey = new PrivateKey(pkey);
 	this->cert = new Certificate(cert);
 			
@@ -160,4 +169,18 @@ void Pkcs12::parse(string password) throw(Pkcs12Exception)
 	}
 	
 	sk_X509_free(ca);
+	this->passwordDigest = digest;
+	this->parsed = true;
+}
+
+ByteArray Pkcs12::getPasswordDigest(string const& password)
+{
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int size = 0;
+	
+	if(!EVP_Digest(password.data(), password.size(), digest, &size, EVP_sha256(), NULL))
+	{
+		throw Pkcs12Exception(Pkcs12Exception::UNKNOWN, "Pkcs12::getPasswordDigest");
+	}
+	return ByteArray(digest, size);
 }
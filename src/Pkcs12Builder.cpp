@@ -1,10 +1,94 @@
 #include <libcryptosec/Pkcs12Builder.h>
 
+#include <algorithm>
+
+/* gera um pacote do lote de Pkcs12Builder::doFinal(std::vector<Pkcs12Builder::Entry> const&, ...) */
+class Pkcs12Task : public ThreadPool::Task
+{
+public:
+	Pkcs12Task(const Pkcs12Builder::Entry *entry, STACK_OF(PKCS12_SAFEBAG) *chain, int nidKey, int nidCert,
+			int iterations, const EVP_MD *md, int macIterations) :
+			entry(entry), chain(chain), nidKey(nidKey), nidCert(nidCert), iterations(iterations), md(md),
+			macIterations(macIterations), errorCode(Pkcs12Exception::UNKNOWN), ok(false)
+	{
+	}
+
+	virtual void run()
+	{
+		STACK_OF(PKCS12_SAFEBAG) *bags = NULL;
+		STACK_OF(PKCS12_SAFEBAG) *keyBags = NULL;
+		STACK_OF(PKCS7) *safes = NULL;
+		PKCS12_SAFEBAG *certBag = NULL;
+		PKCS12_SAFEBAG *keyBag = NULL;
+		PKCS12 *p12 = NULL;
+		const char *pass = this->entry->password.c_str();
+		unsigned char keyId[EVP_MAX_MD_SIZE];
+		unsigned int keyIdSize = 0;
+		unsigned char *data;
+		int size;
+
+		if (!X509_check_private_key(this->entry->cert->getX509(), this->entry->key->getEvpPkey()))
+		{
+			this->errorCode = Pkcs12Exception::KEY_AND_CERT_DO_NOT_MATCH;
+			return;
+		}
+		//mesmas bags geradas por PKCS12_create(), com a cadeia comum compartilhada entre os pacotes
+		if (!X509_digest(this->entry->cert->getX509(), EVP_sha1(), keyId, &keyIdSize)
+				|| (certBag = PKCS12_add_cert(&bags, this->entry->cert->getX509())) == NULL
+				|| !PKCS12_add_localkeyid(certBag, keyId, keyIdSize)
+				|| (this->entry->friendlyName.size() > 0
+						&& !PKCS12_add_friendlyname_asc(certBag, this->entry->friendlyName.c_str(), -1)))
+		{
+			sk_PKCS12_SAFEBAG_pop_free(bags, PKCS12_SAFEBAG_free);
+			return;
+		}
+		for (int i = 0; i < sk_PKCS12_SAFEBAG_num(this->chain); i++)
+		{
+			sk_PKCS12_SAFEBAG_push(bags, sk_PKCS12_SAFEBAG_value(this->chain, i));
+		}
+		if (PKCS12_add_safe(&safes, bags, this->nidCert, this->iterations, pass)
+				&& (keyBag = PKCS12_add_key(&keyBags, this->entry->key->getEvpPkey(), 0, this->iterations, this->nidKey, pass)) != NULL
+				&& PKCS12_add_localkeyid(keyBag, keyId, keyIdSize)
+				&& (this->entry->friendlyName.size() == 0
+						|| PKCS12_add_friendlyname_asc(keyBag, this->entry->friendlyName.c_str(), -1))
+				&& PKCS12_add_safe(&safes, keyBags, -1, 0, NULL))
+		{
+			p12 = PKCS12_add_safes(safes, 0);
+		}
+		//as bags da cadeia pertencem ao lote
+		PKCS12_SAFEBAG_free(certBag);
+		sk_PKCS12_SAFEBAG_free(bags);
+		sk_PKCS12_SAFEBAG_pop_free(keyBags, PKCS12_SAFEBAG_free);
+		sk_PKCS7_pop_free(safes, PKCS7_free);
+
+		if (p12 != NULL && PKCS12_set_mac(p12, pass, -1, NULL, 0, this->macIterations, this->md)
+				&& (size = i2d_PKCS12(p12, NULL)) > 0)
+		{
+			this->der = ByteArray(static_cast<unsigned int>(size));
+			data = this->der.getDataPointer();
+			this->ok = i2d_PKCS12(p12, &data) == size;
+		}
+		PKCS12_free(p12);
+	}
+
+	const Pkcs12Builder::Entry *entry;
+	STACK_OF(PKCS12_SAFEBAG) *chain;
+	int nidKey;
+	int nidCert;
+	int iterations;
+	const EVP_MD *md;
+	int macIterations;
+	Pkcs12Exception::ErrorCode errorCode;
+	ByteArray der;
+	bool ok;
+};
+
 Pkcs12Builder::Pkcs12Builder()
 {
 	this->key = NULL;
 	this->keyCert = NULL;
 	this->friendlyName = string("");
+	this->pool = NULL;
 }
 
 Pkcs12Builder::~Pkcs12Builder()
@@ -34,16 +118,129 @@ void Pkcs12Builder::clearAdditionalCerts() throw()
 }
 
 Pkcs12* Pkcs12Builder::doFinal(string password) const throw(Pkcs12Exception)
+{
+	return this->create(password, 0, 0, 0, NULL, 0);
+}
+
+Pkcs12* Pkcs12Builder::doFinal(string password, Pkcs12Builder::Encryption keyEncryption,
+		Pkcs12Builder::Encryption certEncryption, int iterations, MessageDigest::Algorithm macAlgorithm,
+		int macIterations) const throw(Pkcs12Exception)
+{
+	const EVP_MD *md;
+	if (iterations <= 0)
+	{
+		iterations = PKCS12_DEFAULT_ITER;
+	}
+	if (macIterations <= 0)
+	{
+		macIterations = iterations;
+	}
+	md = MessageDigest::getMessageDigest(macAlgorithm);
+	if (md == NULL)
+	{
+		throw Pkcs12Exception(Pkcs12Exception::UNKNOWN, "Pkcs12Builder::doFinal");
+	}
+	return this->create(password, Pkcs12Builder::getEncryptionNid(keyEncryption),
+			Pkcs12Builder::getEncryptionNid(certEncryption), iterations, md, macIterations);
+}
+
+void Pkcs12Builder::setThreadPool(ThreadPool *pool)
+{
+	this->pool = pool;
+}
+
+void Pkcs12Builder::doFinal(std::vector<Pkcs12Builder::Entry> const& entries, Pkcs12Builder::Sink *sink,
+		Pkcs12Builder::Encryption keyEncryption, Pkcs12Builder::Encryption certEncryption, int iterations,
+		MessageDigest::Algorithm macAlgorithm, int macIterations) const throw(Pkcs12Exception)
+{
+	STACK_OF(PKCS12_SAFEBAG) *chain = sk_PKCS12_SAFEBAG_new_null();
+	std::vector<Pkcs12Task> batch;
+	std::vector<ThreadPool::Task*> tasks;
+	unsigned int window, end;
+	const EVP_MD *md = MessageDigest::getMessageDigest(macAlgorithm);
+	int nidKey = Pkcs12Builder::getEncryptionNid(keyEncryption);
+	int nidCert = Pkcs12Builder::getEncryptionNid(certEncryption);
+
+	//mesmos padroes de PKCS12_create()
+	nidKey = nidKey == 0 ? NID_aes_256_cbc : nidKey;
+	nidCert = nidCert == 0 ? NID_aes_256_cbc : nidCert;
+	if (iterations <= 0)
+	{
+		iterations = PKCS12_DEFAULT_ITER;
+	}
+	if (macIterations <= 0)
+	{
+		macIterations = iterations;
+	}
+
+	//as bags da cadeia comum sao codificadas uma unica vez
+	for (unsigned int i = 0; chain != NULL && i < this->certs.size(); i++)
+	{
+		if (PKCS12_add_cert(&chain, this->certs.at(i)->getX509()) == NULL)
+		{
+			sk_PKCS12_SAFEBAG_pop_free(chain, PKCS12_SAFEBAG_free);
+			chain = NULL;
+		}
+	}
+	if (chain == NULL || md == NULL || sink == NULL)
+	{
+		sk_PKCS12_SAFEBAG_pop_free(chain, PKCS12_SAFEBAG_free);
+		throw Pkcs12Exception(Pkcs12Exception::UNKNOWN, "Pkcs12Builder::doFinal");
+	}
+
+	window = this->pool == NULL ? 1 : this->pool->getSize() * 4;
+	try
+	{
+		for (unsigned int begin = 0; begin < entries.size(); begin = end)
+		{
+			end = std::min(begin + window, (unsigned int) entries.size());
+			batch.clear();
+			tasks.clear();
+			for (unsigned int i = begin; i < end; i++)
+			{
+				batch.push_back(Pkcs12Task(&entries.at(i), chain, nidKey, nidCert, iterations, md, macIterations));
+			}
+			for (unsigned int i = 0; i < batch.size(); i++)
+			{
+				tasks.push_back(&batch.at(i));
+			}
+			if (this->pool == NULL)
+			{
+				batch.at(0).run();
+			}
+			else
+			{
+				this->pool->execute(tasks);
+			}
+			for (unsigned int i = 0; i < batch.size(); i++)
+			{
+				if (batch.at(i).ok)
+				{
+					sink->write(begin + i, batch.at(i).der);
+				}
+				else
+				{
+					Pkcs12Exception exception(batch.at(i).errorCode, "Pkcs12Builder::doFinal");
+					sink->fail(begin + i, exception);
+				}
+			}
+		}
+	}
+	catch (...)
+	{
+		sk_PKCS12_SAFEBAG_pop_free(chain, PKCS12_SAFEBAG_free);
+		throw;
+	}
+	sk_PKCS12_SAFEBAG_pop_free(chain, PKCS12_SAFEBAG_free);
+}
+
+Pkcs12* Pkcs12Builder::create(string password, int nidKey, int nidCert, int iterations, const EVP_MD *md,
+		int macIterations) const throw(Pkcs12Exception)
 {
 	PKCS12* tmp = NULL;
 	STACK_OF(X509)* ca = NULL;
 	char* cpass = NULL;
 	char* cname = NULL;	
-	
-	int nid_key = 0;
-	int nid_cert = 0;
-	int iter = 0;
-	int mac_iter = 0;
 	int keytype = 0;
 
 	//verifica se chave privada corresponde a chave publica
@@ -70,22 +267,49 @@ Pkcs12* Pkcs12Builder::doFinal(string password) const throw(Pkcs12Exception)
 		sk_X509_push(ca, this->certs.at(i)->getX509());
 	}
 	
-	//cria estruta PKCS12
+	//cria estruta PKCS12. Com md definido, o MAC é gerado depois, com o algoritmo escolhido
 	tmp =  PKCS12_create(cpass, cname, this->key->getEvpPkey(), this->keyCert->getX509(), ca,
-	                                nid_key, nid_cert, iter, mac_iter, keytype);
+	                                nidKey, nidCert, iterations, md == NULL ? 0 : -1, keytype);
 
-	if(tmp == NULL)
+	if(tmp != NULL && md != NULL
+			&& !PKCS12_set_mac(tmp, cpass, -1, NULL, 0, macIterations, md))
 	{
-		delete cpass;
-		delete cname;
-		sk_X509_free(ca);
-		
-		throw Pkcs12Exception(Pkcs12Exception::UNKNOWN, "Pkcs12Builder::doFinal");
+		PKCS12_free(tmp);
+		tmp = NULL;
 	}
-	
+
 	delete[] cpass;
 	delete[] cname;
 	sk_X509_free(ca);
 
+	if(tmp == NULL)
+	{
+		throw Pkcs12Exception(Pkcs12Exception::UNKNOWN, "Pkcs12Builder::doFinal");
+	}
+
 	return new Pkcs12(tmp);
 }
+
+int Pkcs12Builder::getEncryptionNid(Pkcs12Builder::Encryption encryption)
+{
+	int ret = 0;
+	switch (encryption)
+	{
+		case Pkcs12Builder::DEFAULT_ENCRYPTION:
+			ret = 0;
+			break;
+		case Pkcs12Builder::NO_ENCRYPTION:
+			ret = -1;
+			break;
+		case Pkcs12Builder::PBE_SHA1_3DES:
+			ret = NID_pbe_WithSHA1And3_Key_TripleDES_CBC;
+			break;
+		case Pkcs12Builder::PBES2_AES_128_CBC:
+			ret = NID_aes_128_cbc;
+			break;
+		case Pkcs12Builder::PBES2_AES_256_CBC:
+			ret = NID_aes_256_cbc;
+			break;
+	}
+	return ret;
+}
@@ -37,7 +37,7 @@ void Pkcs7Builder::update(ByteArray &data)
 	}
 	if (this->state == Pkcs7Builder::INIT)
 	{
-		this->p7bio = PKCS7_dataInit(this->pkcs7, NULL);
+		this->p7bio = this->dataInit();
 		if (!this->p7bio)
 		{
 			this->state = Pkcs7Builder::NO_INIT;
@@ -59,85 +59,118 @@ void Pkcs7Builder::update(ByteArray &data)
 	this->state = Pkcs7Builder::UPDATE;
 }
 
+BIO* Pkcs7Builder::dataInit()
+{
+	return PKCS7_dataInit(this->pkcs7, NULL);
+}
+
+int Pkcs7Builder::dataFinal()
+{
+	return PKCS7_dataFinal(this->pkcs7, this->p7bio);
+}
+
 void Pkcs7Builder::doFinal(std::istream *in, std::ostream *out)
 		throw (InvalidStateException, Pkcs7Exception, EncodeException)
 {
-	int maxSize, size, rc;
-	ByteArray buf, contents;
-	std::string value;
-	BIO *buffer;
-	int ndata, wrote;
-	char *data;
-	maxSize = 1024;
+	this->encode(in, out, Pkcs7Builder::PEM, StreamBio::DEFAULT_BUFFER_SIZE, false);
+}
+
+void Pkcs7Builder::doFinal(std::istream *in, std::ostream *out, Pkcs7Builder::Encoding encoding,
+		unsigned int bufferSize)
+		throw (InvalidStateException, Pkcs7Exception, EncodeException)
+{
+	this->encode(in, out, encoding, bufferSize, true);
+}
+
+void Pkcs7Builder::encode(std::istream *in, std::ostream *out, Pkcs7Builder::Encoding encoding,
+		unsigned int bufferSize, bool streaming)
+		throw (InvalidStateException, Pkcs7Exception, EncodeException)
+{
+	BIO *input, *output;
+	bool detached;
+	int rc, flags;
 	if (this->state != Pkcs7Builder::INIT)
 	{
 		throw InvalidStateException("Pkcs7Builder::doFinal");
 	}
-	buf = ByteArray(maxSize);
-	while ((size = in->readsome((char *)buf.getDataPointer(), maxSize)) > 0)
-	{
-		contents = ByteArray(buf.getDataPointer(), size);
-		this->update(contents);
-	}
-
-	if (this->state != Pkcs7Builder::UPDATE)
+	detached = PKCS7_type_is_signed(this->pkcs7) && PKCS7_get_detached(this->pkcs7);
+	if (encoding == Pkcs7Builder::DER && !detached)
 	{
-		throw InvalidStateException("Pkcs7Builder::dofinal");
+		throw EncodeException(EncodeException::DER_ENCODE, "Pkcs7Builder::doFinal");
 	}
-	rc = BIO_flush(this->p7bio);
-	if (!rc)
+	input = StreamBio::newInput(in, bufferSize);
+	output = StreamBio::newOutput(out, bufferSize);
+	if (input == NULL || output == NULL)
 	{
-        BIO_free(this->p7bio);
-		this->p7bio = NULL;
-        this->state = Pkcs7Builder::NO_INIT;
-        throw Pkcs7Exception(Pkcs7Exception::INTERNAL_ERROR, "Pkcs7Builder::dofinal", true);
+		BIO_free_all(input);
+		BIO_free_all(output);
+		throw EncodeException(EncodeException::BUFFER_CREATING, "Pkcs7Builder::doFinal");
 	}
-	rc = PKCS7_dataFinal(this->pkcs7, this->p7bio);
-	if (!rc)
+	if (detached || !streaming)
 	{
-		BIO_free(this->p7bio);
-		this->p7bio = NULL;
-		PKCS7_free(this->pkcs7);
-		this->pkcs7 = NULL;
-		this->state = Pkcs7Builder::NO_INIT;
-		throw Pkcs7Exception(Pkcs7Exception::INTERNAL_ERROR, "Pkcs7SignedDataBuilder::dofinal", true);
+		/* sem conteúdo anexado, o conteúdo só precisa ser resumido e o pacote não depende do seu tamanho;
+		 * com conteúdo anexado, ele é mantido na estrutura PKCS7 e o pacote é codificado em DER ao final */
+		this->p7bio = this->dataInit();
+		rc = (this->p7bio != NULL);
+		if (rc)
+		{
+			rc = StreamBio::copy(input, this->p7bio, bufferSize) && BIO_flush(this->p7bio) > 0;
+		}
+		if (rc)
+		{
+			rc = this->dataFinal();
+		}
+		if (!rc)
+		{
+			BIO_free_all(input);
+			BIO_free_all(output);
+			this->state = Pkcs7Builder::NO_INIT;
+			BIO_free_all(this->p7bio);
+			this->p7bio = NULL;
+			PKCS7_free(this->pkcs7);
+			this->pkcs7 = NULL;
+			throw Pkcs7Exception(Pkcs7Exception::INTERNAL_ERROR, "Pkcs7Builder::doFinal", true);
+		}
+		if (encoding == Pkcs7Builder::PEM)
+		{
+			rc = PEM_write_bio_PKCS7(output, this->pkcs7);
+		}
+		else
+		{
+			rc = i2d_PKCS7_bio(output, this->pkcs7);
+		}
 	}
-	buffer = BIO_new(BIO_s_mem());
-	if (buffer == NULL)
+	else
 	{
-		this->state = Pkcs7Builder::NO_INIT;
-		BIO_free(this->p7bio);
-		this->p7bio = NULL;
-		PKCS7_free(this->pkcs7);
-		this->pkcs7 = NULL;
-		throw EncodeException(EncodeException::BUFFER_CREATING, "Pkcs7::getPemEncoded");
+		/* os callbacks de streaming do OpenSSL chamam PKCS7_dataInit()/PKCS7_dataFinal()
+		 * enquanto o conteúdo é copiado da entrada para a saída */
+		flags = PKCS7_STREAM | PKCS7_BINARY;
+		if (encoding == Pkcs7Builder::PEM)
+		{
+			rc = PEM_write_bio_PKCS7_stream(output, this->pkcs7, input, flags);
+		}
+		else
+		{
+			rc = i2d_PKCS7_bio_stream(output, this->pkcs7, input, flags);
+		}
 	}
-	wrote = PEM_write_bio_PKCS7(buffer, this->pkcs7);
-	if (!wrote)
+	if (rc)
 	{
-		BIO_free(buffer);
-		this->state = Pkcs7Builder::NO_INIT;
-		BIO_free(this->p7bio);
-		this->p7bio = NULL;
-		PKCS7_free(this->pkcs7);
-		this->pkcs7 = NULL;
-		throw EncodeException(EncodeException::PEM_ENCODE, "Pkcs7::getPemEncoded");
+		rc = BIO_flush(output) > 0;
 	}
-	ndata = BIO_get_mem_data(buffer, &data);
-	if (ndata <= 0)
+	BIO_free_all(input);
+	BIO_free_all(output);
+	this->state = Pkcs7Builder::NO_INIT;
+	if (this->p7bio)
 	{
-		BIO_free(buffer);
-		this->state = Pkcs7Builder::NO_INIT;
-		BIO_free(this->p7bio);
+		BIO_free_all(this->p7bio);
 		this->p7bio = NULL;
-		PKCS7_free(this->pkcs7);
-		this->pkcs7 = NULL;
-		throw EncodeException(EncodeException::BUFFER_READING, "Pkcs7::getPemEncoded");
 	}
-	out->write(data, ndata);
-	this->state = Pkcs7Builder::NO_INIT;
-	BIO_free(this->p7bio);
-	this->p7bio = NULL;
 	PKCS7_free(this->pkcs7);
 	this->pkcs7 = NULL;
+	if (!rc)
+	{
+		throw EncodeException(encoding == Pkcs7Builder::PEM ? EncodeException::PEM_ENCODE : EncodeException::DER_ENCODE,
+				"Pkcs7Builder::doFinal");
+	}
 }
@@ -1,5 +1,289 @@
 #include <libcryptosec/Pkcs7EnvelopedData.h>
 
+/*
+ * Leitura incremental de um pacote envelopado em BER a partir de um std::istream.
+ * readPrefix() decodifica tudo o que precede o conteúdo cifrado e o reescreve em DER, sem o
+ * conteúdo; em seguida read() fornece os octetos do conteúdo cifrado, juntando os fragmentos
+ * de uma OCTET STRING construída.
+ */
+class EnvelopedStreamReader : public StreamBio::Source
+{
+public:
+	EnvelopedStreamReader(std::istream *in) :
+			in(in), consumed(0), remaining(0), outerLength(0), outerStart(0), chunked(false), definite(false), depth(0), done(false), failed(false)
+	{
+	}
+
+	bool readPrefix(std::string &der)
+	{
+		static const std::string envelopedOid("\x06\x09\x2a\x86\x48\x86\xf7\x0d\x01\x07\x03", 11);
+		std::string oid, version, recipients, contentType, algorithm, eci, enveloped, explicitTag;
+		unsigned long long length, eciLength, eciStart;
+		bool indefinite;
+		int tag;
+		if (!this->readHeader(tag, indefinite, length) || tag != 0x30
+				|| !this->readElement(oid) || oid != envelopedOid
+				|| !this->readHeader(tag, indefinite, length) || tag != 0xa0
+				|| !this->readHeader(tag, indefinite, length) || tag != 0x30
+				|| !this->readElement(version) || (unsigned char)version[0] != 0x02
+				|| !this->readElement(recipients) || (unsigned char)recipients[0] != 0x31
+				|| !this->readHeader(tag, indefinite, eciLength) || tag != 0x30)
+		{
+			return false;
+		}
+		eciStart = this->consumed;
+		if (!this->readElement(contentType) || !this->readElement(algorithm))
+		{
+			return false;
+		}
+		if (!indefinite && this->consumed - eciStart >= eciLength)
+		{
+			//conteudo cifrado ausente
+			this->done = true;
+		}
+		else if (!this->readHeader(tag, indefinite, length))
+		{
+			return false;
+		}
+		else if (tag == 0x80)
+		{
+			this->remaining = length;
+			this->done = (length == 0);
+		}
+		else if (tag == 0xa0)
+		{
+			this->chunked = true;
+			this->definite = !indefinite;
+			this->outerLength = length;
+			this->outerStart = this->consumed;
+			this->done = (this->definite && length == 0);
+		}
+		else if (tag == 0x00 && length == 0)
+		{
+			this->done = true;
+		}
+		else
+		{
+			return false;
+		}
+		eci = EnvelopedStreamReader::wrap(0x30, contentType + algorithm);
+		enveloped = EnvelopedStreamReader::wrap(0x30, version + recipients + eci);
+		explicitTag = EnvelopedStreamReader::wrap(0xa0, enveloped);
+		der = EnvelopedStreamReader::wrap(0x30, oid + explicitTag);
+		return true;
+	}
+
+	virtual int read(char *data, int size)
+	{
+		int tag;
+		bool indefinite;
+		unsigned long long length;
+		while (!this->done && !this->failed && this->remaining == 0)
+		{
+			if (this->definite && this->consumed - this->outerStart >= this->outerLength)
+			{
+				this->done = true;
+			}
+			else if (!this->readHeader(tag, indefinite, length))
+			{
+				this->failed = true;
+			}
+			else if (tag == 0x04)
+			{
+				this->remaining = length;
+			}
+			else if (tag == 0x24)
+			{
+				//fragmento construido: seus fragmentos primitivos vem a seguir
+				if (indefinite)
+				{
+					this->depth++;
+				}
+			}
+			else if (tag == 0x00 && length == 0 && !this->definite)
+			{
+				if (this->depth == 0)
+				{
+					this->done = true;
+				}
+				else
+				{
+					this->depth--;
+				}
+			}
+			else
+			{
+				this->failed = true;
+			}
+		}
+		if (this->failed)
+		{
+			return -1;
+		}
+		if (this->done || size <= 0)
+		{
+			return 0;
+		}
+		if ((unsigned long long)size > this->remaining)
+		{
+			size = (int)this->remaining;
+		}
+		if (!this->readBytes(data, size))
+		{
+			this->failed = true;
+			return -1;
+		}
+		this->remaining -= size;
+		if (!this->chunked && this->remaining == 0)
+		{
+			this->done = true;
+		}
+		return size;
+	}
+
+	bool hasFailed() const
+	{
+		return this->failed;
+	}
+
+protected:
+	bool readBytes(char *data, unsigned long long size)
+	{
+		this->in->read(data, size);
+		this->consumed += this->in->gcount();
+		return (unsigned long long)this->in->gcount() == size;
+	}
+
+	/*
+	 * Le um cabecalho TLV, opcionalmente acumulando seus octetos em raw.
+	 */
+	bool readHeader(int &tag, bool &indefinite, unsigned long long &length, std::string *raw = NULL)
+	{
+		unsigned char octet;
+		unsigned char octets;
+		if (!this->readBytes((char *)&octet, 1) || (octet & 0x1f) == 0x1f)
+		{
+			//tags com mais de um octeto nao ocorrem no cabecalho do pacote
+			return false;
+		}
+		tag = octet;
+		if (raw)
+		{
+			raw->push_back(octet);
+		}
+		if (!this->readBytes((char *)&octet, 1))
+		{
+			return false;
+		}
+		if (raw)
+		{
+			raw->push_back(octet);
+		}
+		indefinite = (octet == 0x80);
+		length = 0;
+		if (indefinite)
+		{
+			return (tag & 0x20) != 0;
+		}
+		if (octet < 0x80)
+		{
+			length = octet;
+			return true;
+		}
+		octets = octet & 0x7f;
+		if (octets > 8)
+		{
+			return false;
+		}
+		for (unsigned char i = 0; i < octets; i++)
+		{
+			if (!this->readBytes((char *)&octet, 1))
+			{
+				return false;
+			}
+			if (raw)
+			{
+				raw->push_back(octet);
+			}
+			length = (length << 8) | octet;
+		}
+		return true;
+	}
+
+	/*
+	 * Le um elemento completo, acumulando seus octetos em raw. Limites de sanidade: o cabecalho do
+	 * pacote nunca e grande nem profundo, e nenhum deles pode ser excedido por uma entrada maliciosa.
+	 */
+	bool readElement(std::string &raw, unsigned int nesting = 0)
+	{
+		unsigned long long length;
+		bool indefinite;
+		size_t size;
+		int tag;
+		if (nesting > EnvelopedStreamReader::MAX_NESTING || !this->readHeader(tag, indefinite, length, &raw)
+				|| this->consumed > EnvelopedStreamReader::MAX_PREFIX)
+		{
+			return false;
+		}
+		if (indefinite)
+		{
+			//elementos internos ate o fim de conteudo (00 00)
+			do
+			{
+				size = raw.size();
+				if (!this->readElement(raw, nesting + 1))
+				{
+					return false;
+				}
+			} while (raw.size() - size != 2 || raw[size] != 0 || raw[size + 1] != 0);
+			return true;
+		}
+		if (length > EnvelopedStreamReader::MAX_PREFIX - this->consumed)
+		{
+			return false;
+		}
+		size = raw.size();
+		raw.resize(size + length);
+		return length == 0 || this->readBytes(&raw[size], length);
+	}
+
+	/* profundidade de elementos de comprimento indefinido e octetos lidos antes do conteudo cifrado */
+	static const unsigned int MAX_NESTING = 32;
+	static const unsigned long long MAX_PREFIX = 16777216;
+
+	static std::string wrap(unsigned char tag, const std::string &content)
+	{
+		std::string ret(1, (char)tag);
+		size_t length = content.size();
+		if (length < 0x80)
+		{
+			ret.push_back((char)length);
+		}
+		else
+		{
+			std::string octets;
+			for (; length > 0; length >>= 8)
+			{
+				octets.insert(octets.begin(), (char)(length & 0xff));
+			}
+			ret.push_back((char)(0x80 | octets.size()));
+			ret += octets;
+		}
+		return ret + content;
+	}
+
+	std::istream *in;
+	unsigned long long consumed;
+	unsigned long long remaining;
+	unsigned long long outerLength;
+	unsigned long long outerStart;
+	bool chunked;
+	bool definite;
+	unsigned int depth;
+	bool done;
+	bool failed;
+};
+
 Pkcs7EnvelopedData::Pkcs7EnvelopedData(PKCS7 *pkcs7) throw (Pkcs7Exception) : Pkcs7(pkcs7)
 {
 	if (OBJ_obj2nid(this->pkcs7->type) != NID_pkcs7_enveloped)
@@ -37,23 +321,73 @@ void Pkcs7EnvelopedData::decrypt(Certificate &certificate, PrivateKey &privateKe
 		throw (Pkcs7Exception)
 {
 	BIO *p7bio;
-	int size, maxSize, finalSize;
+	bool ok;
 	p7bio = PKCS7_dataDecode(this->pkcs7, privateKey.getEvpPkey(), NULL, certificate.getX509());
 	if (!p7bio)
 	{
 		throw Pkcs7Exception(Pkcs7Exception::DECRYPTING, "Pkcs7EnvelopedData::decrypt");
 	}
-	maxSize = 4096;
-	size = maxSize;
-	finalSize = 0;
-	char buf[maxSize+1];
-	while (size == maxSize)
+	ok = Pkcs7EnvelopedData::extract(p7bio, out);
+	BIO_free_all(p7bio);
+	if (!ok)
 	{
-		size = BIO_read(p7bio, buf, maxSize);
-		if (size == 0){
-			break;
-		}
-		out->write(buf, size);
+		throw Pkcs7Exception(Pkcs7Exception::DECRYPTING, "Pkcs7EnvelopedData::decrypt", true);
+	}
+}
+
+void Pkcs7EnvelopedData::decrypt(std::istream *in, Certificate &certificate, PrivateKey &privateKey, std::ostream *out)
+		throw (Pkcs7Exception)
+{
+	EnvelopedStreamReader reader(in);
+	std::string der;
+	const unsigned char *p;
+	PKCS7 *pkcs7;
+	BIO *content, *p7bio;
+	bool ok;
+	if (!reader.readPrefix(der))
+	{
+		throw Pkcs7Exception(Pkcs7Exception::INVALID_PKCS7, "Pkcs7EnvelopedData::decrypt");
+	}
+	p = (const unsigned char *)der.data();
+	pkcs7 = d2i_PKCS7(NULL, &p, der.size());
+	if (!pkcs7)
+	{
+		throw Pkcs7Exception(Pkcs7Exception::INVALID_PKCS7, "Pkcs7EnvelopedData::decrypt", true);
+	}
+	content = StreamBio::newInput(&reader);
+	if (!content)
+	{
+		PKCS7_free(pkcs7);
+		throw Pkcs7Exception(Pkcs7Exception::INTERNAL_ERROR, "Pkcs7EnvelopedData::decrypt");
+	}
+	//o conteudo cifrado e fornecido como conteudo destacado
+	p7bio = PKCS7_dataDecode(pkcs7, privateKey.getEvpPkey(), content, certificate.getX509());
+	if (!p7bio)
+	{
+		BIO_free_all(content);
+		PKCS7_free(pkcs7);
+		throw Pkcs7Exception(Pkcs7Exception::DECRYPTING, "Pkcs7EnvelopedData::decrypt", true);
+	}
+	ok = Pkcs7EnvelopedData::extract(p7bio, out) && !reader.hasFailed();
+	BIO_free_all(p7bio);
+	PKCS7_free(pkcs7);
+	if (!ok)
+	{
+		throw Pkcs7Exception(Pkcs7Exception::DECRYPTING, "Pkcs7EnvelopedData::decrypt", true);
+	}
+}
+
+bool Pkcs7EnvelopedData::extract(BIO *p7bio, std::ostream *out)
+{
+	BIO *output, *cipher;
+	bool ok;
+	output = StreamBio::newOutput(out);
+	if (!output)
+	{
+		return false;
 	}
-	BIO_free(p7bio);
+	ok = StreamBio::copy(p7bio, output) && BIO_flush(output) > 0;
+	BIO_free_all(output);
+	cipher = BIO_find_type(p7bio, BIO_TYPE_CIPHER);
+	return ok && (cipher == NULL || BIO_get_cipher_status(cipher) == 1);
 }
@@ -1,11 +1,70 @@
 #include <libcryptosec/Pkcs7EnvelopedDataBuilder.h>
 
+#include <openssl/rand.h>
+
+#include <algorithm>
+
+/*
+ * Cifragem da chave de conteúdo para uma faixa de destinatários, executada por uma thread do ThreadPool.
+ */
+class KeyWrapTask : public ThreadPool::Task
+{
+public:
+	KeyWrapTask(STACK_OF(PKCS7_RECIP_INFO) *recipients, int begin, int end, const unsigned char *key, int keySize) :
+			recipients(recipients), begin(begin), end(end), key(key), keySize(keySize), ok(false)
+	{
+	}
+
+	virtual void run()
+	{
+		PKCS7_RECIP_INFO *ri;
+		EVP_PKEY_CTX *ctx;
+		unsigned char *encrypted;
+		size_t size;
+		for (int i = this->begin; i < this->end; i++)
+		{
+			ri = sk_PKCS7_RECIP_INFO_value(this->recipients, i);
+			ctx = EVP_PKEY_CTX_new(X509_get0_pubkey(ri->cert), NULL);
+			if (ctx == NULL)
+			{
+				return;
+			}
+			//equivalente ao que PKCS7_dataInit() faz para cada destinatario
+			encrypted = NULL;
+			if (EVP_PKEY_encrypt_init(ctx) > 0
+					&& EVP_PKEY_encrypt(ctx, NULL, &size, this->key, this->keySize) > 0
+					&& (encrypted = (unsigned char *)OPENSSL_malloc(size)) != NULL
+					&& EVP_PKEY_encrypt(ctx, encrypted, &size, this->key, this->keySize) > 0)
+			{
+				ASN1_STRING_set0(ri->enc_key, encrypted, (int)size);
+				encrypted = NULL;
+			}
+			else
+			{
+				OPENSSL_free(encrypted);
+				EVP_PKEY_CTX_free(ctx);
+				return;
+			}
+			EVP_PKEY_CTX_free(ctx);
+		}
+		this->ok = true;
+	}
+
+	STACK_OF(PKCS7_RECIP_INFO) *recipients;
+	int begin;
+	int end;
+	const unsigned char *key;
+	int keySize;
+	bool ok;
+};
+
 Pkcs7EnvelopedDataBuilder::Pkcs7EnvelopedDataBuilder(Certificate &cert,
 			SymmetricKey::Algorithm symAlgorithm,
 			SymmetricCipher::OperationMode symOperationMode)
 		throw (Pkcs7Exception, SymmetricCipherException)
 {
 	int rc;
+	this->pool = NULL;
 	PKCS7_set_type(this->pkcs7, NID_pkcs7_enveloped);
 	try
 	{
@@ -76,6 +135,11 @@ void Pkcs7EnvelopedDataBuilder::init(Certificate &cert,
 	this->state = Pkcs7Builder::INIT;
 }
 
+void Pkcs7EnvelopedDataBuilder::setThreadPool(ThreadPool *pool)
+{
+	this->pool = pool;
+}
+
 void Pkcs7EnvelopedDataBuilder::addCipher(Certificate &certificate)
 	throw (InvalidStateException, Pkcs7Exception)
 {
@@ -111,7 +175,7 @@ Pkcs7EnvelopedData* Pkcs7EnvelopedDataBuilder::doFinal()
         this->state = Pkcs7Builder::NO_INIT;
         throw Pkcs7Exception(Pkcs7Exception::INTERNAL_ERROR, "Pkcs7EnvelopedDataBuilder::dofinal");
 	}
-	rc = PKCS7_dataFinal(this->pkcs7, this->p7bio);
+	rc = this->dataFinal();
 	if (!rc)
 	{
 		BIO_free(this->p7bio);
@@ -142,3 +206,90 @@ Pkcs7EnvelopedData* Pkcs7EnvelopedDataBuilder::doFinal(ByteArray &data)
 	this->update(data);
 	return this->doFinal();
 }
+
+BIO* Pkcs7EnvelopedDataBuilder::dataInit()
+{
+	//quantidade minima de destinatarios por tarefa, para que a divisao compense
+	const int minPerTask = 4;
+	STACK_OF(PKCS7_RECIP_INFO) *recipients;
+	X509_ALGOR *algorithm;
+	std::vector<KeyWrapTask> batch;
+	std::vector<ThreadPool::Task*> tasks;
+	unsigned char key[EVP_MAX_KEY_LENGTH], iv[EVP_MAX_IV_LENGTH];
+	EVP_CIPHER_CTX *ctx;
+	BIO *cipher, *mem;
+	int count, ntasks, perTask, keySize, ivSize;
+	bool ok;
+
+	recipients = this->pkcs7->d.enveloped->recipientinfo;
+	count = sk_PKCS7_RECIP_INFO_num(recipients);
+	if (this->pool == NULL || count < 2)
+	{
+		return PKCS7_dataInit(this->pkcs7, NULL);
+	}
+
+	//mesma preparacao da cifra feita por PKCS7_dataInit()
+	algorithm = this->pkcs7->d.enveloped->enc_data->algorithm;
+	cipher = BIO_new(BIO_f_cipher());
+	mem = BIO_new(BIO_s_mem());
+	ctx = NULL;
+	keySize = 0;
+	ivSize = 0;
+	ok = cipher != NULL && mem != NULL && BIO_get_cipher_ctx(cipher, &ctx) > 0
+			&& EVP_CipherInit_ex(ctx, this->pkcs7->d.enveloped->enc_data->cipher, NULL, NULL, NULL, 1) > 0;
+	if (ok)
+	{
+		keySize = EVP_CIPHER_CTX_get_key_length(ctx);
+		ivSize = EVP_CIPHER_CTX_get_iv_length(ctx);
+		ok = (ivSize <= 0 || RAND_bytes(iv, ivSize) > 0)
+				&& EVP_CIPHER_CTX_rand_key(ctx, key) > 0
+				&& EVP_CipherInit_ex(ctx, NULL, NULL, key, iv, 1) > 0;
+	}
+	if (ok)
+	{
+		ASN1_OBJECT_free(algorithm->algorithm);
+		algorithm->algorithm = OBJ_nid2obj(EVP_CIPHER_CTX_get_type(ctx));
+		ok = algorithm->algorithm != NULL;
+	}
+	if (ok && ivSize > 0)
+	{
+		if (algorithm->parameter == NULL)
+		{
+			algorithm->parameter = ASN1_TYPE_new();
+		}
+		ok = algorithm->parameter != NULL && EVP_CIPHER_param_to_asn1(ctx, algorithm->parameter) > 0;
+	}
+
+	if (ok)
+	{
+		ntasks = (count + minPerTask - 1) / minPerTask;
+		if (ntasks > (int)this->pool->getSize() * 4)
+		{
+			ntasks = this->pool->getSize() * 4;
+		}
+		perTask = (count + ntasks - 1) / ntasks;
+		batch.reserve(ntasks);
+		for (int begin = 0; begin < count; begin += perTask)
+		{
+			batch.push_back(KeyWrapTask(recipients, begin, std::min(begin + perTask, count), key, keySize));
+		}
+		for (unsigned int i = 0; i < batch.size(); i++)
+		{
+			tasks.push_back(&batch[i]);
+		}
+		this->pool->execute(tasks);
+		for (unsigned int i = 0; i < batch.size(); i++)
+		{
+			ok = ok && batch[i].ok;
+		}
+	}
+	OPENSSL_cleanse(key, sizeof(key));
+
+	if (!ok)
+	{
+		BIO_free(cipher);
+		BIO_free(mem);
+		return NULL;
+	}
+	return BIO_push(cipher, mem);
+}
@@ -1,5 +1,11 @@
 #include <libcryptosec/Pkcs7SignedData.h>
 
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 CertPathValidatorResult Pkcs7SignedData::cpvr;
 
 Pkcs7SignedData::Pkcs7SignedData(PKCS7 *pkcs7) throw (Pkcs7Exception) : Pkcs7(pkcs7)
@@ -35,6 +41,32 @@ std::vector<Certificate *> Pkcs7SignedData::getCertificates()
 	return ret;
 }
 
+std::vector<Certificate *> Pkcs7SignedData::getSigners(const CertificateStore &store)
+{
+	std::vector<Certificate *> ret;
+	STACK_OF(PKCS7_SIGNER_INFO) *signerInfos = PKCS7_get_signer_info(this->pkcs7);
+	PKCS7_ISSUER_AND_SERIAL *issuerAndSerial;
+	Certificate *certificate;
+	X509 *x509;
+	int i, num;
+	num = sk_PKCS7_SIGNER_INFO_num(signerInfos);
+	for (i=0;i<num;i++)
+	{
+		issuerAndSerial = sk_PKCS7_SIGNER_INFO_value(signerInfos, i)->issuer_and_serial;
+		certificate = store.getByIssuerAndSerialNumber(RDNSequence(issuerAndSerial->issuer),
+				BigInteger(issuerAndSerial->serial));
+		if (certificate)
+		{
+			X509_up_ref(certificate->getX509());
+			ret.push_back(new Certificate(certificate->getX509()));
+			continue;
+		}
+		x509 = X509_find_by_issuer_and_serial(this->pkcs7->d.sign->cert, issuerAndSerial->issuer, issuerAndSerial->serial);
+		ret.push_back(x509 ? new Certificate(X509_dup(x509)) : NULL);
+	}
+	return ret;
+}
+
 std::vector<CertificateRevocationList *> Pkcs7SignedData::getCrls()
 {
 	std::vector<CertificateRevocationList *> ret;
@@ -72,6 +104,106 @@ std::vector<CertificateRevocationList *> Pkcs7SignedData::getCrls()
 }*/
 
 bool Pkcs7SignedData::verify(bool checkSignerCert, vector<Certificate> trustedCerts, CertPathValidatorResult **cpvr, vector<ValidationFlags> vflags)
+{
+	return this->verifyContent(NULL, checkSignerCert, trustedCerts, cpvr, vflags);
+}
+
+bool Pkcs7SignedData::verifyDetached(std::istream *content, bool checkSignerCert, vector<Certificate> trustedCerts,
+		CertPathValidatorResult **cpvr, vector<ValidationFlags> vflags) throw (Pkcs7Exception)
+{
+	BIO *input;
+	bool ret;
+	input = StreamBio::newInput(content);
+	if (!input)
+	{
+		throw Pkcs7Exception(Pkcs7Exception::READING_CONTENT, "Pkcs7SignedData::verifyDetached");
+	}
+	try
+	{
+		ret = this->verifyContent(input, checkSignerCert, trustedCerts, cpvr, vflags);
+	}
+	catch (...)
+	{
+		BIO_free_all(input);
+		throw;
+	}
+	BIO_free_all(input);
+	if (content->bad())
+	{
+		throw Pkcs7Exception(Pkcs7Exception::READING_CONTENT, "Pkcs7SignedData::verifyDetached");
+	}
+	return ret;
+}
+
+bool Pkcs7SignedData::verifyDetached(const unsigned char *content, size_t size, bool checkSignerCert,
+		vector<Certificate> trustedCerts, CertPathValidatorResult **cpvr, vector<ValidationFlags> vflags)
+		throw (Pkcs7Exception)
+{
+	BIO *input;
+	bool ret;
+	input = StreamBio::newInput(content, size);
+	if (!input)
+	{
+		throw Pkcs7Exception(Pkcs7Exception::READING_CONTENT, "Pkcs7SignedData::verifyDetached");
+	}
+	try
+	{
+		ret = this->verifyContent(input, checkSignerCert, trustedCerts, cpvr, vflags);
+	}
+	catch (...)
+	{
+		BIO_free_all(input);
+		throw;
+	}
+	BIO_free_all(input);
+	return ret;
+}
+
+bool Pkcs7SignedData::verifyDetachedFile(std::string const &path, bool checkSignerCert,
+		vector<Certificate> trustedCerts, CertPathValidatorResult **cpvr, vector<ValidationFlags> vflags)
+		throw (Pkcs7Exception)
+{
+	struct stat info;
+	void *mapped;
+	bool ret;
+	int fd;
+	fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw Pkcs7Exception(Pkcs7Exception::READING_CONTENT, "Pkcs7SignedData::verifyDetachedFile");
+	}
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED)
+		{
+			close(fd);
+			madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+			try
+			{
+				ret = this->verifyDetached((const unsigned char *)mapped, info.st_size, checkSignerCert, trustedCerts, cpvr, vflags);
+			}
+			catch (...)
+			{
+				munmap(mapped, info.st_size);
+				throw;
+			}
+			munmap(mapped, info.st_size);
+			return ret;
+		}
+	}
+	close(fd);
+	//arquivos vazios, pipes e sistemas de arquivos sem suporte a mmap
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	if (!file)
+	{
+		throw Pkcs7Exception(Pkcs7Exception::READING_CONTENT, "Pkcs7SignedData::verifyDetachedFile");
+	}
+	return this->verifyDetached(&file, checkSignerCert, trustedCerts, cpvr, vflags);
+}
+
+bool Pkcs7SignedData::verifyContent(BIO *content, bool checkSignerCert, vector<Certificate> &trustedCerts,
+		CertPathValidatorResult **cpvr, vector<ValidationFlags> &vflags)
 {
 	BIO *p7bio;
 	bool ret;
@@ -147,9 +279,10 @@ bool Pkcs7SignedData::verify(bool checkSignerCert, vector<Certificate> trustedCe
 		flags = PKCS7_NOVERIFY;
 	}
 	
-	p7bio = PKCS7_dataInit(this->pkcs7, NULL);
+	//conteudo destacado e lido diretamente pelo PKCS7_verify, em uma unica passagem
+	p7bio = content ? NULL : PKCS7_dataInit(this->pkcs7, NULL);
 	
-	rc = PKCS7_verify(this->pkcs7, certs, store, p7bio, NULL, flags);
+	rc = PKCS7_verify(this->pkcs7, certs, store, content ? content : p7bio, NULL, flags);
 	if (rc == 1)
 	{
 		ret = true;
@@ -1,11 +1,56 @@
 #include <libcryptosec/Pkcs7SignedDataBuilder.h>
 
+#include <map>
+
+/*
+ * Assinatura de um resumo por um signatário, executada por uma thread do ThreadPool.
+ */
+class SignerTask : public ThreadPool::Task
+{
+public:
+	SignerTask(PKCS7_SIGNER_INFO *si, const EVP_MD *md, ByteArray *digest) :
+			si(si), md(md), digest(digest), ok(false)
+	{
+	}
+
+	virtual void run()
+	{
+		EVP_PKEY_CTX *ctx;
+		size_t size;
+		ctx = EVP_PKEY_CTX_new(this->si->pkey, NULL);
+		if (ctx == NULL)
+		{
+			return;
+		}
+		//equivalente ao EVP_SignFinal_ex() usado por PKCS7_dataFinal()
+		if (EVP_PKEY_sign_init(ctx) > 0
+				&& EVP_PKEY_CTX_set_signature_md(ctx, this->md) > 0
+				&& EVP_PKEY_sign(ctx, NULL, &size, this->digest->getDataPointer(), this->digest->size()) > 0)
+		{
+			this->signature = ByteArray(static_cast<unsigned int>(size));
+			if (EVP_PKEY_sign(ctx, this->signature.getDataPointer(), &size, this->digest->getDataPointer(), this->digest->size()) > 0)
+			{
+				this->signature = ByteArray(this->signature.getDataPointer(), static_cast<unsigned int>(size));
+				this->ok = true;
+			}
+		}
+		EVP_PKEY_CTX_free(ctx);
+	}
+
+	PKCS7_SIGNER_INFO *si;
+	const EVP_MD *md;
+	ByteArray *digest;
+	ByteArray signature;
+	bool ok;
+};
+
 Pkcs7SignedDataBuilder::Pkcs7SignedDataBuilder(MessageDigest::Algorithm mesDigAlgorithm,
 			Certificate &cert, PrivateKey &privKey, bool attached)
 		throw (Pkcs7Exception)
 {
 	int rc;
 	PKCS7_SIGNER_INFO *si;
+	this->pool = NULL;
 	PKCS7_set_type(this->pkcs7, NID_pkcs7_signed);
 	PKCS7_content_new(this->pkcs7, NID_pkcs7_data);
 	if (!attached)
@@ -50,6 +95,7 @@ void Pkcs7SignedDataBuilder::init(MessageDigest::Algorithm mesDigAlgorithm, Cert
 	}
 	this->pkcs7 = PKCS7_new();
 	PKCS7_set_type(this->pkcs7, NID_pkcs7_signed);
+	PKCS7_content_new(this->pkcs7, NID_pkcs7_data);
 	if (!attached)
 	{
 		PKCS7_set_detached(this->pkcs7, 1);
@@ -70,6 +116,11 @@ void Pkcs7SignedDataBuilder::init(MessageDigest::Algorithm mesDigAlgorithm, Cert
 	this->state = Pkcs7Builder::INIT;
 }
 
+void Pkcs7SignedDataBuilder::setThreadPool(ThreadPool *pool)
+{
+	this->pool = pool;
+}
+
 void Pkcs7SignedDataBuilder::addSigner(MessageDigest::Algorithm mesDigAlgorithm, Certificate &cert, PrivateKey &privKey)
 		throw (Pkcs7Exception, InvalidStateException)
 {
@@ -144,7 +195,7 @@ Pkcs7SignedData* Pkcs7SignedDataBuilder::doFinal()
         this->state = Pkcs7Builder::NO_INIT;
         throw Pkcs7Exception(Pkcs7Exception::INTERNAL_ERROR, "Pkcs7SignedDataBuilder::dofinal", true);
 	}
-	rc = PKCS7_dataFinal(this->pkcs7, this->p7bio);
+	rc = this->dataFinal();
 	if (!rc)
 	{
 		BIO_free(this->p7bio);
@@ -176,3 +227,97 @@ Pkcs7SignedData* Pkcs7SignedDataBuilder::doFinal(ByteArray &data)
 	this->update(data);
 	return this->doFinal();
 }
+
+int Pkcs7SignedDataBuilder::dataFinal()
+{
+	STACK_OF(PKCS7_SIGNER_INFO) *signers;
+	PKCS7_SIGNER_INFO *si;
+	std::map<int, ByteArray> digests;
+	std::vector<SignerTask> batch;
+	std::vector<ThreadPool::Task*> tasks;
+	std::vector<EVP_PKEY*> keys;
+	EVP_MD_CTX *mdCtx, *copy;
+	unsigned char md[EVP_MAX_MD_SIZE];
+	unsigned int mdSize;
+	BIO *bio;
+	int nid, rc;
+	bool ok = true;
+
+	if (this->pool == NULL)
+	{
+		return PKCS7_dataFinal(this->pkcs7, this->p7bio);
+	}
+
+	//resumo do conteudo: uma finalizacao por algoritmo distinto, a partir dos BIOs de resumo
+	signers = PKCS7_get_signer_info(this->pkcs7);
+	copy = EVP_MD_CTX_new();
+	for (int i = 0; ok && i < sk_PKCS7_SIGNER_INFO_num(signers); i++)
+	{
+		si = sk_PKCS7_SIGNER_INFO_value(signers, i);
+		//atributos autenticados ficam a cargo de PKCS7_dataFinal()
+		if (si->pkey == NULL || sk_X509_ATTRIBUTE_num(si->auth_attr) > 0)
+		{
+			continue;
+		}
+		nid = OBJ_obj2nid(si->digest_alg->algorithm);
+		if (digests.find(nid) == digests.end())
+		{
+			mdCtx = NULL;
+			for (bio = BIO_find_type(this->p7bio, BIO_TYPE_MD); bio != NULL; bio = BIO_find_type(BIO_next(bio), BIO_TYPE_MD))
+			{
+				BIO_get_md_ctx(bio, &mdCtx);
+				if (mdCtx != NULL && EVP_MD_CTX_get_type(mdCtx) == nid)
+				{
+					break;
+				}
+				mdCtx = NULL;
+			}
+			ok = mdCtx != NULL && copy != NULL
+					&& EVP_MD_CTX_copy_ex(copy, mdCtx)
+					&& EVP_DigestFinal_ex(copy, md, &mdSize);
+			if (ok)
+			{
+				digests[nid] = ByteArray(md, mdSize);
+			}
+		}
+		if (ok)
+		{
+			batch.push_back(SignerTask(si, EVP_get_digestbynid(nid), NULL));
+		}
+	}
+	EVP_MD_CTX_free(copy);
+	if (!ok)
+	{
+		return 0;
+	}
+
+	for (unsigned int i = 0; i < batch.size(); i++)
+	{
+		batch[i].digest = &digests[OBJ_obj2nid(batch[i].si->digest_alg->algorithm)];
+		tasks.push_back(&batch[i]);
+	}
+	this->pool->execute(tasks);
+
+	for (unsigned int i = 0; ok && i < batch.size(); i++)
+	{
+		ok = batch[i].ok
+				&& ASN1_STRING_set(batch[i].si->enc_digest, batch[i].signature.getDataPointer(), batch[i].signature.size());
+	}
+	if (!ok)
+	{
+		return 0;
+	}
+
+	//signatarios sem chave sao ignorados por PKCS7_dataFinal(), que apenas finaliza o conteudo
+	for (unsigned int i = 0; i < batch.size(); i++)
+	{
+		keys.push_back(batch[i].si->pkey);
+		batch[i].si->pkey = NULL;
+	}
+	rc = PKCS7_dataFinal(this->pkcs7, this->p7bio);
+	for (unsigned int i = 0; i < batch.size(); i++)
+	{
+		batch[i].si->pkey = keys[i];
+	}
+	return rc;
+}
@@ -1,18 +1,270 @@
 #include <libcryptosec/Random.h>
 
-ByteArray Random::bytes(int nbytes) throw (RandomException)
+#include <openssl/crypto.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#define RANDOM_THREAD_DRBG
+#endif
+
+#include <pthread.h>
+
+/* maior pedido feito de uma vez ao DRBG (max_request do CTR-DRBG) */
+#define RANDOM_MAX_REQUEST 65536
+
+/* estado do gerador de cada thread */
+struct RandomState
+{
+	unsigned char buffer[Random::BUFFER_SIZE];
+	/* bytes ainda não entregues, no fim do buffer */
+	size_t available;
+	/* bytes gerados desde a última semeadura */
+	unsigned long generated;
+	/* valor de randomGeneration quando o estado foi criado, para detectar fork() e troca de método */
+	unsigned long generation;
+	/* o método RAND do OpenSSL é o padrão, ou seja, os bytes podem vir do DRBG da thread */
+	bool defaultMethod;
+#ifdef RANDOM_THREAD_DRBG
+	EVP_RAND_CTX *drbg;
+#endif
+};
+
+static pthread_once_t randomOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t randomKey;
+static volatile unsigned long randomReseedInterval = 0;
+/* incrementado no processo filho após fork() e a cada troca do método RAND; invalida os estados das threads */
+static unsigned long randomGeneration = 1;
+
+static void randomStateFree(void *ptr)
+{
+	RandomState *state = (RandomState *)ptr;
+#ifdef RANDOM_THREAD_DRBG
+	EVP_RAND_CTX_free(state->drbg);
+#endif
+	OPENSSL_cleanse(state->buffer, sizeof(state->buffer));
+	delete state;
+}
+
+static void randomAtForkChild()
+{
+	__atomic_add_fetch(&randomGeneration, 1, __ATOMIC_RELEASE);
+}
+
+static void randomKeyCreate()
+{
+	pthread_key_create(&randomKey, randomStateFree);
+	pthread_atfork(NULL, NULL, randomAtForkChild);
+}
+
+/* com uma engine de números aleatórios configurada, os bytes devem vir dela */
+static bool randomDefaultMethod()
+{
+	return RAND_get_rand_method() == RAND_OpenSSL();
+}
+
+#ifdef RANDOM_THREAD_DRBG
+static EVP_RAND_CTX* randomDrbgNew()
+{
+	EVP_RAND *rand;
+	EVP_RAND_CTX *drbg;
+	OSSL_PARAM params[2];
+	rand = EVP_RAND_fetch(NULL, "CTR-DRBG", NULL);
+	if (rand == NULL)
+	{
+		return NULL;
+	}
+	drbg = EVP_RAND_CTX_new(rand, RAND_get0_primary(NULL));
+	EVP_RAND_free(rand);
+	if (drbg == NULL)
+	{
+		return NULL;
+	}
+	params[0] = OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_CIPHER, (char *)"AES-256-CTR", 0);
+	params[1] = OSSL_PARAM_construct_end();
+	if (!EVP_RAND_instantiate(drbg, 256, 0, NULL, 0, params))
+	{
+		EVP_RAND_CTX_free(drbg);
+		return NULL;
+	}
+	return drbg;
+}
+#endif
+
+/* descarta os bytes em buffer */
+static void randomStateDiscard(RandomState *state)
+{
+	OPENSSL_cleanse(state->buffer, sizeof(state->buffer));
+	state->available = 0;
+	state->generated = 0;
+}
+
+static RandomState* randomGetState() throw (RandomException)
+{
+	RandomState *state;
+	unsigned long generation;
+	pthread_once(&randomOnce, randomKeyCreate);
+	generation = __atomic_load_n(&randomGeneration, __ATOMIC_ACQUIRE);
+	state = (RandomState *)pthread_getspecific(randomKey);
+	if (state != NULL && state->generation == generation)
+	{
+		return state;
+	}
+	if (state == NULL)
+	{
+		state = new RandomState;
+		state->available = 0;
+		state->generated = 0;
+#ifdef RANDOM_THREAD_DRBG
+		state->drbg = NULL;
+#endif
+		pthread_setspecific(randomKey, state);
+	}
+	/* estado novo, herdado do processo pai ou de antes da troca de método: o filho não pode repetir os bytes do pai */
+	randomStateDiscard(state);
+	state->generation = generation;
+	/* RAND_get_rand_method() trava o lock global do RAND: consultado apenas aqui, não a cada pedido */
+	state->defaultMethod = randomDefaultMethod();
+#ifdef RANDOM_THREAD_DRBG
+	EVP_RAND_CTX_free(state->drbg);
+	state->drbg = NULL;
+	if (state->defaultMethod)
+	{
+		state->drbg = randomDrbgNew();
+		if (state->drbg == NULL)
+		{
+			state->generation = 0;
+			throw RandomException(RandomException::NO_DATA_SEEDED, "Random::fillInto");
+		}
+	}
+#endif
+	return state;
+}
+
+/* gera bytes diretamente em data, sem passar pelo buffer */
+static void randomGenerate(RandomState *state, unsigned char *data, size_t size) throw (RandomException)
 {
+	size_t length;
 	int rc;
-	ByteArray ret;
-	ret = ByteArray(nbytes);
-	rc = RAND_bytes(ret.getDataPointer(), nbytes);
-	if (rc == -1)
+#ifdef RANDOM_THREAD_DRBG
+	unsigned long interval = randomReseedInterval;
+#endif
+	while (size > 0)
 	{
-		throw RandomException(RandomException::NO_IMPLEMENTED_FUNCTION, "Random::bytes");
+		length = size < RANDOM_MAX_REQUEST ? size : RANDOM_MAX_REQUEST;
+#ifdef RANDOM_THREAD_DRBG
+		if (interval > 0 && state->generated >= interval)
+		{
+			if (!EVP_RAND_reseed(state->drbg, 0, NULL, 0, NULL, 0))
+			{
+				throw RandomException(RandomException::NO_DATA_SEEDED, "Random::fillInto");
+			}
+			state->generated = 0;
+		}
+		rc = EVP_RAND_generate(state->drbg, data, length, 0, 0, NULL, 0);
+#else
+		rc = RAND_bytes(data, (int)length);
+#endif
+		if (rc == -1)
+		{
+			throw RandomException(RandomException::NO_IMPLEMENTED_FUNCTION, "Random::fillInto");
+		}
+		else if (rc != 1)
+		{
+			throw RandomException(RandomException::NO_DATA_SEEDED, "Random::fillInto");
+		}
+		state->generated += length;
+		data += length;
+		size -= length;
 	}
-	else if (rc == 0)
+}
+
+void Random::fillInto(unsigned char *data, size_t size) throw (RandomException)
+{
+	RandomState *state;
+	unsigned char *next;
+	size_t length;
+	int rc;
+	if (size == 0)
+	{
+		return;
+	}
+	state = randomGetState();
+	if (!state->defaultMethod)
+	{
+		rc = RAND_bytes(data, (int)size);
+		if (rc == -1)
+		{
+			throw RandomException(RandomException::NO_IMPLEMENTED_FUNCTION, "Random::fillInto");
+		}
+		else if (rc == 0)
+		{
+			throw RandomException(RandomException::NO_DATA_SEEDED, "Random::fillInto");
+		}
+		return;
+	}
+	if (size > state->available && size >= Random::BUFFER_SIZE)
+	{
+		randomGenerate(state, data, size);
+		return;
+	}
+	while (size > 0)
+	{
+		if (state->available == 0)
+		{
+			randomGenerate(state, state->buffer, Random::BUFFER_SIZE);
+			state->available = Random::BUFFER_SIZE;
+		}
+		length = size < state->available ? size : state->available;
+		next = state->buffer + Random::BUFFER_SIZE - state->available;
+		memcpy(data, next, length);
+		OPENSSL_cleanse(next, length);
+		state->available -= length;
+		data += length;
+		size -= length;
+	}
+}
+
+void Random::fillInto(ByteArray &buffer) throw (RandomException)
+{
+	Random::fillInto(buffer.getDataPointer(), buffer.size());
+}
+
+void Random::setReseedInterval(unsigned long bytes)
+{
+	randomReseedInterval = bytes;
+}
+
+void Random::methodChanged()
+{
+	pthread_once(&randomOnce, randomKeyCreate);
+	__atomic_add_fetch(&randomGeneration, 1, __ATOMIC_RELEASE);
+}
+
+void Random::reseed() throw (RandomException)
+{
+	RandomState *state = randomGetState();
+	/* recria o estado: descarta o buffer, consulta novamente o método RAND e instancia um DRBG semeado pelo principal */
+	state->generation = 0;
+	try
+	{
+		randomGetState();
+	}
+	catch (RandomException &e)
+	{
+		throw RandomException(e.getErrorCode(), "Random::reseed");
+	}
+}
+
+ByteArray Random::bytes(int nbytes) throw (RandomException)
+{
+	ByteArray ret(nbytes);
+	try
+	{
+		Random::fillInto(ret);
+	}
+	catch (RandomException &e)
 	{
-		throw RandomException(RandomException::NO_DATA_SEEDED, "Random::bytes");
+		throw RandomException(e.getErrorCode(), "Random::bytes");
 	}
 	return ret;
 }
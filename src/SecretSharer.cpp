@@ -11,6 +11,8 @@
 
 #include <libcryptosec/SecretSharer.h>
 
+#include <pthread.h>
+
 /* global */
 
 # ifdef DEBUG
@@ -404,6 +406,9 @@ void SecretSharer::split_poly (std::istream *data, int parts, int threshold, std
 	}
 }
 
+/* bytes read from each stream at a time in the xor case */
+#define XOR_BLOCK_SIZE 65536
+
 /*
  * Split the specified input file into nout output files, such that
  * only all of them are sufficient to reconstruct the input.
@@ -413,30 +418,223 @@ void SecretSharer::split_poly (std::istream *data, int parts, int threshold, std
 
 void SecretSharer::split_xor (std::istream *data, int parts, std::vector<std::ostream *>* secrets)
 		throw (RandomException){
-	unsigned int i;
+	std::vector<unsigned char> xored(XOR_BLOCK_SIZE), buffer(XOR_BLOCK_SIZE);
+	size_t n;
 	int j;
-	unsigned char ch;
-	unsigned char *buffer, xored;
-	buffer = (unsigned char *)calloc(sizeof (unsigned char) * parts + 1, sizeof(unsigned char));
-	while ((i = data->readsome((char *)&ch, 1)) > 0){
-		xored = ch;
-		try{
-			SecretSharer::rand_bytes(buffer, parts-1);
-		}catch(...){
-			free(buffer);
-			throw;
+	do{
+		data->read((char *)&xored[0], XOR_BLOCK_SIZE);
+		n = (size_t)data->gcount();
+		if (n == 0){
+			break;
 		}
 		for (j=0;j<parts-1;j++){
-			xored ^= buffer[j];
-			(secrets->at(j))->write((char *)&(buffer[j]), 1);
-			
+			SecretSharer::rand_bytes(&buffer[0], n);
+			ByteArray::xorInto(&xored[0], &buffer[0], n);
+			(secrets->at(j))->write((char *)&buffer[0], n);
+		}
+		(secrets->at(parts-1))->write((char *)&xored[0], n);
+	}while (n == XOR_BLOCK_SIZE);
+	OPENSSL_cleanse(&xored[0], xored.size());
+	OPENSSL_cleanse(&buffer[0], buffer.size());
+}
+
+
+/******************* Code related to the GF(2^8) format *********************/
+
+/*
+ * Each part starts with the magic, the format version, its x coordinate
+ * and the threshold, followed by one byte per byte of the secret:
+ * the value at x of a polynomial over GF(2^8) whose constant term is the
+ * secret byte.  Data is processed in blocks, one pass per coefficient,
+ * and every multiplication by a constant is a lookup in a 256 entry table.
+ */
+
+#define GF256_MAGIC "SSGF"
+#define GF256_VERSION 1
+#define GF256_HEADER_SIZE 7
+#define GF256_BLOCK_SIZE 65536
+#define GF256_PARTS_LIMIT 255
+
+/* GF(2^8) modulo x^8 + x^4 + x^3 + x + 1, generator x + 1. gf_exp is
+   doubled so that gf_exp[gf_log[a] + gf_log[b]] needs no reduction. */
+static unsigned char gf_exp[510];
+static unsigned char gf_log[256];
+static pthread_once_t gf_once = PTHREAD_ONCE_INIT;
+
+static void gf_init(void){
+	unsigned int i, x = 1;
+	for (i = 0; i < 255; i++){
+		gf_exp[i] = gf_exp[i + 255] = (unsigned char)x;
+		gf_log[x] = (unsigned char)i;
+		x ^= x << 1;
+		if (x & 0x100){
+			x ^= 0x11b;
+		}
+	}
+}
+
+/* table[v] = c * v */
+static void gf_mul_table(unsigned char c, unsigned char *table){
+	unsigned int v;
+	table[0] = 0;
+	for (v = 1; v < 256; v++){
+		table[v] = c == 0 ? 0 : gf_exp[gf_log[c] + gf_log[v]];
+	}
+}
+
+/* cleanses the buffers holding secret material on every exit, exceptions
+   included: the input and output blocks and the random coefficients */
+class gf_cleanser{
+public:
+	gf_cleanser(std::vector<unsigned char> *a, std::vector<unsigned char> *b,
+			std::vector<unsigned char> *c = NULL){
+		buffers[0] = a;
+		buffers[1] = b;
+		buffers[2] = c;
+	}
+	~gf_cleanser(){
+		for (int i = 0; i < 3; i++){
+			if (buffers[i] != NULL && !buffers[i]->empty()){
+				OPENSSL_cleanse(&(*buffers[i])[0], buffers[i]->size());
+			}
+		}
+	}
+private:
+	std::vector<unsigned char> *buffers[3];
+};
+
+static void gf_write_header(std::ostream *out, unsigned char x, unsigned char threshold){
+	unsigned char header[GF256_HEADER_SIZE];
+	memcpy(header, GF256_MAGIC, 4);
+	header[4] = GF256_VERSION;
+	header[5] = x;
+	header[6] = threshold;
+	out->write((char *)header, GF256_HEADER_SIZE);
+}
+
+void SecretSharer::split_gf256 (std::istream *data, int parts, int threshold, std::vector<std::ostream *>* secrets)
+		throw (RandomException, SecretSharerException){
+	std::vector<unsigned char> in(GF256_BLOCK_SIZE), out(GF256_BLOCK_SIZE);
+	std::vector<unsigned char> coef((threshold - 1) * GF256_BLOCK_SIZE + 1);
+	std::vector<unsigned char> tables(parts * 256);
+	unsigned char *table, *c;
+	int i, k;
+	size_t j, n;
+	gf_cleanser cleanser(&in, &out, &coef);
+
+	pthread_once(&gf_once, gf_init);
+	for (i = 0; i < parts; i++){
+		gf_mul_table((unsigned char)(i + 1), &tables[i * 256]);
+		gf_write_header(secrets->at(i), (unsigned char)(i + 1), (unsigned char)threshold);
+	}
+	do{
+		data->read((char *)&in[0], GF256_BLOCK_SIZE);
+		n = (size_t)data->gcount();
+		if (data->bad()){
+			throw SecretSharerException(SecretSharerException::INTERNAL_ERROR, "SecretSharer::split_gf256");
+		}
+		if (n == 0){
+			break;
+		}
+		/* coefficient k + 1 of every byte of the block is at coef[k * n] */
+		if (threshold > 1){
+			SecretSharer::rand_bytes(&coef[0], (threshold - 1) * n);
+		}
+		for (i = 0; i < parts; i++){
+			table = &tables[i * 256];
+			/* Horner: ((a[t-1] x + a[t-2]) x + ... + a[1]) x + secret */
+			if (threshold == 1){
+				memcpy(&out[0], &in[0], n);
+			}else{
+				memcpy(&out[0], &coef[(threshold - 2) * n], n);
+				for (k = threshold - 3; k >= 0; k--){
+					c = &coef[k * n];
+					for (j = 0; j < n; j++){
+						out[j] = table[out[j]] ^ c[j];
+					}
+				}
+				for (j = 0; j < n; j++){
+					out[j] = table[out[j]] ^ in[j];
+				}
+			}
+			secrets->at(i)->write((char *)&out[0], n);
+			if (!secrets->at(i)->good()){
+				throw SecretSharerException(SecretSharerException::INTERNAL_ERROR, "SecretSharer::split_gf256");
+			}
+		}
+	}while (n == GF256_BLOCK_SIZE);
+}
+
+void SecretSharer::assemble_gf256(std::vector<std::istream *>* secrets, unsigned int threshold, std::ostream *secret)
+		throw (SecretSharerException){
+	std::vector<std::istream *> chosen;
+	std::vector<unsigned char> x, tables, in, out(GF256_BLOCK_SIZE);
+	unsigned char header[GF256_HEADER_SIZE], *table;
+	unsigned int i, m, logNum, logDen;
+	size_t j, n, size;
+	bool duplicated;
+	gf_cleanser cleanser(&in, &out);
+
+	pthread_once(&gf_once, gf_init);
+	/* any threshold parts with distinct x coordinates recover the secret */
+	for (i = 0; i < secrets->size() && chosen.size() < threshold; i++){
+		secrets->at(i)->read((char *)header, GF256_HEADER_SIZE);
+		if (secrets->at(i)->gcount() != GF256_HEADER_SIZE || memcmp(header, GF256_MAGIC, 4) != 0
+				|| header[4] != GF256_VERSION || header[5] == 0){
+			throw SecretSharerException(SecretSharerException::INTERNAL_ERROR, "SecretSharer::assemble_gf256");
+		}
+		if (header[6] != threshold){
+			throw SecretSharerException(SecretSharerException::INVALID_THRESHOLD_VALUE, "SecretSharer::assemble_gf256");
+		}
+		duplicated = false;
+		for (m = 0; m < x.size(); m++){
+			duplicated = duplicated || x[m] == header[5];
 		}
-		(secrets->at(parts-1))->write((char *)&(xored), 1);
+		if (!duplicated){
+			x.push_back(header[5]);
+			chosen.push_back(secrets->at(i));
+		}
+	}
+	if (chosen.size() < threshold){
+		throw SecretSharerException(SecretSharerException::INVALID_PARTS_VALUE, "SecretSharer::assemble_gf256");
+	}
+	/* Lagrange coefficients at 0: l[i] = prod x[m] / (x[m] - x[i]), m != i */
+	tables.resize(threshold * 256);
+	for (i = 0; i < threshold; i++){
+		logNum = 0;
+		logDen = 0;
+		for (m = 0; m < threshold; m++){
+			if (m != i){
+				logNum += gf_log[x[m]];
+				logDen += gf_log[x[m] ^ x[i]];
+			}
+		}
+		gf_mul_table(gf_exp[(logNum + 255 * threshold - logDen) % 255], &tables[i * 256]);
 	}
-	free(buffer);
+	in.resize(threshold * GF256_BLOCK_SIZE);
+	do{
+		n = 0;
+		for (i = 0; i < threshold; i++){
+			chosen[i]->read((char *)&in[i * GF256_BLOCK_SIZE], GF256_BLOCK_SIZE);
+			size = (size_t)chosen[i]->gcount();
+			if (chosen[i]->bad() || (i > 0 && size != n)){
+				throw SecretSharerException(SecretSharerException::INTERNAL_ERROR, "SecretSharer::assemble_gf256");
+			}
+			n = size;
+		}
+		memset(&out[0], 0, n);
+		for (i = 0; i < threshold; i++){
+			table = &tables[i * 256];
+			for (j = 0; j < n; j++){
+				out[j] ^= table[in[i * GF256_BLOCK_SIZE + j]];
+			}
+		}
+		secret->write((char *)&out[0], n);
+	}while (n == GF256_BLOCK_SIZE);
 }
 
-void SecretSharer::split(std::istream *data, int parts, int threshold, std::vector<std::ostream *>* secrets)
+void SecretSharer::split(std::istream *data, int parts, int threshold, std::vector<std::ostream *>* secrets,
+		SecretSharer::Format format)
 		throw (SecretSharerException, RandomException){
 	int i;
 	int size, maxSize, finalSize;
@@ -449,7 +647,12 @@ void SecretSharer::split(std::istream *data, int parts, int threshold, std::vect
 	}else if ((unsigned int)threshold > secrets->size()){
 		throw SecretSharerException(SecretSharerException::INVALID_PARTS_VALUE, "SecretSharer::split");
 	}
-	if (threshold == 1){
+	if (format == SecretSharer::GF256){
+		if (parts > GF256_PARTS_LIMIT || (unsigned int)parts > secrets->size()){
+			throw SecretSharerException(SecretSharerException::INVALID_PARTS_VALUE, "SecretSharer::split");
+		}
+		SecretSharer::split_gf256 (data, parts, threshold, secrets);
+	}else if (threshold == 1){
 		maxSize = 1024;
 		size = maxSize;
 		finalSize = 0;
@@ -477,7 +680,7 @@ void SecretSharer::split(std::istream *data, int parts, int threshold, std::vect
  * largest prime < 2^16.  This is the main routine for the splitting case.
  *
  */
-    
+
 /******************* Code related to assembly *********************/
 
 
@@ -736,24 +939,27 @@ void SecretSharer::assemble_poly(std::vector<std::istream *>* secrets, unsigned
  */
 
 void SecretSharer::assemble_xor(std::vector<std::istream *>* secrets, unsigned int parts, std::ostream *secret){
-	unsigned int i, size;
-	unsigned char ch, result;
-	size = (secrets->at(0))->readsome((char *)&result, 1);
-	while (size != 0){
+	std::vector<unsigned char> result(XOR_BLOCK_SIZE), buffer(XOR_BLOCK_SIZE);
+	unsigned int i;
+	size_t n;
+	do{
+		(secrets->at(0))->read((char *)&result[0], XOR_BLOCK_SIZE);
+		n = (size_t)(secrets->at(0))->gcount();
 		for (i=1;i<parts;i++){
-			size = (secrets->at(i))->readsome((char *)&ch, 1);
-			result ^= (ch & 0xff);
+			(secrets->at(i))->read((char *)&buffer[0], n);
+			ByteArray::xorInto(&result[0], &buffer[0], (size_t)(secrets->at(i))->gcount());
 		}
-		secret->write((char *)&result, 1);
-		size = (secrets->at(0))->readsome((char *)&result, 1);
-	}
+		secret->write((char *)&result[0], n);
+	}while (n == XOR_BLOCK_SIZE);
+	OPENSSL_cleanse(&result[0], result.size());
 }
 
 /*
  * Given the data parts, assemble them to generate the
  * original secret.  This is the main routine for the assembly case.
  */
-void SecretSharer::join(std::vector<std::istream *>* secrets, unsigned int parts, unsigned int threshold, std::ostream *secret)
+void SecretSharer::join(std::vector<std::istream *>* secrets, unsigned int parts, unsigned int threshold, std::ostream *secret,
+		SecretSharer::Format format)
 		throw (SecretSharerException){
 //	int i, j;
 	int maxSize, size, finalSize;
@@ -768,7 +974,9 @@ void SecretSharer::join(std::vector<std::istream *>* secrets, unsigned int parts
 	}else if (secrets->size() < threshold){
 		throw SecretSharerException(SecretSharerException::INVALID_PARTS_VALUE, "SecretSharer::join");
 	}
-	if (threshold == 1){
+	if (format == SecretSharer::GF256){
+		SecretSharer::assemble_gf256 (secrets, threshold, secret);
+	}else if (threshold == 1){
 		maxSize = 1024;
 		size = maxSize;
 		finalSize = 0;
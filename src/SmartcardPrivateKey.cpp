@@ -0,0 +1,29 @@
+#include <libcryptosec/SmartcardPrivateKey.h>
+
+#include <libcryptosec/SmartcardSlot.h>
+
+SmartcardPrivateKey::SmartcardPrivateKey(EVP_PKEY *key, std::string &id, std::string &serial, SmartcardSlot *slot)
+		throw (AsymmetricKeyException) : PrivateKey(key)
+{
+	this->id = id;
+	this->serial = serial;
+	this->slot = slot;
+}
+
+SmartcardPrivateKey::~SmartcardPrivateKey()
+{
+	if (this->slot)
+	{
+		this->slot->releasePrivateKey();
+	}
+}
+
+std::string SmartcardPrivateKey::getId()
+{
+	return this->id;
+}
+
+std::string SmartcardPrivateKey::getSerial()
+{
+	return this->serial;
+}
@@ -1,12 +1,23 @@
 #include <libcryptosec/SmartcardSlot.h>
 
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
 SmartcardSlot::SmartcardSlot(PKCS11_SLOT *slot)
 {
 	this->slot = slot;
+	this->loggedIn = false;
+	this->certificatesLoaded = false;
+	this->privateKeysInUse = 0;
+	pthread_mutex_init(&this->mutex, NULL);
 }
 
 SmartcardSlot::~SmartcardSlot()
 {
+	pthread_mutex_lock(&this->mutex);
+	this->close();
+	pthread_mutex_unlock(&this->mutex);
+	pthread_mutex_destroy(&this->mutex);
 }
 
 std::string SmartcardSlot::getSerial()
@@ -27,55 +38,169 @@ std::vector<SmartcardCertificate *> SmartcardSlot::getCertificates()
 		throw (SmartcardModuleException)
 {
 	PKCS11_CERT *certs;
-	unsigned int i, j, ncerts;
-	char *bufferId;
+	unsigned int j, ncerts;
 	std::string id, label, serial;
-	int rc, k, emptySlots;
+	int rc;
 	std::vector<SmartcardCertificate *> ret;
-	std::vector<SmartcardCertificate *>::iterator iter;
-	emptySlots = 0;
 	SmartcardCertificate *cert;
 
-	rc = PKCS11_enumerate_certs(this->slot[0].token, &certs, &ncerts);
-	if (rc < 0){
-		for (iter=ret.begin();iter!=ret.end();iter++)
+	pthread_mutex_lock(&this->mutex);
+	if (!this->certificatesLoaded)
+	{
+		rc = PKCS11_enumerate_certs(this->slot[0].token, &certs, &ncerts);
+		if (rc < 0){
+			pthread_mutex_unlock(&this->mutex);
+			throw SmartcardModuleException(SmartcardModuleException::ENUMERATING_CERTIFICATES, "SmartcardSlot::getCertificates", true);
+		}
+		for (j=0;j<ncerts;j++)
 		{
-			ret.erase(iter);
-			delete *iter;
+			this->certificates.push_back(&certs[j]);
 		}
-		throw SmartcardModuleException(SmartcardModuleException::ENUMERATING_CERTIFICATES, "SmartcardSlot::getCertificates", true);
+		this->certificatesLoaded = true;
 	}
-	for (j=0;j<ncerts;j++)
+	serial = this->slot[0].token->serialnr;
+	for (j=0;j<this->certificates.size();j++)
 	{
-		bufferId = (char *)calloc((certs[j].id_len * 2) + 1, sizeof(char));
-		for (k=0;k<certs[j].id_len;k++)
-		{
-			sprintf(&(bufferId[k*2]), "%02X", certs[i].id[k]);
-		}
-		id.append(bufferId);
-		free(bufferId);
-		label = certs[j].label;
-		serial = this->slot[0].token->serialnr;
-		cert = new SmartcardCertificate(id, label, serial, X509_dup(certs[j].x509));
+		id = SmartcardSlot::encodeId(this->certificates[j]->id, this->certificates[j]->id_len);
+		label = this->certificates[j]->label;
+		cert = new SmartcardCertificate(id, label, serial, X509_dup(this->certificates[j]->x509));
 		ret.push_back(cert);
 	}
+	pthread_mutex_unlock(&this->mutex);
 	return ret;
 }
 
 ByteArray SmartcardSlot::decrypt(std::string &keyId, std::string &pin, ByteArray &data)
 		throw (SmartcardModuleException)
 {
-	int rc, found = 0, nret, keySize, j, errorCode;
-	PKCS11_KEY *keys;
+	int nret, keySize;
+	PKCS11_KEY *key;
 	ByteArray ret;
-    unsigned int nKeys, i;
-    std::string idTmp;
-    char *bufferId;
     ERR_clear_error();
     if (pin.size() < 4 || pin.size() > 8)
     {
     	throw SmartcardModuleException(SmartcardModuleException::INVALID_PIN, "SmartcardSlot::decrypt", true);
     }
+    pthread_mutex_lock(&this->mutex);
+    //a libp11 mantém uma única sessão por slot: a operação é serializada, e o handle da chave
+    //não pode ser descartado por um login concorrente com outro PIN enquanto é usado
+    try
+    {
+    	this->login(pin);
+    	key = this->getKey(keyId);
+    }
+    catch (SmartcardModuleException &e)
+    {
+    	pthread_mutex_unlock(&this->mutex);
+    	throw;
+    }
+    keySize = PKCS11_get_key_size(key);
+	ret = ByteArray(keySize);
+    nret = PKCS11_private_decrypt(data.size(), data.getDataPointer(), ret.getDataPointer(), key, RSA_PKCS1_PADDING);
+    pthread_mutex_unlock(&this->mutex);
+    if (nret <= 0)
+    {
+		throw SmartcardModuleException(SmartcardModuleException::DECRYPTING_DATA, "SmartcardSlot::decrypt", true);
+    }
+    ret = ByteArray(ret.getDataPointer(), nret);
+    return ret;
+}
+
+SmartcardPrivateKey* SmartcardSlot::getPrivateKey(std::string &keyId, std::string &pin)
+		throw (SmartcardModuleException)
+{
+	EVP_PKEY *pkey = NULL;
+	std::string serial;
+	std::map<std::string, EVP_PKEY *>::iterator found;
+	ERR_clear_error();
+	if (pin.size() < 4 || pin.size() > 8)
+	{
+		throw SmartcardModuleException(SmartcardModuleException::INVALID_PIN, "SmartcardSlot::getPrivateKey", true);
+	}
+	pthread_mutex_lock(&this->mutex);
+	try
+	{
+		this->login(pin);
+		found = this->privateKeys.find(keyId);
+		if (found == this->privateKeys.end())
+		{
+			pkey = PKCS11_get_private_key(this->getKey(keyId));
+			if (pkey == NULL)
+			{
+				throw SmartcardModuleException(SmartcardModuleException::ENUMERATING_PRIVATE_KEYS, "SmartcardSlot::getPrivateKey", true);
+			}
+			found = this->privateKeys.insert(std::make_pair(keyId, pkey)).first;
+		}
+	}
+	catch (SmartcardModuleException &e)
+	{
+		pthread_mutex_unlock(&this->mutex);
+		throw;
+	}
+	pkey = found->second;
+	EVP_PKEY_up_ref(pkey);
+	this->privateKeysInUse++;
+	pthread_mutex_unlock(&this->mutex);
+	serial = this->slot[0].token->serialnr;
+	try
+	{
+		return new SmartcardPrivateKey(pkey, keyId, serial, this);
+	}
+	catch (AsymmetricKeyException &e)
+	{
+		EVP_PKEY_free(pkey);
+		this->releasePrivateKey();
+		throw SmartcardModuleException(SmartcardModuleException::ENUMERATING_PRIVATE_KEYS, "SmartcardSlot::getPrivateKey");
+	}
+}
+
+void SmartcardSlot::logout() throw (SmartcardModuleException)
+{
+	pthread_mutex_lock(&this->mutex);
+	if (this->privateKeysInUse > 0)
+	{
+		pthread_mutex_unlock(&this->mutex);
+		throw SmartcardModuleException(SmartcardModuleException::SESSION_IN_USE, "SmartcardSlot::logout");
+	}
+	this->close();
+	pthread_mutex_unlock(&this->mutex);
+}
+
+void SmartcardSlot::refresh() throw (SmartcardModuleException)
+{
+	pthread_mutex_lock(&this->mutex);
+	if (this->privateKeysInUse > 0)
+	{
+		pthread_mutex_unlock(&this->mutex);
+		throw SmartcardModuleException(SmartcardModuleException::SESSION_IN_USE, "SmartcardSlot::refresh");
+	}
+	this->clearHandles();
+	pthread_mutex_unlock(&this->mutex);
+}
+
+void SmartcardSlot::login(std::string &pin) throw (SmartcardModuleException)
+{
+	int rc, errorCode, logged = 0;
+	ByteArray digest = this->getPinDigest(pin);
+
+	if (this->loggedIn)
+	{
+		//a sessão pode ter sido encerrada por outro objeto do mesmo slot ou pela remoção do token
+		if (digest == this->pinDigest && PKCS11_is_logged_in(this->slot, 0, &logged) == 0 && logged)
+		{
+			return;
+		}
+		//um novo login descartaria os handles usados pelas SmartcardPrivateKey em uso
+		if (this->privateKeysInUse > 0)
+		{
+			throw SmartcardModuleException(SmartcardModuleException::SESSION_IN_USE, "SmartcardSlot::login");
+		}
+		PKCS11_logout(this->slot);
+		this->loggedIn = false;
+		this->pinDigest = ByteArray();
+	}
+	//handles enumerados antes do login não incluem as chaves privadas, e o logout acima libera os certificados
+	this->clearHandles();
 	rc = PKCS11_login(this->slot, 0, pin.c_str());
 	if (rc != 0)
     {
@@ -93,41 +218,102 @@ ByteArray SmartcardSlot::decrypt(std::string &keyId, std::string &pin, ByteArray
     		throw SmartcardModuleException(SmartcardModuleException::UNKNOWN, "SmartcardSlot::decrypt", true);
     	}
     }
-	rc = PKCS11_enumerate_keys(this->slot[0].token, &keys, &nKeys);
-	if (rc != 0 || nKeys == 0)
+	this->loggedIn = true;
+	this->pinDigest = digest;
+}
+
+PKCS11_KEY* SmartcardSlot::getKey(std::string &keyId) throw (SmartcardModuleException)
+{
+	int rc;
+	PKCS11_KEY *keys;
+	unsigned int nKeys, i;
+	std::map<std::string, PKCS11_KEY *>::iterator found;
+
+	if (this->keys.empty())
+	{
+		rc = PKCS11_enumerate_keys(this->slot[0].token, &keys, &nKeys);
+		if (rc != 0 || nKeys == 0)
+		{
+			throw SmartcardModuleException(SmartcardModuleException::ENUMERATING_PRIVATE_KEYS, "SmartcardSlot::decrypt", true);
+		}
+		for (i=0;i<nKeys;i++)
+		{
+			this->keys[SmartcardSlot::encodeId(keys[i].id, keys[i].id_len)] = &keys[i];
+		}
+	}
+	found = this->keys.find(keyId);
+	if (found == this->keys.end())
+	{
+		throw SmartcardModuleException(SmartcardModuleException::ID_NOT_FOUND, "SmartcardSlot::decrypt", true);
+	}
+	return found->second;
+}
+
+void SmartcardSlot::releasePrivateKey()
+{
+	pthread_mutex_lock(&this->mutex);
+	this->privateKeysInUse--;
+	pthread_mutex_unlock(&this->mutex);
+}
+
+void SmartcardSlot::close()
+{
+	if (this->loggedIn)
 	{
 		PKCS11_logout(this->slot);
-		throw SmartcardModuleException(SmartcardModuleException::ENUMERATING_PRIVATE_KEYS, "SmartcardSlot::decrypt", true);
+		this->loggedIn = false;
+		this->pinDigest = ByteArray();
 	}
-	found = -1;
-	for (i=0;(i<nKeys)&&(found==-1);i++)
+	this->clearHandles();
+}
+
+void SmartcardSlot::clearPrivateKeys()
+{
+	std::map<std::string, EVP_PKEY *>::iterator iter;
+	for (iter = this->privateKeys.begin(); iter != this->privateKeys.end(); iter++)
 	{
-		bufferId = (char *)calloc((keys[i].id_len * 2) + 1, sizeof(char));
-		for (j=0;j<keys[i].id_len;j++)
+		EVP_PKEY_free(iter->second);
+	}
+	this->privateKeys.clear();
+}
+
+void SmartcardSlot::clearHandles()
+{
+	this->clearPrivateKeys();
+	this->keys.clear();
+	this->certificates.clear();
+	this->certificatesLoaded = false;
+}
+
+std::string SmartcardSlot::encodeId(const unsigned char *id, size_t size)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	std::string ret(size * 2, '0');
+	for (size_t i = 0; i < size; i++)
+	{
+		ret[i * 2] = hex[id[i] >> 4];
+		ret[i * 2 + 1] = hex[id[i] & 0x0f];
+	}
+	return ret;
+}
+
+ByteArray SmartcardSlot::getPinDigest(std::string &pin) throw (SmartcardModuleException)
+{
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int size = 0;
+	if (this->pinKey.size() == 0)
+	{
+		this->pinKey = ByteArray(32);
+		if (RAND_bytes(this->pinKey.getDataPointer(), this->pinKey.size()) != 1)
 		{
-			sprintf(&(bufferId[j*2]), "%02X", keys[i].id[j]);
+			this->pinKey = ByteArray();
+			throw SmartcardModuleException(SmartcardModuleException::UNKNOWN, "SmartcardSlot::login", true);
 		}
-		idTmp = bufferId;
-		free(bufferId);
-        if (keyId == idTmp)
-        {
-            found = i;
-            keySize = PKCS11_get_key_size(&keys[i]);
-        }
-    }
-	if (found < 0)
+	}
+	if (HMAC(EVP_sha256(), this->pinKey.getDataPointer(), this->pinKey.size(),
+			(const unsigned char *) pin.data(), pin.size(), digest, &size) == NULL)
 	{
-		PKCS11_logout(this->slot);
-		//TODO: apagar todas as chaves encontradas, não tem na libp11
-		throw SmartcardModuleException(SmartcardModuleException::ID_NOT_FOUND, "SmartcardSlot::decrypt", true);
+		throw SmartcardModuleException(SmartcardModuleException::UNKNOWN, "SmartcardSlot::login", true);
 	}
-	ret = ByteArray(keySize);
-    nret = PKCS11_private_decrypt(data.size(), data.getDataPointer(), ret.getDataPointer(), &keys[found], RSA_PKCS1_PADDING);
-    PKCS11_logout(this->slot);
-    if (nret <= 0)
-    {
-		throw SmartcardModuleException(SmartcardModuleException::DECRYPTING_DATA, "SmartcardSlot::decrypt", true);
-    }
-    ret = ByteArray(ret.getDataPointer(), nret);
-    return ret;
+	return ByteArray(digest, size);
 }
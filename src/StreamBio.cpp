@@ -0,0 +1,332 @@
+#include <libcryptosec/StreamBio.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+pthread_once_t StreamBio::methodsOnce = PTHREAD_ONCE_INIT;
+BIO_METHOD *StreamBio::inputMethod = NULL;
+BIO_METHOD *StreamBio::outputMethod = NULL;
+BIO_METHOD *StreamBio::memoryMethod = NULL;
+BIO_METHOD *StreamBio::sourceMethod = NULL;
+
+/* região de memória lida por StreamBio::newInput(const unsigned char*, size_t) */
+struct MemoryRegion
+{
+	const unsigned char *data;
+	size_t remaining;
+};
+
+static int streamBioCreate(BIO *bio)
+{
+	BIO_set_init(bio, 1);
+	return 1;
+}
+
+static int streamBioDestroy(BIO *bio)
+{
+	if (bio == NULL)
+	{
+		return 0;
+	}
+	//o stream pertence ao chamador
+	BIO_set_data(bio, NULL);
+	return 1;
+}
+
+static int streamBioRead(BIO *bio, char *data, int size)
+{
+	std::istream *in;
+	BIO_clear_retry_flags(bio);
+	in = (std::istream *)BIO_get_data(bio);
+	if (in == NULL || size <= 0)
+	{
+		return 0;
+	}
+	in->read(data, size);
+	if (in->gcount() > 0)
+	{
+		return (int)in->gcount();
+	}
+	return in->bad() ? -1 : 0;
+}
+
+static int sourceBioRead(BIO *bio, char *data, int size)
+{
+	StreamBio::Source *source;
+	BIO_clear_retry_flags(bio);
+	source = (StreamBio::Source *)BIO_get_data(bio);
+	if (source == NULL || size <= 0)
+	{
+		return 0;
+	}
+	return source->read(data, size);
+}
+
+static long sourceBioCtrl(BIO *bio, int cmd, long num, void *ptr)
+{
+	return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+static int memoryBioDestroy(BIO *bio)
+{
+	if (bio == NULL)
+	{
+		return 0;
+	}
+	delete (MemoryRegion *)BIO_get_data(bio);
+	BIO_set_data(bio, NULL);
+	return 1;
+}
+
+static int memoryBioRead(BIO *bio, char *data, int size)
+{
+	MemoryRegion *region;
+	size_t length;
+	BIO_clear_retry_flags(bio);
+	region = (MemoryRegion *)BIO_get_data(bio);
+	if (region == NULL || size <= 0)
+	{
+		return 0;
+	}
+	length = region->remaining < (size_t)size ? region->remaining : (size_t)size;
+	memcpy(data, region->data, length);
+	region->data += length;
+	region->remaining -= length;
+	return (int)length;
+}
+
+static long memoryBioCtrl(BIO *bio, int cmd, long num, void *ptr)
+{
+	MemoryRegion *region = (MemoryRegion *)BIO_get_data(bio);
+	switch (cmd)
+	{
+		case BIO_CTRL_EOF:
+			return (region == NULL || region->remaining == 0) ? 1 : 0;
+		case BIO_CTRL_PENDING:
+			return region == NULL ? 0 : (long)std::min(region->remaining, (size_t)LONG_MAX);
+		case BIO_CTRL_FLUSH:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static int streamBioWrite(BIO *bio, const char *data, int size)
+{
+	std::ostream *out;
+	BIO_clear_retry_flags(bio);
+	out = (std::ostream *)BIO_get_data(bio);
+	if (out == NULL || size < 0)
+	{
+		return -1;
+	}
+	out->write(data, size);
+	return out->good() ? size : -1;
+}
+
+static int streamBioPuts(BIO *bio, const char *str)
+{
+	int size = 0;
+	while (str[size] != '\0')
+	{
+		size++;
+	}
+	return streamBioWrite(bio, str, size);
+}
+
+static long streamBioInputCtrl(BIO *bio, int cmd, long num, void *ptr)
+{
+	std::istream *in = (std::istream *)BIO_get_data(bio);
+	switch (cmd)
+	{
+		case BIO_CTRL_EOF:
+			return (in == NULL || in->eof()) ? 1 : 0;
+		case BIO_CTRL_FLUSH:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static long streamBioOutputCtrl(BIO *bio, int cmd, long num, void *ptr)
+{
+	std::ostream *out = (std::ostream *)BIO_get_data(bio);
+	switch (cmd)
+	{
+		case BIO_CTRL_FLUSH:
+			if (out == NULL)
+			{
+				return 0;
+			}
+			out->flush();
+			return out->good() ? 1 : 0;
+		default:
+			return 0;
+	}
+}
+
+void StreamBio::createMethods()
+{
+	StreamBio::inputMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "std::istream");
+	if (StreamBio::inputMethod)
+	{
+		BIO_meth_set_create(StreamBio::inputMethod, streamBioCreate);
+		BIO_meth_set_destroy(StreamBio::inputMethod, streamBioDestroy);
+		BIO_meth_set_read(StreamBio::inputMethod, streamBioRead);
+		BIO_meth_set_ctrl(StreamBio::inputMethod, streamBioInputCtrl);
+	}
+	StreamBio::outputMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "std::ostream");
+	if (StreamBio::outputMethod)
+	{
+		BIO_meth_set_create(StreamBio::outputMethod, streamBioCreate);
+		BIO_meth_set_destroy(StreamBio::outputMethod, streamBioDestroy);
+		BIO_meth_set_write(StreamBio::outputMethod, streamBioWrite);
+		BIO_meth_set_puts(StreamBio::outputMethod, streamBioPuts);
+		BIO_meth_set_ctrl(StreamBio::outputMethod, streamBioOutputCtrl);
+	}
+	StreamBio::memoryMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "memory region");
+	if (StreamBio::memoryMethod)
+	{
+		BIO_meth_set_create(StreamBio::memoryMethod, streamBioCreate);
+		BIO_meth_set_destroy(StreamBio::memoryMethod, memoryBioDestroy);
+		BIO_meth_set_read(StreamBio::memoryMethod, memoryBioRead);
+		BIO_meth_set_ctrl(StreamBio::memoryMethod, memoryBioCtrl);
+	}
+	StreamBio::sourceMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "StreamBio::Source");
+	if (StreamBio::sourceMethod)
+	{
+		BIO_meth_set_create(StreamBio::sourceMethod, streamBioCreate);
+		BIO_meth_set_destroy(StreamBio::sourceMethod, streamBioDestroy);
+		BIO_meth_set_read(StreamBio::sourceMethod, sourceBioRead);
+		BIO_meth_set_ctrl(StreamBio::sourceMethod, sourceBioCtrl);
+	}
+}
+
+BIO_METHOD* StreamBio::getInputMethod()
+{
+	pthread_once(&StreamBio::methodsOnce, StreamBio::createMethods);
+	return StreamBio::inputMethod;
+}
+
+BIO_METHOD* StreamBio::getOutputMethod()
+{
+	pthread_once(&StreamBio::methodsOnce, StreamBio::createMethods);
+	return StreamBio::outputMethod;
+}
+
+BIO_METHOD* StreamBio::getMemoryMethod()
+{
+	pthread_once(&StreamBio::methodsOnce, StreamBio::createMethods);
+	return StreamBio::memoryMethod;
+}
+
+BIO_METHOD* StreamBio::getSourceMethod()
+{
+	pthread_once(&StreamBio::methodsOnce, StreamBio::createMethods);
+	return StreamBio::sourceMethod;
+}
+
+BIO* StreamBio::push(BIO *sink, unsigned int bufferSize)
+{
+	BIO *buffer;
+	if (bufferSize == 0)
+	{
+		return sink;
+	}
+	buffer = BIO_new(BIO_f_buffer());
+	if (buffer == NULL || !BIO_set_buffer_size(buffer, bufferSize))
+	{
+		BIO_free(buffer);
+		BIO_free(sink);
+		return NULL;
+	}
+	return BIO_push(buffer, sink);
+}
+
+BIO* StreamBio::newInput(std::istream *in, unsigned int bufferSize)
+{
+	BIO *bio;
+	BIO_METHOD *method = StreamBio::getInputMethod();
+	if (method == NULL || in == NULL)
+	{
+		return NULL;
+	}
+	bio = BIO_new(method);
+	if (bio == NULL)
+	{
+		return NULL;
+	}
+	BIO_set_data(bio, in);
+	return StreamBio::push(bio, bufferSize);
+}
+
+BIO* StreamBio::newInput(const unsigned char *data, size_t size)
+{
+	BIO *bio;
+	MemoryRegion *region;
+	BIO_METHOD *method = StreamBio::getMemoryMethod();
+	if (method == NULL || (data == NULL && size > 0))
+	{
+		return NULL;
+	}
+	bio = BIO_new(method);
+	if (bio == NULL)
+	{
+		return NULL;
+	}
+	region = new MemoryRegion;
+	region->data = data;
+	region->remaining = size;
+	BIO_set_data(bio, region);
+	return bio;
+}
+
+BIO* StreamBio::newInput(StreamBio::Source *source, unsigned int bufferSize)
+{
+	BIO *bio;
+	BIO_METHOD *method = StreamBio::getSourceMethod();
+	if (method == NULL || source == NULL)
+	{
+		return NULL;
+	}
+	bio = BIO_new(method);
+	if (bio == NULL)
+	{
+		return NULL;
+	}
+	BIO_set_data(bio, source);
+	return StreamBio::push(bio, bufferSize);
+}
+
+BIO* StreamBio::newOutput(std::ostream *out, unsigned int bufferSize)
+{
+	BIO *bio;
+	BIO_METHOD *method = StreamBio::getOutputMethod();
+	if (method == NULL || out == NULL)
+	{
+		return NULL;
+	}
+	bio = BIO_new(method);
+	if (bio == NULL)
+	{
+		return NULL;
+	}
+	BIO_set_data(bio, out);
+	return StreamBio::push(bio, bufferSize);
+}
+
+bool StreamBio::copy(BIO *in, BIO *out, unsigned int bufferSize)
+{
+	std::vector<char> buffer(bufferSize > 0 ? bufferSize : StreamBio::DEFAULT_BUFFER_SIZE);
+	int size;
+	while ((size = BIO_read(in, &buffer[0], (int)buffer.size())) > 0)
+	{
+		if (BIO_write(out, &buffer[0], size) != size)
+		{
+			return false;
+		}
+	}
+	return size == 0;
+}
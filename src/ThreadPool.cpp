@@ -0,0 +1,186 @@
+#include <libcryptosec/ThreadPool.h>
+
+#include <unistd.h>
+
+/*
+ * ThreadPool cuja tarefa está em execução na thread corrente, NULL fora de tarefas,
+ * para que execute() chamado por uma tarefa não espere por um lote do qual depende.
+ */
+static pthread_key_t runningKey;
+static pthread_once_t runningOnce = PTHREAD_ONCE_INIT;
+
+static void runningKeyInit()
+{
+	pthread_key_create(&runningKey, NULL);
+}
+
+ThreadPool::ThreadPool(unsigned int threads)
+{
+	pthread_t thread;
+
+	this->tasks = NULL;
+	this->next = 0;
+	this->pending = 0;
+	this->stop = false;
+	pthread_mutex_init(&this->mutex, NULL);
+	pthread_mutex_init(&this->executeMutex, NULL);
+	pthread_cond_init(&this->workCond, NULL);
+	pthread_cond_init(&this->doneCond, NULL);
+	pthread_once(&runningOnce, runningKeyInit);
+
+	if (threads == 0)
+	{
+		threads = ThreadPool::getProcessors();
+	}
+
+	//a thread que chama execute() tambem trabalha
+	for (unsigned int i = 1; i < threads; i++)
+	{
+		if (pthread_create(&thread, NULL, ThreadPool::worker, this) != 0)
+		{
+			break;
+		}
+		this->threads.push_back(thread);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	pthread_mutex_lock(&this->mutex);
+	this->stop = true;
+	pthread_cond_broadcast(&this->workCond);
+	pthread_mutex_unlock(&this->mutex);
+
+	for (unsigned int i = 0; i < this->threads.size(); i++)
+	{
+		pthread_join(this->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&this->doneCond);
+	pthread_cond_destroy(&this->workCond);
+	pthread_mutex_destroy(&this->executeMutex);
+	pthread_mutex_destroy(&this->mutex);
+}
+
+void ThreadPool::execute(std::vector<ThreadPool::Task*> &tasks)
+{
+	if (tasks.empty())
+	{
+		return;
+	}
+
+	/*
+	 * chamado por uma tarefa: se este ThreadPool já executa um lote, ele pode depender da própria tarefa
+	 * (diretamente ou por meio de outro ThreadPool), então as tarefas são executadas nesta thread
+	 */
+	if (pthread_getspecific(runningKey) != NULL)
+	{
+		if (pthread_mutex_trylock(&this->executeMutex) != 0)
+		{
+			for (unsigned int i = 0; i < tasks.size(); i++)
+			{
+				ThreadPool::run(tasks[i]);
+			}
+			return;
+		}
+	}
+	else
+	{
+		pthread_mutex_lock(&this->executeMutex);
+	}
+	pthread_mutex_lock(&this->mutex);
+
+	this->tasks = &tasks;
+	this->next = 0;
+	this->pending = tasks.size();
+	if (tasks.size() > 1)
+	{
+		pthread_cond_broadcast(&this->workCond);
+	}
+
+	this->runTasks();
+	while (this->pending > 0)
+	{
+		pthread_cond_wait(&this->doneCond, &this->mutex);
+	}
+	this->tasks = NULL;
+
+	pthread_mutex_unlock(&this->mutex);
+	pthread_mutex_unlock(&this->executeMutex);
+}
+
+unsigned int ThreadPool::getSize() const
+{
+	return this->threads.size() + 1;
+}
+
+unsigned int ThreadPool::getProcessors()
+{
+	long ret;
+
+	ret = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ret < 1)
+	{
+		ret = 1;
+	}
+
+	return static_cast<unsigned int>(ret);
+}
+
+void* ThreadPool::worker(void *arg)
+{
+	ThreadPool *pool = static_cast<ThreadPool*>(arg);
+
+	pthread_mutex_lock(&pool->mutex);
+	while (!pool->stop)
+	{
+		if (pool->tasks != NULL && pool->next < pool->tasks->size())
+		{
+			pool->runTasks();
+		}
+		else
+		{
+			pthread_cond_wait(&pool->workCond, &pool->mutex);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+void ThreadPool::runTasks()
+{
+	ThreadPool::Task *task;
+	void *previous = pthread_getspecific(runningKey);
+
+	while (this->tasks != NULL && this->next < this->tasks->size())
+	{
+		task = (*this->tasks)[this->next];
+		this->next++;
+		pthread_mutex_unlock(&this->mutex);
+
+		pthread_setspecific(runningKey, this);
+		ThreadPool::run(task);
+		pthread_setspecific(runningKey, previous);
+
+		pthread_mutex_lock(&this->mutex);
+		this->pending--;
+		if (this->pending == 0)
+		{
+			pthread_cond_signal(&this->doneCond);
+		}
+	}
+}
+
+void ThreadPool::run(ThreadPool::Task *task)
+{
+	task->failed = false;
+	try
+	{
+		task->run();
+	}
+	catch (...)
+	{
+		task->failed = true;
+	}
+}
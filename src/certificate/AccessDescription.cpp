@@ -1,11 +1,12 @@
 #include <libcryptosec/certificate/AccessDescription.h>
+#include <libcryptosec/certificate/ObjectIdentifierFactory.h>
 
 AccessDescription::AccessDescription() {
 }
 
 AccessDescription::AccessDescription(ACCESS_DESCRIPTION *accessDescription) {
 	if(accessDescription->method) {
-		accessMethod = ObjectIdentifier(OBJ_dup(accessDescription->method));
+		accessMethod = ObjectIdentifierFactory::getObjectIdentifier(accessDescription->method);
 	}
 	if(accessDescription->location) {
 		accessLocation = GeneralName(accessDescription->location);
@@ -15,7 +16,7 @@ AccessDescription::AccessDescription(ACCESS_DESCRIPTION *accessDescription) {
 ACCESS_DESCRIPTION* AccessDescription::getAccessDescription() {
 	ACCESS_DESCRIPTION* accessDescription = ACCESS_DESCRIPTION_new();
 
-	accessDescription->method = accessMethod.getObjectIdentifier();
+	accessDescription->method = OBJ_dup(accessMethod.getObjectIdentifier());
 	accessDescription->location = accessLocation.getGeneralName();
 
 	return accessDescription;
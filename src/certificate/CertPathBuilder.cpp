@@ -0,0 +1,331 @@
+#include <libcryptosec/certificate/CertPathBuilder.h>
+
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+
+CertPathBuilder::CertPathBuilder(const CertificateStore& trusted, const CertificateStore& intermediates,
+		unsigned int maxPathLength) : trusted(trusted), intermediates(intermediates), maxPathLength(maxPathLength)
+{
+	pthread_mutex_init(&this->mutex, NULL);
+}
+
+CertPathBuilder::~CertPathBuilder()
+{
+	pthread_mutex_destroy(&this->mutex);
+}
+
+/*
+ * Busca em profundidade com limite crescente de intermediários, de modo que os caminhos mais curtos
+ * são encontrados primeiro. Os certificados sem caminho encontrados em um limite continuam descartados
+ * nos seguintes, assim como as assinaturas já verificadas.
+ */
+std::vector<std::vector<Certificate *> > CertPathBuilder::build(const Certificate& target, DateTime when,
+		unsigned int maxPaths)
+{
+	Search search;
+
+	search.when = when.getDateTime();
+	search.maxPaths = maxPaths;
+	if (maxPaths == 0)
+	{
+		return search.paths;
+	}
+	if (this->trusted.contains(target))
+	{
+		search.paths.push_back(std::vector<Certificate *>());
+	}
+	for (unsigned int limit = 0; limit <= this->maxPathLength && search.paths.size() < maxPaths; limit++)
+	{
+		this->search(search, target, NULL, 0, limit);
+	}
+	return search.paths;
+}
+
+/*
+ * O caminho mais curto é construído primeiro sozinho, reaproveitando os caminhos guardados; só se ele
+ * não for válido os alternativos são construídos, sem os caminhos guardados.
+ */
+bool CertPathBuilder::verify(Certificate& target, std::vector<Certificate *>& path, DateTime when,
+		std::vector<CertificateRevocationList> crls, std::vector<ValidationFlags> flags, unsigned int maxPaths)
+{
+	std::vector<std::vector<Certificate *> > paths = this->build(target, when, maxPaths > 0 ? 1 : 0);
+	std::vector<Certificate *> first;
+
+	if (paths.empty())
+	{
+		return false;
+	}
+	if (this->validate(target, paths[0], when, crls, flags))
+	{
+		path = paths[0];
+		return true;
+	}
+	first = paths[0];
+	if (maxPaths > 1)
+	{
+		paths = this->build(target, when, maxPaths);
+	}
+	for (unsigned int i = 0; i < paths.size(); i++)
+	{
+		if (paths[i] != first && this->validate(target, paths[i], when, crls, flags))
+		{
+			path = paths[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CertPathBuilder::validate(Certificate& target, std::vector<Certificate *>& path, DateTime& when,
+		std::vector<CertificateRevocationList>& crls, std::vector<ValidationFlags>& flags)
+{
+	std::vector<Certificate> untrustedChain, trustedChain;
+
+	if (path.empty())
+	{
+		trustedChain.push_back(target);
+	}
+	else
+	{
+		for (unsigned int j = 0; j + 1 < path.size(); j++)
+		{
+			untrustedChain.push_back(*path[j]);
+		}
+		trustedChain.push_back(*path.back());
+	}
+	CertPathValidator validator(target, untrustedChain, trustedChain, when, crls, flags);
+	return validator.verify();
+}
+
+/*
+ * Procura emissores de current, que está no caminho com below intermediários (não auto-emitidos)
+ * abaixo dele e pode receber mais remaining intermediários acima. stored é current no repositório de
+ * intermediários, ou NULL para o certificado alvo.
+ * Retorna true se algum candidato foi descartado por já estar no caminho: nesse caso a falha depende
+ * do caminho corrente e current não é guardado como sem saída.
+ */
+bool CertPathBuilder::search(Search &search, const Certificate &current, Certificate *stored, unsigned int below,
+		unsigned int remaining)
+{
+	std::vector<Certificate *> candidates;
+	unsigned int found = search.paths.size(), above;
+	bool cut = false;
+
+	candidates = this->trusted.getIssuers(current);
+	for (unsigned int i = 0; i < candidates.size() && search.paths.size() < search.maxPaths; i++)
+	{
+		if (this->isInPath(search, candidates[i]))
+		{
+			cut = true;
+		}
+		else if (this->isAcceptable(search, candidates[i], below) && this->isSignedBy(current, stored, candidates[i]))
+		{
+			this->addPath(search, candidates[i]);
+		}
+	}
+	if (remaining == 0)
+	{
+		return cut;
+	}
+
+	candidates = this->intermediates.getIssuers(current);
+	for (unsigned int i = 0; i < candidates.size() && search.paths.size() < search.maxPaths; i++)
+	{
+		if (candidates[i] == stored)
+		{
+			continue;
+		}
+		if (this->isInPath(search, candidates[i]))
+		{
+			cut = true;
+			continue;
+		}
+		above = below + (CertPathBuilder::isSelfIssued(candidates[i]) ? 0 : 1);
+		//um intermediário também confiável já termina o caminho pelo repositório de confiáveis
+		if (!this->isAcceptable(search, candidates[i], below) || this->isDeadEnd(search, candidates[i], above, remaining - 1)
+				|| this->trusted.contains(*candidates[i]) || !this->isSignedBy(current, stored, candidates[i]))
+		{
+			continue;
+		}
+		search.path.push_back(candidates[i]);
+		if (!this->useCachedPath(search, candidates[i], above, remaining - 1))
+		{
+			cut |= this->search(search, *candidates[i], candidates[i], above, remaining - 1);
+		}
+		search.path.pop_back();
+	}
+
+	if (stored != NULL && !cut && search.paths.size() == found)
+	{
+		search.deadEnds[stored].push_back(std::make_pair(below, remaining));
+	}
+	return cut;
+}
+
+/* validade, BasicConstraints/KeyUsage de AC (X509_check_ca) e pathLenConstraint */
+bool CertPathBuilder::isAcceptable(Search &search, Certificate *issuer, unsigned int below) const
+{
+	X509 *cert = issuer->getX509();
+	long pathLength;
+
+	if (X509_cmp_time(X509_get0_notBefore(cert), &search.when) > 0 || X509_cmp_time(X509_get0_notAfter(cert), &search.when) < 0)
+	{
+		return false;
+	}
+	if (X509_check_ca(cert) < 1)
+	{
+		return false;
+	}
+	pathLength = X509_get_pathlen(cert);
+	return pathLength < 0 || below <= (unsigned long)pathLength;
+}
+
+bool CertPathBuilder::isSignedBy(const Certificate &current, Certificate *stored, Certificate *issuer)
+{
+	std::map<std::pair<Certificate *, Certificate *>, bool>::iterator iter;
+	bool ret;
+
+	if (stored != NULL)
+	{
+		pthread_mutex_lock(&this->mutex);
+		iter = this->signatures.find(std::make_pair(stored, issuer));
+		if (iter != this->signatures.end())
+		{
+			ret = iter->second;
+			pthread_mutex_unlock(&this->mutex);
+			return ret;
+		}
+		pthread_mutex_unlock(&this->mutex);
+	}
+	ret = X509_verify(current.getX509(), X509_get0_pubkey(issuer->getX509())) == 1;
+	if (!ret)
+	{
+		ERR_clear_error();
+	}
+	if (stored != NULL)
+	{
+		pthread_mutex_lock(&this->mutex);
+		if (this->signatures.size() >= CertPathBuilder::MAX_CACHED)
+		{
+			this->signatures.clear();
+		}
+		this->signatures[std::make_pair(stored, issuer)] = ret;
+		pthread_mutex_unlock(&this->mutex);
+	}
+	return ret;
+}
+
+/* sem saída com menos intermediários abaixo e mais espaço acima implica sem saída agora */
+bool CertPathBuilder::isDeadEnd(Search &search, Certificate *certificate, unsigned int below, unsigned int remaining) const
+{
+	std::map<Certificate *, std::vector<std::pair<unsigned int, unsigned int> > >::iterator iter;
+
+	iter = search.deadEnds.find(certificate);
+	if (iter == search.deadEnds.end())
+	{
+		return false;
+	}
+	for (unsigned int i = 0; i < iter->second.size(); i++)
+	{
+		if (iter->second[i].first <= below && iter->second[i].second >= remaining)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CertPathBuilder::isInPath(Search &search, Certificate *certificate) const
+{
+	for (unsigned int i = 0; i < search.path.size(); i++)
+	{
+		if (search.path[i] == certificate)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Completa o caminho com o caminho guardado a partir de certificate, se ainda for aceitável: as
+ * assinaturas já foram verificadas, mas validade, pathLenConstraint, tamanho e ciclos dependem da
+ * construção corrente. Só é usado quando se busca um único caminho: o caminho guardado é o mais curto
+ * a partir de certificate, e a busca por caminhos alternativos precisa percorrer os demais emissores.
+ */
+bool CertPathBuilder::useCachedPath(Search &search, Certificate *certificate, unsigned int below, unsigned int remaining)
+{
+	std::map<Certificate *, std::vector<Certificate *> >::iterator iter;
+	std::vector<Certificate *> cached;
+	size_t size = search.path.size();
+	bool ret = true;
+
+	if (search.maxPaths > 1)
+	{
+		return false;
+	}
+	pthread_mutex_lock(&this->mutex);
+	iter = this->cachedPaths.find(certificate);
+	if (iter != this->cachedPaths.end())
+	{
+		cached = iter->second;
+	}
+	pthread_mutex_unlock(&this->mutex);
+	if (cached.empty() || cached.size() - 1 > remaining)
+	{
+		return false;
+	}
+	for (unsigned int i = 0; i < cached.size() && ret; i++)
+	{
+		ret = !this->isInPath(search, cached[i]) && this->isAcceptable(search, cached[i], below);
+		if (i + 1 < cached.size())
+		{
+			below += CertPathBuilder::isSelfIssued(cached[i]) ? 0 : 1;
+			search.path.push_back(cached[i]);
+		}
+	}
+	if (ret)
+	{
+		this->addPath(search, cached.back());
+	}
+	search.path.resize(size);
+	return ret;
+}
+
+/* o caminho corrente seguido de anchor; guarda também o caminho a partir de cada intermediário */
+void CertPathBuilder::addPath(Search &search, Certificate *anchor)
+{
+	std::vector<Certificate *> path = search.path;
+	std::vector<Certificate *> *cached;
+
+	path.push_back(anchor);
+	for (unsigned int i = 0; i < search.paths.size(); i++)
+	{
+		if (search.paths[i] == path)
+		{
+			return;
+		}
+	}
+	search.paths.push_back(path);
+
+	pthread_mutex_lock(&this->mutex);
+	if (this->cachedPaths.size() >= CertPathBuilder::MAX_CACHED)
+	{
+		this->cachedPaths.clear();
+	}
+	for (unsigned int i = 0; i + 1 < path.size(); i++)
+	{
+		cached = &this->cachedPaths[path[i]];
+		if (cached->empty() || cached->size() > path.size() - i - 1)
+		{
+			cached->assign(path.begin() + i + 1, path.end());
+		}
+	}
+	pthread_mutex_unlock(&this->mutex);
+}
+
+bool CertPathBuilder::isSelfIssued(Certificate *certificate)
+{
+	X509 *cert = certificate->getX509();
+	return X509_NAME_cmp(X509_get_subject_name(cert), X509_get_issuer_name(cert)) == 0;
+}
@@ -1,5 +1,244 @@
 #include <libcryptosec/certificate/CertificateBuilder.h>
 
+#include <openssl/err.h>
+#include <sys/time.h>
+#include <algorithm>
+
+/*
+ * Campos do modelo de um lote de CertificateBuilder::sign(std::vector<CertificateBuilder::Entry> const&, ...),
+ * copiados do builder pela thread que chamou sign() e somente lidos pelas tarefas.
+ */
+struct IssueTemplate
+{
+	long version;
+	X509_NAME *issuer;
+	ASN1_TIME *notBefore;
+	ASN1_TIME *notAfter;
+	STACK_OF(X509_EXTENSION) *extensions;
+	EVP_PKEY *key;
+	const EVP_MD *md;
+
+	static void release(IssueTemplate &model)
+	{
+		X509_NAME_free(model.issuer);
+		ASN1_TIME_free(model.notBefore);
+		ASN1_TIME_free(model.notAfter);
+		sk_X509_EXTENSION_pop_free(model.extensions, X509_EXTENSION_free);
+	}
+};
+
+/* emite uma fatia das entradas de um lote */
+class IssueTask : public ThreadPool::Task
+{
+public:
+	IssueTask(const IssueTemplate *model, const std::vector<CertificateBuilder::Entry> *entries, unsigned int window,
+			unsigned int begin, unsigned int end, std::vector<ByteArray> *der, std::vector<char> *ok,
+			std::vector<std::string> *errors) :
+			model(model), entries(entries), window(window), begin(begin), end(end), der(der), ok(ok), errors(errors)
+	{
+	}
+
+	virtual void run()
+	{
+		for (unsigned int i = this->begin; i < this->end; i++)
+		{
+			(*this->ok)[i - this->window] = this->issue(this->entries->at(i), (*this->der)[i - this->window],
+					(*this->errors)[i - this->window]);
+		}
+	}
+
+	/*
+	 * Monta o certificado campo a campo: X509_dup() não copia um certificado sem assinatura e
+	 * X509_set_pubkey()/d2i_X509_PUBKEY() decodificariam a chave do titular, que só precisa ser copiada.
+	 */
+	bool issue(const CertificateBuilder::Entry &entry, ByteArray &der, std::string &error)
+	{
+		X509 *cert = X509_new();
+		X509_NAME *subject = NULL;
+		ASN1_INTEGER *serial = NULL;
+		ASN1_BIT_STRING *bits = NULL;
+		ASN1_TIME *time = NULL;
+		ByteArray publicKeyInfo;
+		unsigned char *data;
+		bool ret;
+		int size;
+
+		ERR_clear_error();
+		try
+		{
+			serial = entry.serialNumber.getASN1Value();
+			subject = const_cast<RDNSequence &>(entry.subject).getX509Name();
+			publicKeyInfo = entry.publicKey != NULL ? entry.publicKey->getDerEncoded() : entry.publicKeyInfo;
+		}
+		catch (LibCryptoSecException &e)
+		{
+			error = e.toString();
+		}
+		catch (std::exception &e)
+		{
+			error = e.what();
+		}
+
+		ret = error.empty() && cert != NULL && serial != NULL && subject != NULL
+				&& X509_set_version(cert, this->model->version)
+				&& X509_set_serialNumber(cert, serial)
+				&& X509_set_issuer_name(cert, this->model->issuer)
+				&& X509_set_subject_name(cert, subject);
+		if (ret && (bits = IssueTask::setPublicKeyInfo(cert, publicKeyInfo)) == NULL)
+		{
+			error = "Invalid subject public key info";
+			ret = false;
+		}
+		if (ret && entry.hasValidity)
+		{
+			ret = (time = ASN1_TIME_set(NULL, entry.notBefore.getDateTime())) != NULL && X509_set1_notBefore(cert, time);
+			ASN1_TIME_free(time);
+			ret = ret && (time = ASN1_TIME_set(NULL, entry.notAfter.getDateTime())) != NULL && X509_set1_notAfter(cert, time);
+			ASN1_TIME_free(time);
+		}
+		else if (ret)
+		{
+			ret = X509_set1_notBefore(cert, this->model->notBefore) && X509_set1_notAfter(cert, this->model->notAfter);
+		}
+		for (int i = 0; ret && i < sk_X509_EXTENSION_num(this->model->extensions); i++)
+		{
+			ret = IssueTask::addExtension(cert, sk_X509_EXTENSION_value(this->model->extensions, i), bits);
+		}
+		if (ret && !X509_sign(cert, this->model->key, this->model->md))
+		{
+			error = "Signing: " + IssueTask::getErrors();
+			ret = false;
+		}
+		ret = ret && (size = i2d_X509(cert, NULL)) > 0;
+		if (ret)
+		{
+			der = ByteArray(static_cast<unsigned int>(size));
+			data = der.getDataPointer();
+			ret = i2d_X509(cert, &data) == size;
+		}
+		if (!ret && error.empty())
+		{
+			error = IssueTask::getErrors();
+		}
+
+		ASN1_INTEGER_free(serial);
+		X509_NAME_free(subject);
+		X509_free(cert);
+		return ret;
+	}
+
+	/*
+	 * Erros do OpenSSL da thread corrente; OpenSSLErrorHandler::getErrors() usa um BIO compartilhado
+	 * entre as threads.
+	 */
+	static std::string getErrors()
+	{
+		char buffer[256];
+		std::string ret;
+		unsigned long code;
+
+		while ((code = ERR_get_error()) != 0)
+		{
+			ERR_error_string_n(code, buffer, sizeof(buffer));
+			ret += ret.empty() ? "" : "; ";
+			ret += buffer;
+		}
+		return ret.empty() ? "Building the certificate" : ret;
+	}
+
+	/*
+	 * Copia o SubjectPublicKeyInfo (SEQUENCE { AlgorithmIdentifier, BIT STRING }) para cert.
+	 * Retorna a chave, que pertence a cert, ou NULL se publicKeyInfo for inválido.
+	 */
+	static ASN1_BIT_STRING* setPublicKeyInfo(X509 *cert, ByteArray &publicKeyInfo)
+	{
+		const unsigned char *p = publicKeyInfo.getDataPointer(), *end;
+		X509_ALGOR *algorithm = NULL;
+		ASN1_BIT_STRING *bits = NULL;
+		const ASN1_OBJECT *object;
+		const void *value;
+		ASN1_OBJECT *oid = NULL;
+		void *parameter = NULL;
+		unsigned char *key = NULL;
+		ASN1_BIT_STRING *ret = NULL;
+		long length;
+		int tag, xclass, type;
+
+		if (publicKeyInfo.size() == 0 || ASN1_get_object(&p, &length, &tag, &xclass, publicKeyInfo.size()) != V_ASN1_CONSTRUCTED
+				|| tag != V_ASN1_SEQUENCE)
+		{
+			return NULL;
+		}
+		end = p + length;
+		if ((algorithm = d2i_X509_ALGOR(NULL, &p, end - p)) != NULL && (bits = d2i_ASN1_BIT_STRING(NULL, &p, end - p)) != NULL
+				&& p == end && bits->length > 0)
+		{
+			X509_ALGOR_get0(&object, &type, &value, algorithm);
+			if (type == V_ASN1_OBJECT)
+			{
+				parameter = OBJ_dup((const ASN1_OBJECT *) value);
+			}
+			else if (type != V_ASN1_UNDEF && type != V_ASN1_NULL)
+			{
+				parameter = ASN1_STRING_dup((const ASN1_STRING *) value);
+			}
+			oid = OBJ_dup(object);
+			key = (unsigned char *) OPENSSL_memdup(bits->data, bits->length);
+			if (oid != NULL && key != NULL && (type == V_ASN1_UNDEF || type == V_ASN1_NULL || parameter != NULL)
+					&& X509_PUBKEY_set0_param(X509_get_X509_PUBKEY(cert), oid, type, parameter, key, bits->length))
+			{
+				ret = X509_get0_pubkey_bitstr(cert);
+			}
+			else
+			{
+				ASN1_OBJECT_free(oid);
+				if (type == V_ASN1_OBJECT)
+				{
+					ASN1_OBJECT_free((ASN1_OBJECT *) parameter);
+				}
+				else
+				{
+					ASN1_STRING_free((ASN1_STRING *) parameter);
+				}
+				OPENSSL_free(key);
+			}
+		}
+		X509_ALGOR_free(algorithm);
+		ASN1_BIT_STRING_free(bits);
+		return ret;
+	}
+
+	/* copia a extensão do modelo, recalculando SubjectKeyIdentifier a partir da chave do titular */
+	static bool addExtension(X509 *cert, X509_EXTENSION *extension, ASN1_BIT_STRING *key)
+	{
+		unsigned char md[EVP_MAX_MD_SIZE];
+		unsigned int size;
+		ASN1_OCTET_STRING *keyIdentifier;
+		bool ret;
+
+		if (OBJ_obj2nid(X509_EXTENSION_get_object(extension)) != NID_subject_key_identifier)
+		{
+			return X509_add_ext(cert, extension, -1);
+		}
+		keyIdentifier = ASN1_OCTET_STRING_new();
+		ret = keyIdentifier != NULL && EVP_Digest(key->data, key->length, md, &size, EVP_sha1(), NULL)
+				&& ASN1_OCTET_STRING_set(keyIdentifier, md, size)
+				&& X509_add1_ext_i2d(cert, NID_subject_key_identifier, keyIdentifier,
+						X509_EXTENSION_get_critical(extension), X509V3_ADD_APPEND) == 1;
+		ASN1_OCTET_STRING_free(keyIdentifier);
+		return ret;
+	}
+
+	const IssueTemplate *model;
+	const std::vector<CertificateBuilder::Entry> *entries;
+	unsigned int window;
+	unsigned int begin;
+	unsigned int end;
+	std::vector<ByteArray> *der;
+	std::vector<char> *ok;
+	std::vector<std::string> *errors;
+};
+
 CertificateBuilder::CertificateBuilder()
 {
 	DateTime dateTime;
@@ -7,12 +246,14 @@ CertificateBuilder::CertificateBuilder()
 	this->setNotBefore(dateTime);
 	this->setNotAfter(dateTime);
 	this->setIncludeEcdsaParameters(false);
+	this->pool = NULL;
 }
 
 CertificateBuilder::CertificateBuilder(std::string pemEncoded)
 		throw (EncodeException)
 {
 	this->setIncludeEcdsaParameters(false);
+	this->pool = NULL;
 	BIO *buffer;
 	buffer = BIO_new(BIO_s_mem());
 	if (buffer == NULL)
@@ -37,6 +278,7 @@ CertificateBuilder::CertificateBuilder(ByteArray &derEncoded)
 	throw (EncodeException)
 {
 	this->setIncludeEcdsaParameters(false);
+	this->pool = NULL;
 	BIO *buffer;
 	buffer = BIO_new(BIO_s_mem());
 	if (buffer == NULL)
@@ -60,6 +302,7 @@ CertificateBuilder::CertificateBuilder(ByteArray &derEncoded)
 CertificateBuilder::CertificateBuilder(CertificateRequest &request)
 {
 	this->setIncludeEcdsaParameters(false);
+	this->pool = NULL;
 	RDNSequence subject;
 	PublicKey *publicKey = NULL;
 	std::vector<Extension *> extensions;
@@ -104,6 +347,7 @@ CertificateBuilder::CertificateBuilder(const CertificateBuilder& cert)
 {
 	this->cert = X509_dup(cert.getX509());
 	this->setIncludeEcdsaParameters(cert.isIncludeEcdsaParameters());
+	this->pool = cert.pool;
 }
 
 CertificateBuilder::~CertificateBuilder()
@@ -990,16 +1234,7 @@ Certificate* CertificateBuilder::sign(PrivateKey &privateKey, MessageDigest::Alg
 	pub = this->getPublicKey();
 	delete pub;
 
-	// TODO: We force Identity message digest for EdDSA to avoid changing callers which always pass digests.
-	EVP_PKEY* pkey = privateKey.getEvpPkey();
-	int pkeyType = EVP_PKEY_base_id(pkey);
-	int nid25519 = OBJ_sn2nid("ED25519");
-	int nid521 = OBJ_sn2nid("ED521");
-	int nid448 = OBJ_sn2nid("ED448");
-	if (pkeyType == nid25519 || pkeyType == nid521 || pkeyType == nid448) {
-		messageDigestAlgorithm = MessageDigest::Identity;
-	}
-
+	messageDigestAlgorithm = CertificateBuilder::getSignatureAlgorithm(privateKey, messageDigestAlgorithm);
 	rc = X509_sign(this->cert, privateKey.getEvpPkey(), MessageDigest::getMessageDigest(messageDigestAlgorithm));
 	if (!rc)
 	{
@@ -1012,6 +1247,123 @@ Certificate* CertificateBuilder::sign(PrivateKey &privateKey, MessageDigest::Alg
 	return ret;
 }
 
+void CertificateBuilder::setThreadPool(ThreadPool *pool)
+{
+	this->pool = pool;
+}
+
+CertificateBuilder::Statistics CertificateBuilder::sign(std::vector<CertificateBuilder::Entry> const& entries,
+		CertificateBuilder::Sink *sink, PrivateKey &privateKey, MessageDigest::Algorithm messageDigestAlgorithm)
+		const throw (CertificationException, EncodeException)
+{
+	IssueTemplate model;
+	CertificateBuilder::Statistics statistics;
+	std::vector<IssueTask> batch;
+	std::vector<ThreadPool::Task*> tasks;
+	std::vector<ByteArray> der;
+	std::vector<char> ok;
+	std::vector<std::string> errors;
+	unsigned int slices, window, perTask, end;
+	struct timeval start, finish;
+
+	if (sink == NULL)
+	{
+		throw CertificationException(CertificationException::SET_NO_VALUE, "CertificateBuilder::sign");
+	}
+	gettimeofday(&start, NULL);
+
+	//copias do modelo: X509_NAME_dup() codifica o nome de origem, o que nao pode ocorrer entre threads
+	model.version = X509_get_version(this->cert);
+	model.issuer = X509_NAME_dup(X509_get_issuer_name(this->cert));
+	model.notBefore = ASN1_STRING_dup(X509_get0_notBefore(this->cert));
+	model.notAfter = ASN1_STRING_dup(X509_get0_notAfter(this->cert));
+	model.extensions = X509_get0_extensions(this->cert) == NULL ? sk_X509_EXTENSION_new_null()
+			: sk_X509_EXTENSION_deep_copy(X509_get0_extensions(this->cert), X509_EXTENSION_dup, X509_EXTENSION_free);
+	model.key = privateKey.getEvpPkey();
+	model.md = MessageDigest::getMessageDigest(CertificateBuilder::getSignatureAlgorithm(privateKey, messageDigestAlgorithm));
+	if (model.issuer == NULL || model.notBefore == NULL || model.notAfter == NULL || model.extensions == NULL)
+	{
+		IssueTemplate::release(model);
+		throw CertificationException(CertificationException::SET_NO_VALUE, "CertificateBuilder::sign");
+	}
+
+	//cada tarefa emite uma fatia da janela, diluindo o custo de execute() entre varios certificados
+	slices = this->pool == NULL ? 1 : this->pool->getSize() * 4;
+	window = slices * 64;
+	statistics.issued = 0;
+	statistics.failed = 0;
+	try
+	{
+		for (unsigned int begin = 0; begin < entries.size(); begin = end)
+		{
+			end = std::min(begin + window, (unsigned int) entries.size());
+			perTask = (end - begin + slices - 1) / slices;
+			der.assign(end - begin, ByteArray());
+			ok.assign(end - begin, 0);
+			errors.assign(end - begin, std::string());
+			batch.clear();
+			tasks.clear();
+			for (unsigned int i = begin; i < end; i += perTask)
+			{
+				batch.push_back(IssueTask(&model, &entries, begin, i, std::min(i + perTask, end), &der, &ok, &errors));
+			}
+			for (unsigned int i = 0; i < batch.size(); i++)
+			{
+				tasks.push_back(&batch.at(i));
+			}
+			if (this->pool == NULL)
+			{
+				batch.at(0).run();
+			}
+			else
+			{
+				this->pool->execute(tasks);
+			}
+			for (unsigned int i = begin; i < end; i++)
+			{
+				if (ok.at(i - begin))
+				{
+					statistics.issued++;
+					sink->write(i, der.at(i - begin));
+				}
+				else
+				{
+					CertificationException exception(CertificationException::INTERNAL_ERROR, "CertificateBuilder::sign",
+							errors.at(i - begin));
+					statistics.failed++;
+					sink->fail(i, exception);
+				}
+			}
+		}
+	}
+	catch (...)
+	{
+		IssueTemplate::release(model);
+		throw;
+	}
+	IssueTemplate::release(model);
+
+	gettimeofday(&finish, NULL);
+	statistics.seconds = (finish.tv_sec - start.tv_sec) + (finish.tv_usec - start.tv_usec) / 1e6;
+	statistics.certificatesPerSecond = statistics.seconds > 0 ? statistics.issued / statistics.seconds : 0;
+	return statistics;
+}
+
+MessageDigest::Algorithm CertificateBuilder::getSignatureAlgorithm(PrivateKey &privateKey,
+		MessageDigest::Algorithm messageDigestAlgorithm)
+{
+	// TODO: We force Identity message digest for EdDSA to avoid changing callers which always pass digests.
+	EVP_PKEY* pkey = privateKey.getEvpPkey();
+	int pkeyType = EVP_PKEY_base_id(pkey);
+	int nid25519 = OBJ_sn2nid("ED25519");
+	int nid521 = OBJ_sn2nid("ED521");
+	int nid448 = OBJ_sn2nid("ED448");
+	if (pkeyType == nid25519 || pkeyType == nid521 || pkeyType == nid448) {
+		return MessageDigest::Identity;
+	}
+	return messageDigestAlgorithm;
+}
+
 X509* CertificateBuilder::getX509() const
 {
 	return this->cert;
@@ -1025,6 +1377,7 @@ CertificateBuilder& CertificateBuilder::operator =(const CertificateBuilder& val
 	}
     this->cert = X509_dup(value.getX509());
     this->setIncludeEcdsaParameters(value.isIncludeEcdsaParameters());
+    this->pool = value.pool;
     return (*this);
 }
 
@@ -1075,3 +1428,32 @@ int CertificateBuilder::getCodification(RDNSequence& name){
 
 	return entryType;
 }
+
+CertificateBuilder::StreamSink::StreamSink(std::ostream *out, bool pem) : out(out), pem(pem)
+{
+}
+
+void CertificateBuilder::StreamSink::write(unsigned int index, ByteArray &der) throw (EncodeException)
+{
+	std::string base64;
+
+	if (!this->pem)
+	{
+		this->out->write((const char *) der.getDataPointer(), der.size());
+	}
+	else
+	{
+		base64 = Base64::encode(der);
+		*this->out << "-----BEGIN CERTIFICATE-----\n";
+		for (size_t i = 0; i < base64.size(); i += 64)
+		{
+			this->out->write(base64.data() + i, std::min((size_t) 64, base64.size() - i));
+			*this->out << '\n';
+		}
+		*this->out << "-----END CERTIFICATE-----\n";
+	}
+	if (this->out->fail())
+	{
+		throw EncodeException(EncodeException::BUFFER_WRITING, "CertificateBuilder::StreamSink::write");
+	}
+}
@@ -0,0 +1,388 @@
+#include <libcryptosec/certificate/CertificateStore.h>
+
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <openssl/x509v3.h>
+
+#include <string.h>
+
+/* chave de CertificateStore::getHash, sorteada uma vez por processo */
+static unsigned char hashKey[16];
+static pthread_once_t hashKeyOnce = PTHREAD_ONCE_INIT;
+
+static void hashKeyInit()
+{
+	if (RAND_bytes(hashKey, sizeof(hashKey)) != 1)
+	{
+		memset(hashKey, 0, sizeof(hashKey));
+	}
+}
+
+CertificateStore::CertificateStore()
+{
+	for (int i = 0; i < CertificateStore::INDEXES; i++)
+	{
+		this->tables[i] = CertificateStore::newTable(64);
+	}
+	this->count = 0;
+	pthread_mutex_init(&this->mutex, NULL);
+}
+
+CertificateStore::~CertificateStore()
+{
+	Table *table, *retired;
+	Node *node, *next;
+	for (int i = 0; i < CertificateStore::INDEXES; i++)
+	{
+		for (table = this->tables[i]; table != NULL; table = retired)
+		{
+			for (size_t j = 0; j <= table->mask; j++)
+			{
+				for (node = table->buckets[j]; node != NULL; node = next)
+				{
+					next = node->next;
+					delete node;
+				}
+			}
+			retired = table->retired;
+			delete[] table->buckets;
+			delete table;
+		}
+	}
+	for (unsigned int i = 0; i < this->certificates.size(); i++)
+	{
+		delete this->certificates[i];
+	}
+	pthread_mutex_destroy(&this->mutex);
+}
+
+bool CertificateStore::add(const Certificate& certificate) throw (CertificationException)
+{
+	std::vector<Entry> entries(1);
+	try
+	{
+		CertificateStore::newEntry(certificate, entries[0]);
+	}
+	catch (...)
+	{
+		CertificateStore::deleteEntries(entries);
+		throw;
+	}
+	return this->insert(entries) == 1;
+}
+
+unsigned int CertificateStore::add(const std::vector<Certificate>& certificates) throw (CertificationException)
+{
+	std::vector<Entry> entries(certificates.size());
+	try
+	{
+		for (unsigned int i = 0; i < certificates.size(); i++)
+		{
+			CertificateStore::newEntry(certificates[i], entries[i]);
+		}
+	}
+	catch (...)
+	{
+		CertificateStore::deleteEntries(entries);
+		throw;
+	}
+	return this->insert(entries);
+}
+
+unsigned int CertificateStore::add(const std::vector<Certificate *>& certificates) throw (CertificationException)
+{
+	std::vector<Entry> entries(certificates.size());
+	try
+	{
+		for (unsigned int i = 0; i < certificates.size(); i++)
+		{
+			CertificateStore::newEntry(*certificates[i], entries[i]);
+		}
+	}
+	catch (...)
+	{
+		CertificateStore::deleteEntries(entries);
+		throw;
+	}
+	return this->insert(entries);
+}
+
+std::vector<Certificate *> CertificateStore::getBySubject(const RDNSequence& subject) const
+{
+	return this->find(CertificateStore::SUBJECT, subject.getCanonical());
+}
+
+std::vector<Certificate *> CertificateStore::getBySubjectKeyIdentifier(const ByteArray& keyIdentifier) const
+{
+	return this->find(CertificateStore::SUBJECT_KEY_IDENTIFIER,
+			std::string((const char *)const_cast<ByteArray&>(keyIdentifier).getDataPointer(), keyIdentifier.size()));
+}
+
+Certificate* CertificateStore::getByIssuerAndSerialNumber(const RDNSequence& issuer, const BigInteger& serialNumber) const
+{
+	ASN1_INTEGER *serial;
+	std::string key;
+	try
+	{
+		serial = serialNumber.getASN1Value();
+	}
+	catch (BigIntegerException &ex)
+	{
+		return NULL;
+	}
+	key = CertificateStore::getIssuerAndSerialNumberKey(issuer.getCanonical(), serial);
+	ASN1_INTEGER_free(serial);
+	return this->findFirst(CertificateStore::ISSUER_AND_SERIAL_NUMBER, key);
+}
+
+Certificate* CertificateStore::getByFingerPrint(const ByteArray& fingerPrint) const
+{
+	return this->findFirst(CertificateStore::FINGERPRINT,
+			std::string((const char *)const_cast<ByteArray&>(fingerPrint).getDataPointer(), fingerPrint.size()));
+}
+
+std::vector<Certificate *> CertificateStore::getIssuers(const Certificate& certificate) const
+{
+	std::vector<Certificate *> ret, candidates;
+	X509 *cert = certificate.getX509();
+	X509_NAME *issuer = X509_get_issuer_name(cert);
+	AUTHORITY_KEYID *authorityKeyId;
+
+	authorityKeyId = (AUTHORITY_KEYID *)X509_get_ext_d2i(cert, NID_authority_key_identifier, NULL, NULL);
+	if (authorityKeyId != NULL && authorityKeyId->keyid != NULL)
+	{
+		candidates = this->find(CertificateStore::SUBJECT_KEY_IDENTIFIER,
+				std::string((const char *)ASN1_STRING_get0_data(authorityKeyId->keyid), ASN1_STRING_length(authorityKeyId->keyid)));
+		for (unsigned int i = 0; i < candidates.size(); i++)
+		{
+			if (X509_NAME_cmp(X509_get_subject_name(candidates[i]->getX509()), issuer) == 0)
+			{
+				ret.push_back(candidates[i]);
+			}
+		}
+	}
+	AUTHORITY_KEYID_free(authorityKeyId);
+	if (ret.empty())
+	{
+		ret = this->find(CertificateStore::SUBJECT, RDNSequence(issuer).getCanonical());
+	}
+	return ret;
+}
+
+bool CertificateStore::contains(const Certificate& certificate) const
+{
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int length;
+	if (X509_digest(certificate.getX509(), EVP_sha256(), digest, &length) != 1)
+	{
+		return false;
+	}
+	return this->findFirst(CertificateStore::FINGERPRINT, std::string((const char *)digest, length)) != NULL;
+}
+
+std::vector<Certificate *> CertificateStore::getCertificates() const
+{
+	std::vector<Certificate *> ret;
+	pthread_mutex_lock(&this->mutex);
+	ret = this->certificates;
+	pthread_mutex_unlock(&this->mutex);
+	return ret;
+}
+
+unsigned int CertificateStore::size() const
+{
+	return __atomic_load_n(&this->count, __ATOMIC_ACQUIRE);
+}
+
+void CertificateStore::newEntry(const Certificate& certificate, Entry &entry) throw (CertificationException)
+{
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int length;
+	ASN1_OCTET_STRING *keyIdentifier;
+	X509 *cert;
+
+	/* a estrutura X509 é compartilhada com o chamador: X509_dup decodificaria o certificado de novo,
+	 * o que custa mais que todo o restante da inserção */
+	cert = certificate.getX509();
+	if (cert == NULL || X509_digest(cert, EVP_sha256(), digest, &length) != 1)
+	{
+		throw CertificationException(CertificationException::INVALID_CERTIFICATE, "CertificateStore::newEntry");
+	}
+	X509_up_ref(cert);
+	entry.certificate = new Certificate(cert);
+	entry.keys[CertificateStore::FINGERPRINT].assign((const char *)digest, length);
+	entry.keys[CertificateStore::SUBJECT] = RDNSequence(X509_get_subject_name(cert)).getCanonical();
+	keyIdentifier = (ASN1_OCTET_STRING *)X509_get_ext_d2i(cert, NID_subject_key_identifier, NULL, NULL);
+	if (keyIdentifier != NULL)
+	{
+		entry.keys[CertificateStore::SUBJECT_KEY_IDENTIFIER].assign((const char *)ASN1_STRING_get0_data(keyIdentifier),
+				ASN1_STRING_length(keyIdentifier));
+		ASN1_OCTET_STRING_free(keyIdentifier);
+	}
+	entry.keys[CertificateStore::ISSUER_AND_SERIAL_NUMBER] = CertificateStore::getIssuerAndSerialNumberKey(
+			RDNSequence(X509_get_issuer_name(cert)).getCanonical(), X509_get_serialNumber(cert));
+}
+
+void CertificateStore::deleteEntries(std::vector<Entry>& entries)
+{
+	for (unsigned int i = 0; i < entries.size(); i++)
+	{
+		delete entries[i].certificate;
+		entries[i].certificate = NULL;
+	}
+}
+
+/* o número de série em DER, que delimita o próprio tamanho, seguido da forma canônica do emissor */
+std::string CertificateStore::getIssuerAndSerialNumberKey(const std::string& issuer, ASN1_INTEGER *serialNumber)
+{
+	std::string ret;
+	unsigned char *der = NULL;
+	int length = i2d_ASN1_INTEGER(serialNumber, &der);
+	if (length <= 0)
+	{
+		return ret;
+	}
+	ret.reserve(length + issuer.size());
+	ret.append((const char *)der, length);
+	ret += issuer;
+	OPENSSL_free(der);
+	return ret;
+}
+
+/* as chaves vêm de certificados de terceiros: o hash usa uma chave secreta para que não se possa
+ * escolher certificados que caiam todos no mesmo bucket */
+size_t CertificateStore::getHash(const std::string& key)
+{
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	SHA256_CTX ctx;
+	size_t ret;
+
+	pthread_once(&hashKeyOnce, hashKeyInit);
+	SHA256_Init(&ctx);
+	SHA256_Update(&ctx, hashKey, sizeof(hashKey));
+	SHA256_Update(&ctx, key.data(), key.size());
+	SHA256_Final(digest, &ctx);
+	memcpy(&ret, digest, sizeof(ret));
+	return ret;
+}
+
+CertificateStore::Table* CertificateStore::newTable(size_t buckets)
+{
+	Table *table = new Table;
+	table->mask = buckets - 1;
+	table->count = 0;
+	table->buckets = new Node*[buckets];
+	memset(table->buckets, 0, buckets * sizeof(Node *));
+	table->retired = NULL;
+	return table;
+}
+
+unsigned int CertificateStore::insert(std::vector<Entry>& entries)
+{
+	unsigned int ret = 0;
+	pthread_mutex_lock(&this->mutex);
+	for (unsigned int i = 0; i < entries.size(); i++)
+	{
+		if (this->findFirst(CertificateStore::FINGERPRINT, entries[i].keys[CertificateStore::FINGERPRINT]) != NULL)
+		{
+			delete entries[i].certificate;
+			continue;
+		}
+		this->certificates.push_back(entries[i].certificate);
+		for (int j = 0; j < CertificateStore::INDEXES; j++)
+		{
+			this->link((Index)j, entries[i].keys[j], entries[i].certificate);
+		}
+		ret++;
+	}
+	__atomic_store_n(&this->count, this->certificates.size(), __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&this->mutex);
+	return ret;
+}
+
+/*
+ * Chamado com a trava obtida. Nós e tabelas são preenchidos antes de publicados com semântica de
+ * release, e nunca são alterados depois, de modo que as consultas os percorrem sem travas.
+ */
+void CertificateStore::link(Index index, const std::string& key, Certificate *certificate)
+{
+	Table *table = this->tables[index], *grown;
+	Node *node, *copy;
+	size_t bucket;
+
+	if (key.empty())
+	{
+		return;
+	}
+	if (table->count > table->mask)
+	{
+		grown = CertificateStore::newTable((table->mask + 1) * 2);
+		for (size_t i = 0; i <= table->mask; i++)
+		{
+			for (node = table->buckets[i]; node != NULL; node = node->next)
+			{
+				copy = new Node(*node);
+				bucket = copy->hash & grown->mask;
+				copy->next = grown->buckets[bucket];
+				grown->buckets[bucket] = copy;
+			}
+		}
+		grown->count = table->count;
+		grown->retired = table;
+		__atomic_store_n(&this->tables[index], grown, __ATOMIC_RELEASE);
+		table = grown;
+	}
+	node = new Node;
+	node->hash = CertificateStore::getHash(key);
+	node->key = key;
+	node->certificate = certificate;
+	bucket = node->hash & table->mask;
+	node->next = table->buckets[bucket];
+	__atomic_store_n(&table->buckets[bucket], node, __ATOMIC_RELEASE);
+	table->count++;
+}
+
+std::vector<Certificate *> CertificateStore::find(Index index, const std::string& key) const
+{
+	std::vector<Certificate *> ret;
+	Table *table;
+	Node *node;
+	size_t hash;
+
+	if (key.empty())
+	{
+		return ret;
+	}
+	hash = CertificateStore::getHash(key);
+	table = __atomic_load_n(&this->tables[index], __ATOMIC_ACQUIRE);
+	for (node = __atomic_load_n(&table->buckets[hash & table->mask], __ATOMIC_ACQUIRE); node != NULL; node = node->next)
+	{
+		if (node->hash == hash && node->key == key)
+		{
+			ret.push_back(node->certificate);
+		}
+	}
+	return ret;
+}
+
+Certificate* CertificateStore::findFirst(Index index, const std::string& key) const
+{
+	Table *table;
+	Node *node;
+	size_t hash;
+
+	if (key.empty())
+	{
+		return NULL;
+	}
+	hash = CertificateStore::getHash(key);
+	table = __atomic_load_n(&this->tables[index], __ATOMIC_ACQUIRE);
+	for (node = __atomic_load_n(&table->buckets[hash & table->mask], __ATOMIC_ACQUIRE); node != NULL; node = node->next)
+	{
+		if (node->hash == hash && node->key == key)
+		{
+			return node->certificate;
+		}
+	}
+	return NULL;
+}
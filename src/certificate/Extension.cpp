@@ -11,7 +11,7 @@ Extension::Extension(X509_EXTENSION *ext) throw (CertificationException)
 	{
 		throw CertificationException(CertificationException::INVALID_EXTENSION, "Extension::Extension");
 	}
-	this->objectIdentifier = ObjectIdentifier(OBJ_dup(X509_EXTENSION_get_object(ext)));
+	this->objectIdentifier = ObjectIdentifierFactory::getObjectIdentifier(X509_EXTENSION_get_object(ext));
 	this->critical = X509_EXTENSION_get_critical(ext)?true:false;
 	ASN1_OCTET_STRING* data = X509_EXTENSION_get_data(ext);
 	this->value = ByteArray(ASN1_STRING_get0_data(data), ASN1_STRING_length(data));
@@ -1,4 +1,5 @@
 #include <libcryptosec/certificate/GeneralName.h>
+#include <libcryptosec/certificate/ObjectIdentifierFactory.h>
 
 GeneralName::GeneralName()
 {
@@ -73,7 +74,7 @@ GeneralName::GeneralName(GENERAL_NAME *generalName) {
 			this->setUniformResourceIdentifier(data);
 			break;
 		case GEN_RID:
-			registeredId = ObjectIdentifier(OBJ_dup(generalName->d.registeredID));
+			registeredId = ObjectIdentifierFactory::getObjectIdentifier(generalName->d.registeredID);
 			this->setRegisteredId(registeredId);
 			break;
 		default:
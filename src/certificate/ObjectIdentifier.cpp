@@ -3,23 +3,42 @@
 ObjectIdentifier::ObjectIdentifier()
 {
 	this->asn1Object = ASN1_OBJECT_new();
+	this->shared = false;
 //	printf("New OID: nid: %d - length: %d\n", this->asn1Object->nid, this->asn1Object->length);
 }
 
 ObjectIdentifier::ObjectIdentifier(ASN1_OBJECT *asn1Object)
 {
 	this->asn1Object = asn1Object;
+	this->shared = false;
 //	printf("Set OID: nid: %d - length: %d\n", this->asn1Object->nid, this->asn1Object->length);
 }
 
+ObjectIdentifier::ObjectIdentifier(ASN1_OBJECT *asn1Object, bool shared)
+{
+	this->asn1Object = asn1Object;
+	this->shared = shared;
+}
+
 ObjectIdentifier::ObjectIdentifier(const ObjectIdentifier& objectIdentifier)
 {
-	this->asn1Object = OBJ_dup(objectIdentifier.getObjectIdentifier());
+	this->shared = objectIdentifier.shared;
+	if (this->shared)
+	{
+		this->asn1Object = objectIdentifier.asn1Object;
+	}
+	else
+	{
+		this->asn1Object = OBJ_dup(objectIdentifier.getObjectIdentifier());
+	}
 }
 
 ObjectIdentifier::~ObjectIdentifier()
 {
-	ASN1_OBJECT_free(this->asn1Object);
+	if (!this->shared)
+	{
+		ASN1_OBJECT_free(this->asn1Object);
+	}
 }
 
 std::string ObjectIdentifier::getXmlEncoded()
@@ -92,12 +111,22 @@ ASN1_OBJECT* ObjectIdentifier::getObjectIdentifier() const
 
 ObjectIdentifier& ObjectIdentifier::operator =(const ObjectIdentifier& value)
 {	
-	if (this->asn1Object)
+	if (this == &value)
+	{
+		return (*this);
+	}
+
+	if (this->asn1Object && !this->shared)
 	{
 		ASN1_OBJECT_free(this->asn1Object);
 	}
 
-	if (OBJ_length(value.getObjectIdentifier()) > 0)
+	this->shared = value.shared;
+	if (this->shared)
+	{
+		this->asn1Object = value.asn1Object;
+	}
+	else if (OBJ_length(value.getObjectIdentifier()) > 0)
 	{
 		this->asn1Object = OBJ_dup(value.getObjectIdentifier());
 	}
@@ -107,3 +136,13 @@ ObjectIdentifier& ObjectIdentifier::operator =(const ObjectIdentifier& value)
 	}
 	return (*this);
 }
+
+bool ObjectIdentifier::operator ==(const ObjectIdentifier& value) const
+{
+	return this->asn1Object == value.asn1Object || OBJ_cmp(this->asn1Object, value.asn1Object) == 0;
+}
+
+bool ObjectIdentifier::operator !=(const ObjectIdentifier& value) const
+{
+	return !(*this == value);
+}
@@ -1,9 +1,45 @@
 #include <libcryptosec/certificate/ObjectIdentifierFactory.h>
 
+pthread_mutex_t ObjectIdentifierFactory::mutex = PTHREAD_MUTEX_INITIALIZER;
+std::map<std::string, ASN1_OBJECT*> *ObjectIdentifierFactory::registered = NULL;
+
+ASN1_OBJECT* ObjectIdentifierFactory::getRegistered(std::string const& oid)
+{
+	std::map<std::string, ASN1_OBJECT*>::iterator iter;
+	ASN1_OBJECT *asn1Obj = NULL;
+
+	pthread_mutex_lock(&ObjectIdentifierFactory::mutex);
+	if (ObjectIdentifierFactory::registered == NULL)
+	{
+		ObjectIdentifierFactory::registered = new std::map<std::string, ASN1_OBJECT*>();
+	}
+	iter = ObjectIdentifierFactory::registered->find(oid);
+	if (iter != ObjectIdentifierFactory::registered->end())
+	{
+		asn1Obj = iter->second;
+	}
+	else if (ObjectIdentifierFactory::registered->size() < ObjectIdentifierFactory::MAX_REGISTERED)
+	{
+		asn1Obj = OBJ_txt2obj(oid.c_str(), 1);
+		if (asn1Obj)
+		{
+			(*ObjectIdentifierFactory::registered)[oid] = asn1Obj;
+		}
+	}
+	pthread_mutex_unlock(&ObjectIdentifierFactory::mutex);
+	return asn1Obj;
+}
+
 ObjectIdentifier ObjectIdentifierFactory::getObjectIdentifier(std::string oid)
 		throw (CertificationException)
 {
 	ASN1_OBJECT *asn1Obj;
+	asn1Obj = ObjectIdentifierFactory::getRegistered(oid);
+	if (asn1Obj)
+	{
+		return ObjectIdentifier(asn1Obj, true);
+	}
+	//registro cheio ou OID inválido
 	asn1Obj = OBJ_txt2obj(oid.c_str(), 1);
 	if (!asn1Obj)
 	{
@@ -16,32 +52,62 @@ ObjectIdentifier ObjectIdentifierFactory::getObjectIdentifier(int nid)
 		throw (CertificationException)
 {
 	ASN1_OBJECT *asn1Obj;
+	//objetos da tabela do OpenSSL, ou adicionados por OBJ_create, vivem até o fim do processo
 	asn1Obj = OBJ_nid2obj(nid);
 	if (!asn1Obj)
 	{
 		throw CertificationException(CertificationException::UNKNOWN_OID, "ObjectIdentifierFactory::getObjectIdentifier");
 	}
-	return ObjectIdentifier(asn1Obj);
+	return ObjectIdentifier(asn1Obj, true);
 }
 
-ObjectIdentifier ObjectIdentifierFactory::createObjectIdentifier(std::string oid, std::string name)
+ObjectIdentifier ObjectIdentifierFactory::getObjectIdentifier(const ASN1_OBJECT *asn1Object)
 		throw (CertificationException)
 {
 	ASN1_OBJECT *asn1Obj;
 	int nid;
+	if (!asn1Object)
+	{
+		return ObjectIdentifier();
+	}
+	nid = OBJ_obj2nid(asn1Object);
+	if (nid != NID_undef)
+	{
+		return ObjectIdentifierFactory::getObjectIdentifier(nid);
+	}
+	asn1Obj = OBJ_dup(asn1Object);
+	if (!asn1Obj)
+	{
+		throw CertificationException(CertificationException::INTERNAL_ERROR, "ObjectIdentifierFactory::getObjectIdentifier");
+	}
+	return ObjectIdentifier(asn1Obj);
+}
 
-	ObjectIdentifierFactory::getObjectIdentifier(oid);
+ObjectIdentifier ObjectIdentifierFactory::createObjectIdentifier(std::string oid, std::string name)
+		throw (CertificationException)
+{
+	ObjectIdentifier registeredOid = ObjectIdentifierFactory::getObjectIdentifier(oid);
+	ASN1_OBJECT *asn1Obj = registeredOid.getObjectIdentifier();
+	ASN1_OBJECT *newObj;
+	int nid;
 
-	nid = OBJ_create(oid.c_str(), name.c_str(), name.c_str());
-	
-	if (nid == NID_undef)
+	//mesmas verificações de OBJ_create, sem converter o OID novamente
+	if (OBJ_obj2nid(asn1Obj) != NID_undef || OBJ_sn2nid(name.c_str()) != NID_undef
+			|| OBJ_ln2nid(name.c_str()) != NID_undef)
 	{
 		throw CertificationException(CertificationException::INTERNAL_ERROR, "ObjectIdentifierFactory::createObjectIdentifier");
 	}
-	asn1Obj = OBJ_nid2obj(nid);
-	if (!asn1Obj)
+	newObj = ASN1_OBJECT_create(OBJ_new_nid(1), (unsigned char *)OBJ_get0_data(asn1Obj), OBJ_length(asn1Obj),
+			name.c_str(), name.c_str());
+	if (!newObj)
 	{
 		throw CertificationException(CertificationException::INTERNAL_ERROR, "ObjectIdentifierFactory::createObjectIdentifier");
 	}
-	return ObjectIdentifier(asn1Obj);
+	nid = OBJ_add_object(newObj);
+	ASN1_OBJECT_free(newObj);
+	if (nid == NID_undef)
+	{
+		throw CertificationException(CertificationException::INTERNAL_ERROR, "ObjectIdentifierFactory::createObjectIdentifier");
+	}
+	return ObjectIdentifierFactory::getObjectIdentifier(nid);
 }
@@ -1,4 +1,5 @@
 #include <libcryptosec/certificate/PolicyInformation.h>
+#include <libcryptosec/certificate/ObjectIdentifierFactory.h>
 
 PolicyInformation::PolicyInformation()
 {
@@ -10,7 +11,7 @@ PolicyInformation::PolicyInformation(POLICYINFO *policyInfo)
 	PolicyQualifierInfo policyQualifierInfo;
 	if (policyInfo)
 	{
-		this->policyIdentifier = ObjectIdentifier(OBJ_dup(policyInfo->policyid));
+		this->policyIdentifier = ObjectIdentifierFactory::getObjectIdentifier(policyInfo->policyid);
 		num = sk_POLICYQUALINFO_num(policyInfo->qualifiers);
 		for (i=0;i<num;i++)
 		{
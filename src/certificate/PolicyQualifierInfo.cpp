@@ -10,7 +10,7 @@ PolicyQualifierInfo::PolicyQualifierInfo(POLICYQUALINFO *policyQualInfo)
 	char *data;
 	if (policyQualInfo)
 	{
-		this->objectIdentifier = ObjectIdentifier(OBJ_dup(policyQualInfo->pqualid));
+		this->objectIdentifier = ObjectIdentifierFactory::getObjectIdentifier(policyQualInfo->pqualid);
 		switch (this->objectIdentifier.getNid())
 		{
 			case NID_id_qt_cps:
@@ -1,116 +1,169 @@
 #include <libcryptosec/certificate/RDNSequence.h>
 
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <cctype>
+
+/* chave de RDNSequence::getHash, sorteada uma vez por processo */
+static unsigned char hashKey[16];
+static pthread_once_t hashKeyOnce = PTHREAD_ONCE_INIT;
+
+static void hashKeyInit()
+{
+	if (RAND_bytes(hashKey, sizeof(hashKey)) != 1)
+	{
+		memset(hashKey, 0, sizeof(hashKey));
+	}
+}
+
+/* tamanho em 4 bytes, big endian, para que a concatenação das entradas seja inequívoca */
+static void appendLength(std::string &out, size_t length)
+{
+	out += (char)((length >> 24) & 0xff);
+	out += (char)((length >> 16) & 0xff);
+	out += (char)((length >> 8) & 0xff);
+	out += (char)(length & 0xff);
+}
+
+/* espaços nas pontas removidos, sequências internas reduzidas a um espaço e letras ASCII em minúsculas */
+static std::string canonicalValue(const std::string &value)
+{
+	std::string ret;
+	bool space = false;
+	unsigned char c;
+	ret.reserve(value.size());
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		c = (unsigned char)value[i];
+		if (c < 0x80 && isspace(c))
+		{
+			space = !ret.empty();
+			continue;
+		}
+		if (space)
+		{
+			ret += ' ';
+			space = false;
+		}
+		ret += (char)(c < 0x80 ? tolower(c) : c);
+	}
+	return ret;
+}
+
+/* valor da entrada em UTF-8, qualquer que seja o tipo de string, ou fallback se não puder ser convertido */
+static std::string toUtf8(ASN1_STRING *data, const std::string &fallback)
+{
+	unsigned char *utf8;
+	int length = ASN1_STRING_to_UTF8(&utf8, data);
+	std::string ret;
+	if (length < 0)
+	{
+		return fallback;
+	}
+	ret.assign((const char *)utf8, length);
+	OPENSSL_free(utf8);
+	return ret;
+}
+
 RDNSequence::RDNSequence()
 {
 	this->newEntries.clear();
+	this->hash = 0;
+	this->hashed = false;
 //	printf("NUM: %d\n", this->newEntries.size());
 }
 
 RDNSequence::RDNSequence(X509_NAME *rdn)
 {
-	X509_NAME_ENTRY *nameEntry;
-	int i, num;
-	ASN1_STRING *asn1data;
-	unsigned const char* data;
-	std::string value;
-	std::pair<ObjectIdentifier, std::string> oneEntry;
+	int i, num, set = -1;
+	std::vector<std::string> values;
+	this->hash = 0;
+	this->hashed = false;
 	if (rdn)
 	{
 		num = X509_NAME_entry_count(rdn);
 		for (i=0;i<num;i++)
 		{
-			nameEntry = X509_NAME_get_entry(rdn, i);
-			oneEntry.first = ObjectIdentifier(OBJ_dup(X509_NAME_ENTRY_get_object(nameEntry)));
-			
-			asn1data = X509_NAME_ENTRY_get_data(nameEntry);
-			data = ASN1_STRING_get0_data(asn1data);
-			value = std::string(reinterpret_cast<const char*>(data));
-			oneEntry.second = value;
-			
-			this->newEntries.push_back(oneEntry);
-			
-			
-//			nameEntry = sk_X509_NAME_ENTRY_value(rdn->entries, i);
-//			nid = OBJ_obj2nid(nameEntry->object);
-//			if (nid != NID_undef)
-//			{
-//				if (RDNSequence::id2Type(nid) != RDNSequence::UNKNOWN)
-//				{
-//					data = (char *)ASN1_STRING_data(nameEntry->value);
-//					value = data;
-//					this->entries[RDNSequence::id2Type(nid)].push_back(value);
-//				}
-//				else
-//				{
-//					data = (char *)ASN1_STRING_data(nameEntry->value);
-//					value = data;
-//					oneEntry.second = value;
-//					data = (char *)calloc(31, sizeof(char));
-//					OBJ_obj2txt(data, 30, nameEntry->object, 1);
-//					value = data;
-//					free(data);
-//					oneEntry.first = value;
-//					this->unknownEntries.push_back(oneEntry);
-//				}
-//			}
+			this->addNameEntry(X509_NAME_get_entry(rdn, i), values, set);
 		}
+		this->addCanonical(values);
 	}
 }
 
 RDNSequence::RDNSequence(STACK_OF(X509_NAME_ENTRY) *entries)
 {
-	X509_NAME_ENTRY *nameEntry;
-	int i, num;
-	char *data;
-	std::string value;
-	std::pair<ObjectIdentifier, std::string> oneEntry;
-//	std::vector<std::string> entry;
-//
-//	for (i=0;i<14;i++)
-//	{
-//		this->entries.push_back(entry);
-//	}
+	int i, num, set = -1;
+	std::vector<std::string> values;
+	this->hash = 0;
+	this->hashed = false;
 	if (entries)
 	{
 		num = sk_X509_NAME_ENTRY_num(entries);
 		for (i=0;i<num;i++)
 		{
-			nameEntry = sk_X509_NAME_ENTRY_value(entries, i);
-			
-			oneEntry.first = ObjectIdentifier(OBJ_dup(X509_NAME_ENTRY_get_object(nameEntry)));
-			
-			data = (char *)X509_NAME_ENTRY_get_data(nameEntry);
-			value = data;
-			oneEntry.second = value;
-			
-			this->newEntries.push_back(oneEntry);
-			
-//			nid = OBJ_obj2nid(nameEntry->object);
-//			if (nid != NID_undef)
-//			{
-//				if (RDNSequence::id2Type(nid) != RDNSequence::UNKNOWN)
-//				{
-//					data = (char *)ASN1_STRING_data(nameEntry->value);
-//					value = data;
-//					this->entries[RDNSequence::id2Type(nid)].push_back(value);
-//				}
-//				else
-//				{
-//					data = (char *)ASN1_STRING_data(nameEntry->value);
-//					value = data;
-//					oneEntry.second = value;
-//					data = (char *)calloc(31, sizeof(char));
-//					OBJ_obj2txt(data, 30, nameEntry->object, 1);
-//					value = data;
-//					free(data);
-//					oneEntry.first = value;
-//					this->unknownEntries.push_back(oneEntry);
-//				}
-//			}
+			this->addNameEntry(sk_X509_NAME_ENTRY_value(entries, i), values, set);
 		}
+		this->addCanonical(values);
 	}
 }
 
+/*
+ * values acumula a forma canônica das entradas do RDN corrente, identificado por set
+ * (X509_NAME_ENTRY_set()); o RDN é adicionado à forma canônica quando a entrada é de outro RDN.
+ */
+void RDNSequence::addNameEntry(X509_NAME_ENTRY *nameEntry, std::vector<std::string> &values, int &set)
+{
+	ASN1_STRING *asn1data;
+	unsigned const char* data;
+	std::pair<ObjectIdentifier, std::string> oneEntry;
+
+	oneEntry.first = ObjectIdentifierFactory::getObjectIdentifier(X509_NAME_ENTRY_get_object(nameEntry));
+	asn1data = X509_NAME_ENTRY_get_data(nameEntry);
+	data = ASN1_STRING_get0_data(asn1data);
+	oneEntry.second = std::string(reinterpret_cast<const char*>(data));
+	this->newEntries.push_back(oneEntry);
+
+	if (X509_NAME_ENTRY_set(nameEntry) != set)
+	{
+		this->addCanonical(values);
+		set = X509_NAME_ENTRY_set(nameEntry);
+	}
+	values.push_back(RDNSequence::getCanonical(oneEntry.first, toUtf8(asn1data, oneEntry.second)));
+}
+
+std::string RDNSequence::getCanonical(const ObjectIdentifier& oid, const std::string& value)
+{
+	ASN1_OBJECT *asn1Obj = oid.getObjectIdentifier();
+	std::string canonicalData = canonicalValue(value);
+	std::string ret;
+
+	appendLength(ret, OBJ_length(asn1Obj));
+	ret.append((const char *)OBJ_get0_data(asn1Obj), OBJ_length(asn1Obj));
+	appendLength(ret, canonicalData.size());
+	ret += canonicalData;
+	return ret;
+}
+
+/* um RDN: a quantidade de valores e os valores em ordem, pois um RDN é um conjunto (RFC 5280 7.1) */
+void RDNSequence::addCanonical(std::vector<std::string> &values)
+{
+	if (values.empty())
+	{
+		return;
+	}
+	std::sort(values.begin(), values.end());
+	appendLength(this->canonical, values.size());
+	for (unsigned int i = 0; i < values.size(); i++)
+	{
+		this->canonical += values[i];
+	}
+	values.clear();
+	__atomic_store_n(&this->hashed, false, __ATOMIC_RELEASE);
+}
+
 RDNSequence::~RDNSequence()
 {
 }
@@ -164,12 +217,19 @@ void RDNSequence::addEntry(RDNSequence::EntryType type, std::string value)
 {
 //	this->entries[type].push_back(value);
 	std::pair<ObjectIdentifier, std::string> oneEntry;
-	ObjectIdentifier oid;
+	X509_NAME_ENTRY *entry;
 	if (type != RDNSequence::UNKNOWN)
 	{
 		oneEntry.first = ObjectIdentifierFactory::getObjectIdentifier(RDNSequence::type2Id(type));
 		oneEntry.second = value;
 		this->newEntries.push_back(oneEntry);
+		//a forma canônica parte do valor codificado como em getX509Name(), para que seja igual à do nome decodificado
+		entry = X509_NAME_ENTRY_create_by_OBJ(NULL, oneEntry.first.getObjectIdentifier(), MBSTRING_ASC,
+				(const unsigned char *)value.c_str(), value.length());
+		std::vector<std::string> values(1, RDNSequence::getCanonical(oneEntry.first,
+				entry != NULL ? toUtf8(X509_NAME_ENTRY_get_data(entry), value) : value));
+		X509_NAME_ENTRY_free(entry);
+		this->addCanonical(values);
 	}
 }
 
@@ -454,5 +514,48 @@ int RDNSequence::type2Id(RDNSequence::EntryType type)
 RDNSequence& RDNSequence::operator =(const RDNSequence& value)
 {
 	this->newEntries = value.getEntries();
+	this->canonical = value.canonical;
+	this->hash = value.getHash();
+	this->hashed = true;
 	return *this;
 }
+
+const std::string& RDNSequence::getCanonical() const
+{
+	return this->canonical;
+}
+
+/*
+ * Calculado na primeira chamada após a última alteração do nome. Threads concorrentes podem calcular
+ * o mesmo valor, que é publicado antes de hashed.
+ */
+size_t RDNSequence::getHash() const
+{
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	std::string data;
+	size_t ret;
+
+	if (__atomic_load_n(&this->hashed, __ATOMIC_ACQUIRE))
+	{
+		return __atomic_load_n(&this->hash, __ATOMIC_RELAXED);
+	}
+	pthread_once(&hashKeyOnce, hashKeyInit);
+	data.reserve(sizeof(hashKey) + this->canonical.size());
+	data.append((const char *)hashKey, sizeof(hashKey));
+	data += this->canonical;
+	SHA256((const unsigned char *)data.data(), data.size(), digest);
+	memcpy(&ret, digest, sizeof(ret));
+	__atomic_store_n(&this->hash, ret, __ATOMIC_RELAXED);
+	__atomic_store_n(&this->hashed, true, __ATOMIC_RELEASE);
+	return ret;
+}
+
+bool RDNSequence::operator ==(const RDNSequence& value) const
+{
+	return this->canonical == value.canonical;
+}
+
+bool RDNSequence::operator !=(const RDNSequence& value) const
+{
+	return !(*this == value);
+}
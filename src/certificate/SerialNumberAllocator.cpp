@@ -0,0 +1,176 @@
+#include <libcryptosec/certificate/SerialNumberAllocator.h>
+
+#include <libcryptosec/Random.h>
+
+#include <openssl/bn.h>
+
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <set>
+
+const unsigned int SerialNumberAllocator::SIZE;
+const unsigned int SerialNumberAllocator::MAX_SHARD;
+
+/*
+ * SerialNumberAllocators existentes, para que o processo filho de um fork() reinicie os contadores:
+ * do contrário emitiria os mesmos shard e contador que o pai.
+ */
+static pthread_mutex_t allocatorsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t allocatorsOnce = PTHREAD_ONCE_INIT;
+static std::set<SerialNumberAllocator *> allocators;
+
+static void allocatorsLock()
+{
+	pthread_mutex_lock(&allocatorsMutex);
+}
+
+static void allocatorsUnlock()
+{
+	pthread_mutex_unlock(&allocatorsMutex);
+}
+
+static void allocatorsInit()
+{
+	pthread_atfork(allocatorsLock, allocatorsUnlock, SerialNumberAllocator::forkChild);
+}
+
+/* instante corrente em microssegundos, multiplicado por 4096 */
+static uint64_t initialCounter()
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((uint64_t) now.tv_sec * 1000000 + now.tv_usec) << 12;
+}
+
+SerialNumberAllocator::SerialNumberAllocator() throw (RandomException)
+{
+	unsigned char data[4];
+
+	Random::fillInto(data, sizeof(data));
+	this->init(((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]) & SerialNumberAllocator::MAX_SHARD);
+}
+
+SerialNumberAllocator::SerialNumberAllocator(unsigned int shard) throw (CertificationException)
+{
+	if (shard > SerialNumberAllocator::MAX_SHARD)
+	{
+		throw CertificationException(CertificationException::INVALID_TYPE, "SerialNumberAllocator::SerialNumberAllocator");
+	}
+	this->init(shard);
+}
+
+SerialNumberAllocator::~SerialNumberAllocator()
+{
+	pthread_mutex_lock(&allocatorsMutex);
+	allocators.erase(this);
+	pthread_mutex_unlock(&allocatorsMutex);
+}
+
+void SerialNumberAllocator::init(unsigned int shard)
+{
+	this->shard = shard;
+	this->counter = initialCounter();
+	pthread_once(&allocatorsOnce, allocatorsInit);
+	pthread_mutex_lock(&allocatorsMutex);
+	allocators.insert(this);
+	pthread_mutex_unlock(&allocatorsMutex);
+}
+
+/* o filho tem uma única thread e herdou a trava obtida antes do fork() */
+void SerialNumberAllocator::forkChild()
+{
+	uint64_t counter = initialCounter();
+	std::set<SerialNumberAllocator *>::iterator iter;
+
+	for (iter = allocators.begin(); iter != allocators.end(); iter++)
+	{
+		(*iter)->counter = counter;
+	}
+	pthread_mutex_unlock(&allocatorsMutex);
+}
+
+void SerialNumberAllocator::next(unsigned char *serial) throw (RandomException)
+{
+	uint64_t counter = __atomic_fetch_add(&this->counter, 1, __ATOMIC_RELAXED);
+
+	Random::fillInto(serial + SerialNumberAllocator::SIZE - 8, 8);
+	this->fill(serial, counter);
+}
+
+void SerialNumberAllocator::next(unsigned char *serials, unsigned int count) throw (RandomException)
+{
+	uint64_t counter;
+
+	if (count == 0)
+	{
+		return;
+	}
+	counter = __atomic_fetch_add(&this->counter, count, __ATOMIC_RELAXED);
+	Random::fillInto(serials, (size_t) count * SerialNumberAllocator::SIZE);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		this->fill(serials + (size_t) i * SerialNumberAllocator::SIZE, counter + i);
+	}
+}
+
+BigInteger SerialNumberAllocator::next() throw (RandomException, BigIntegerException)
+{
+	unsigned char serial[SerialNumberAllocator::SIZE];
+	BigInteger ret;
+
+	this->next(serial);
+	ret.setUnsignedValue(serial, sizeof(serial));
+	return ret;
+}
+
+std::vector<BigInteger> SerialNumberAllocator::next(unsigned int count) throw (RandomException, BigIntegerException)
+{
+	ByteArray serials((unsigned int) count * SerialNumberAllocator::SIZE);
+	std::vector<BigInteger> ret(count);
+
+	this->next(serials.getDataPointer(), count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		ret[i].setUnsignedValue(serials.getDataPointer() + i * SerialNumberAllocator::SIZE, SerialNumberAllocator::SIZE);
+	}
+	return ret;
+}
+
+unsigned int SerialNumberAllocator::getShard() const
+{
+	return this->shard;
+}
+
+bool SerialNumberAllocator::getShard(const BigInteger &serial, unsigned int &shard)
+{
+	unsigned char data[SerialNumberAllocator::SIZE];
+
+	if (serial.isNegative() || BN_num_bytes(serial.getBIGNUM()) != (int) SerialNumberAllocator::SIZE)
+	{
+		return false;
+	}
+	BN_bn2bin(serial.getBIGNUM(), data);
+	if ((data[0] & 0xC0) != 0x40)
+	{
+		return false;
+	}
+	shard = ((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]) & SerialNumberAllocator::MAX_SHARD;
+	return true;
+}
+
+/* shard e contador sobre os 20 octetos aleatórios; os 8 últimos permanecem aleatórios */
+void SerialNumberAllocator::fill(unsigned char *serial, uint64_t counter) const
+{
+	unsigned int prefix = this->shard | (1u << 30);
+
+	for (int i = 3; i >= 0; i--, prefix >>= 8)
+	{
+		serial[i] = (unsigned char) prefix;
+	}
+	for (int i = 11; i >= 4; i--, counter >>= 8)
+	{
+		serial[i] = (unsigned char) counter;
+	}
+}
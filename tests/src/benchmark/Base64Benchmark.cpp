@@ -0,0 +1,91 @@
+#include <libcryptosec/Base64.h>
+
+#include <openssl/evp.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+/*
+ * Vazão de Base64::encode e Base64::decode sobre 16 MB, comparada com EVP_EncodeBlock e
+ * EVP_DecodeBlock, e da decodificação de PEM (linhas de 64 caracteres) e em stream.
+ */
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void report(const char *name, size_t bytes, double seconds)
+{
+    printf("%-24s %10.1f MB/s\n", name, bytes / seconds / 1e6);
+}
+
+int main()
+{
+    const unsigned int size = 16 * 1024 * 1024;
+    const int rounds = 8;
+    ByteArray data(size);
+    std::string encoded, pem, reference(4 * ((size + 2) / 3) + 1, '\0');
+    unsigned char *decoded = new unsigned char[size + 3];
+    double start;
+
+    for (unsigned int i = 0; i < size; i++) {
+        data[i] = (unsigned char) (i * 167 + (i >> 9));
+    }
+
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        encoded = Base64::encode(data);
+    }
+    report("Base64::encode", (size_t) size * rounds, now() - start);
+
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        EVP_EncodeBlock((unsigned char *) &reference[0], data.getDataPointer(), size);
+    }
+    report("EVP_EncodeBlock", (size_t) size * rounds, now() - start);
+
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        Base64::decode(encoded);
+    }
+    report("Base64::decode", (size_t) size * rounds, now() - start);
+
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        EVP_DecodeBlock(decoded, (const unsigned char *) encoded.data(), encoded.size());
+    }
+    report("EVP_DecodeBlock", (size_t) size * rounds, now() - start);
+
+    for (size_t i = 0; i < encoded.size(); i += 64) {
+        pem += encoded.substr(i, 64) + "\n";
+    }
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        Base64::decode(pem);
+    }
+    report("Base64::decode (PEM)", (size_t) size * rounds, now() - start);
+
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        std::istringstream in(std::string((const char *) data.getDataPointer(), size));
+        std::ostringstream out;
+        Base64::encode(&in, &out, 64);
+    }
+    report("Base64 stream encode", (size_t) size * rounds, now() - start);
+
+    start = now();
+    for (int i = 0; i < rounds; i++) {
+        std::istringstream in(pem);
+        std::ostringstream out;
+        Base64::decode(&in, &out);
+    }
+    report("Base64 stream decode", (size_t) size * rounds, now() - start);
+
+    delete[] decoded;
+    return 0;
+}
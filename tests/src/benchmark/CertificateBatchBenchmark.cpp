@@ -0,0 +1,122 @@
+#include <libcryptosec/certificate/CertificateBuilder.h>
+#include <libcryptosec/ECDSAKeyPair.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Emissão de certificados ECDSA P-256 para dispositivos, com as mesmas extensões, um a um com
+ * CertificateBuilder::sign(PrivateKey&, ...), preenchendo o builder a cada certificado, e em lote
+ * a partir de um modelo com 1 e com std::thread::hardware_concurrency() threads.
+ */
+
+static const unsigned int CERTIFICATES = 20000;
+static const unsigned int SINGLE = 2000;
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static RDNSequence name(const std::string &commonName)
+{
+    RDNSequence rdn;
+    rdn.addEntry(RDNSequence::COUNTRY, "BR");
+    rdn.addEntry(RDNSequence::ORGANIZATION, "LabSEC");
+    rdn.addEntry(RDNSequence::COMMON_NAME, commonName);
+    return rdn;
+}
+
+static void prepare(CertificateBuilder &builder, RDNSequence &issuer, PublicKey &issuerKey)
+{
+    DateTime notBefore(time(NULL)), notAfter(time(NULL) + 365 * 86400);
+    SubjectKeyIdentifierExtension ski;
+    AuthorityKeyIdentifierExtension aki;
+    BasicConstraintsExtension basicConstraints;
+    KeyUsageExtension keyUsage;
+
+    builder.setVersion(2);
+    builder.setIssuer(issuer);
+    builder.setNotBefore(notBefore);
+    builder.setNotAfter(notAfter);
+    ski.setKeyIdentifier(issuerKey.getKeyIdentifier());
+    builder.addExtension(ski);
+    aki.setKeyIdentifier(issuerKey.getKeyIdentifier());
+    builder.addExtension(aki);
+    basicConstraints.setCa(false);
+    builder.addExtension(basicConstraints);
+    keyUsage.setUsage(KeyUsageExtension::DIGITAL_SIGNATURE, true);
+    builder.addExtension(keyUsage);
+}
+
+class CountingSink : public CertificateBuilder::Sink {
+public:
+    CountingSink() : bytes(0) {
+    }
+
+    virtual void write(unsigned int index, ByteArray &der) {
+        bytes += der.size();
+    }
+
+    unsigned long bytes;
+};
+
+int main()
+{
+    ECDSAKeyPair issuerKeyPair(AsymmetricKey::X962_PRIME256V1);
+    ECDSAKeyPair deviceKeyPair(AsymmetricKey::X962_PRIME256V1);
+    PrivateKey *issuerKey = issuerKeyPair.getPrivateKey();
+    PublicKey *issuerPublicKey = issuerKeyPair.getPublicKey();
+    PublicKey *deviceKey = deviceKeyPair.getPublicKey();
+    ByteArray deviceKeyInfo = deviceKey->getDerEncoded();
+    RDNSequence issuer = name("Device CA");
+    std::vector<RDNSequence> subjects;
+    std::vector<CertificateBuilder::Entry> entries;
+    CertificateBuilder model;
+    CertificateBuilder::Statistics statistics;
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::vector<unsigned int> sizes(1, 1);
+    double start;
+
+    for (unsigned int i = 0; i < CERTIFICATES; i++) {
+        subjects.push_back(name("Device " + std::to_string(i)));
+        entries.push_back(CertificateBuilder::Entry(BigInteger((long) i + 1), subjects.back(), deviceKeyInfo));
+    }
+
+    start = now();
+    for (unsigned int i = 0; i < SINGLE; i++) {
+        CertificateBuilder builder;
+        prepare(builder, issuer, *issuerPublicKey);
+        builder.setSerialNumber((long) i + 1);
+        builder.setSubject(subjects[i]);
+        builder.setPublicKey(*deviceKey);
+        delete builder.sign(*issuerKey, MessageDigest::SHA256);
+    }
+    printf("%-32s %10.0f certificates/s\n", "sign (one by one)", SINGLE / (now() - start));
+
+    prepare(model, issuer, *issuerPublicKey);
+    if (threads > 1) {
+        sizes.push_back(threads);
+    }
+    for (unsigned int i = 0; i < sizes.size(); i++) {
+        ThreadPool pool(sizes[i]);
+        CountingSink sink;
+        char label[32];
+
+        model.setThreadPool(&pool);
+        statistics = model.sign(entries, &sink, *issuerKey, MessageDigest::SHA256);
+        snprintf(label, sizeof(label), "sign (batch, %u threads)", sizes[i]);
+        printf("%-32s %10.0f certificates/s (%u issued, %lu bytes)\n", label, statistics.certificatesPerSecond,
+                statistics.issued, sink.bytes);
+    }
+
+    delete issuerKey;
+    delete issuerPublicKey;
+    delete deviceKey;
+    return 0;
+}
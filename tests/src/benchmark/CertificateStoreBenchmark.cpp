@@ -0,0 +1,121 @@
+#include <libcryptosec/certificate/CertificateStore.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+#include <libcryptosec/ECDSAKeyPair.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Inserção em lote de 100 mil certificados em um CertificateStore e consultas por titular,
+ * emissor e número de série e impressão digital, comparadas com a busca linear pelo titular em um
+ * vector de certificados, como é feito hoje com as cadeias passadas ao CertPathValidator.
+ * Os certificados são cópias de um mesmo certificado com titular e número de série alterados.
+ */
+
+static const unsigned int CERTIFICATES = 100000;
+static const unsigned int LOOKUPS = 200000;
+static const unsigned int LINEAR_LOOKUPS = 200;
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static std::string commonName(unsigned int i)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "Intermediate %u", i);
+    return buffer;
+}
+
+static RDNSequence name(unsigned int i)
+{
+    RDNSequence rdn;
+    rdn.addEntry(RDNSequence::ORGANIZATION, "LabSEC");
+    rdn.addEntry(RDNSequence::COMMON_NAME, commonName(i));
+    return rdn;
+}
+
+int main()
+{
+    ECDSAKeyPair keyPair(AsymmetricKey::X962_PRIME256V1);
+    PrivateKey *privateKey = keyPair.getPrivateKey();
+    PublicKey *publicKey = keyPair.getPublicKey();
+    RDNSequence issuer = name(0);
+    CertificateBuilder builder;
+    Certificate *model;
+    std::vector<Certificate *> certificates;
+    std::vector<ByteArray> fingerPrints;
+    std::vector<RDNSequence> names;
+    CertificateStore store;
+    unsigned int found = 0;
+    double start;
+
+    builder.setSubject(issuer);
+    builder.setIssuer(issuer);
+    builder.setPublicKey(*publicKey);
+    model = builder.sign(*privateKey, MessageDigest::SHA256);
+    for (unsigned int i = 0; i < CERTIFICATES; i++) {
+        X509 *cert = X509_dup(model->getX509());
+        X509_NAME *subject = X509_NAME_new();
+        X509_NAME_add_entry_by_txt(subject, "O", MBSTRING_UTF8, (const unsigned char *) "LabSEC", -1, -1, 0);
+        X509_NAME_add_entry_by_txt(subject, "CN", MBSTRING_UTF8, (const unsigned char *) commonName(i).c_str(), -1, -1, 0);
+        X509_set_subject_name(cert, subject);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), i + 1);
+        X509_NAME_free(subject);
+        X509_sign(cert, privateKey->getEvpPkey(), EVP_sha256());
+        certificates.push_back(new Certificate(cert));
+        fingerPrints.push_back(certificates.back()->getFingerPrint(MessageDigest::SHA256));
+    }
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        names.push_back(name((i * 7919) % CERTIFICATES));
+    }
+
+    start = now();
+    store.add(certificates);
+    printf("%-32s %10.0f certificates/s\n", "add (batch)", CERTIFICATES / (now() - start));
+
+    start = now();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        found += store.getBySubject(names[i]).size();
+    }
+    printf("%-32s %10.0f lookups/s\n", "getBySubject", LOOKUPS / (now() - start));
+
+    start = now();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        found += store.getByIssuerAndSerialNumber(issuer, BigInteger((long) (i % CERTIFICATES) + 1)) != NULL;
+    }
+    printf("%-32s %10.0f lookups/s\n", "getByIssuerAndSerialNumber", LOOKUPS / (now() - start));
+
+    start = now();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        found += store.getByFingerPrint(fingerPrints[(i * 7919) % CERTIFICATES]) != NULL;
+    }
+    printf("%-32s %10.0f lookups/s\n", "getByFingerPrint", LOOKUPS / (now() - start));
+
+    start = now();
+    for (unsigned int i = 0; i < LINEAR_LOOKUPS; i++) {
+        X509_NAME *subject = names[i].getX509Name();
+        for (unsigned int j = 0; j < certificates.size(); j++) {
+            if (X509_NAME_cmp(X509_get_subject_name(certificates[j]->getX509()), subject) == 0) {
+                found++;
+                break;
+            }
+        }
+        X509_NAME_free(subject);
+    }
+    printf("%-32s %10.0f lookups/s\n", "linear search by subject", LINEAR_LOOKUPS / (now() - start));
+
+    printf("(%u found, %u stored)\n", found, store.size());
+    for (unsigned int i = 0; i < certificates.size(); i++) {
+        delete certificates[i];
+    }
+    delete model;
+    delete privateKey;
+    delete publicKey;
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <libcryptosec/Pkcs7EnvelopedDataBuilder.h>
+#include <libcryptosec/RSAKeyPair.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Tempo de envelopagem de 64 KB para 1, 10, 100 e 1000 destinatários RSA-2048,
+ * com a chave de conteúdo cifrada sequencialmente e em paralelo.
+ * Os destinatários compartilham o par de chaves; apenas o certificado muda.
+ */
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double envelope(std::vector<Certificate *> &certs, unsigned int count, ByteArray &content, ThreadPool *pool)
+{
+    double start = now();
+    Pkcs7EnvelopedDataBuilder builder(*certs[0], SymmetricKey::AES_256, SymmetricCipher::CBC);
+    for (unsigned int i = 1; i < count; i++) {
+        builder.addCipher(*certs[i]);
+    }
+    builder.setThreadPool(pool);
+    delete builder.doFinal(content);
+    return now() - start;
+}
+
+int main()
+{
+    const unsigned int counts[] = {1, 10, 100, 1000};
+    RSAKeyPair keyPair(2048);
+    PrivateKey *privKey = keyPair.getPrivateKey();
+    std::vector<Certificate *> certs;
+    ByteArray content(65536);
+    ThreadPool pool;
+
+    for (unsigned int i = 0; i < 1000; i++) {
+        RDNSequence name;
+        CertificateBuilder builder;
+        char cn[32];
+        sprintf(cn, "recipient %u", i);
+        name.addEntry(RDNSequence::COMMON_NAME, cn);
+        builder.setSerialNumber(i + 1);
+        builder.setIssuer(name);
+        builder.setSubject(name);
+        builder.setPublicKey(*keyPair.getPublicKey());
+        certs.push_back(builder.sign(*privKey, MessageDigest::SHA256));
+    }
+
+    printf("%-12s %14s %14s %10s   (%u threads)\n", "recipients", "serial (ms)", "parallel (ms)", "speedup", pool.getSize());
+    for (unsigned int i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        double serial = envelope(certs, counts[i], content, NULL);
+        double parallel = envelope(certs, counts[i], content, &pool);
+        printf("%-12u %14.2f %14.2f %9.2fx\n", counts[i], serial * 1000, parallel * 1000, serial / parallel);
+    }
+
+    for (unsigned int i = 0; i < certs.size(); i++) {
+        delete certs[i];
+    }
+    delete privKey;
+    return 0;
+}
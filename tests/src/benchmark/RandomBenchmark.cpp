@@ -0,0 +1,80 @@
+#include <libcryptosec/Random.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+/*
+ * Nonces de 12 bytes gerados por segundo com 1, 2, 4 e 8 threads, com Random::fillInto
+ * (DRBG e buffer por thread), Random::bytes e RAND_bytes diretamente, e o ganho de vazão em relação a
+ * uma thread.
+ */
+
+static const unsigned int NONCES = 200000;
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void fillInto()
+{
+    unsigned char nonce[12];
+    for (unsigned int i = 0; i < NONCES; i++) {
+        Random::fillInto(nonce, sizeof(nonce));
+    }
+}
+
+static void bytes()
+{
+    for (unsigned int i = 0; i < NONCES; i++) {
+        Random::bytes(12);
+    }
+}
+
+static void randBytes()
+{
+    unsigned char nonce[12];
+    for (unsigned int i = 0; i < NONCES; i++) {
+        RAND_bytes(nonce, sizeof(nonce));
+    }
+}
+
+static double run(void (*function)(), unsigned int threads)
+{
+    std::vector<std::thread> pool;
+    double start = now();
+    for (unsigned int i = 0; i < threads; i++) {
+        pool.push_back(std::thread(function));
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        pool[i].join();
+    }
+    return NONCES * threads / (now() - start) / 1e6;
+}
+
+int main()
+{
+    const unsigned int threads[] = {1, 2, 4, 8};
+    double fillIntoBase = 0, randBytesBase = 0;
+
+    /* ganho: vazão total em relação a 1 thread; perto do número de threads (até o de núcleos) indica que
+     * as threads não disputam um lock global */
+    printf("%-8s %16s %8s %16s %16s %8s   (%u cores, Mnonces/s)\n", "threads", "fillInto", "gain", "bytes",
+            "RAND_bytes", "gain", std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        double fillIntoRate = run(fillInto, threads[i]);
+        double bytesRate = run(bytes, threads[i]);
+        double randBytesRate = run(randBytes, threads[i]);
+        if (i == 0) {
+            fillIntoBase = fillIntoRate;
+            randBytesBase = randBytesRate;
+        }
+        printf("%-8u %16.2f %8.2f %16.2f %16.2f %8.2f\n", threads[i], fillIntoRate, fillIntoRate / fillIntoBase,
+                bytesRate, randBytesRate, randBytesRate / randBytesBase);
+    }
+    return 0;
+}
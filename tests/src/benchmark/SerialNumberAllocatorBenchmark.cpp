@@ -0,0 +1,102 @@
+#include <libcryptosec/certificate/SerialNumberAllocator.h>
+#include <libcryptosec/Random.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+/*
+ * Números de série de 20 octetos gerados por segundo com SerialNumberAllocator (um a um, em lotes
+ * de 1024 e como BigInteger) e com Random::bytes convertido em BigInteger, como fazem os chamadores
+ * de CertificateBuilder::setSerialNumber(BigInteger) hoje (sem a consulta ao banco de dados), com 1,
+ * 2 e 4 threads compartilhando o mesmo SerialNumberAllocator.
+ */
+
+static const unsigned int SERIALS = 1000000;
+static const unsigned int BATCH = 1024;
+
+static SerialNumberAllocator shared(1);
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void single()
+{
+    unsigned char serial[SerialNumberAllocator::SIZE];
+    for (unsigned int i = 0; i < SERIALS; i++) {
+        shared.next(serial);
+    }
+}
+
+static void batch()
+{
+    std::vector<unsigned char> serials(BATCH * SerialNumberAllocator::SIZE);
+    for (unsigned int i = 0; i < SERIALS; i += BATCH) {
+        shared.next(&serials[0], BATCH);
+    }
+}
+
+static void bigInteger()
+{
+    for (unsigned int i = 0; i < SERIALS; i++) {
+        shared.next();
+    }
+}
+
+static void randomBytes()
+{
+    for (unsigned int i = 0; i < SERIALS; i++) {
+        ByteArray bytes = Random::bytes(SerialNumberAllocator::SIZE);
+        bytes[0] &= 0x7f;
+        BIGNUM *bn = BN_bin2bn(bytes.getDataPointer(), bytes.size(), NULL);
+        BigInteger serial(bn);
+        BN_free(bn);
+    }
+}
+
+static double run(void (*function)(), unsigned int threads)
+{
+    std::vector<std::thread> pool;
+    double start = now();
+    for (unsigned int i = 0; i < threads; i++) {
+        pool.push_back(std::thread(function));
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        pool[i].join();
+    }
+    return SERIALS * threads / (now() - start) / 1e6;
+}
+
+static void print(const char *name, void (*function)())
+{
+    const unsigned int threads[] = {1, 2, 4, 8};
+    double base = 0, rate;
+
+    printf("%-44s", name);
+    for (unsigned int i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        rate = run(function, threads[i]);
+        if (i == 0) {
+            base = rate;
+        }
+        printf(" %8.2f (%4.2fx)", rate, rate / base);
+    }
+    printf("\n");
+}
+
+int main()
+{
+    /* ganho em relação a 1 thread; perto do número de threads (até o de núcleos) indica que as threads
+     * não disputam o contador nem um lock global do gerador */
+    printf("%-44s %16s %16s %16s %16s   (%u cores, millions of serials/s)\n", "threads", "1", "2", "4", "8",
+            std::thread::hardware_concurrency());
+    print("SerialNumberAllocator::next(unsigned char*)", single);
+    print("SerialNumberAllocator::next(..., 1024)", batch);
+    print("SerialNumberAllocator::next()", bigInteger);
+    print("Random::bytes + BigInteger", randomBytes);
+    return 0;
+}
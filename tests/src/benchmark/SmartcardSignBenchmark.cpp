@@ -0,0 +1,111 @@
+#include <libcryptosec/SmartcardReader.h>
+#include <libcryptosec/Signer.h>
+#include <libcryptosec/ThreadPool.h>
+
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*
+ * Assinaturas RSA por segundo com uma chave em token PKCS#11 (por exemplo, SoftHSM):
+ * resolvendo a chave a cada assinatura (login, enumeração e logout, como em SmartcardSlot::decrypt()
+ * antes do cache de sessão), com a chave resolvida uma única vez, e com a chave compartilhada
+ * por várias threads.
+ *
+ * Configuração por variáveis de ambiente:
+ *   PKCS11_MODULE  caminho do módulo PKCS#11 (ex.: /usr/lib/softhsm/libsofthsm2.so)
+ *   PKCS11_SERIAL  serial do token
+ *   PKCS11_KEY_ID  id da chave e do certificado, em hexadecimal maiúsculo
+ *   PKCS11_PIN     PIN do usuário
+ * Sem essas variáveis o benchmark não é executado.
+ */
+
+static const unsigned int SIGNATURES = 200;
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+class SignTask : public ThreadPool::Task
+{
+public:
+    SignTask(PrivateKey *key, ByteArray *hash, unsigned int count) : key(key), hash(hash), count(count)
+    {
+    }
+
+    virtual void run()
+    {
+        for (unsigned int i = 0; i < this->count; i++) {
+            Signer::sign(*this->key, *this->hash, MessageDigest::SHA256);
+        }
+    }
+
+    PrivateKey *key;
+    ByteArray *hash;
+    unsigned int count;
+};
+
+int main()
+{
+    const char *module = getenv("PKCS11_MODULE");
+    const char *serialEnv = getenv("PKCS11_SERIAL");
+    const char *keyIdEnv = getenv("PKCS11_KEY_ID");
+    const char *pinEnv = getenv("PKCS11_PIN");
+    ThreadPool pool;
+    ByteArray hash(32);
+    double start, perOperation, cached, parallel;
+
+    if (module == NULL || serialEnv == NULL || keyIdEnv == NULL || pinEnv == NULL) {
+        printf("PKCS11_MODULE, PKCS11_SERIAL, PKCS11_KEY_ID and PKCS11_PIN not set, skipping\n");
+        return 0;
+    }
+    std::string serial(serialEnv), keyId(keyIdEnv), pin(pinEnv);
+    SmartcardReader::initialize(module);
+    SmartcardSlots *slots = SmartcardReader::getInstance()->getSmartcardSlots();
+
+    start = now();
+    for (unsigned int i = 0; i < SIGNATURES; i++) {
+        SmartcardSlot *slot = slots->getSmartcardSlot(serial, keyId);
+        PrivateKey *key = slot->getPrivateKey(keyId, pin);
+        Signer::sign(*key, hash, MessageDigest::SHA256);
+        delete key;
+        delete slot;
+    }
+    perOperation = now() - start;
+
+    SmartcardSlot *slot = slots->getSmartcardSlot(serial, keyId);
+    PrivateKey *key = slot->getPrivateKey(keyId, pin);
+    start = now();
+    for (unsigned int i = 0; i < SIGNATURES; i++) {
+        Signer::sign(*key, hash, MessageDigest::SHA256);
+    }
+    cached = now() - start;
+
+    std::vector<SignTask> batch;
+    std::vector<ThreadPool::Task *> tasks;
+    for (unsigned int i = 0; i < pool.getSize(); i++) {
+        batch.push_back(SignTask(key, &hash, SIGNATURES / pool.getSize()));
+    }
+    for (unsigned int i = 0; i < batch.size(); i++) {
+        tasks.push_back(&batch[i]);
+    }
+    start = now();
+    pool.execute(tasks);
+    parallel = now() - start;
+
+    printf("%-24s %14s\n", "mode", "signatures/s");
+    printf("%-24s %14.1f\n", "resolve per signature", SIGNATURES / perOperation);
+    printf("%-24s %14.1f\n", "cached key", SIGNATURES / cached);
+    printf("%-24s %14.1f   (%u threads)\n", "cached key, parallel",
+            (SIGNATURES / pool.getSize()) * pool.getSize() / parallel, pool.getSize());
+
+    delete key;
+    delete slot;
+    delete slots;
+    SmartcardReader::destroy();
+    return 0;
+}
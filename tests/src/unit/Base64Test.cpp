@@ -1,5 +1,7 @@
 #include <libcryptosec/Base64.h>
 
+#include <openssl/evp.h>
+
 #include <sstream>
 #include <gtest/gtest.h>
 
@@ -92,6 +94,27 @@ protected:
       ASSERT_EQ(encode, Base64Test::stringB64);
     }
 
+    /**
+     * @brief Dados pseudoaleatórios de tamanho arbitrário
+     */
+    ByteArray Data(unsigned int length) {
+      ByteArray ba(length);
+      for (unsigned int i = 0; i < length; i++) {
+        ba[i] = (unsigned char) (i * 167 + (i >> 7) + 13);
+      }
+      return ba;
+    }
+
+    /**
+     * @brief Codificação de referência do OpenSSL
+     */
+    std::string Reference(ByteArray &ba) {
+      std::string ret(4 * ((ba.size() + 2) / 3) + 1, '\0');
+      int size { EVP_EncodeBlock((unsigned char *) &ret[0], ba.getDataPointer(), ba.size()) };
+      ret.resize(size);
+      return ret;
+    }
+
     static std::string stringASCII;
     static std::string stringHex;
     static std::string stringB64;
@@ -149,3 +172,69 @@ TEST_F(Base64Test, Encoding) {
   EncodingSanityTest();
 }
 
+
+/**
+ * @brief Tamanhos que exercitam os blocos vetoriais e o restante escalar
+ */
+TEST_F(Base64Test, EncodeDecodeLengths) {
+  for (unsigned int length = 0; length < 200; length++) {
+    ByteArray ba { Data(length) };
+    std::string encoded { Base64::encode(ba) };
+    ASSERT_EQ(encoded, Reference(ba));
+    ASSERT_EQ(Base64::decode(encoded), ba);
+  }
+  ByteArray big { Data(1000003) };
+  std::string encoded { Base64::encode(big) };
+  ASSERT_EQ(encoded, Reference(big));
+  ASSERT_EQ(Base64::decode(encoded), big);
+}
+
+/**
+ * @brief Quebras de linha e espaços, como em PEM, são ignorados na decodificação
+ */
+TEST_F(Base64Test, DecodeWhitespace) {
+  ByteArray ba { Data(5000) };
+  std::string encoded { Base64::encode(ba) };
+  std::string pem;
+  for (unsigned int i = 0; i < encoded.size(); i += 64) {
+    pem += encoded.substr(i, 64) + (i % 128 ? "\r\n" : "\n");
+  }
+  ASSERT_EQ(Base64::decode(pem), ba);
+  std::string spaced { " \t" + Base64Test::stringB64.substr(0, 10) + " " + Base64Test::stringB64.substr(10) + "\n" };
+  ASSERT_EQ(Base64::decode(spaced).toString(), Base64Test::stringASCII);
+}
+
+/**
+ * @brief A decodificação termina no primeiro caractere inválido
+ */
+TEST_F(Base64Test, DecodeStopsAtInvalid) {
+  ByteArray ba { Data(300) };
+  std::string encoded { Base64::encode(ba) };
+  std::string truncated { encoded.substr(0, 200) + "*" + encoded.substr(200) };
+  ASSERT_EQ(Base64::decode(truncated), ByteArray(ba.getDataPointer(), 150));
+}
+
+/**
+ * @brief Codificação e decodificação em stream, com e sem quebra de linha
+ */
+TEST_F(Base64Test, Stream) {
+  ByteArray ba { Data(200000) };
+  std::istringstream in { std::string((const char *) ba.getDataPointer(), ba.size()) };
+  std::ostringstream encoded, decoded, plain;
+
+  ASSERT_TRUE(Base64::encode(&in, &encoded, 64));
+  std::string pem { encoded.str() };
+  unsigned int chars { 4 * ((ba.size() + 2) / 3) };
+  ASSERT_EQ(pem.size(), chars + (chars + 63) / 64);
+  ASSERT_EQ(pem.back(), '\n');
+  for (unsigned int i = 64; i < pem.size(); i += 65) {
+    ASSERT_EQ(pem[i], '\n');
+  }
+  std::istringstream encodedIn { pem };
+  ASSERT_TRUE(Base64::decode(&encodedIn, &decoded));
+  ASSERT_EQ(decoded.str(), std::string((const char *) ba.getDataPointer(), ba.size()));
+
+  std::istringstream plainIn { std::string((const char *) ba.getDataPointer(), ba.size()) };
+  ASSERT_TRUE(Base64::encode(&plainIn, &plain));
+  ASSERT_EQ(plain.str(), Reference(ba));
+}
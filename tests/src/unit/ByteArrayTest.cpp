@@ -265,3 +265,99 @@ TEST_F(ByteArrayTest, TestThrow) {
 TEST_F(ByteArrayTest, TestHexSeparator) {
     testHexSeparator();
 }
+
+/**
+ * @brief Conversão de hexadecimal, com e sem separador, é inversa de toHex
+ */
+TEST_F(ByteArrayTest, FromHex) {
+    ByteArray all(256);
+    for (int i = 0; i < 256; i++) {
+        all[i] = (unsigned char) i;
+    }
+    ASSERT_EQ(ByteArray::fromHex(all.toHex()), all);
+    ASSERT_EQ(ByteArray::fromHex(all.toHex(':'), ':'), all);
+    ASSERT_EQ(ByteArray::fromHex("53696d706c65").toString(), simpleASCII);
+    ASSERT_EQ(ByteArray::fromHex(simpleHexSeparator, '-').toString(), simpleASCII);
+    ASSERT_EQ(ByteArray::fromHex("").size(), 0);
+    ASSERT_EQ(ByteArray::fromHex("", '-').size(), 0);
+    ASSERT_EQ(ByteArray().toHex(':'), "");
+}
+
+/**
+ * @brief Texto hexadecimal mal formado é rejeitado
+ */
+TEST_F(ByteArrayTest, FromHexInvalid) {
+    ASSERT_THROW(ByteArray::fromHex("ABC"), std::invalid_argument);
+    ASSERT_THROW(ByteArray::fromHex("0G"), std::invalid_argument);
+    ASSERT_THROW(ByteArray::fromHex("53-69"), std::invalid_argument);
+    ASSERT_THROW(ByteArray::fromHex("53:69", '-'), std::invalid_argument);
+    ASSERT_THROW(ByteArray::fromHex("53-69-", '-'), std::invalid_argument);
+    ASSERT_THROW(ByteArray::fromHex("5369", '-'), std::invalid_argument);
+}
+
+/**
+ * @brief Comparação em tempo constante
+ */
+TEST_F(ByteArrayTest, ConstantTimeEquals) {
+    ByteArray ba{stringASCII};
+    ByteArray other{stringASCII};
+    ASSERT_TRUE(ByteArray::constantTimeEquals(ba, other));
+    other[size - 1] ^= 0x01;
+    ASSERT_FALSE(ByteArray::constantTimeEquals(ba, other));
+    ASSERT_FALSE(ByteArray::constantTimeEquals(ba, ByteArray{simpleASCII}));
+    ASSERT_TRUE(ByteArray::constantTimeEquals(ByteArray(), ByteArray()));
+}
+
+/**
+ * @brief Ou-exclusivo entre ByteArray's de tamanhos diferentes e sobre o próprio objeto
+ */
+TEST_F(ByteArrayTest, Xor) {
+    for (unsigned int length = 0; length < 100; length += 7) {
+        ByteArray left(length + 5), right(length);
+        for (unsigned int i = 0; i < length + 5; i++) {
+            left[i] = (unsigned char) (i * 31 + 7);
+        }
+        for (unsigned int i = 0; i < length; i++) {
+            right[i] = (unsigned char) (i * 17 + 3);
+        }
+        ByteArray xored = left xor right;
+        ASSERT_EQ(xored.size(), length + 5);
+        for (unsigned int i = 0; i < length + 5; i++) {
+            ASSERT_EQ(xored[i], (unsigned char) (left[i] ^ (i < length ? right[i] : 0)));
+        }
+        ASSERT_EQ(right xor left, xored);
+        ByteArray inPlace(right);
+        inPlace ^= left;
+        ASSERT_EQ(inPlace, xored);
+        inPlace ^= right;
+        ASSERT_EQ(inPlace, left);
+    }
+}
+
+/**
+ * @brief Ou-exclusivo de vários ByteArray's em uma passada
+ */
+TEST_F(ByteArrayTest, XorMultiple) {
+    std::vector<ByteArray> array;
+    unsigned int sizes[] = {10000, 3, 10001, 0, 4097};
+    for (unsigned int k = 0; k < 5; k++) {
+        ByteArray ba(sizes[k]);
+        for (unsigned int i = 0; i < sizes[k]; i++) {
+            ba[i] = (unsigned char) (i * (k + 3) + k);
+        }
+        array.push_back(ba);
+    }
+    ByteArray expected = array[0];
+    for (unsigned int k = 1; k < 5; k++) {
+        expected = expected xor array[k];
+    }
+    ByteArray xored = ByteArray::xOr(array);
+    ASSERT_EQ(xored.size(), 10001);
+    ASSERT_EQ(xored, expected);
+
+    ByteArray data(stringASCII), value(stringASCII);
+    ByteArray::xorInto(data.getDataPointer() + 1, value.getDataPointer() + 2, data.size() - 2);
+    for (unsigned int i = 1; i < data.size() - 1; i++) {
+        ASSERT_EQ(data[i], (unsigned char) (stringASCII[i] ^ stringASCII[i + 1]));
+    }
+}
@@ -0,0 +1,222 @@
+#include <libcryptosec/certificate/CertPathBuilder.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+#include <libcryptosec/ECDSAKeyPair.h>
+
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários da classe CertPathBuilder
+ *
+ * Duas hierarquias ligadas por um certificado cruzado: RootA (confiável) emitiu um certificado para
+ * RootB, que emitiu Sub, que emitiu Leaf. O repositório de intermediários contém ainda a RootB
+ * auto-assinada (não confiável) e versões de Sub expirada e sem BasicConstraints de AC.
+ */
+class CertPathBuilderTest : public ::testing::Test {
+
+protected:
+    static void SetUpTestCase() {
+        for (int i = 0; i < 4; i++) {
+            ECDSAKeyPair keyPair(AsymmetricKey::X962_PRIME256V1);
+            privKeys[i] = keyPair.getPrivateKey();
+            pubKeys[i] = keyPair.getPublicKey();
+        }
+    }
+
+    static void TearDownTestCase() {
+        for (int i = 0; i < 4; i++) {
+            delete privKeys[i];
+            delete pubKeys[i];
+        }
+    }
+
+    virtual void SetUp() {
+        now = time(NULL);
+        rootA = issue("RootA", ROOT_A, "RootA", ROOT_A, true, -1, 1, now - 3600, now + 86400);
+        rootB = issue("RootB", ROOT_B, "RootB", ROOT_B, true, -1, 1, now - 3600, now + 86400);
+        crossB = issue("RootB", ROOT_B, "RootA", ROOT_A, true, -1, 2, now - 3600, now + 86400);
+        sub = issue("Sub", SUB, "RootB", ROOT_B, true, 0, 3, now - 3600, now + 86400);
+        expiredSub = issue("Sub", SUB, "RootB", ROOT_B, true, -1, 4, now - 7200, now - 3600);
+        endEntitySub = issue("Sub", SUB, "RootB", ROOT_B, false, -1, 5, now - 3600, now + 86400);
+        leaf = issue("Leaf", LEAF, "Sub", SUB, false, -1, 6, now - 3600, now + 86400);
+
+        trusted.add(*rootA);
+        intermediates.add(*expiredSub);
+        intermediates.add(*endEntitySub);
+        intermediates.add(*rootB);
+        intermediates.add(*crossB);
+        intermediates.add(*sub);
+    }
+
+    virtual void TearDown() {
+        delete rootA;
+        delete rootB;
+        delete crossB;
+        delete sub;
+        delete expiredSub;
+        delete endEntitySub;
+        delete leaf;
+    }
+
+    enum Key {
+        ROOT_A = 0,
+        ROOT_B = 1,
+        SUB = 2,
+        LEAF = 3,
+    };
+
+    static RDNSequence name(const std::string &commonName) {
+        RDNSequence rdn;
+        rdn.addEntry(RDNSequence::COMMON_NAME, commonName);
+        return rdn;
+    }
+
+    static Certificate* issue(const std::string &subject, Key subjectKey, const std::string &issuer, Key issuerKey,
+            bool ca, long pathLen, long serial, time_t notBefore, time_t notAfter) {
+        CertificateBuilder builder;
+        RDNSequence subjectName = name(subject), issuerName = name(issuer);
+        DateTime before(notBefore), after(notAfter);
+        SubjectKeyIdentifierExtension ski;
+        AuthorityKeyIdentifierExtension aki;
+        BasicConstraintsExtension basicConstraints;
+
+        builder.setSubject(subjectName);
+        builder.setIssuer(issuerName);
+        builder.setSerialNumber(serial);
+        builder.setNotBefore(before);
+        builder.setNotAfter(after);
+        builder.setPublicKey(*pubKeys[subjectKey]);
+        ski.setKeyIdentifier(pubKeys[subjectKey]->getKeyIdentifier());
+        builder.addExtension(ski);
+        aki.setKeyIdentifier(pubKeys[issuerKey]->getKeyIdentifier());
+        builder.addExtension(aki);
+        basicConstraints.setCa(ca);
+        if (pathLen >= 0) {
+            basicConstraints.setPathLen(pathLen);
+        }
+        builder.addExtension(basicConstraints);
+        return builder.sign(*privKeys[issuerKey], MessageDigest::SHA256);
+    }
+
+    static PrivateKey *privKeys[4];
+    static PublicKey *pubKeys[4];
+
+    time_t now;
+    Certificate *rootA, *rootB, *crossB, *sub, *expiredSub, *endEntitySub, *leaf;
+    CertificateStore trusted, intermediates;
+};
+
+PrivateKey *CertPathBuilderTest::privKeys[4];
+PublicKey *CertPathBuilderTest::pubKeys[4];
+
+/**
+ * @brief Caminho através do certificado cruzado, ignorando os candidatos expirados e que não são de AC
+ */
+TEST_F(CertPathBuilderTest, BridgedPath) {
+    CertPathBuilder builder(trusted, intermediates);
+    std::vector<std::vector<Certificate *> > paths;
+    std::vector<Certificate *> path;
+
+    for (int i = 0; i < 2; i++) {
+        paths = builder.build(*leaf, DateTime(now), 4);
+        ASSERT_EQ(paths.size(), 1u);
+        ASSERT_EQ(paths[0].size(), 3u);
+        ASSERT_TRUE(*paths[0][0] == *sub);
+        ASSERT_TRUE(*paths[0][1] == *crossB);
+        ASSERT_TRUE(*paths[0][2] == *rootA);
+    }
+
+    ASSERT_TRUE(builder.verify(*leaf, path, DateTime(now)));
+    ASSERT_EQ(path, paths[0]);
+
+    paths = builder.build(*rootA, DateTime(now));
+    ASSERT_EQ(paths.size(), 1u);
+    ASSERT_TRUE(paths[0].empty());
+}
+
+/**
+ * @brief Sem caminho fora da validade dos certificados, com limite de intermediários ou com pathLenConstraint excedido
+ */
+TEST_F(CertPathBuilderTest, Pruning) {
+    CertPathBuilder builder(trusted, intermediates);
+    CertPathBuilder shortBuilder(trusted, intermediates, 1);
+    Certificate *subSub = issue("SubSub", LEAF, "Sub", SUB, true, -1, 7, now - 3600, now + 86400);
+    Certificate *leafOfSubSub = issue("Leaf", LEAF, "SubSub", LEAF, false, -1, 8, now - 3600, now + 86400);
+    std::vector<Certificate *> path;
+
+    ASSERT_EQ(builder.build(*leaf, DateTime(now)).size(), 1u);
+    ASSERT_TRUE(builder.build(*leaf, DateTime(now + 2 * 86400)).empty());
+    ASSERT_TRUE(shortBuilder.build(*leaf, DateTime(now)).empty());
+
+    intermediates.add(*subSub);
+    ASSERT_TRUE(builder.build(*leafOfSubSub, DateTime(now)).empty());
+    ASSERT_FALSE(builder.verify(*leafOfSubSub, path, DateTime(now)));
+
+    delete subSub;
+    delete leafOfSubSub;
+}
+
+/**
+ * @brief Com RootA e RootB confiáveis, os dois caminhos são encontrados, também depois de construções
+ * que guardaram o caminho mais curto a partir de Sub
+ */
+TEST_F(CertPathBuilderTest, AlternativePaths) {
+    CertPathBuilder builder(trusted, intermediates);
+    std::vector<std::vector<Certificate *> > paths;
+
+    trusted.add(*rootB);
+    ASSERT_EQ(builder.build(*leaf, DateTime(now)).size(), 1u);
+    for (int i = 0; i < 2; i++) {
+        paths = builder.build(*leaf, DateTime(now), 4);
+        ASSERT_EQ(paths.size(), 2u);
+        ASSERT_EQ(paths[0].size(), 2u);
+        ASSERT_TRUE(*paths[0][0] == *sub);
+        ASSERT_TRUE(*paths[0][1] == *rootB);
+        ASSERT_EQ(paths[1].size(), 3u);
+        ASSERT_TRUE(*paths[1][0] == *sub);
+        ASSERT_TRUE(*paths[1][1] == *crossB);
+        ASSERT_TRUE(*paths[1][2] == *rootA);
+    }
+
+    paths = builder.build(*leaf, DateTime(now));
+    ASSERT_EQ(paths.size(), 1u);
+    ASSERT_TRUE(*paths[0][1] == *rootB);
+}
+
+/**
+ * @brief verify() reaproveita o caminho guardado a partir de Sub: com as verificações de assinatura
+ * esquecidas, nenhuma assinatura entre intermediários é verificada novamente
+ */
+TEST_F(CertPathBuilderTest, VerifyUsesCachedPath) {
+    class Probe : public CertPathBuilder {
+    public:
+        Probe(const CertificateStore& trusted, const CertificateStore& intermediates) :
+                CertPathBuilder(trusted, intermediates) {}
+        using CertPathBuilder::signatures;
+    };
+    Probe builder(trusted, intermediates);
+    std::vector<Certificate *> path;
+
+    ASSERT_TRUE(builder.verify(*leaf, path, DateTime(now)));
+    ASSERT_FALSE(builder.signatures.empty());
+    builder.signatures.clear();
+    path.clear();
+    ASSERT_TRUE(builder.verify(*leaf, path, DateTime(now)));
+    ASSERT_EQ(path.size(), 3u);
+    ASSERT_TRUE(*path[1] == *crossB);
+    ASSERT_TRUE(builder.signatures.empty());
+}
+
+/**
+ * @brief Certificados cruzados em ciclo sem certificado confiável não levam a caminho
+ */
+TEST_F(CertPathBuilderTest, Loop) {
+    CertificateStore none;
+    CertPathBuilder builder(none, intermediates);
+    Certificate *crossA = issue("RootA", ROOT_A, "RootB", ROOT_B, true, -1, 9, now - 3600, now + 86400);
+
+    intermediates.add(*crossA);
+    intermediates.add(*rootA);
+    ASSERT_TRUE(builder.build(*leaf, DateTime(now), 4).empty());
+
+    delete crossA;
+}
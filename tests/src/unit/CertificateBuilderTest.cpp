@@ -1,5 +1,6 @@
 #include <libcryptosec/certificate/CertificateBuilder.h>
 #include <libcryptosec/RSAKeyPair.h>
+#include <libcryptosec/ECDSAKeyPair.h>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
@@ -507,3 +508,157 @@ TEST_F(CertificateBuilderTest, EncodingTest_NewRequestDefaultCodification) {
 	certBuilder->alterSubject(rdn);
 	testStringCodificaton(expectedCodification);
 }
+
+/**
+ * @brief Sink que guarda os certificados emitidos em lote.
+ */
+class CertificateBuilderTestSink : public CertificateBuilder::Sink {
+public:
+	virtual void write(unsigned int index, ByteArray &der) {
+		indexes.push_back(index);
+		certificates.push_back(der);
+	}
+
+	virtual void fail(unsigned int index, CertificationException &exception) {
+		failures.push_back(index);
+		details.push_back(exception.getDetails());
+	}
+
+	std::vector<unsigned int> indexes;
+	std::vector<ByteArray> certificates;
+	std::vector<unsigned int> failures;
+	std::vector<std::string> details;
+};
+
+/*!
+ * @brief Testa a emissão em lote a partir do builder como modelo, com chaves em SubjectPublicKeyInfo e em
+ * PublicKey, validade própria, SubjectKeyIdentifier recalculado e uma chave inválida.
+ */
+TEST_F(CertificateBuilderTest, SignBatch) {
+	ECDSAKeyPair issuerKeyPair(AsymmetricKey::X962_PRIME256V1);
+	ECDSAKeyPair subjectKeyPair(AsymmetricKey::X962_PRIME256V1);
+	PrivateKey *issuerKey = issuerKeyPair.getPrivateKey();
+	PublicKey *issuerPublicKey = issuerKeyPair.getPublicKey();
+	PublicKey *subjectKey = subjectKeyPair.getPublicKey();
+	ThreadPool pool(4);
+	CertificateBuilder builder;
+	RDNSequence issuer;
+	DateTime notBefore(time(NULL) - 60), notAfter(time(NULL) + 86400);
+	SubjectKeyIdentifierExtension ski;
+	BasicConstraintsExtension basicConstraints;
+	std::vector<CertificateBuilder::Entry> entries;
+	CertificateBuilderTestSink sink;
+	CertificateBuilder::Statistics statistics;
+
+	issuer.addEntry(RDNSequence::COMMON_NAME, "Issuing CA");
+	builder.setIssuer(issuer);
+	builder.setNotBefore(notBefore);
+	builder.setNotAfter(notAfter);
+	builder.setVersion(2);
+	ski.setKeyIdentifier(ByteArray("template"));
+	builder.addExtension(ski);
+	basicConstraints.setCa(false);
+	builder.addExtension(basicConstraints);
+
+	for (long i = 0; i < 300; i++) {
+		RDNSequence subject;
+		subject.addEntry(RDNSequence::COMMON_NAME, "Device " + std::to_string(i));
+		if (i % 2 == 0) {
+			entries.push_back(CertificateBuilder::Entry(BigInteger(i + 1), subject, subjectKey->getDerEncoded()));
+		} else {
+			entries.push_back(CertificateBuilder::Entry(BigInteger(i + 1), subject, subjectKey));
+		}
+	}
+	entries.at(5).publicKeyInfo = ByteArray("not a key");
+	entries.at(5).publicKey = NULL;
+	entries.at(8).setValidity(DateTime(1000000000), DateTime(2000000000));
+
+	builder.setThreadPool(&pool);
+	statistics = builder.sign(entries, &sink, *issuerKey, MessageDigest::SHA256);
+
+	ASSERT_EQ(statistics.issued, 299u);
+	ASSERT_EQ(statistics.failed, 1u);
+	ASSERT_GT(statistics.certificatesPerSecond, 0);
+	ASSERT_EQ(sink.failures, std::vector<unsigned int>(1, 5));
+	ASSERT_EQ(sink.details, std::vector<std::string>(1, "Invalid subject public key info"));
+	ASSERT_EQ(sink.certificates.size(), 299u);
+	for (unsigned int i = 0; i < sink.certificates.size(); i++) {
+		unsigned int index = sink.indexes.at(i);
+		Certificate cert(sink.certificates.at(i));
+		PublicKey *publicKey = cert.getPublicKey();
+		const ASN1_OCTET_STRING *keyIdentifier = X509_get0_subject_key_id(cert.getX509());
+		ByteArray expectedKeyIdentifier = subjectKey->getKeyIdentifier();
+
+		ASSERT_EQ(index, i < 5 ? i : i + 1);
+		ASSERT_TRUE(cert.verify(*issuerPublicKey));
+		ASSERT_EQ(cert.getSerialNumber(), (long) index + 1);
+		ASSERT_EQ(cert.getSubject().getEntries(RDNSequence::COMMON_NAME).at(0), "Device " + std::to_string(index));
+		ASSERT_EQ(cert.getIssuer().getEntries(RDNSequence::COMMON_NAME).at(0), "Issuing CA");
+		ASSERT_EQ(cert.getVersion(), 2);
+		ASSERT_EQ(publicKey->getDerEncoded(), subjectKey->getDerEncoded());
+		ASSERT_EQ(ByteArray(keyIdentifier->data, keyIdentifier->length), expectedKeyIdentifier);
+		ASSERT_EQ(X509_get_extension_flags(cert.getX509()) & EXFLAG_CA, 0u);
+		ASSERT_EQ(X509_get_ext_count(cert.getX509()), 2);
+		if (index == 8) {
+			ASSERT_EQ(cert.getNotBefore().getDateTime(), 1000000000);
+			ASSERT_EQ(cert.getNotAfter().getDateTime(), 2000000000);
+		} else {
+			ASSERT_EQ(cert.getNotBefore().getDateTime(), notBefore.getDateTime());
+			ASSERT_EQ(cert.getNotAfter().getDateTime(), notAfter.getDateTime());
+		}
+		delete publicKey;
+	}
+
+	//o modelo nao e alterado e a emissao sequencial interrompe o lote na falha
+	std::ostringstream out;
+	CertificateBuilder::StreamSink streamSink(&out);
+	builder.setThreadPool(NULL);
+	ASSERT_TRUE(builder.getSubject().getEntries(RDNSequence::COMMON_NAME).empty());
+	ASSERT_THROW(builder.sign(entries, &streamSink, *issuerKey, MessageDigest::SHA256), CertificationException);
+
+	delete issuerKey;
+	delete issuerPublicKey;
+	delete subjectKey;
+}
+
+/*!
+ * @brief Testa a escrita dos certificados emitidos em lote em PEM e em DER.
+ */
+TEST_F(CertificateBuilderTest, StreamSink) {
+	ECDSAKeyPair keyPair(AsymmetricKey::X962_PRIME256V1);
+	PrivateKey *privateKey = keyPair.getPrivateKey();
+	PublicKey *publicKey = keyPair.getPublicKey();
+	CertificateBuilder builder;
+	RDNSequence subject;
+	std::vector<CertificateBuilder::Entry> entries;
+	std::ostringstream pem, der;
+	CertificateBuilder::StreamSink pemSink(&pem), derSink(&der, false);
+
+	subject.addEntry(RDNSequence::COMMON_NAME, "Device");
+	builder.setIssuer(subject);
+	entries.push_back(CertificateBuilder::Entry(BigInteger(1), subject, publicKey));
+	entries.push_back(CertificateBuilder::Entry(BigInteger(2), subject, publicKey));
+	ASSERT_EQ(builder.sign(entries, &pemSink, *privateKey, MessageDigest::SHA256).issued, 2u);
+	ASSERT_EQ(builder.sign(entries, &derSink, *privateKey, MessageDigest::SHA256).issued, 2u);
+
+	std::string pemEncoded = pem.str();
+	size_t second = pemEncoded.find("-----BEGIN CERTIFICATE-----", 1);
+	ASSERT_NE(second, std::string::npos);
+	Certificate first(pemEncoded.substr(0, second)), last(pemEncoded.substr(second));
+	ASSERT_EQ(first.getSerialNumber(), 1);
+	ASSERT_EQ(last.getSerialNumber(), 2);
+	ASSERT_EQ(first.getPemEncoded() + last.getPemEncoded(), pemEncoded);
+
+	std::string derEncoded = der.str();
+	const unsigned char *p = (const unsigned char *) derEncoded.data(), *end = p + derEncoded.size();
+	for (long serial = 1; serial <= 2; serial++) {
+		X509 *cert = d2i_X509(NULL, &p, end - p);
+		ASSERT_TRUE(cert != NULL);
+		ASSERT_EQ(ASN1_INTEGER_get(X509_get0_serialNumber(cert)), serial);
+		X509_free(cert);
+	}
+	ASSERT_EQ(p, end);
+
+	delete privateKey;
+	delete publicKey;
+}
@@ -0,0 +1,203 @@
+#include <libcryptosec/certificate/CertificateStore.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+#include <libcryptosec/ECDSAKeyPair.h>
+
+#include <atomic>
+#include <thread>
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários da classe CertificateStore
+ */
+class CertificateStoreTest : public ::testing::Test {
+
+protected:
+    static void SetUpTestCase() {
+        ECDSAKeyPair keyPair(AsymmetricKey::X962_PRIME256V1);
+        ECDSAKeyPair otherKeyPair(AsymmetricKey::X962_PRIME256V1);
+        privKey = keyPair.getPrivateKey();
+        pubKey = keyPair.getPublicKey();
+        otherPrivKey = otherKeyPair.getPrivateKey();
+        otherPubKey = otherKeyPair.getPublicKey();
+    }
+
+    static void TearDownTestCase() {
+        delete privKey;
+        delete pubKey;
+        delete otherPrivKey;
+        delete otherPubKey;
+    }
+
+    static RDNSequence name(const std::string &commonName) {
+        RDNSequence rdn;
+        rdn.addEntry(RDNSequence::ORGANIZATION, "LabSEC");
+        rdn.addEntry(RDNSequence::COMMON_NAME, commonName);
+        return rdn;
+    }
+
+    static ByteArray keyId(const std::string &id) {
+        return ByteArray(id);
+    }
+
+    /*
+     * Certificado de subject emitido por issuer, com SKI e AKI opcionais (vazios não são incluídos).
+     */
+    static Certificate* issue(const std::string &subject, const std::string &issuer, long serial,
+            const std::string &ski, const std::string &aki, PublicKey &subjectKey, PrivateKey &issuerKey) {
+        CertificateBuilder builder;
+        RDNSequence subjectName = name(subject), issuerName = name(issuer);
+
+        builder.setSubject(subjectName);
+        builder.setIssuer(issuerName);
+        builder.setSerialNumber(serial);
+        builder.setPublicKey(subjectKey);
+        if (!ski.empty()) {
+            SubjectKeyIdentifierExtension ext;
+            ext.setKeyIdentifier(keyId(ski));
+            builder.addExtension(ext);
+        }
+        if (!aki.empty()) {
+            AuthorityKeyIdentifierExtension ext;
+            ext.setKeyIdentifier(keyId(aki));
+            builder.addExtension(ext);
+        }
+        return builder.sign(issuerKey, MessageDigest::SHA256);
+    }
+
+    static void push(std::vector<Certificate> &certificates, Certificate *cert) {
+        certificates.push_back(*cert);
+        delete cert;
+    }
+
+    static PrivateKey *privKey;
+    static PublicKey *pubKey;
+    static PrivateKey *otherPrivKey;
+    static PublicKey *otherPubKey;
+};
+
+PrivateKey *CertificateStoreTest::privKey = NULL;
+PublicKey *CertificateStoreTest::pubKey = NULL;
+PrivateKey *CertificateStoreTest::otherPrivKey = NULL;
+PublicKey *CertificateStoreTest::otherPubKey = NULL;
+
+/**
+ * @brief Consultas por titular, SKI, emissor e número de série e impressão digital
+ */
+TEST_F(CertificateStoreTest, Lookup) {
+    CertificateStore store;
+    Certificate *root = issue("Root", "Root", 1, "root", "", *pubKey, *privKey);
+    Certificate *ca = issue("CA", "Root", 2, "ca", "root", *pubKey, *privKey);
+    Certificate *leaf = issue("Leaf", "CA", 2, "", "ca", *otherPubKey, *privKey);
+    std::vector<Certificate *> found;
+
+    ASSERT_TRUE(store.add(*root));
+    ASSERT_TRUE(store.add(*ca));
+    ASSERT_TRUE(store.add(*leaf));
+    ASSERT_FALSE(store.add(*ca));
+    ASSERT_EQ(store.size(), 3u);
+
+    found = store.getBySubject(name(" ca "));
+    ASSERT_EQ(found.size(), 1u);
+    ASSERT_TRUE(*found[0] == *ca);
+
+    found = store.getBySubjectKeyIdentifier(keyId("root"));
+    ASSERT_EQ(found.size(), 1u);
+    ASSERT_TRUE(*found[0] == *root);
+    ASSERT_TRUE(store.getBySubjectKeyIdentifier(keyId("leaf")).empty());
+
+    ASSERT_TRUE(*store.getByIssuerAndSerialNumber(name("Root"), BigInteger(2)) == *ca);
+    ASSERT_TRUE(*store.getByIssuerAndSerialNumber(name("CA"), BigInteger(2)) == *leaf);
+    ASSERT_TRUE(store.getByIssuerAndSerialNumber(name("CA"), BigInteger(1)) == NULL);
+
+    ASSERT_TRUE(*store.getByFingerPrint(leaf->getFingerPrint(MessageDigest::SHA256)) == *leaf);
+    ASSERT_TRUE(store.getByFingerPrint(leaf->getFingerPrint(MessageDigest::SHA1)) == NULL);
+    ASSERT_TRUE(store.contains(*root));
+
+    delete root;
+    delete ca;
+    delete leaf;
+}
+
+/**
+ * @brief Emissores são escolhidos pelo AKI entre certificados de mesmo nome; sem AKI, pelo nome
+ */
+TEST_F(CertificateStoreTest, Issuers) {
+    CertificateStore store;
+    std::vector<Certificate> certificates;
+    std::vector<Certificate *> issuers;
+    Certificate *leaf, *noKeyId, *unknown;
+
+    push(certificates, issue("CA", "Root", 1, "ca-1", "root", *pubKey, *privKey));
+    push(certificates, issue("CA", "Root", 2, "ca-2", "root", *otherPubKey, *privKey));
+    push(certificates, issue("Other CA", "Root", 3, "ca-1", "root", *pubKey, *privKey));
+    ASSERT_EQ(store.add(certificates), 3u);
+
+    leaf = issue("Leaf", "CA", 1, "", "ca-2", *pubKey, *otherPrivKey);
+    issuers = store.getIssuers(*leaf);
+    ASSERT_EQ(issuers.size(), 1u);
+    ASSERT_TRUE(*issuers[0] == certificates[1]);
+
+    noKeyId = issue("Leaf", "CA", 2, "", "", *pubKey, *otherPrivKey);
+    ASSERT_EQ(store.getIssuers(*noKeyId).size(), 2u);
+
+    unknown = issue("Leaf", "CA", 3, "", "ca-3", *pubKey, *otherPrivKey);
+    ASSERT_EQ(store.getIssuers(*unknown).size(), 2u);
+
+    delete leaf;
+    delete noKeyId;
+    delete unknown;
+}
+
+/**
+ * @brief Consultas concorrentes com inserções em lote que fazem as tabelas crescerem
+ */
+TEST_F(CertificateStoreTest, ConcurrentReads) {
+    const unsigned int total = 600, batch = 50;
+    CertificateStore store;
+    std::vector<Certificate> certificates;
+    std::vector<ByteArray> fingerPrints;
+    std::vector<std::thread> readers;
+    std::atomic<bool> done(false);
+    std::atomic<unsigned int> errors(0);
+
+    for (unsigned int i = 0; i < total; i++) {
+        Certificate *cert = issue("Leaf " + std::to_string(i), "CA", i + 1, "leaf-" + std::to_string(i), "ca",
+                *pubKey, *privKey);
+        certificates.push_back(*cert);
+        fingerPrints.push_back(cert->getFingerPrint(MessageDigest::SHA256));
+        delete cert;
+    }
+
+    for (int t = 0; t < 4; t++) {
+        readers.push_back(std::thread([&, t]() {
+            while (!done) {
+                for (unsigned int i = t; i < total; i += 4) {
+                    Certificate *found = store.getByFingerPrint(fingerPrints[i]);
+                    std::vector<Certificate *> bySubject = store.getBySubject(name("Leaf " + std::to_string(i)));
+                    if ((found != NULL && found->getFingerPrint(MessageDigest::SHA256) != fingerPrints[i]) ||
+                            bySubject.size() > 1 ||
+                            (bySubject.size() == 1 && bySubject[0]->getFingerPrint(MessageDigest::SHA256) != fingerPrints[i])) {
+                        errors++;
+                    }
+                }
+            }
+        }));
+    }
+    for (unsigned int i = 0; i < total; i += batch) {
+        std::vector<Certificate> slice(certificates.begin() + i, certificates.begin() + i + batch);
+        EXPECT_EQ(store.add(slice), batch);
+    }
+    done = true;
+    for (unsigned int t = 0; t < readers.size(); t++) {
+        readers[t].join();
+    }
+
+    ASSERT_EQ(errors, 0u);
+    ASSERT_EQ(store.size(), total);
+    ASSERT_EQ(store.getCertificates().size(), total);
+    for (unsigned int i = 0; i < total; i++) {
+        ASSERT_TRUE(store.getByFingerPrint(fingerPrints[i]) != NULL);
+        ASSERT_EQ(store.getBySubjectKeyIdentifier(keyId("leaf-" + std::to_string(i))).size(), 1u);
+        ASSERT_TRUE(store.getByIssuerAndSerialNumber(name("CA"), BigInteger((long) i + 1)) != NULL);
+    }
+}
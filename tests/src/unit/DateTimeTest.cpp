@@ -292,3 +292,91 @@ TEST_F(DateTimeTest, getMonthSize) {
     ASSERT_EQ(DateTime::getMonthSize(DateTimeTest::month ,DateTimeTest::leapYear), 29);
     ASSERT_EQ(DateTime::getMonthSize(DateTimeTest::month, DateTimeTest::year), 28);
 }
+
+/**
+ * @brief Tests direct parsing of UTCTime and GeneralizedTime bytes into epoch
+ */
+TEST_F(DateTimeTest, Time2Epoch) {
+    time_t epoch;
+    long nanoseconds;
+    std::string utc = "170223224507Z";
+    std::string gt = "20170223224507.25Z";
+    std::string offset = "20170224014507+0300";
+    std::string noSeconds = "1702232245Z";
+    std::string pre1970 = "650101000000Z";
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) utc.data(), utc.size(), false, epoch, nanoseconds));
+    ASSERT_EQ(epoch, DateTimeTest::epoch);
+    ASSERT_EQ(nanoseconds, 0);
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) gt.data(), gt.size(), true, epoch, nanoseconds));
+    ASSERT_EQ(epoch, DateTimeTest::epoch);
+    ASSERT_EQ(nanoseconds, 250000000);
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) offset.data(), offset.size(), true, epoch, nanoseconds));
+    ASSERT_EQ(epoch, DateTimeTest::epoch);
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) noSeconds.data(), noSeconds.size(), false, epoch, nanoseconds));
+    ASSERT_EQ(epoch, DateTimeTest::epoch - DateTimeTest::sec);
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) pre1970.data(), pre1970.size(), false, epoch, nanoseconds));
+    ASSERT_EQ(epoch, -157766400);
+}
+
+/**
+ * @brief Tests fractions of hour and minute in GeneralizedTime and the fraction kept by DateTime
+ */
+TEST_F(DateTimeTest, Time2EpochFraction) {
+    time_t epoch;
+    long nanoseconds;
+    std::string hourFraction = "2017022322.75Z";
+    std::string minuteFraction = "201702232245.125Z";
+    std::string secondFraction = "20170223224507.5Z";
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) hourFraction.data(), hourFraction.size(), true, epoch, nanoseconds));
+    ASSERT_EQ(epoch, DateTimeTest::epoch - DateTimeTest::sec);
+    ASSERT_EQ(nanoseconds, 0);
+
+    ASSERT_TRUE(DateTime::time2epoch((const unsigned char*) minuteFraction.data(), minuteFraction.size(), true, epoch, nanoseconds));
+    ASSERT_EQ(epoch, DateTimeTest::epoch);
+    ASSERT_EQ(nanoseconds, 500000000);
+
+    ASN1_TIME *asn1 = ASN1_GENERALIZEDTIME_new();
+    ASN1_STRING_set(asn1, secondFraction.data(), secondFraction.size());
+    DateTime fromAsn1(asn1);
+    DateTime fromString(secondFraction);
+    DateTime whole(DateTimeTest::epoch);
+    ASN1_TIME_free(asn1);
+
+    ASSERT_EQ(fromAsn1.getSeconds(), DateTimeTest::epoch);
+    ASSERT_EQ(fromAsn1.getNanoseconds(), 500000000);
+    ASSERT_TRUE(fromAsn1 == fromString);
+    ASSERT_FALSE(fromAsn1 == whole);
+    ASSERT_FALSE(fromAsn1 == DateTimeTest::epoch);
+    ASSERT_TRUE(fromAsn1 > whole);
+    ASSERT_TRUE(whole < fromAsn1);
+    ASSERT_TRUE(fromAsn1 > DateTimeTest::epoch);
+
+    whole = fromAsn1;
+    ASSERT_EQ(whole.getNanoseconds(), 500000000);
+    whole.setDateTime(DateTimeTest::epoch);
+    ASSERT_EQ(whole.getNanoseconds(), 0);
+}
+
+/**
+ * @brief Tests that malformed time strings are rejected by the direct parser
+ */
+TEST_F(DateTimeTest, Time2EpochInvalid) {
+    time_t epoch;
+    long nanoseconds;
+    std::string badMonth = "171323224507Z";
+    std::string badDay = "170230224507Z";
+    std::string noZone = "170223224507";
+    std::string trailing = "170223224507Zx";
+
+    ASSERT_FALSE(DateTime::time2epoch((const unsigned char*) badMonth.data(), badMonth.size(), false, epoch, nanoseconds));
+    ASSERT_FALSE(DateTime::time2epoch((const unsigned char*) badDay.data(), badDay.size(), false, epoch, nanoseconds));
+    ASSERT_FALSE(DateTime::time2epoch((const unsigned char*) noZone.data(), noZone.size(), false, epoch, nanoseconds));
+    ASSERT_FALSE(DateTime::time2epoch((const unsigned char*) trailing.data(), trailing.size(), false, epoch, nanoseconds));
+    ASSERT_FALSE(DateTime::time2epoch(NULL, 0, true, epoch, nanoseconds));
+}
@@ -0,0 +1,108 @@
+#include <libcryptosec/FileDigest.h>
+
+#include <fstream>
+#include <sstream>
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários da classe FileDigest
+ */
+class FileDigestTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+        std::ostringstream buffer;
+
+        buffer << file.rdbuf();
+        content = ByteArray(buffer.str());
+    }
+
+    /*
+     * Resumo em árvore calculado diretamente a partir da definição do formato.
+     */
+    ByteArray treeDigest(MessageDigest::Algorithm algorithm, ByteArray &data, unsigned int chunkSize) {
+        std::vector<ByteArray> level;
+        MessageDigest md;
+
+        for (unsigned int offset = 0; offset < data.size() || level.empty(); offset += chunkSize) {
+            unsigned int length = std::min(chunkSize, data.size() - offset);
+            ByteArray node(length + 1);
+            node[0] = 0x00;
+            memcpy(node.getDataPointer() + 1, data.getDataPointer() + offset, length);
+            md.init(algorithm);
+            level.push_back(md.doFinal(node));
+        }
+
+        while (level.size() > 1) {
+            std::vector<ByteArray> next;
+            for (unsigned int i = 0; i + 1 < level.size(); i += 2) {
+                ByteArray prefix(1);
+                prefix[0] = 0x01;
+                md.init(algorithm);
+                md.update(prefix);
+                md.update(level[i]);
+                next.push_back(md.doFinal(level[i + 1]));
+            }
+            if (level.size() % 2) {
+                next.push_back(level.back());
+            }
+            level = next;
+        }
+
+        return level[0];
+    }
+
+    ByteArray content;
+    static std::string path;
+};
+
+std::string FileDigestTest::path = "files/binaryFile";
+
+/**
+ * @brief Tests that the standard mode matches MessageDigest for files and streams
+ */
+TEST_F(FileDigestTest, Standard) {
+    MessageDigest md(MessageDigest::SHA256);
+    ByteArray expected = md.doFinal(content);
+    FileDigest digest(MessageDigest::SHA256, FileDigest::STANDARD, NULL, 4096);
+    std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+
+    ASSERT_EQ(digest.digestFile(path), expected);
+    ASSERT_EQ(digest.digestStream(stream), expected);
+}
+
+/**
+ * @brief Tests the tree mode against the documented format, serial and parallel
+ */
+TEST_F(FileDigestTest, Tree) {
+    ThreadPool pool(4);
+    ByteArray expected = treeDigest(MessageDigest::SHA256, content, 65536);
+    FileDigest serial(MessageDigest::SHA256, FileDigest::TREE, NULL, 65536);
+    FileDigest parallel(MessageDigest::SHA256, FileDigest::TREE, &pool, 65536);
+    std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+
+    ASSERT_EQ(serial.digestFile(path), expected);
+    ASSERT_EQ(parallel.digestFile(path), expected);
+    ASSERT_EQ(parallel.digestStream(stream), expected);
+}
+
+/**
+ * @brief Tests the tree mode over empty content
+ */
+TEST_F(FileDigestTest, TreeEmpty) {
+    ByteArray empty;
+    std::istringstream stream("");
+    FileDigest digest(MessageDigest::SHA256, FileDigest::TREE);
+
+    ASSERT_EQ(digest.digestStream(stream), treeDigest(MessageDigest::SHA256, empty, 1024));
+}
+
+/**
+ * @brief Tests error reporting for missing files
+ */
+TEST_F(FileDigestTest, MissingFile) {
+    FileDigest digest(MessageDigest::SHA256);
+
+    ASSERT_THROW(digest.digestFile("files/doesNotExist"), MessageDigestException);
+}
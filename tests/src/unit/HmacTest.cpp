@@ -228,3 +228,61 @@ TEST_F(HmacTest, HmacDoFinalTwice) {
 	hmac->doFinal("");
 	EXPECT_THROW(hmac->doFinal(), InvalidStateException);
 }
+
+/**
+ * @brief Testa reinicialização do Hmac com reset(), reaproveitando a chave já processada.
+ */
+TEST_F(HmacTest, HmacResetReusesKey) {
+	hmac->init(HmacTest::key30bytes, MessageDigest::SHA256);
+	hmac->doFinal(HmacTest::plainTexts[0]);
+	hmac->reset();
+	EXPECT_STRCASEEQ("47460fd58266a86d9fe2e9c902ca0c97c58306d3de53fc0596c2df7f251e4d2d",
+			hmac->doFinal(HmacTest::plainTexts[0]).toHex().c_str());
+
+	hmac->reset();
+	hmac->update("garbage");
+	hmac->reset();
+	EXPECT_STRCASEEQ("47460fd58266a86d9fe2e9c902ca0c97c58306d3de53fc0596c2df7f251e4d2d",
+			hmac->doFinal(HmacTest::plainTexts[0]).toHex().c_str());
+}
+
+/**
+ * @brief Testa cópia de um Hmac com chave carregada e conteúdo parcial.
+ */
+TEST_F(HmacTest, HmacCopy) {
+	ByteArray plain("plain");
+	ByteArray text("Text");
+
+	hmac->init(HmacTest::key30bytes, MessageDigest::SHA256);
+	hmac->update(plain);
+
+	Hmac copy(*hmac);
+	EXPECT_STRCASEEQ("47460fd58266a86d9fe2e9c902ca0c97c58306d3de53fc0596c2df7f251e4d2d",
+			copy.doFinal(text).toHex().c_str());
+	EXPECT_STRCASEEQ("47460fd58266a86d9fe2e9c902ca0c97c58306d3de53fc0596c2df7f251e4d2d",
+			hmac->doFinal(text).toHex().c_str());
+}
+
+/**
+ * @brief Testa geração do Hmac em buffer do chamador através do .finalInto().
+ */
+TEST_F(HmacTest, HmacFinalInto) {
+	unsigned char buffer[EVP_MAX_MD_SIZE];
+	unsigned int size;
+
+	hmac->init(HmacTest::key30bytes, MessageDigest::SHA256);
+	EXPECT_EQ(hmac->getSize(), 32u);
+	hmac->update(HmacTest::plainTexts[0]);
+	EXPECT_THROW(hmac->finalInto(buffer, 16), HmacException);
+	size = hmac->finalInto(buffer, sizeof(buffer));
+	EXPECT_STRCASEEQ("47460fd58266a86d9fe2e9c902ca0c97c58306d3de53fc0596c2df7f251e4d2d",
+			ByteArray(buffer, size).toHex().c_str());
+	EXPECT_THROW(hmac->finalInto(buffer, sizeof(buffer)), InvalidStateException);
+}
+
+/**
+ * @brief Testa reset() sem inicialização prévia.
+ */
+TEST_F(HmacTest, HmacResetWithoutInit) {
+	EXPECT_THROW(hmac->reset(), InvalidStateException);
+}
@@ -191,3 +191,98 @@ TEST_F(MessageDigestTest, DoFinalByteArray) {
     testDoFinalByteArray(MessageDigest::SHA256, byteArray);
     ASSERT_EQ(ba->toHex(), MessageDigestTest::digestUpdate);
 }
+
+/**
+ * @brief Tests batch digest of independent inputs into a contiguous buffer
+ */
+TEST_F(MessageDigestTest, DoFinalBatch) {
+    std::vector<ByteArray> inputs;
+    ByteArray digests;
+    ThreadPool pool(4);
+
+    for (int i = 0; i < 1000; i++) {
+        std::ostringstream stream;
+        stream << data << i;
+        inputs.push_back(ByteArray(stream.str()));
+    }
+
+    digests = MessageDigest::doFinal(MessageDigest::SHA256, inputs);
+    ASSERT_EQ(digests.size(), 1000u * 32u);
+    ASSERT_EQ(MessageDigest::doFinal(MessageDigest::SHA256, inputs, &pool), digests);
+
+    for (unsigned int i = 0; i < inputs.size(); i += 111) {
+        testDigestByteArray(MessageDigest::SHA256, inputs[i]);
+        ASSERT_EQ(ByteArray(digests.getDataPointer() + i * 32, 32), *ba);
+    }
+}
+
+/**
+ * @brief Tests digest sizes reported for each algorithm
+ */
+TEST_F(MessageDigestTest, DigestSize) {
+    ASSERT_EQ(MessageDigest::getDigestSize(MessageDigest::MD5), 16u);
+    ASSERT_EQ(MessageDigest::getDigestSize(MessageDigest::SHA1), 20u);
+    ASSERT_EQ(MessageDigest::getDigestSize(MessageDigest::SHA256), 32u);
+    ASSERT_EQ(MessageDigest::getDigestSize(MessageDigest::SHA512), 64u);
+}
+
+/**
+ * @brief Tests forking an in-progress digest through the copy constructor and assignment
+ */
+TEST_F(MessageDigestTest, Copy) {
+    MessageDigest prefix(MessageDigest::SHA256);
+    prefix.update(data);
+
+    MessageDigest fork(prefix);
+    MessageDigest other;
+    other = prefix;
+
+    ASSERT_EQ(fork.doFinal(diffData).toHex(), MessageDigestTest::digestUpdate);
+    ASSERT_EQ(prefix.doFinal().toHex(), MessageDigestTest::digestSHA256);
+    ASSERT_EQ(other.doFinal(diffData).toHex(), MessageDigestTest::digestUpdate);
+}
+
+/**
+ * @brief Tests exporting and restoring midstates for every supported algorithm
+ */
+TEST_F(MessageDigestTest, Midstate) {
+    MessageDigest::Algorithm algorithms[] = {MessageDigest::MD5, MessageDigest::SHA1, MessageDigest::SHA224,
+            MessageDigest::SHA256, MessageDigest::SHA384, MessageDigest::SHA512};
+
+    for (unsigned int i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++) {
+        MessageDigest exportable;
+        MessageDigest restored;
+        ByteArray midstate;
+
+        testUpdateString(algorithms[i], diffData);
+        ByteArray expected = *ba;
+
+        exportable.init(algorithms[i], true);
+        exportable.update(data);
+        midstate = exportable.getMidstate();
+
+        restored.setMidstate(midstate);
+        ASSERT_EQ(restored.getMidstate(), midstate);
+        ASSERT_EQ(restored.doFinal(diffData), expected);
+        ASSERT_EQ(exportable.doFinal(diffData), expected);
+    }
+}
+
+/**
+ * @brief Tests midstate error handling
+ */
+TEST_F(MessageDigestTest, InvalidMidstate) {
+    ByteArray midstate;
+    ByteArray garbage("garbage");
+
+    md->init(MessageDigest::SHA256);
+    ASSERT_THROW(md->getMidstate(), InvalidStateException);
+    ASSERT_THROW(md->init(MessageDigest::Identity, true), MessageDigestException);
+    ASSERT_THROW(md->setMidstate(garbage), MessageDigestException);
+
+    md->init(MessageDigest::SHA256, true);
+    md->update(data);
+    midstate = md->getMidstate();
+    ByteArray truncated(midstate.getDataPointer(), midstate.size() - 1);
+    ASSERT_THROW(md->setMidstate(truncated), MessageDigestException);
+}
@@ -141,3 +141,40 @@ TEST_F(ObjectIdentifierFactoryTest, ThrowFromCreate) {
   testThrowFromCreate();
 }
 
+
+/**
+ * @brief OIDs registrados são compartilhados entre chamadas e cópias
+ */
+TEST_F(ObjectIdentifierFactoryTest, Registered) {
+  ObjectIdentifier first = ObjectIdentifierFactory::getObjectIdentifier("1.3.6.1.4.1.99999.45.1");
+  ObjectIdentifier second = ObjectIdentifierFactory::getObjectIdentifier("1.3.6.1.4.1.99999.45.1");
+  ObjectIdentifier copy(first);
+  ObjectIdentifier assigned;
+
+  assigned = second;
+  ASSERT_EQ(first.getObjectIdentifier(), second.getObjectIdentifier());
+  ASSERT_EQ(copy.getObjectIdentifier(), first.getObjectIdentifier());
+  ASSERT_EQ(assigned.getObjectIdentifier(), first.getObjectIdentifier());
+  ASSERT_EQ(assigned.getOid(), "1.3.6.1.4.1.99999.45.1");
+  ASSERT_TRUE(first == second);
+  ASSERT_TRUE(genFromString() == genFromNid());
+  ASSERT_TRUE(first != genFromString());
+}
+
+/**
+ * @brief OIDs lidos de estruturas do OpenSSL: conhecidos são compartilhados, os demais copiados
+ */
+TEST_F(ObjectIdentifierFactoryTest, FromAsn1Object) {
+  ASN1_OBJECT *known = OBJ_txt2obj(oid.c_str(), 1);
+  ASN1_OBJECT *unknown = OBJ_txt2obj("1.3.6.1.4.1.99999.45.2", 1);
+  ObjectIdentifier fromKnown = ObjectIdentifierFactory::getObjectIdentifier(known);
+  ObjectIdentifier fromUnknown = ObjectIdentifierFactory::getObjectIdentifier(unknown);
+
+  ASSERT_EQ(fromKnown.getObjectIdentifier(), genFromNid().getObjectIdentifier());
+  ASSERT_NE(fromUnknown.getObjectIdentifier(), unknown);
+  ASN1_OBJECT_free(known);
+  ASN1_OBJECT_free(unknown);
+  testObjectIdentifier(fromKnown);
+  ASSERT_EQ(fromUnknown.getOid(), "1.3.6.1.4.1.99999.45.2");
+  ASSERT_EQ(ObjectIdentifierFactory::getObjectIdentifier((const ASN1_OBJECT *) NULL).getName(), "undefined");
+}
@@ -93,4 +93,142 @@ TEST_F(Pkcs12Test, Pkcs12Factory) {
  */
 TEST_F(Pkcs12Test, Pkcs12) {
     testPkcs12();
-}
\ No newline at end of file
+}
+/**
+ * @brief Tests if the parsed contents are reused for the same password and
+ * if a wrong password is still rejected after a successful parse
+ */
+TEST_F(Pkcs12Test, ParseCache) {
+    startUp();
+    Pkcs12Builder pkcs12Builder;
+    pkcs12Builder.setKeyAndCertificate(privKey, cert);
+    pkcs12 = pkcs12Builder.doFinal(password);
+
+    Certificate *first = pkcs12->getCertificate(password);
+    PrivateKey *key = pkcs12->getPrivKey(password);
+
+    ASSERT_THROW(pkcs12->getCertificate("wrong"), Pkcs12Exception);
+    Certificate *second = pkcs12->getCertificate(password);
+
+    ASSERT_EQ(first->getPemEncoded(), second->getPemEncoded());
+    ASSERT_EQ(key->getPemEncoded(), privKey->getPemEncoded());
+    delete first;
+    delete second;
+    delete key;
+    delete pkcs12;
+}
+
+/**
+ * @brief Tests if Pkcs12Builder applies the requested PBE algorithms, iteration counts and MAC
+ */
+TEST_F(Pkcs12Test, Pkcs12BuilderParameters) {
+    startUp();
+    Pkcs12Builder pkcs12Builder;
+    pkcs12Builder.setKeyAndCertificate(privKey, cert);
+    pkcs12 = pkcs12Builder.doFinal(password, Pkcs12Builder::PBES2_AES_256_CBC, Pkcs12Builder::PBE_SHA1_3DES,
+            10000, MessageDigest::SHA512, 5000);
+
+    ByteArray der = pkcs12->getDerEncoded();
+    const unsigned char *data = der.getDataPointer();
+    PKCS12 *p12 = d2i_PKCS12(NULL, &data, der.size());
+    const X509_ALGOR *macAlgorithm = NULL;
+    const ASN1_INTEGER *macIterations = NULL;
+    const ASN1_OBJECT *macOid = NULL;
+
+    PKCS12_get0_mac(NULL, &macAlgorithm, NULL, &macIterations, p12);
+    X509_ALGOR_get0(&macOid, NULL, NULL, macAlgorithm);
+    ASSERT_EQ(OBJ_obj2nid(macOid), NID_sha512);
+    ASSERT_EQ(ASN1_INTEGER_get(macIterations), 5000);
+    PKCS12_free(p12);
+
+    PrivateKey *key = pkcs12->getPrivKey(password);
+    ASSERT_EQ(key->getPemEncoded(), privKey->getPemEncoded());
+    delete key;
+    delete pkcs12;
+
+    pkcs12 = pkcs12Builder.doFinal(password, Pkcs12Builder::NO_ENCRYPTION, Pkcs12Builder::NO_ENCRYPTION, 1);
+    Certificate *pkcs12Cert = pkcs12->getCertificate(password);
+    ASSERT_EQ(pkcs12Cert->getPemEncoded(), cert->getPemEncoded());
+    delete pkcs12Cert;
+    delete pkcs12;
+}
+
+/**
+ * @brief Sink that keeps the packages generated in batch
+ */
+class Pkcs12TestSink : public Pkcs12Builder::Sink {
+public:
+    virtual void write(unsigned int index, ByteArray &der) {
+        indexes.push_back(index);
+        packages.push_back(der);
+    }
+
+    virtual void fail(unsigned int index, Pkcs12Exception &exception) {
+        failures.push_back(index);
+    }
+
+    std::vector<unsigned int> indexes;
+    std::vector<ByteArray> packages;
+    std::vector<unsigned int> failures;
+};
+
+/**
+ * @brief Sink that only counts the packages, stopping the batch on failures
+ */
+class Pkcs12TestDefaultSink : public Pkcs12Builder::Sink {
+public:
+    Pkcs12TestDefaultSink() : written(0) {
+    }
+
+    virtual void write(unsigned int index, ByteArray &der) {
+        written++;
+    }
+
+    unsigned int written;
+};
+
+/**
+ * @brief Tests if Pkcs12Builder generates packages in batch, in order and with the common chain
+ */
+TEST_F(Pkcs12Test, Pkcs12BuilderBatch) {
+    startUp();
+    ThreadPool pool(4);
+    RSAKeyPair otherKeyPair(2048);
+    PrivateKey *otherKey = otherKeyPair.getPrivateKey();
+    Pkcs12Builder pkcs12Builder;
+    std::vector<Pkcs12Builder::Entry> entries;
+    Pkcs12TestSink sink;
+
+    for (unsigned int i = 0; i < 10; i++) {
+        std::ostringstream entryPassword;
+        entryPassword << password << i;
+        entries.push_back(Pkcs12Builder::Entry(privKey, cert, entryPassword.str(), "device"));
+    }
+    entries.at(7).key = otherKey;
+    pkcs12Builder.addAdditionalCert(cert);
+    pkcs12Builder.setThreadPool(&pool);
+    pkcs12Builder.doFinal(entries, &sink, Pkcs12Builder::PBES2_AES_256_CBC, Pkcs12Builder::PBES2_AES_128_CBC, 1000);
+
+    ASSERT_EQ(sink.packages.size(), 9u);
+    ASSERT_EQ(sink.failures, std::vector<unsigned int>(1, 7));
+    for (unsigned int i = 0; i < sink.packages.size(); i++) {
+        unsigned int index = sink.indexes.at(i);
+        Pkcs12 *batchPkcs12 = Pkcs12Factory::fromDerEncoded(sink.packages.at(i));
+        PrivateKey *key = batchPkcs12->getPrivKey(entries.at(index).password);
+        std::vector<Certificate *> chain = batchPkcs12->getAdditionalCertificates(entries.at(index).password);
+
+        ASSERT_EQ(index, i < 7 ? i : i + 1);
+        ASSERT_EQ(key->getPemEncoded(), privKey->getPemEncoded());
+        ASSERT_EQ(chain.size(), 1u);
+        ASSERT_EQ(chain.at(0)->getPemEncoded(), cert->getPemEncoded());
+        delete chain.at(0);
+        delete key;
+        delete batchPkcs12;
+    }
+
+    Pkcs12TestDefaultSink defaultSink;
+    pkcs12Builder.setThreadPool(NULL);
+    ASSERT_THROW(pkcs12Builder.doFinal(entries, &defaultSink), Pkcs12Exception);
+    ASSERT_EQ(defaultSink.written, 7u);
+    delete otherKey;
+}
@@ -0,0 +1,336 @@
+#include <libcryptosec/Pkcs7SignedDataBuilder.h>
+#include <libcryptosec/Pkcs7EnvelopedDataBuilder.h>
+#include <libcryptosec/Pkcs7Factory.h>
+#include <libcryptosec/RSAKeyPair.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários das classes Pkcs7Builder, Pkcs7SignedDataBuilder e Pkcs7SignedData
+ */
+class Pkcs7Test : public ::testing::Test {
+
+protected:
+    static void SetUpTestCase() {
+        RSAKeyPair keyPair(2048);
+        privKey = keyPair.getPrivateKey();
+
+        RDNSequence name;
+        name.addEntry(RDNSequence::COMMON_NAME, "Pkcs7Test");
+
+        CertificateBuilder certBuilder;
+        certBuilder.setPublicKey(*keyPair.getPublicKey());
+        certBuilder.setIssuer(name);
+        certBuilder.setSubject(name);
+        certBuilder.setSerialNumber(1);
+        cert = certBuilder.sign(*privKey, MessageDigest::SHA256);
+
+        RSAKeyPair otherKeyPair(2048);
+        otherPrivKey = otherKeyPair.getPrivateKey();
+
+        CertificateBuilder otherCertBuilder;
+        otherCertBuilder.setPublicKey(*otherKeyPair.getPublicKey());
+        otherCertBuilder.setIssuer(name);
+        otherCertBuilder.setSubject(name);
+        otherCertBuilder.setSerialNumber(2);
+        otherCert = otherCertBuilder.sign(*otherPrivKey, MessageDigest::SHA256);
+
+        for (unsigned int i = 0; i < 300000; i++) {
+            content += (char) (i * 31 + (i >> 8));
+        }
+    }
+
+    static void TearDownTestCase() {
+        delete privKey;
+        delete cert;
+        delete otherPrivKey;
+        delete otherCert;
+    }
+
+    std::string sign(Pkcs7Builder::Encoding encoding, bool attached) {
+        Pkcs7SignedDataBuilder builder(MessageDigest::SHA256, *cert, *privKey, attached);
+        std::istringstream in(content);
+        std::ostringstream out;
+
+        builder.doFinal(&in, &out, encoding, 4096);
+        return out.str();
+    }
+
+    Pkcs7SignedData* signDetached() {
+        ByteArray der(sign(Pkcs7Builder::DER, false));
+        return dynamic_cast<Pkcs7SignedData *>(Pkcs7Factory::fromDerEncoded(der));
+    }
+
+    std::string envelope(Pkcs7Builder::Encoding encoding) {
+        Pkcs7EnvelopedDataBuilder builder(*cert, SymmetricKey::AES_256, SymmetricCipher::CBC);
+        std::istringstream in(content);
+        std::ostringstream out;
+
+        builder.doFinal(&in, &out, encoding, 4096);
+        return out.str();
+    }
+
+    Pkcs7SignedData* signMultiple(ThreadPool *pool) {
+        Pkcs7SignedDataBuilder builder(MessageDigest::SHA256, *cert, *privKey, true);
+
+        builder.addSigner(MessageDigest::SHA512, *otherCert, *otherPrivKey);
+        builder.addSigner(MessageDigest::SHA256, *otherCert, *otherPrivKey);
+        builder.setThreadPool(pool);
+        return builder.doFinal(content);
+    }
+
+    static PrivateKey *privKey;
+    static Certificate *cert;
+    static PrivateKey *otherPrivKey;
+    static Certificate *otherCert;
+    static std::string content;
+};
+
+PrivateKey *Pkcs7Test::privKey = NULL;
+Certificate *Pkcs7Test::cert = NULL;
+PrivateKey *Pkcs7Test::otherPrivKey = NULL;
+Certificate *Pkcs7Test::otherCert = NULL;
+std::string Pkcs7Test::content;
+
+/**
+ * @brief Assinatura em stream com conteúdo anexado, codificada em BER
+ */
+TEST_F(Pkcs7Test, StreamAttachedBer) {
+    ByteArray ber(sign(Pkcs7Builder::BER, true));
+    Pkcs7SignedData *signedData = dynamic_cast<Pkcs7SignedData *>(Pkcs7Factory::fromDerEncoded(ber));
+    std::ostringstream extracted;
+
+    ASSERT_TRUE(signedData != NULL);
+    ASSERT_TRUE(signedData->verifyAndExtract(&extracted));
+    ASSERT_EQ(extracted.str(), content);
+    delete signedData;
+}
+
+/**
+ * @brief Assinatura em stream com conteúdo anexado, codificada em PEM
+ */
+TEST_F(Pkcs7Test, StreamAttachedPem) {
+    std::string pem = sign(Pkcs7Builder::PEM, true);
+    Pkcs7SignedData *signedData = dynamic_cast<Pkcs7SignedData *>(Pkcs7Factory::fromPemEncoded(pem));
+    std::ostringstream extracted;
+
+    ASSERT_TRUE(signedData != NULL);
+    ASSERT_TRUE(signedData->verifyAndExtract(&extracted));
+    ASSERT_EQ(extracted.str(), content);
+    delete signedData;
+}
+
+/**
+ * @brief Assinatura em stream sem conteúdo anexado: DER e PEM representam o mesmo pacote
+ */
+TEST_F(Pkcs7Test, StreamDetachedDer) {
+    ByteArray der(sign(Pkcs7Builder::DER, false));
+    std::string pem = sign(Pkcs7Builder::PEM, false);
+    Pkcs7 *fromPem = Pkcs7Factory::fromPemEncoded(pem);
+
+    ASSERT_LT(der.size(), content.size());
+    ASSERT_EQ(fromPem->getDerEncoded(), der);
+    delete fromPem;
+}
+
+/**
+ * @brief doFinal(std::istream*, std::ostream*) mantém o PEM com o pacote em DER; apenas a versão com
+ * Pkcs7Builder::Encoding escreve BER com comprimentos indefinidos
+ */
+TEST_F(Pkcs7Test, LegacyDoFinalPem) {
+    Pkcs7SignedDataBuilder signedBuilder(MessageDigest::SHA256, *cert, *privKey, true);
+    Pkcs7EnvelopedDataBuilder envelopedBuilder(*cert, SymmetricKey::AES_256, SymmetricCipher::CBC);
+    std::istringstream signedIn(content), envelopedIn(content);
+    std::ostringstream signedOut, envelopedOut, extracted;
+    std::string streamed = sign(Pkcs7Builder::PEM, true);
+
+    signedBuilder.doFinal(&signedIn, &signedOut);
+    std::string signedPem = signedOut.str();
+    Pkcs7SignedData *signedData = dynamic_cast<Pkcs7SignedData *>(Pkcs7Factory::fromPemEncoded(signedPem));
+    ASSERT_TRUE(signedData != NULL);
+    ASSERT_EQ(signedData->getPemEncoded(), signedPem);
+    ASSERT_TRUE(signedData->verifyAndExtract(&extracted));
+    ASSERT_EQ(extracted.str(), content);
+    delete signedData;
+
+    envelopedBuilder.doFinal(&envelopedIn, &envelopedOut);
+    std::string envelopedPem = envelopedOut.str();
+    Pkcs7 *envelopedData = Pkcs7Factory::fromPemEncoded(envelopedPem);
+    ASSERT_EQ(envelopedData->getPemEncoded(), envelopedPem);
+    delete envelopedData;
+
+    Pkcs7 *fromStream = Pkcs7Factory::fromPemEncoded(streamed);
+    ASSERT_NE(fromStream->getPemEncoded(), streamed);
+    delete fromStream;
+}
+
+/**
+ * @brief DER não pode ser escrito incrementalmente com conteúdo anexado
+ */
+TEST_F(Pkcs7Test, StreamAttachedDerInvalid) {
+    ASSERT_THROW(sign(Pkcs7Builder::DER, true), EncodeException);
+}
+
+/**
+ * @brief Verificação de assinatura destacada sobre stream, região de memória e arquivo
+ */
+TEST_F(Pkcs7Test, VerifyDetached) {
+    Pkcs7SignedData *signedData = signDetached();
+    std::istringstream in(content);
+    std::string path = "pkcs7_detached_content.tmp";
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+
+    file << content;
+    file.close();
+
+    ASSERT_TRUE(signedData->verifyDetached(&in));
+    ASSERT_TRUE(signedData->verifyDetached((const unsigned char *) content.data(), content.size()));
+    ASSERT_TRUE(signedData->verifyDetachedFile(path));
+    std::remove(path.c_str());
+    delete signedData;
+}
+
+/**
+ * @brief Conteúdo alterado ou ausente invalida a assinatura destacada
+ */
+TEST_F(Pkcs7Test, VerifyDetachedInvalid) {
+    Pkcs7SignedData *signedData = signDetached();
+    std::string tampered = content;
+    tampered[tampered.size() / 2] ^= 0x01;
+    std::istringstream in(tampered);
+
+    ASSERT_FALSE(signedData->verifyDetached(&in));
+    ASSERT_FALSE(signedData->verifyDetached((const unsigned char *) content.data(), content.size() - 1));
+    ASSERT_FALSE(signedData->verify());
+    ASSERT_THROW(signedData->verifyDetachedFile("pkcs7_missing_content.tmp"), Pkcs7Exception);
+    delete signedData;
+}
+
+/**
+ * @brief Assinaturas geradas em paralelo são idênticas às geradas sequencialmente
+ */
+TEST_F(Pkcs7Test, ParallelSigners) {
+    ThreadPool pool(4);
+    Pkcs7SignedData *serial = signMultiple(NULL);
+    Pkcs7SignedData *parallel = signMultiple(&pool);
+
+    ASSERT_TRUE(parallel->verify());
+    ASSERT_EQ(parallel->getDerEncoded(), serial->getDerEncoded());
+    delete serial;
+    delete parallel;
+}
+
+/**
+ * @brief Certificados dos signatários buscados no CertificateStore e entre os anexados ao pacote
+ */
+TEST_F(Pkcs7Test, SignersFromStore) {
+    Pkcs7SignedData *signedData = signMultiple(NULL);
+    CertificateStore store, empty;
+    std::vector<Certificate *> signers;
+
+    store.add(*otherCert);
+    signers = signedData->getSigners(store);
+    ASSERT_EQ(signers.size(), 3u);
+    ASSERT_TRUE(*signers[0] == *cert);
+    ASSERT_TRUE(*signers[1] == *otherCert);
+    ASSERT_TRUE(*signers[2] == *otherCert);
+    for (unsigned int i = 0; i < signers.size(); i++) {
+        delete signers[i];
+    }
+
+    signers = signedData->getSigners(empty);
+    ASSERT_EQ(signers.size(), 3u);
+    for (unsigned int i = 0; i < signers.size(); i++) {
+        ASSERT_TRUE(signers[i] != NULL);
+        delete signers[i];
+    }
+    delete signedData;
+}
+
+/**
+ * @brief Envelopagem e decifragem em stream
+ */
+TEST_F(Pkcs7Test, StreamEnveloped) {
+    std::istringstream in(envelope(Pkcs7Builder::BER));
+    std::ostringstream out;
+
+    Pkcs7EnvelopedData::decrypt(&in, *cert, *privKey, &out);
+    ASSERT_EQ(out.str(), content);
+}
+
+/**
+ * @brief Decifragem em stream de pacotes em DER e decifragem em memória de pacotes em BER
+ */
+TEST_F(Pkcs7Test, StreamEnvelopedDer) {
+    ByteArray ber(envelope(Pkcs7Builder::BER));
+    Pkcs7EnvelopedData *enveloped = dynamic_cast<Pkcs7EnvelopedData *>(Pkcs7Factory::fromDerEncoded(ber));
+    ByteArray der = enveloped->getDerEncoded();
+    std::istringstream in(std::string((const char *) der.getDataPointer(), der.size()));
+    std::ostringstream streamed, decrypted;
+
+    Pkcs7EnvelopedData::decrypt(&in, *cert, *privKey, &streamed);
+    enveloped->decrypt(*cert, *privKey, &decrypted);
+    ASSERT_EQ(streamed.str(), content);
+    ASSERT_EQ(decrypted.str(), content);
+    delete enveloped;
+}
+
+/**
+ * @brief Pacotes truncados ou de outro tipo não são decifrados
+ */
+TEST_F(Pkcs7Test, StreamEnvelopedInvalid) {
+    std::string enveloped = envelope(Pkcs7Builder::BER);
+    std::istringstream truncated(enveloped.substr(0, enveloped.size() / 2));
+    std::istringstream signedData(sign(Pkcs7Builder::BER, true));
+    std::ostringstream out;
+
+    ASSERT_THROW(Pkcs7EnvelopedData::decrypt(&truncated, *cert, *privKey, &out), Pkcs7Exception);
+    ASSERT_THROW(Pkcs7EnvelopedData::decrypt(&signedData, *cert, *privKey, &out), Pkcs7Exception);
+}
+
+/**
+ * @brief Cabeçalhos com aninhamento profundo ou maiores que o limite são rejeitados sem esgotar pilha ou memória
+ */
+TEST_F(Pkcs7Test, StreamEnvelopedNested) {
+    //contentInfo, [0], EnvelopedData e versão com comprimentos indefinidos, seguidos dos recipientInfos
+    std::string prefix("\x30\x80\x06\x09\x2a\x86\x48\x86\xf7\x0d\x01\x07\x03\xa0\x80\x30\x80\x02\x01\x00", 20);
+    std::string nested = prefix, wide = prefix + "\x31\x80";
+    std::ostringstream out;
+
+    for (unsigned int i = 0; i < 1000000; i++) {
+        nested += "\x31\x80";
+    }
+    for (unsigned int i = 0; i < 17; i++) {
+        wide += std::string("\x04\x83\x10\x00\x00", 5) + std::string(1 << 20, 'x');
+    }
+    std::istringstream nestedIn(nested), wideIn(wide);
+
+    ASSERT_THROW(Pkcs7EnvelopedData::decrypt(&nestedIn, *cert, *privKey, &out), Pkcs7Exception);
+    ASSERT_THROW(Pkcs7EnvelopedData::decrypt(&wideIn, *cert, *privKey, &out), Pkcs7Exception);
+}
+
+/**
+ * @brief Envelopagem com a chave de conteúdo cifrada em paralelo para vários destinatários
+ */
+TEST_F(Pkcs7Test, ParallelRecipients) {
+    ThreadPool pool(4);
+    Pkcs7EnvelopedDataBuilder builder(*cert, SymmetricKey::AES_256, SymmetricCipher::CBC);
+    Pkcs7EnvelopedData *enveloped;
+    std::ostringstream first, second;
+
+    for (int i = 0; i < 8; i++) {
+        builder.addCipher(i % 2 ? *cert : *otherCert);
+    }
+    builder.setThreadPool(&pool);
+    enveloped = builder.doFinal(content);
+
+    enveloped->decrypt(*cert, *privKey, &first);
+    enveloped->decrypt(*otherCert, *otherPrivKey, &second);
+    ASSERT_EQ(first.str(), content);
+    ASSERT_EQ(second.str(), content);
+    delete enveloped;
+}
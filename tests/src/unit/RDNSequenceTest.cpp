@@ -1,6 +1,7 @@
 #include <libcryptosec/certificate/RDNSequence.h>
 
 #include <sstream>
+#include <unordered_map>
 #include <gtest/gtest.h>
 
 
@@ -142,3 +143,136 @@ TEST_F(RDNSequenceTest, XMLEncoded) {
 TEST_F(RDNSequenceTest, Sanity) {
   testSanity();
 }
+
+/**
+ * @brief Comparação segundo a RFC 5280: maiúsculas e espaços não são significativos
+ */
+TEST_F(RDNSequenceTest, CanonicalEquality) {
+  RDNSequence name, folded, other, empty;
+
+  name.addEntry(RDNSequence::COUNTRY, "BR");
+  name.addEntry(RDNSequence::ORGANIZATION, "LabSEC UFSC");
+  name.addEntry(RDNSequence::COMMON_NAME, "Autoridade  Certificadora");
+  folded.addEntry(RDNSequence::COUNTRY, "br");
+  folded.addEntry(RDNSequence::ORGANIZATION, "  labsec\tufsc ");
+  folded.addEntry(RDNSequence::COMMON_NAME, "AUTORIDADE CERTIFICADORA");
+  other.addEntry(RDNSequence::ORGANIZATION, "LabSEC UFSC");
+  other.addEntry(RDNSequence::COUNTRY, "BR");
+  other.addEntry(RDNSequence::COMMON_NAME, "Autoridade Certificadora");
+
+  ASSERT_TRUE(name == folded);
+  ASSERT_EQ(name.getHash(), folded.getHash());
+  ASSERT_EQ(name.getCanonical(), folded.getCanonical());
+  ASSERT_TRUE(name != other);
+  ASSERT_TRUE(name != empty);
+  ASSERT_TRUE(empty == RDNSequence());
+  ASSERT_EQ(empty.getHash(), RDNSequence().getHash());
+}
+
+/**
+ * @brief Nomes lidos de um X509_NAME, copiados e atribuídos mantêm a forma canônica
+ */
+TEST_F(RDNSequenceTest, CanonicalFromX509Name) {
+  RDNSequence name = genRDNSequence();
+  X509_NAME *x509 = name.getX509Name();
+  RDNSequence parsed(x509);
+  RDNSequence copy(parsed);
+  RDNSequence assigned;
+
+  assigned = parsed;
+  ASSERT_TRUE(parsed == name);
+  ASSERT_TRUE(copy == name);
+  ASSERT_TRUE(assigned == name);
+  ASSERT_EQ(assigned.getHash(), name.getHash());
+
+  X509_NAME_add_entry_by_NID(x509, NID_commonName, V_ASN1_BMPSTRING, (unsigned char *) "\0a\0b", 4, -1, 0);
+  RDNSequence bmp(x509);
+  name.addEntry(RDNSequence::COMMON_NAME, "AB");
+  ASSERT_TRUE(bmp == name);
+  X509_NAME_free(x509);
+}
+
+/**
+ * @brief Um nome com valor UTF-8 adicionado por addEntry é igual ao próprio X509_NAME decodificado
+ */
+TEST_F(RDNSequenceTest, CanonicalUtf8RoundTrip) {
+  RDNSequence name;
+  name.addEntry(RDNSequence::COMMON_NAME, "S\xc3\xa3o Jos\xc3\xa9");
+  name.addEntry(RDNSequence::COUNTRY, "BR");
+  X509_NAME *x509 = name.getX509Name();
+  RDNSequence parsed(x509);
+
+  ASSERT_TRUE(parsed == name);
+  ASSERT_EQ(parsed.getHash(), name.getHash());
+  X509_NAME_free(x509);
+}
+
+/**
+ * @brief RDNs com vários valores: CN=a+O=b difere de CN=a,O=b, e a ordem dos valores de um RDN não é significativa
+ */
+TEST_F(RDNSequenceTest, CanonicalMultiValued) {
+  X509_NAME *multi = X509_NAME_new();
+  X509_NAME *reversed = X509_NAME_new();
+  X509_NAME *single = X509_NAME_new();
+
+  X509_NAME_add_entry_by_NID(multi, NID_commonName, MBSTRING_ASC, (unsigned char *) "a", -1, -1, 0);
+  X509_NAME_add_entry_by_NID(multi, NID_organizationName, MBSTRING_ASC, (unsigned char *) "b", -1, -1, -1);
+  X509_NAME_add_entry_by_NID(reversed, NID_organizationName, MBSTRING_ASC, (unsigned char *) "B", -1, -1, 0);
+  X509_NAME_add_entry_by_NID(reversed, NID_commonName, MBSTRING_ASC, (unsigned char *) "A", -1, -1, -1);
+  X509_NAME_add_entry_by_NID(single, NID_commonName, MBSTRING_ASC, (unsigned char *) "a", -1, -1, 0);
+  X509_NAME_add_entry_by_NID(single, NID_organizationName, MBSTRING_ASC, (unsigned char *) "b", -1, -1, 0);
+
+  RDNSequence multiName(multi), reversedName(reversed), singleName(single);
+  RDNSequence added;
+  added.addEntry(RDNSequence::COMMON_NAME, "a");
+  added.addEntry(RDNSequence::ORGANIZATION, "b");
+
+  ASSERT_EQ(X509_NAME_entry_count(multi), 2);
+  ASSERT_TRUE(multiName != singleName);
+  ASSERT_TRUE(multiName == reversedName);
+  ASSERT_EQ(multiName.getHash(), reversedName.getHash());
+  ASSERT_TRUE(singleName == added);
+  ASSERT_EQ(singleName.getHash(), added.getHash());
+
+  X509_NAME_free(multi);
+  X509_NAME_free(reversed);
+  X509_NAME_free(single);
+}
+
+/**
+ * @brief O hash acompanha as entradas adicionadas depois de calculado
+ */
+TEST_F(RDNSequenceTest, HashAfterAddEntry) {
+  RDNSequence name, other;
+
+  name.addEntry(RDNSequence::COMMON_NAME, "a");
+  other.addEntry(RDNSequence::COMMON_NAME, "a");
+  ASSERT_EQ(name.getHash(), other.getHash());
+  name.addEntry(RDNSequence::ORGANIZATION, "b");
+  ASSERT_TRUE(name != other);
+  ASSERT_NE(name.getHash(), other.getHash());
+  other.addEntry(RDNSequence::ORGANIZATION, "B");
+  ASSERT_EQ(name.getHash(), other.getHash());
+}
+
+/**
+ * @brief Uso como chave de std::unordered_map
+ */
+TEST_F(RDNSequenceTest, UnorderedMap) {
+  std::unordered_map<RDNSequence, int> names;
+  std::unordered_map<RDNSequence, int, RDNSequence::Hash> explicitHash;
+
+  for (int i = 0; i < 100; i++) {
+    RDNSequence name;
+    name.addEntry(RDNSequence::COMMON_NAME, "Name " + std::to_string(i));
+    names[name] = i;
+    explicitHash[name] = i;
+  }
+  for (int i = 0; i < 100; i++) {
+    RDNSequence name;
+    name.addEntry(RDNSequence::COMMON_NAME, " NAME  " + std::to_string(i));
+    ASSERT_EQ(names.at(name), i);
+    ASSERT_EQ(explicitHash.at(name), i);
+  }
+  ASSERT_EQ(names.size(), 100);
+}
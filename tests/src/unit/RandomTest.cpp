@@ -3,7 +3,12 @@
 #include <openssl/rsa.h>
 #include <openssl/evp.h>
 #include <openssl/ossl_typ.h>
+#include <libcryptosec/ThreadPool.h>
+
+#include <set>
 #include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <gtest/gtest.h>
 
 class RandomTest: public ::testing::Test {
@@ -86,3 +91,118 @@ TEST_F(RandomTest, CleanSeedTest) {
 TEST_F(RandomTest, RandomStatusTest) {
   randomStatus();
 }
+
+/**
+ * @brief Preenchimento de regiões menores e maiores que o buffer da thread
+ */
+TEST_F(RandomTest, FillIntoTest) {
+  unsigned int sizes[] = {1, 12, 16, 4095, 4096, 4097, 100000};
+  std::set<std::string> seen;
+  for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    ByteArray first(sizes[i]), second(sizes[i]);
+    Random::fillInto(first);
+    Random::fillInto(second.getDataPointer(), second.size());
+    ASSERT_TRUE(first != second);
+    if (sizes[i] >= 16) {
+      ASSERT_TRUE(first != ByteArray(sizes[i]));
+    }
+  }
+  for (unsigned int i = 0; i < 1000; i++) {
+    ByteArray nonce(12);
+    Random::fillInto(nonce);
+    ASSERT_TRUE(seen.insert(nonce.toHex()).second);
+  }
+  Random::fillInto(NULL, 0);
+}
+
+/**
+ * @brief Threads com geradores próprios não repetem bytes
+ */
+TEST_F(RandomTest, ThreadsTest) {
+  class NonceTask : public ThreadPool::Task {
+  public:
+    void run() {
+      for (unsigned int i = 0; i < 500; i++) {
+        ByteArray nonce(16);
+        Random::fillInto(nonce);
+        nonces.push_back(nonce.toHex());
+      }
+    }
+    std::vector<std::string> nonces;
+  };
+  ThreadPool pool(4);
+  std::vector<NonceTask> tasks(8);
+  std::vector<ThreadPool::Task *> pointers;
+  std::set<std::string> seen;
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    pointers.push_back(&tasks[i]);
+  }
+  pool.execute(pointers);
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    ASSERT_EQ(tasks[i].nonces.size(), 500);
+    seen.insert(tasks[i].nonces.begin(), tasks[i].nonces.end());
+  }
+  ASSERT_EQ(seen.size(), 8 * 500);
+}
+
+/**
+ * @brief O processo filho não reutiliza os bytes em buffer do pai
+ */
+TEST_F(RandomTest, ForkTest) {
+  ByteArray parent(16), child(16);
+  int fds[2], status;
+  pid_t pid;
+
+  Random::fillInto(parent);
+  ASSERT_EQ(pipe(fds), 0);
+  pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    Random::fillInto(child);
+    _exit(write(fds[1], child.getDataPointer(), child.size()) == 16 ? 0 : 1);
+  }
+  Random::fillInto(parent);
+  ASSERT_EQ(read(fds[0], child.getDataPointer(), child.size()), 16);
+  waitpid(pid, &status, 0);
+  close(fds[0]);
+  close(fds[1]);
+  ASSERT_TRUE(parent != child);
+}
+
+/**
+ * @brief Renovação explícita e periódica da semente
+ */
+TEST_F(RandomTest, ReseedTest) {
+  ByteArray data(10000);
+  Random::setReseedInterval(4096);
+  Random::fillInto(data);
+  Random::fillInto(data);
+  Random::reseed();
+  Random::fillInto(data);
+  Random::setReseedInterval(0);
+  ASSERT_TRUE(data != ByteArray(10000));
+}
+
+static int fixedBytes(unsigned char *buf, int num) {
+  memset(buf, 0x5a, num);
+  return 1;
+}
+
+/**
+ * @brief Um método RAND configurado é usado após Random::methodChanged()
+ */
+TEST_F(RandomTest, MethodChangedTest) {
+  RAND_METHOD fixed = {NULL, fixedBytes, NULL, NULL, fixedBytes, NULL};
+  ByteArray data(16);
+
+  Random::fillInto(data);
+  ASSERT_EQ(RAND_set_rand_method(&fixed), 1);
+  Random::methodChanged();
+  Random::fillInto(data);
+  ASSERT_EQ(data, ByteArray(std::string(16, 0x5a)));
+
+  ASSERT_EQ(RAND_set_rand_method(NULL), 1);
+  Random::methodChanged();
+  Random::fillInto(data);
+  ASSERT_TRUE(data != ByteArray(std::string(16, 0x5a)));
+}
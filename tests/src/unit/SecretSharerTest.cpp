@@ -182,3 +182,121 @@ TEST_F(SecretSharerTest, splitBiggerThreshold) {
     unsigned int splitThreshold = 3;
     testSplitInvalidParam(splitSecretSize, splitParts, splitThreshold);
 }
+
+/**
+ * @brief Test if any threshold parts in the GF256 format recover a secret larger than one block
+ */
+TEST_F(SecretSharerTest, gf256JoinAnyThreshold) {
+    ByteArray secret = Random::bytes(200000);
+    std::vector<std::ostringstream *> parts;
+    std::vector<std::ostream *> secretParts;
+    for (unsigned int i = 0; i < 5; i++) {
+        parts.push_back(new std::ostringstream());
+        secretParts.push_back(parts[i]);
+    }
+    SecretSharer::split(secret.toStream(), 5, 3, &secretParts, SecretSharer::GF256);
+
+    const unsigned int subsets[][3] = {{0, 1, 2}, {4, 2, 0}, {3, 1, 4}};
+    for (unsigned int s = 0; s < 3; s++) {
+        std::vector<std::istringstream *> streams;
+        std::vector<std::istream *> secretPartsJoin;
+        std::ostringstream recovered;
+        for (unsigned int i = 0; i < 3; i++) {
+            streams.push_back(new std::istringstream(parts[subsets[s][i]]->str()));
+            secretPartsJoin.push_back(streams[i]);
+        }
+        SecretSharer::join(&secretPartsJoin, 5, 3, &recovered, SecretSharer::GF256);
+        ASSERT_EQ(ByteArray(recovered.str()), secret);
+        for (unsigned int i = 0; i < 3; i++) {
+            delete streams[i];
+        }
+    }
+    for (unsigned int i = 0; i < 5; i++) {
+        delete parts[i];
+    }
+}
+
+/**
+ * @brief Test the GF256 format with threshold 1 and with threshold equal to the number of parts
+ */
+TEST_F(SecretSharerTest, gf256JoinEdgeThresholds) {
+    std::vector<std::ostream *> allParts;
+    for (unsigned int i = 0; i < 4; i++) {
+        allParts.push_back(new std::ostringstream());
+    }
+    SecretSharer::split(fullSecret.toStream(), 4, 4, &allParts, SecretSharer::GF256);
+
+    std::vector<std::istream *> secretPartsJoin;
+    for (unsigned int i = 0; i < 4; i++) {
+        secretPartsJoin.push_back(new std::istringstream(((std::ostringstream *) allParts[i])->str()));
+    }
+    std::ostringstream recovered;
+    SecretSharer::join(&secretPartsJoin, 4, 4, &recovered, SecretSharer::GF256);
+    ASSERT_EQ(ByteArray(recovered.str()), fullSecret);
+
+    std::vector<std::ostream *> singlePart(1, new std::ostringstream());
+    SecretSharer::split(fullSecret.toStream(), 1, 1, &singlePart, SecretSharer::GF256);
+    std::istringstream singleIn(((std::ostringstream *) singlePart[0])->str());
+    std::vector<std::istream *> singleJoin(1, &singleIn);
+    std::ostringstream singleRecovered;
+    SecretSharer::join(&singleJoin, 1, 1, &singleRecovered, SecretSharer::GF256);
+    ASSERT_EQ(ByteArray(singleRecovered.str()), fullSecret);
+}
+
+/**
+ * @brief Test if GF256 join rejects parts of another format, duplicated parts and a wrong threshold
+ */
+TEST_F(SecretSharerTest, gf256JoinInvalid) {
+    std::vector<std::ostream *> legacyParts = splitSecret(4, 4, 3);
+    std::vector<std::ostream *> parts;
+    for (unsigned int i = 0; i < 3; i++) {
+        parts.push_back(new std::ostringstream());
+    }
+    SecretSharer::split(fullSecret.toStream(), 3, 2, &parts, SecretSharer::GF256);
+    std::string first = ((std::ostringstream *) parts[0])->str();
+
+    std::istringstream legacy0(((std::ostringstream *) legacyParts[0])->str());
+    std::istringstream legacy1(((std::ostringstream *) legacyParts[1])->str());
+    std::istringstream legacy2(((std::ostringstream *) legacyParts[2])->str());
+    std::vector<std::istream *> legacyJoin;
+    legacyJoin.push_back(&legacy0);
+    legacyJoin.push_back(&legacy1);
+    legacyJoin.push_back(&legacy2);
+    std::ostringstream out;
+    ASSERT_THROW(SecretSharer::join(&legacyJoin, 4, 3, &out, SecretSharer::GF256), SecretSharerException);
+
+    std::istringstream copy0(first), copy1(first);
+    std::vector<std::istream *> duplicatedJoin;
+    duplicatedJoin.push_back(&copy0);
+    duplicatedJoin.push_back(&copy1);
+    ASSERT_THROW(SecretSharer::join(&duplicatedJoin, 3, 2, &out, SecretSharer::GF256), SecretSharerException);
+
+    std::istringstream part0(first), part1(((std::ostringstream *) parts[1])->str()), part2(((std::ostringstream *) parts[2])->str());
+    std::vector<std::istream *> thresholdJoin;
+    thresholdJoin.push_back(&part0);
+    thresholdJoin.push_back(&part1);
+    thresholdJoin.push_back(&part2);
+    ASSERT_THROW(SecretSharer::join(&thresholdJoin, 3, 3, &out, SecretSharer::GF256), SecretSharerException);
+
+    std::vector<std::ostream *> tooManyParts;
+    for (unsigned int i = 0; i < 256; i++) {
+        tooManyParts.push_back(&out);
+    }
+    ASSERT_THROW(SecretSharer::split(fullSecret.toStream(), 256, 2, &tooManyParts, SecretSharer::GF256), SecretSharerException);
+}
+
+/**
+ * @brief Xor splitting (parts == threshold) of a secret spanning several blocks
+ */
+TEST_F(SecretSharerTest, xorJoinLargeSecret) {
+    std::vector<std::ostream *> secretParts;
+    fullSecret = Random::bytes(200001);
+    for (unsigned int i = 0; i < 3; i++) {
+        secretParts.push_back(new std::ostringstream());
+    }
+    SecretSharer::split(fullSecret.toStream(), 3, 3, &secretParts);
+    for (unsigned int i = 0; i < 3; i++) {
+        ASSERT_EQ(((std::ostringstream *) secretParts[i])->str().size(), fullSecret.size());
+    }
+    testJoinSecret(3, 3, 3, &secretParts);
+}
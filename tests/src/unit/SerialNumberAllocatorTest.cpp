@@ -0,0 +1,148 @@
+#include <libcryptosec/certificate/SerialNumberAllocator.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+#include <libcryptosec/ECDSAKeyPair.h>
+
+#include <set>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários da classe SerialNumberAllocator
+ */
+class SerialNumberAllocatorTest : public ::testing::Test {
+
+protected:
+    static std::string toString(const unsigned char *serial) {
+        return std::string((const char *) serial, SerialNumberAllocator::SIZE);
+    }
+};
+
+/**
+ * @brief Números de série positivos, de 20 octetos, com o shard e o contador consecutivo
+ */
+TEST_F(SerialNumberAllocatorTest, Format) {
+    SerialNumberAllocator allocator(SerialNumberAllocator::MAX_SHARD - 1);
+    unsigned char serials[3 * SerialNumberAllocator::SIZE];
+    unsigned int shard;
+
+    ASSERT_EQ(allocator.getShard(), SerialNumberAllocator::MAX_SHARD - 1);
+    allocator.next(serials, 3);
+    for (unsigned int i = 0; i < 3; i++) {
+        unsigned char *serial = serials + i * SerialNumberAllocator::SIZE;
+        ASSERT_EQ(serial[0], 0x7f);
+        ASSERT_EQ(serial[3], 0xfe);
+        if (i > 0) {
+            ASSERT_EQ(serial[11], (unsigned char) ((serial - SerialNumberAllocator::SIZE)[11] + 1));
+        }
+    }
+
+    for (unsigned int i = 0; i < 100; i++) {
+        BigInteger serial = allocator.next();
+        ASN1_INTEGER *asn1 = serial.getASN1Value();
+        ASSERT_FALSE(serial.isNegative());
+        ASSERT_EQ(asn1->length, (int) SerialNumberAllocator::SIZE);
+        ASSERT_TRUE(SerialNumberAllocator::getShard(serial, shard));
+        ASSERT_EQ(shard, SerialNumberAllocator::MAX_SHARD - 1);
+        ASN1_INTEGER_free(asn1);
+    }
+    ASSERT_FALSE(SerialNumberAllocator::getShard(BigInteger(1234), shard));
+
+    ASSERT_THROW(SerialNumberAllocator(SerialNumberAllocator::MAX_SHARD + 1), CertificationException);
+    ASSERT_LE(SerialNumberAllocator().getShard(), SerialNumberAllocator::MAX_SHARD);
+}
+
+/**
+ * @brief Números de série únicos entre threads que compartilham o SerialNumberAllocator e entre shards
+ */
+TEST_F(SerialNumberAllocatorTest, Unique) {
+    const unsigned int perThread = 20000;
+    SerialNumberAllocator allocator(1), other(2);
+    std::vector<std::vector<std::string> > generated(4);
+    std::vector<std::thread> threads;
+    std::set<std::string> unique;
+
+    for (unsigned int t = 0; t < generated.size(); t++) {
+        threads.push_back(std::thread([&, t]() {
+            unsigned char serials[10 * SerialNumberAllocator::SIZE];
+            SerialNumberAllocator &current = t % 2 == 0 ? allocator : other;
+            for (unsigned int i = 0; i < perThread; i += 10) {
+                current.next(serials, 10);
+                for (unsigned int j = 0; j < 10; j++) {
+                    generated[t].push_back(toString(serials + j * SerialNumberAllocator::SIZE));
+                }
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    for (unsigned int t = 0; t < generated.size(); t++) {
+        unique.insert(generated[t].begin(), generated[t].end());
+    }
+    ASSERT_EQ(unique.size(), perThread * generated.size());
+
+    std::vector<BigInteger> serials = allocator.next(100);
+    std::set<std::string> hex;
+    ASSERT_EQ(serials.size(), 100u);
+    for (unsigned int i = 0; i < serials.size(); i++) {
+        hex.insert(serials[i].toHex());
+    }
+    ASSERT_EQ(hex.size(), 100u);
+}
+
+/**
+ * @brief O processo filho de um fork() não repete shard e contador do pai
+ */
+TEST_F(SerialNumberAllocatorTest, Fork) {
+    SerialNumberAllocator allocator(3);
+    unsigned char parent[SerialNumberAllocator::SIZE], child[SerialNumberAllocator::SIZE];
+    int fds[2], status;
+    pid_t pid;
+
+    ASSERT_EQ(pipe(fds), 0);
+    pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        allocator.next(child);
+        _exit(write(fds[1], child, sizeof(child)) == sizeof(child) ? 0 : 1);
+    }
+    allocator.next(parent);
+    ASSERT_EQ(read(fds[0], child, sizeof(child)), (ssize_t) sizeof(child));
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+    ASSERT_TRUE(toString(parent).substr(0, 12) != toString(child).substr(0, 12));
+}
+
+/**
+ * @brief Número de série usado na emissão de um certificado
+ */
+TEST_F(SerialNumberAllocatorTest, Certificate) {
+    ECDSAKeyPair keyPair(AsymmetricKey::X962_PRIME256V1);
+    PrivateKey *privateKey = keyPair.getPrivateKey();
+    PublicKey *publicKey = keyPair.getPublicKey();
+    SerialNumberAllocator allocator(42);
+    BigInteger serial = allocator.next();
+    CertificateBuilder builder;
+    RDNSequence name;
+    Certificate *cert;
+    unsigned int shard;
+
+    name.addEntry(RDNSequence::COMMON_NAME, "Device");
+    builder.setSubject(name);
+    builder.setIssuer(name);
+    builder.setPublicKey(*publicKey);
+    builder.setSerialNumber(serial);
+    cert = builder.sign(*privateKey, MessageDigest::SHA256);
+
+    ASSERT_EQ(cert->getSerialNumberBigInt().toHex(), serial.toHex());
+    ASSERT_TRUE(SerialNumberAllocator::getShard(cert->getSerialNumberBigInt(), shard));
+    ASSERT_EQ(shard, 42u);
+
+    delete cert;
+    delete privateKey;
+    delete publicKey;
+}
@@ -0,0 +1,296 @@
+#include <libcryptosec/SmartcardReader.h>
+#include <libcryptosec/AsymmetricCipher.h>
+#include <libcryptosec/RSAPublicKey.h>
+#include <libcryptosec/Signer.h>
+#include <libcryptosec/Pkcs7SignedDataBuilder.h>
+#include <libcryptosec/Pkcs7Factory.h>
+#include <libcryptosec/certificate/CertificateBuilder.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários da classe SmartcardSlot com um token PKCS#11 (por exemplo, SoftHSM) contendo
+ * uma chave RSA e o certificado correspondente, com o mesmo id.
+ * Configuração por variáveis de ambiente, como em SmartcardSignBenchmark:
+ *   PKCS11_MODULE  caminho do módulo PKCS#11
+ *   PKCS11_SERIAL  serial do token
+ *   PKCS11_KEY_ID  id da chave e do certificado, em hexadecimal maiúsculo
+ *   PKCS11_PIN     PIN do usuário
+ * Sem essas variáveis os testes são ignorados.
+ */
+class SmartcardSlotTest : public ::testing::Test {
+
+protected:
+    static void SetUpTestCase() {
+        const char *module = getenv("PKCS11_MODULE");
+        if (module != NULL && getenv("PKCS11_SERIAL") != NULL && getenv("PKCS11_KEY_ID") != NULL &&
+                getenv("PKCS11_PIN") != NULL) {
+            SmartcardReader::initialize(module);
+            available = true;
+        }
+    }
+
+    static void TearDownTestCase() {
+        if (available) {
+            SmartcardReader::destroy();
+            available = false;
+        }
+    }
+
+    virtual void SetUp() {
+        if (!available) {
+            GTEST_SKIP() << "PKCS11_MODULE, PKCS11_SERIAL, PKCS11_KEY_ID and PKCS11_PIN not set";
+        }
+        serial = getenv("PKCS11_SERIAL");
+        keyId = getenv("PKCS11_KEY_ID");
+        pin = getenv("PKCS11_PIN");
+        slots = SmartcardReader::getInstance()->getSmartcardSlots();
+        slot = slots->getSmartcardSlot(serial, keyId);
+    }
+
+    virtual void TearDown() {
+        if (available) {
+            delete slot;
+            delete slots;
+        }
+    }
+
+    /**
+     * @return certificado do token com o id da chave, que deve ser liberado pelo chamador.
+     */
+    Certificate* getCertificate() {
+        std::vector<SmartcardCertificate *> certificates = slot->getCertificates();
+        Certificate *ret = NULL;
+        for (unsigned int i = 0; i < certificates.size(); i++) {
+            if (ret == NULL && certificates[i]->getId() == keyId) {
+                ret = certificates[i]->getCertificate();
+            }
+            delete certificates[i];
+        }
+        return ret;
+    }
+
+    ByteArray encrypt(ByteArray &data) {
+        Certificate *certificate = getCertificate();
+        PublicKey *publicKey = certificate->getPublicKey();
+        ByteArray der = publicKey->getDerEncoded();
+        RSAPublicKey rsa(der);
+        delete publicKey;
+        delete certificate;
+        return AsymmetricCipher::encrypt(rsa, data, AsymmetricCipher::PKCS1);
+    }
+
+    static ByteArray digest() {
+        MessageDigest md(MessageDigest::SHA256);
+        std::string data("libcryptosec");
+        return md.doFinal(data);
+    }
+
+    static bool available;
+    std::string serial, keyId, pin;
+    SmartcardSlots *slots;
+    SmartcardSlot *slot;
+};
+
+bool SmartcardSlotTest::available = false;
+
+/**
+ * @brief Decifragem com a chave do token, reutilizando a sessão autenticada
+ */
+TEST_F(SmartcardSlotTest, Decrypt) {
+    ByteArray data("libcryptosec");
+    ByteArray encrypted = encrypt(data);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(slot->decrypt(keyId, pin, encrypted), data);
+    }
+    slot->logout();
+    ASSERT_EQ(slot->decrypt(keyId, pin, encrypted), data);
+}
+
+/**
+ * @brief Decifragem concorrente no mesmo SmartcardSlot, com um logout e um refresh entre as rodadas
+ */
+TEST_F(SmartcardSlotTest, ConcurrentDecrypt) {
+    ByteArray data("libcryptosec");
+    ByteArray encrypted = encrypt(data);
+
+    for (int round = 0; round < 2; round++) {
+        std::vector<std::thread> threads;
+        std::vector<int> decrypted(4, 0);
+        for (unsigned int t = 0; t < decrypted.size(); t++) {
+            threads.push_back(std::thread([&, t]() {
+                try {
+                    for (int i = 0; i < 20; i++) {
+                        if (slot->decrypt(keyId, pin, encrypted) == data) {
+                            decrypted[t]++;
+                        }
+                    }
+                } catch (SmartcardModuleException &e) {
+                }
+            }));
+        }
+        for (unsigned int t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        for (unsigned int t = 0; t < decrypted.size(); t++) {
+            ASSERT_EQ(decrypted[t], 20);
+        }
+        slot->logout();
+        slot->refresh();
+    }
+}
+
+/**
+ * @brief Certificados enumerados novamente após o logout, que libera os handles da libp11
+ */
+TEST_F(SmartcardSlotTest, CertificatesAfterLogout) {
+    ByteArray data("libcryptosec");
+    ByteArray encrypted = encrypt(data);
+    Certificate *before = getCertificate();
+
+    ASSERT_EQ(slot->decrypt(keyId, pin, encrypted), data);
+    slot->logout();
+    Certificate *after = getCertificate();
+    ASSERT_TRUE(after != NULL);
+    ASSERT_EQ(after->getDerEncoded(), before->getDerEncoded());
+
+    delete after;
+    delete before;
+}
+
+/**
+ * @brief PINs com tamanho inválido são rejeitados sem tentativa de login
+ */
+TEST_F(SmartcardSlotTest, InvalidPin) {
+    ByteArray data("libcryptosec");
+    std::string shortPin("123");
+
+    ASSERT_THROW(slot->decrypt(keyId, shortPin, data), SmartcardModuleException);
+    ASSERT_THROW(slot->getPrivateKey(keyId, shortPin), SmartcardModuleException);
+}
+
+/**
+ * @brief Assinatura com a chave do token por Signer, também por várias threads
+ */
+TEST_F(SmartcardSlotTest, Signer) {
+    SmartcardPrivateKey *key = slot->getPrivateKey(keyId, pin);
+    Certificate *certificate = getCertificate();
+    PublicKey *publicKey = certificate->getPublicKey();
+    ByteArray hash = digest();
+    std::vector<std::thread> threads;
+    std::vector<int> verified(4, 0);
+
+    ASSERT_EQ(key->getId(), keyId);
+    ByteArray signature = Signer::sign(*key, hash, MessageDigest::SHA256);
+    ASSERT_TRUE(Signer::verify(*publicKey, signature, hash, MessageDigest::SHA256));
+
+    for (unsigned int t = 0; t < verified.size(); t++) {
+        threads.push_back(std::thread([&, t]() {
+            try {
+                for (int i = 0; i < 10; i++) {
+                    ByteArray current = Signer::sign(*key, hash, MessageDigest::SHA256);
+                    if (Signer::verify(*publicKey, current, hash, MessageDigest::SHA256)) {
+                        verified[t]++;
+                    }
+                }
+            } catch (LibCryptoSecException &e) {
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    for (unsigned int t = 0; t < verified.size(); t++) {
+        ASSERT_EQ(verified[t], 10);
+    }
+
+    delete publicKey;
+    delete certificate;
+    delete key;
+}
+
+/**
+ * @brief Emissão de certificado assinado com a chave do token
+ */
+TEST_F(SmartcardSlotTest, CertificateBuilder) {
+    SmartcardPrivateKey *key = slot->getPrivateKey(keyId, pin);
+    Certificate *issuer = getCertificate();
+    PublicKey *issuerKey = issuer->getPublicKey();
+    CertificateBuilder builder;
+    RDNSequence subject, issuerName = issuer->getSubject();
+    Certificate *certificate;
+
+    subject.addEntry(RDNSequence::COMMON_NAME, "Smartcard");
+    builder.setSubject(subject);
+    builder.setIssuer(issuerName);
+    builder.setPublicKey(*issuerKey);
+    builder.setSerialNumber(1);
+    certificate = builder.sign(*key, MessageDigest::SHA256);
+    ASSERT_TRUE(certificate->verify(*issuerKey));
+
+    delete certificate;
+    delete issuerKey;
+    delete issuer;
+    delete key;
+}
+
+/**
+ * @brief Assinatura PKCS#7 com a chave do token
+ */
+TEST_F(SmartcardSlotTest, Pkcs7SignedDataBuilder) {
+    SmartcardPrivateKey *key = slot->getPrivateKey(keyId, pin);
+    Certificate *certificate = getCertificate();
+    std::string content("libcryptosec");
+    std::istringstream in(content);
+    std::ostringstream out, extracted;
+    Pkcs7SignedData *signedData;
+
+    {
+        Pkcs7SignedDataBuilder builder(MessageDigest::SHA256, *certificate, *key, true);
+        builder.doFinal(&in, &out, Pkcs7Builder::DER, 4096);
+    }
+    ByteArray der(out.str());
+    signedData = dynamic_cast<Pkcs7SignedData *>(Pkcs7Factory::fromDerEncoded(der));
+    ASSERT_TRUE(signedData != NULL);
+    ASSERT_TRUE(signedData->verifyAndExtract(&extracted));
+    ASSERT_EQ(extracted.str(), content);
+
+    delete signedData;
+    delete certificate;
+    delete key;
+}
+
+/**
+ * @brief Operações que encerrariam a sessão de uma SmartcardPrivateKey em uso falham com SESSION_IN_USE
+ */
+TEST_F(SmartcardSlotTest, SessionInUse) {
+    SmartcardPrivateKey *key = slot->getPrivateKey(keyId, pin);
+    ByteArray hash = digest();
+    std::string otherPin = pin == "00000000" ? "11111111" : "00000000";
+    ByteArray data("libcryptosec");
+
+    try {
+        slot->decrypt(keyId, otherPin, data);
+        FAIL();
+    } catch (SmartcardModuleException &e) {
+        ASSERT_EQ(e.getErrorCode(), SmartcardModuleException::SESSION_IN_USE);
+    }
+    try {
+        delete slot->getPrivateKey(keyId, otherPin);
+        FAIL();
+    } catch (SmartcardModuleException &e) {
+        ASSERT_EQ(e.getErrorCode(), SmartcardModuleException::SESSION_IN_USE);
+    }
+    ASSERT_THROW(slot->logout(), SmartcardModuleException);
+    ASSERT_THROW(slot->refresh(), SmartcardModuleException);
+    Signer::sign(*key, hash, MessageDigest::SHA256);
+
+    delete key;
+    slot->logout();
+    slot->refresh();
+}
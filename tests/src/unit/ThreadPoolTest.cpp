@@ -0,0 +1,175 @@
+#include <libcryptosec/ThreadPool.h>
+
+#include <stdexcept>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+/**
+ * @brief Testes unitários da classe ThreadPool
+ */
+class ThreadPoolTest : public ::testing::Test {
+
+protected:
+    class CounterTask : public ThreadPool::Task {
+    public:
+        CounterTask() : value(0) {}
+        virtual void run() {
+            for (int i = 0; i < 1000; i++) {
+                value++;
+            }
+        }
+        int value;
+    };
+
+    class FailingTask : public ThreadPool::Task {
+    public:
+        virtual void run() {
+            throw std::runtime_error("fail");
+        }
+    };
+};
+
+/**
+ * @brief Tests that every task runs exactly once, repeatedly on the same pool
+ */
+TEST_F(ThreadPoolTest, Execute) {
+    ThreadPool pool(4);
+    std::vector<CounterTask> counters(100);
+    std::vector<ThreadPool::Task*> tasks;
+
+    for (unsigned int i = 0; i < counters.size(); i++) {
+        tasks.push_back(&counters[i]);
+    }
+
+    ASSERT_EQ(pool.getSize(), 4u);
+    for (int round = 1; round <= 3; round++) {
+        pool.execute(tasks);
+        for (unsigned int i = 0; i < counters.size(); i++) {
+            ASSERT_EQ(counters[i].value, round * 1000);
+            ASSERT_FALSE(counters[i].hasFailed());
+        }
+    }
+}
+
+/**
+ * @brief Tests that exceptions thrown by a task mark it as failed
+ */
+TEST_F(ThreadPoolTest, FailingTask) {
+    ThreadPool pool(2);
+    FailingTask failing;
+    CounterTask counter;
+    std::vector<ThreadPool::Task*> tasks;
+
+    tasks.push_back(&failing);
+    tasks.push_back(&counter);
+    pool.execute(tasks);
+
+    ASSERT_TRUE(failing.hasFailed());
+    ASSERT_FALSE(counter.hasFailed());
+    ASSERT_EQ(counter.value, 1000);
+}
+
+/**
+ * @brief Tests a single-threaded pool, which runs tasks on the calling thread
+ */
+TEST_F(ThreadPoolTest, SingleThread) {
+    ThreadPool pool(1);
+    CounterTask counter;
+    std::vector<ThreadPool::Task*> tasks(1, &counter);
+
+    pool.execute(tasks);
+    ASSERT_EQ(pool.getSize(), 1u);
+    ASSERT_EQ(counter.value, 1000);
+    ASSERT_GE(ThreadPool::getProcessors(), 1u);
+}
+
+/**
+ * @brief Tests that a task may call execute() on the pool running it, directly or through another pool
+ */
+TEST_F(ThreadPoolTest, Reentrant) {
+    class NestedTask : public ThreadPool::Task {
+    public:
+        NestedTask(ThreadPool *pool, ThreadPool *inner) : pool(pool), inner(inner), counters(4) {}
+        virtual void run() {
+            std::vector<ThreadPool::Task*> tasks;
+            for (unsigned int i = 0; i < counters.size(); i++) {
+                tasks.push_back(&counters[i]);
+            }
+            if (inner != NULL) {
+                NestedTask back(pool, NULL);
+                std::vector<ThreadPool::Task*> outer(1, &back);
+                inner->execute(outer);
+                counters = back.counters;
+            } else {
+                pool->execute(tasks);
+            }
+        }
+        ThreadPool *pool, *inner;
+        std::vector<CounterTask> counters;
+    };
+
+    ThreadPool pool(2), inner(2);
+    std::vector<NestedTask> nested;
+    std::vector<ThreadPool::Task*> tasks;
+
+    for (unsigned int i = 0; i < 8; i++) {
+        nested.push_back(NestedTask(&pool, i % 2 == 0 ? NULL : &inner));
+    }
+    for (unsigned int i = 0; i < nested.size(); i++) {
+        tasks.push_back(&nested[i]);
+    }
+    pool.execute(tasks);
+    for (unsigned int i = 0; i < nested.size(); i++) {
+        ASSERT_FALSE(nested[i].hasFailed());
+        for (unsigned int j = 0; j < nested[i].counters.size(); j++) {
+            ASSERT_EQ(nested[i].counters[j].value, 1000);
+        }
+    }
+}
+
+/**
+ * @brief Tests multi-task nested batches alternating between two pools, each waiting on the other
+ */
+TEST_F(ThreadPoolTest, CrossPoolReentrant) {
+    class ChainTask : public ThreadPool::Task {
+    public:
+        ChainTask(std::vector<ThreadPool*> *pools, unsigned int depth, int *leaves) :
+                pools(pools), depth(depth), leaves(leaves) {}
+        virtual void run() {
+            // give the other pool threads time to take tasks from the batch
+            usleep(1000);
+            if (depth == pools->size()) {
+                __atomic_add_fetch(leaves, 1, __ATOMIC_SEQ_CST);
+                return;
+            }
+            std::vector<ChainTask> children(4, ChainTask(pools, depth + 1, leaves));
+            std::vector<ThreadPool::Task*> tasks;
+            for (unsigned int i = 0; i < children.size(); i++) {
+                tasks.push_back(&children[i]);
+            }
+            (*pools)[depth]->execute(tasks);
+            for (unsigned int i = 0; i < children.size(); i++) {
+                if (children[i].hasFailed()) {
+                    throw std::runtime_error("child failed");
+                }
+            }
+        }
+        std::vector<ThreadPool*> *pools;
+        unsigned int depth;
+        int *leaves;
+    };
+
+    ThreadPool outer(3), inner(3);
+    std::vector<ThreadPool*> pools;
+
+    pools.push_back(&outer);
+    pools.push_back(&inner);
+    pools.push_back(&outer);
+    pools.push_back(&inner);
+    for (int round = 0; round < 2; round++) {
+        int leaves = 0;
+        ChainTask root(&pools, 0, &leaves);
+        root.run();
+        ASSERT_EQ(leaves, 4 * 4 * 4 * 4);
+    }
+}